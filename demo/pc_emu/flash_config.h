@@ -38,8 +38,10 @@
 #define FLASH_TYPE_W25Q256FV_32K    12  /**< 32 KiB sector mode */
 #define FLASH_TYPE_W25Q256FV_64K    13  /**< 64 KiB sector mode */
 
-/** Type of emulated flash memory */
+/** Type of emulated flash memory. It can be overridden from Makefile. */
+#ifndef FLASH_TYPE
 #define FLASH_TYPE                  FLASH_TYPE_W25Q16DV_64K
+#endif
 
 #if FLASH_TYPE == FLASH_TYPE_M25P40
 /* Geometry of ST M25P40 */
@@ -128,6 +130,10 @@
 #define PIFS_FLASH_4BYTE_ADDRESS            1
 #endif
 
+/** Emulator implements every burst operation of flash driver */
+#define PIFS_FLASH_CAPABILITIES             (PIFS_FLASH_CAP_WRITE_PAGES | PIFS_FLASH_CAP_ERASE_BLOCKS \
+                                             | PIFS_FLASH_CAP_READ_SG)
+
 #define PIFS_FLASH_ERASED_BYTE_VALUE        0xFFu
 #define PIFS_FLASH_PROGRAMMED_BYTE_VALUE    (PIFS_FLASH_ERASED_BYTE_VALUE ^ 0xFFu)
 
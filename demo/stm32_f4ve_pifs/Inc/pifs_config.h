@@ -48,6 +48,7 @@
 #define PIFS_LEAST_WEARED_BLOCK_NUM     26u  /**< Number of stored least weared blocks */
 #define PIFS_MOST_WEARED_BLOCK_NUM      26u  /**< Number of stored most weared blocks */
 #define PIFS_DELTA_MAP_PAGE_NUM         10u  /**< Number of delta page maps */
+#define PIFS_DELTA_MAP_EXT_PAGE_NUM     6u   /**< Maximum number of delta map pages chained on demand, 0: merge when delta map is full */
 #define PIFS_ENABLE_CRC                 1u   /**< Use CRC for headers and entries. */
 #define PIFS_CHECKSUM_SIZE              4u   /**< Size of checksum variable in bytes. Valid values are 1, 2 and 4. */
 #define PIFS_MAP_PAGE_COUNT_SIZE        1u   /**< Size of page count variable of map entry in bytes. Valid values are 1, 2 and 4. */
@@ -66,6 +67,36 @@
 #define PIFS_STATIC_WEAR_LEVEL_LIMIT  500u
 #define PIFS_CALC_TBR_IN_FREE_SPACE     0u   /**< 1: Free pages and to be released pages are counted, 0: only free pages counted */
 #define PIFS_FSCHECK_USE_STATIC_MEMORY  1u   /**< 1: Use static memory for file system check, 0: Use dynamic (malloc) for file system check */
+#define PIFS_CACHE_PAGE_NUM             4u   /**< Number of logical pages in the page cache. More pages: less flash access, more RAM */
+#define PIFS_CACHE_WAY_NUM              4u   /**< Associativity of page cache. PIFS_CACHE_PAGE_NUM shall be multiple of it.
+                                                  PIFS_CACHE_WAY_NUM == PIFS_CACHE_PAGE_NUM: fully associative cache */
+#define PIFS_ENABLE_STATISTICS          0u   /**< 1: Collect statistics (cache hits/misses, etc.), 0: no statistics */
+#define PIFS_ENABLE_FSBM_IN_RAM         1u   /**< 1: Keep a copy of free space bitmap in RAM for faster allocation, 0: use only flash */
+#define PIFS_ENABLE_DELTA_INDEX         1u   /**< 1: Look up delta pages through a hash table in RAM, 0: search delta map linearly */
+#define PIFS_DELTA_FILTER_PAGE_NUM      8u   /**< Number of logical pages covered by one bit of delta presence filter in RAM, 0: disabled */
+#define PIFS_DELTA_PATCH_PAGE_NUM       4u   /**< Maximum number of patch pages, small overwrites are stored in them as patches. 0: disabled */
+#define PIFS_DELTA_PATCH_SIZE_MAX       32u  /**< Maximum size of a patch in bytes, larger overwrites need delta page */
+#define PIFS_ENTRY_INDEX_LIST_NUM       2u   /**< Number of entry lists (directories) whose file names are indexed in RAM.
+                                                  Least recently used index is replaced. 0: no index, entries are searched linearly */
+#define PIFS_EXTENT_CACHE_NUM           8u   /**< Number of map entries cached per opened file for fast seeking. 0: fseek walks the map */
+#define PIFS_ENABLE_MERGE_PRE_ERASE     1u   /**< 1: Blocks can be erased in advance of merge by pifs_merge_pre_erase(), merge still copies management data at once. 0: merge erases all blocks */
+#define PIFS_MERGE_PRE_ERASE_AUTO_NUM   0u   /**< Number of pifs_merge_pre_erase() calls when space is allocated and merge is not needed yet. 0: only user calls it */
+#define PIFS_ENABLE_PAGE_CNTR           1u   /**< 1: Count free and to be released pages of blocks in RAM, 0: count them in free space bitmap */
+#define PIFS_ENABLE_MOUNT_HINT          0u   /**< 1: Address of header is stored in mount hint blocks for fast mount, 0: all blocks are scanned at mount */
+#define PIFS_MOUNT_HINT_BLOCK_NUM       2u   /**< Number of blocks after the reserved blocks to store mount hints. Minimum 2, they are used in rotation */
+#define PIFS_ENABLE_FSBM_BATCH          1u   /**< 1: Free space bitmap is written once after writing or releasing pages of a file, 0: after every marked page */
+#define PIFS_DIRECT_READ_PAGE_NUM_MAX   64u  /**< Maximum number of whole logical pages read directly to user's buffer by one flash read.
+                                                  0: every page is read through the page cache */
+#define PIFS_READ_AHEAD_PAGE_NUM        4u   /**< Size of read-ahead buffer of an opened file in logical pages.
+                                                  0: no read-ahead, pifs_fadvise() is not available */
+#define PIFS_SKIP_FREE_PAGE_READ        1u   /**< 1: Free pages of data blocks are known to be erased, they are not read before writing */
+#define PIFS_ENABLE_ERASED_BITMAP       1u   /**< 1: Keep a bitmap of pages verified to be erased in RAM, PIFS_CHECK_IF_PAGE_IS_ERASED reads them only once */
+#define PIFS_ENABLE_BLOCK_TYPE_TABLE    1u   /**< 1: Keep type of blocks in a table in RAM, 0: calculate type of block from header at every check */
+#define PIFS_ENABLE_ALLOC_CURSOR        1u   /**< 1: Allocation continues from first free page instead of beginning of flash memory */
+#define PIFS_ENABLE_EXTENT_ALLOC        1u   /**< 1: Keep longest free run of blocks in RAM to allocate contiguous pages for large writes, needs PIFS_ENABLE_FSBM_IN_RAM */
+#define PIFS_ENABLE_FALLOCATE           1u   /**< 1: Enable pifs_fallocate() to reserve pages for a file in advance */
+#define PIFS_ENABLE_DEFERRED_MAP_ENTRY  1u   /**< 1: Last map entry of file is kept in RAM while appended pages are contiguous, it is written by pifs_fflush(). Its pages are reserved in RAM copy of free space bitmap until then, after a reset they are found by PIFS_CHECK_IF_PAGE_IS_ERASED and released. Needs PIFS_ENABLE_FSBM_IN_RAM */
+#define PIFS_ENABLE_MAP_TAIL_CACHE      1u   /**< 1: Position of last map entry of opened file is kept in RAM, appending does not walk the map */
 
 #define PIFS_PACKED_ATTRIBUTE           __attribute__((packed))
 #define PIFS_ALIGNED_ATTRIBUTE(align)   __attribute__((aligned(align)))
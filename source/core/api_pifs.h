@@ -147,6 +147,17 @@ typedef enum
     PIFS_SEEK_END,
 } pifs_fseek_origin_t;
 
+#if PIFS_READ_AHEAD_PAGE_NUM
+/** Access pattern of file, @see pifs_fadvise() */
+typedef enum
+{
+    PIFS_FADV_NORMAL = 0,   /**< Read-ahead is started when sequential reading is detected */
+    PIFS_FADV_SEQUENTIAL,   /**< Read-ahead is always used */
+    PIFS_FADV_RANDOM,       /**< Read-ahead is not used */
+    PIFS_FADV_NOREUSE,      /**< Data is read once. Read-ahead is always used, it does not fill the page cache. */
+} pifs_fadvise_advice_t;
+#endif
+
 typedef uint32_t pifs_ino_t;
 
 struct pifs_dirent
@@ -171,6 +182,9 @@ extern int pifs_errno;
 void pifs_print_fs_info(void);
 void pifs_print_header_info(void);
 void pifs_print_free_space_info(void);
+#if PIFS_ENABLE_STATISTICS
+void pifs_print_cache_info(void);
+#endif
 pifs_status_t pifs_init(void);
 pifs_status_t pifs_delete(void);
 pifs_status_t pifs_check(void);
@@ -185,6 +199,12 @@ int pifs_fclose(P_FILE * a_file);
 int pifs_fseek(P_FILE * a_file, long int a_offset, int a_origin);
 void pifs_rewind(P_FILE * a_file);
 long int pifs_ftell(P_FILE * a_file);
+#if PIFS_READ_AHEAD_PAGE_NUM
+int pifs_fadvise(P_FILE * a_file, int a_advice);
+#endif
+#if PIFS_ENABLE_FALLOCATE
+int pifs_fallocate(P_FILE * a_file, long int a_offset, long int a_length);
+#endif
 #if PIFS_ENABLE_USER_DATA
 int pifs_fgetuserdata(P_FILE * a_file, pifs_user_data_t * a_user_data);
 int pifs_fsetuserdata(P_FILE * a_file, const pifs_user_data_t * a_user_data);
@@ -225,6 +245,9 @@ pifs_status_t pifs_get_to_be_released_space(size_t * a_to_be_released_management
                                             size_t * a_to_be_released_data_bytes,
                                             size_t * a_to_be_released_management_page_count,
                                             size_t * a_to_be_released_data_page_count);
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+pifs_status_t pifs_merge_pre_erase(bool_t * a_is_merge_prepared);
+#endif
 #ifdef __cplusplus
 }
 #endif
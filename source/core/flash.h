@@ -80,8 +80,16 @@ typedef uint32_t pifs_page_offset_t;
 #error PIFS_FLASH_PAGE_SIZE_BYTE or PIFS_LOGICAL_PAGE_SIZE_BYTE is too big!
 #endif
 
+#if PIFS_ENABLE_MOUNT_HINT
+/** First block used by the file system. Mount hint blocks are between the
+ * reserved blocks and the file system. */
+#define PIFS_FLASH_BLOCK_FIRST_FS   (PIFS_FLASH_BLOCK_RESERVED_NUM + PIFS_MOUNT_HINT_BLOCK_NUM)
+#else
+/** First block used by the file system */
+#define PIFS_FLASH_BLOCK_FIRST_FS   PIFS_FLASH_BLOCK_RESERVED_NUM
+#endif
 /** Number of blocks used by the file system */
-#define PIFS_FLASH_BLOCK_NUM_FS     (PIFS_FLASH_BLOCK_NUM_ALL - PIFS_FLASH_BLOCK_RESERVED_NUM)
+#define PIFS_FLASH_BLOCK_NUM_FS     (PIFS_FLASH_BLOCK_NUM_ALL - PIFS_FLASH_BLOCK_FIRST_FS)
 /** Size of a block in bytes */
 #define PIFS_FLASH_BLOCK_SIZE_BYTE  (PIFS_FLASH_PAGE_SIZE_BYTE * PIFS_FLASH_PAGE_PER_BLOCK)
 /** Size of the whole flash memory in bytes */
@@ -93,6 +101,29 @@ typedef uint32_t pifs_page_offset_t;
 /** Number of flash pages used by the file system */
 #define PIFS_FLASH_PAGE_NUM_FS      (PIFS_FLASH_BLOCK_NUM_FS * PIFS_FLASH_PAGE_PER_BLOCK)
 
+#define PIFS_FLASH_CAP_WRITE_PAGES  0x01u   /**< Driver implements pifs_flash_write_pages() */
+#define PIFS_FLASH_CAP_ERASE_BLOCKS 0x02u   /**< Driver implements pifs_flash_erase_blocks() */
+#define PIFS_FLASH_CAP_READ_SG      0x04u   /**< Driver implements pifs_flash_read_sg() */
+
+/** Burst operations implemented by the flash driver, PIFS_FLASH_CAP_xxx bits.
+ * Operations which are not implemented by the driver are emulated by single
+ * page calls. It can be defined in flash_config.h. */
+#ifndef PIFS_FLASH_CAPABILITIES
+#define PIFS_FLASH_CAPABILITIES     0u
+#endif
+
+/**
+ * One element of scatter-gather read.
+ */
+typedef struct
+{
+    pifs_block_address_t block_address; /**< Address of block */
+    pifs_page_address_t  page_address;  /**< Address of the page in block */
+    pifs_page_offset_t   page_offset;   /**< Offset in page */
+    void               * buf;           /**< Buffer to fill */
+    size_t               buf_size;      /**< Size of buffer */
+} pifs_flash_sg_t;
+
 /**
  * @brief pifs_flash_init Initialize flash driver.
  *
@@ -140,6 +171,37 @@ pifs_status_t pifs_flash_write(pifs_block_address_t a_block_address, pifs_page_a
  */
 pifs_status_t pifs_flash_erase(pifs_block_address_t a_block_address);
 
+/**
+ * @brief pifs_flash_read_sg Read several areas of flash memory by one
+ * operation.
+ *
+ * @param[in] a_sg      Areas to read and buffers to fill.
+ * @param[in] a_sg_num  Number of elements in a_sg.
+ * @return PIFS_SUCCESS if read successfully finished.
+ */
+pifs_status_t pifs_flash_read_sg(const pifs_flash_sg_t * a_sg, size_t a_sg_num);
+
+/**
+ * @brief pifs_flash_write_pages Program whole consecutive pages of a block.
+ *
+ * @param[in] a_block_address Address of block.
+ * @param[in] a_page_address  Address of the first page in block.
+ * @param[in] a_buf           Buffer to write, size shall be
+ *                            a_page_count * PIFS_FLASH_PAGE_SIZE_BYTE.
+ * @param[in] a_page_count    Number of pages to program.
+ * @return PIFS_SUCCESS if write successfully finished.
+ */
+pifs_status_t pifs_flash_write_pages(pifs_block_address_t a_block_address, pifs_page_address_t a_page_address, const void * const a_buf, size_t a_page_count);
+
+/**
+ * @brief pifs_flash_erase_blocks Erase consecutive blocks.
+ *
+ * @param[in] a_block_address Address of first block to erase.
+ * @param[in] a_block_count   Number of blocks to erase.
+ * @return PIFS_SUCCESS if blocks were erased successfully.
+ */
+pifs_status_t pifs_flash_erase_blocks(pifs_block_address_t a_block_address, size_t a_block_count);
+
 /**
  * @brief pifs_flash_print_stat Called by the terminal to print information
  * about flash memory.
@@ -22,6 +22,7 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 
 #define PIFS_DEBUG_LEVEL 3
@@ -69,43 +70,297 @@ static pifs_checksum_t pifs_calc_header_checksum(pifs_header_t * a_pifs_header)
 }
 
 /**
- * @brief pifs_flush  Flush cache.
+ * @brief pifs_cache_init Invalidate all pages of page cache.
+ */
+static void pifs_cache_init(void)
+{
+    pifs_size_t i;
+
+    for (i = 0; i < PIFS_CACHE_PAGE_NUM; i++)
+    {
+        pifs.cache[i].address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+        pifs.cache[i].address.page_address = PIFS_PAGE_ADDRESS_INVALID;
+        pifs.cache[i].is_dirty = FALSE;
+        pifs.cache[i].last_used = 0;
+        pifs.cache[i].dirty_seq = 0;
+        memset(pifs.cache[i].buf, 0, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+    }
+    pifs.cache_mru = &pifs.cache[0];
+    pifs.cache_use_cntr = 0;
+    pifs.cache_dirty_cntr = 0;
+#if PIFS_ENABLE_STATISTICS
+    pifs.cache_hit_cntr = 0;
+    pifs.cache_miss_cntr = 0;
+    pifs.cache_write_back_cntr = 0;
+    pifs.flash_read_cntr = 0;
+    pifs.flash_write_cntr = 0;
+    pifs.flash_write_byte_cntr = 0;
+    pifs.flash_erase_cntr = 0;
+    pifs.merge_cntr = 0;
+#endif
+}
+
+/**
+ * @brief pifs_cache_find Find page in the page cache.
+ * Only the ways of the page's set are searched.
+ *
+ * @param[in] a_block_address   Block address of page.
+ * @param[in] a_page_address    Page address of page.
+ * @return Pointer to cached page or NULL if page is not cached.
+ */
+static pifs_cache_page_t * pifs_cache_find(pifs_block_address_t a_block_address,
+                                           pifs_page_address_t a_page_address)
+{
+    pifs_cache_page_t * found = NULL;
+    pifs_cache_page_t * cache_page;
+    pifs_size_t         i;
+
+    /* Consecutive accesses of the same page are the most common */
+    if (pifs.cache_mru->address.block_address == a_block_address
+            && pifs.cache_mru->address.page_address == a_page_address)
+    {
+        found = pifs.cache_mru;
+    }
+    else
+    {
+        cache_page = &pifs.cache[PIFS_CACHE_SET_IDX(a_block_address, a_page_address)
+                                 * PIFS_CACHE_WAY_NUM];
+        for (i = 0; i < PIFS_CACHE_WAY_NUM && !found; i++)
+        {
+            if (cache_page[i].address.block_address == a_block_address
+                    && cache_page[i].address.page_address == a_page_address)
+            {
+                found = &cache_page[i];
+            }
+        }
+    }
+
+    return found;
+}
+
+/**
+ * @brief pifs_flash_read_logical_page Read flash pages of a logical page by
+ * one scatter-gather read.
+ *
+ * @param[in] a_block_address   Block address of page to read.
+ * @param[in] a_page_address    Logical page address of page to read.
+ * @param[out] a_buf            Buffer to fill, size of logical page.
+ * @return PIFS_SUCCESS if data read successfully.
+ */
+static pifs_status_t pifs_flash_read_logical_page(pifs_block_address_t a_block_address,
+                                                  pifs_page_address_t a_page_address,
+                                                  uint8_t * a_buf)
+{
+    pifs_status_t   ret;
+    pifs_flash_sg_t sg[PIFS_FLASH_PAGE_PER_LOGICAL_PAGE];
+    pifs_size_t     i;
+
+    for (i = 0; i < PIFS_FLASH_PAGE_PER_LOGICAL_PAGE; i++)
+    {
+        sg[i].block_address = a_block_address;
+        sg[i].page_address = PIFS_LP2FP(a_page_address) + i;
+        sg[i].page_offset = 0;
+        sg[i].buf = a_buf + i * PIFS_FLASH_PAGE_SIZE_BYTE;
+        sg[i].buf_size = PIFS_FLASH_PAGE_SIZE_BYTE;
+    }
+    ret = pifs_flash_read_sg(sg, PIFS_FLASH_PAGE_PER_LOGICAL_PAGE);
+#if PIFS_ENABLE_STATISTICS
+    pifs.flash_read_cntr += PIFS_FLASH_PAGE_PER_LOGICAL_PAGE;
+#endif
+
+    return ret;
+}
+
+/**
+ * @brief pifs_cache_write_back Write one cached page to the flash memory.
  *
+ * @param[in] a_cache_page  Pointer to cached page.
  * @return PIFS_SUCCESS if data written successfully.
  */
-pifs_status_t pifs_flush(void)
+static pifs_status_t pifs_cache_write_back(pifs_cache_page_t * a_cache_page)
 {
     pifs_status_t ret = PIFS_SUCCESS;
-#if PIFS_LOGICAL_PAGE_ENABLED
-    pifs_size_t   i;
-#endif
 
-    if (pifs.cache_page_buf_is_dirty)
+    /* Flash pages of logical page are programmed by one burst */
+    ret = pifs_flash_write_pages(a_cache_page->address.block_address,
+                                 PIFS_LP2FP(a_cache_page->address.page_address),
+                                 a_cache_page->buf, PIFS_FLASH_PAGE_PER_LOGICAL_PAGE);
+#if PIFS_ENABLE_STATISTICS
+    pifs.flash_write_cntr += PIFS_FLASH_PAGE_PER_LOGICAL_PAGE;
+    pifs.flash_write_byte_cntr += PIFS_LOGICAL_PAGE_SIZE_BYTE;
+#endif
+    if (ret == PIFS_SUCCESS)
     {
-#if PIFS_LOGICAL_PAGE_ENABLED
-        for (i = 0; i < PIFS_FLASH_PAGE_PER_LOGICAL_PAGE && ret == PIFS_SUCCESS; i++)
+        a_cache_page->is_dirty = FALSE;
+#if PIFS_ENABLE_STATISTICS
+        pifs.cache_write_back_cntr++;
 #endif
+    }
+    else
+    {
+        PIFS_ERROR_MSG("Cannot flush buffer %s\r\n",
+                       pifs_address2str(&a_cache_page->address));
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_cache_write_back_older Write back dirty pages in the order they
+ * became dirty. Pages which became dirty later than a_dirty_age are kept
+ * in the cache.
+ *
+ * @param[in] a_dirty_age   Minimum age of dirty pages to write back.
+ *                          0: write back all dirty pages.
+ * @param[in] a_is_data_only TRUE: only pages of data blocks are written back.
+ * @return PIFS_SUCCESS if data written successfully.
+ */
+static pifs_status_t pifs_cache_write_back_older(uint32_t a_dirty_age, bool_t a_is_data_only)
+{
+    pifs_status_t       ret = PIFS_SUCCESS;
+    pifs_cache_page_t * oldest;
+    uint32_t            oldest_age;
+    uint32_t            age;
+    pifs_size_t         i;
+
+    do
+    {
+        oldest = NULL;
+        oldest_age = 0;
+        for (i = 0; i < PIFS_CACHE_PAGE_NUM; i++)
         {
-            ret = pifs_flash_write(pifs.cache_page_buf_address.block_address,
-                                   PIFS_LP2FP(pifs.cache_page_buf_address.page_address) + PIFS_LOGICAL_PAGE_IDX(i),
-                                   0,
-                                   pifs.cache_page_buf + PIFS_LOGICAL_PAGE_IDX(i * PIFS_FLASH_PAGE_SIZE_BYTE),
-                                   PIFS_FLASH_PAGE_SIZE_BYTE);
-            if (ret == PIFS_SUCCESS)
-            {
-                pifs.cache_page_buf_is_dirty = FALSE;
-            }
-            else
+            if (pifs.cache[i].is_dirty
+                    && (!a_is_data_only
+                        || pifs_is_block_type(pifs.cache[i].address.block_address,
+                                              PIFS_BLOCK_TYPE_DATA, &pifs.header)))
             {
-                PIFS_ERROR_MSG("Cannot flush buffer %s\r\n",
-                               pifs_address2str(&pifs.cache_page_buf_address));
+                age = pifs.cache_dirty_cntr - pifs.cache[i].dirty_seq;
+                if (age >= a_dirty_age && (!oldest || age > oldest_age))
+                {
+                    oldest = &pifs.cache[i];
+                    oldest_age = age;
+                }
             }
         }
+        if (oldest)
+        {
+            ret = pifs_cache_write_back(oldest);
+        }
+    } while (oldest && ret == PIFS_SUCCESS);
+
+    return ret;
+}
+
+/**
+ * @brief pifs_cache_alloc Get a page of cache for a not cached page.
+ * Least recently used way of the set is selected. If it is dirty, it and every
+ * page which became dirty before it are written back first.
+ *
+ * @param[in] a_block_address   Block address of page to cache.
+ * @param[in] a_page_address    Page address of page to cache.
+ * @param[out] a_cache_page     Pointer to the allocated page of cache.
+ * @return PIFS_SUCCESS if cache page is available.
+ */
+static pifs_status_t pifs_cache_alloc(pifs_block_address_t a_block_address,
+                                      pifs_page_address_t a_page_address,
+                                      pifs_cache_page_t ** a_cache_page)
+{
+    pifs_status_t       ret = PIFS_SUCCESS;
+    pifs_cache_page_t * cache_page = &pifs.cache[PIFS_CACHE_SET_IDX(a_block_address, a_page_address)
+                                                 * PIFS_CACHE_WAY_NUM];
+    pifs_cache_page_t * victim = &cache_page[0];
+    pifs_size_t         i;
+
+    for (i = 0; i < PIFS_CACHE_WAY_NUM; i++)
+    {
+        if (cache_page[i].address.block_address == PIFS_BLOCK_ADDRESS_INVALID)
+        {
+            /* Unused way, no need to look further */
+            victim = &cache_page[i];
+            break;
+        }
+        if ((pifs.cache_use_cntr - cache_page[i].last_used)
+                > (pifs.cache_use_cntr - victim->last_used))
+        {
+            victim = &cache_page[i];
+        }
+    }
+
+    if (victim->is_dirty)
+    {
+#if PIFS_ENABLE_FSBM_BATCH
+        if (pifs.fsbm_batch_cntr
+                && pifs_is_block_type(victim->address.block_address, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+        {
+            /* Data page is not referenced until the batch is finished, */
+            /* so it is written back without management pages */
+            ret = pifs_cache_write_back_older(pifs.cache_dirty_cntr - victim->dirty_seq, TRUE);
+        }
+        else
+#endif
+        {
+            ret = pifs_cache_write_back_older(pifs.cache_dirty_cntr - victim->dirty_seq, FALSE);
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Address will be set when page's content is valid */
+        victim->address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+        victim->address.page_address = PIFS_PAGE_ADDRESS_INVALID;
+        *a_cache_page = victim;
     }
 
     return ret;
 }
 
+/**
+ * @brief pifs_cache_touch Update LRU information of a cached page.
+ *
+ * @param[in] a_cache_page  Pointer to cached page.
+ * @param[in] a_is_dirty    TRUE: page was changed.
+ */
+static void pifs_cache_touch(pifs_cache_page_t * a_cache_page, bool_t a_is_dirty)
+{
+    if (a_cache_page != pifs.cache_mru)
+    {
+        a_cache_page->last_used = ++pifs.cache_use_cntr;
+        pifs.cache_mru = a_cache_page;
+    }
+    if (a_is_dirty && !a_cache_page->is_dirty)
+    {
+        a_cache_page->is_dirty = TRUE;
+        a_cache_page->dirty_seq = ++pifs.cache_dirty_cntr;
+    }
+}
+
+/**
+ * @brief pifs_get_cache_page_buf Get buffer of a cached page.
+ * It shall be called right after pifs_read() or pifs_write(), when the
+ * page is surely in the cache.
+ *
+ * @param[in] a_block_address   Block address of page.
+ * @param[in] a_page_address    Page address of page.
+ * @return Pointer to the page's buffer or NULL if page is not cached.
+ */
+uint8_t * pifs_get_cache_page_buf(pifs_block_address_t a_block_address,
+                                  pifs_page_address_t a_page_address)
+{
+    pifs_cache_page_t * cache_page = pifs_cache_find(a_block_address, a_page_address);
+
+    return cache_page ? cache_page->buf : NULL;
+}
+
+/**
+ * @brief pifs_flush  Flush cache.
+ * Dirty pages are written in the same order as they were changed.
+ *
+ * @return PIFS_SUCCESS if data written successfully.
+ */
+pifs_status_t pifs_flush(void)
+{
+    return pifs_cache_write_back_older(0, FALSE);
+}
+
 /**
  * @brief pifs_read  Cached read.
  *
@@ -113,7 +368,7 @@ pifs_status_t pifs_flush(void)
  * @param[in] a_page_address    Page address of page to read.
  * @param[in] a_page_offset     Offset in page.
  * @param[out] a_buf            Pointer to buffer to fill or NULL if
- *                              pifs.cache_page_buf is used.
+ *                              cached page is used (@see pifs_get_cache_page_buf).
  * @param[in] a_buf_size        Size of buffer. Ignored if a_buf is NULL.
  * @return PIFS_SUCCESS if data read successfully.
  */
@@ -123,53 +378,106 @@ pifs_status_t pifs_read(pifs_block_address_t a_block_address,
                         void * const a_buf,
                         pifs_size_t a_buf_size)
 {
-    pifs_status_t ret = PIFS_ERROR_GENERAL;
-#if PIFS_LOGICAL_PAGE_ENABLED
-    pifs_size_t   i;
-#endif
+    pifs_status_t       ret = PIFS_SUCCESS;
+    pifs_cache_page_t * cache_page;
 
-    if (a_block_address == pifs.cache_page_buf_address.block_address
-            && a_page_address == pifs.cache_page_buf_address.page_address)
+    cache_page = pifs_cache_find(a_block_address, a_page_address);
+    if (cache_page)
     {
         /* Cache hit */
-        if (a_buf)
-        {
-            memcpy(a_buf, &pifs.cache_page_buf[a_page_offset], a_buf_size);
-        }
-        ret = PIFS_SUCCESS;
+#if PIFS_ENABLE_STATISTICS
+        pifs.cache_hit_cntr++;
+#endif
     }
     else
     {
-        /* Cache miss, first flush cache */
-        ret = pifs_flush();
+        /* Cache miss, get a free page of cache */
+#if PIFS_ENABLE_STATISTICS
+        pifs.cache_miss_cntr++;
+#endif
+        ret = pifs_cache_alloc(a_block_address, a_page_address, &cache_page);
 
         if (ret == PIFS_SUCCESS)
         {
-#if PIFS_LOGICAL_PAGE_ENABLED
-            for (i = 0; i < PIFS_FLASH_PAGE_PER_LOGICAL_PAGE && ret == PIFS_SUCCESS; i++)
-#endif
-            {
-                ret = pifs_flash_read(a_block_address,
-                                      PIFS_LP2FP(a_page_address) + PIFS_LOGICAL_PAGE_IDX(i),
-                                      0,
-                                      pifs.cache_page_buf + PIFS_LOGICAL_PAGE_IDX(i * PIFS_FLASH_PAGE_SIZE_BYTE),
-                                      PIFS_FLASH_PAGE_SIZE_BYTE);
-            }
+            ret = pifs_flash_read_logical_page(a_block_address, a_page_address, cache_page->buf);
         }
 
         if (ret == PIFS_SUCCESS)
         {
-            if (a_buf)
+            cache_page->address.block_address = a_block_address;
+            cache_page->address.page_address = a_page_address;
+        }
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        if (a_buf)
+        {
+            memcpy(a_buf, &cache_page->buf[a_page_offset], a_buf_size);
+        }
+        pifs_cache_touch(cache_page, FALSE);
+    }
+
+    return ret;
+}
+
+#if PIFS_DIRECT_READ_PAGE_NUM_MAX || PIFS_READ_AHEAD_PAGE_NUM
+/**
+ * @brief pifs_read_direct Read whole logical pages of a block directly to
+ * the buffer, the page cache is bypassed. Consecutive not cached pages are
+ * read by one flash read. Cached pages are copied from the cache, because
+ * they may be newer than the flash memory.
+ *
+ * @param[in] a_block_address   Block address of first page to read.
+ * @param[in] a_page_address    Page address of first page to read.
+ * @param[in] a_page_count      Number of pages to read.
+ * @param[out] a_buf            Pointer to buffer to fill.
+ * @return PIFS_SUCCESS if data read successfully.
+ */
+pifs_status_t pifs_read_direct(pifs_block_address_t a_block_address,
+                               pifs_page_address_t a_page_address,
+                               pifs_page_count_t a_page_count,
+                               void * const a_buf)
+{
+    pifs_status_t       ret = PIFS_SUCCESS;
+    uint8_t           * buf = (uint8_t*) a_buf;
+    pifs_cache_page_t * cache_page;
+    pifs_page_count_t   page_count;
+
+    PIFS_ASSERT(a_page_address + a_page_count <= PIFS_LOGICAL_PAGE_PER_BLOCK);
+    while (a_page_count && ret == PIFS_SUCCESS)
+    {
+        cache_page = pifs_cache_find(a_block_address, a_page_address);
+        if (cache_page)
+        {
+#if PIFS_ENABLE_STATISTICS
+            pifs.cache_hit_cntr++;
+#endif
+            memcpy(buf, cache_page->buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+            page_count = 1;
+        }
+        else
+        {
+            page_count = 1;
+            while (page_count < a_page_count
+                   && !pifs_cache_find(a_block_address, a_page_address + page_count))
             {
-                memcpy(a_buf, &pifs.cache_page_buf[a_page_offset], a_buf_size);
+                page_count++;
             }
-            pifs.cache_page_buf_address.block_address = a_block_address;
-            pifs.cache_page_buf_address.page_address = a_page_address;
+            ret = pifs_flash_read(a_block_address, PIFS_LP2FP(a_page_address), 0,
+                                  buf, page_count * PIFS_LOGICAL_PAGE_SIZE_BYTE);
+#if PIFS_ENABLE_STATISTICS
+            pifs.flash_read_cntr += PIFS_LP2FP(page_count);
+#endif
         }
+        a_page_address += page_count;
+        a_page_count -= page_count;
+        buf += page_count * PIFS_LOGICAL_PAGE_SIZE_BYTE;
     }
 
     return ret;
 }
+#endif
 
 /**
  * @brief pifs_write  Cached write.
@@ -178,7 +486,8 @@ pifs_status_t pifs_read(pifs_block_address_t a_block_address,
  * @param[in] a_page_address    Page address of page to write.
  * @param[in] a_page_offset     Offset in page.
  * @param[in] a_buf             Pointer to buffer to write or NULL if
- *                              pifs.cache_page_buf is directly written.
+ *                              cached page is directly written
+ *                              (@see pifs_get_cache_page_buf).
  * @param[in] a_buf_size        Size of buffer. Ignored if a_buf is NULL.
  * @return PIFS_SUCCESS if data write successfully.
  */
@@ -188,56 +497,133 @@ pifs_status_t pifs_write(pifs_block_address_t a_block_address,
                          const void * const a_buf,
                          pifs_size_t a_buf_size)
 {
-    pifs_status_t ret = PIFS_ERROR_GENERAL;
-#if PIFS_LOGICAL_PAGE_ENABLED
-    pifs_size_t   i;
+    pifs_status_t       ret = PIFS_SUCCESS;
+    pifs_cache_page_t * cache_page;
+    bool_t              is_partial;
+#if PIFS_SKIP_FREE_PAGE_READ
+    bool_t              is_erased = FALSE;
 #endif
 
-    if (a_block_address == pifs.cache_page_buf_address.block_address
-            && a_page_address == pifs.cache_page_buf_address.page_address)
+    cache_page = pifs_cache_find(a_block_address, a_page_address);
+    if (cache_page)
     {
         /* Cache hit */
-        if (a_buf)
-        {
-            memcpy(&pifs.cache_page_buf[a_page_offset], a_buf, a_buf_size);
-        }
-        pifs.cache_page_buf_is_dirty = TRUE;
-        ret = PIFS_SUCCESS;
+#if PIFS_ENABLE_STATISTICS
+        pifs.cache_hit_cntr++;
+#endif
     }
     else
     {
-        /* Cache miss, first flush cache */
-        ret = pifs_flush();
+        /* Cache miss, get a free page of cache */
+#if PIFS_ENABLE_STATISTICS
+        pifs.cache_miss_cntr++;
+#endif
+        is_partial = (a_page_offset != 0 || a_buf_size != PIFS_LOGICAL_PAGE_SIZE_BYTE);
+#if PIFS_SKIP_FREE_PAGE_READ
+        /* Checked before allocation as free space bitmap can be read through the cache */
+        is_erased = is_partial && pifs_is_page_known_erased(a_block_address, a_page_address);
+#endif
+        ret = pifs_cache_alloc(a_block_address, a_page_address, &cache_page);
+
+#if PIFS_SKIP_FREE_PAGE_READ
+        if (ret == PIFS_SUCCESS && is_erased)
+        {
+            memset(cache_page->buf, PIFS_FLASH_ERASED_BYTE_VALUE, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        }
+        else
+#endif
+        if (ret == PIFS_SUCCESS && is_partial)
+        {
+            /* Only part of page is written */
+            ret = pifs_flash_read_logical_page(a_block_address, a_page_address, cache_page->buf);
+        }
 
         if (ret == PIFS_SUCCESS)
         {
-            if (a_page_offset != 0 || a_buf_size != PIFS_LOGICAL_PAGE_SIZE_BYTE)
-            {
-#if PIFS_LOGICAL_PAGE_ENABLED
-                for (i = 0; i < PIFS_FLASH_PAGE_PER_LOGICAL_PAGE && ret == PIFS_SUCCESS; i++)
+            cache_page->address.block_address = a_block_address;
+            cache_page->address.page_address = a_page_address;
+        }
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        if (a_buf)
+        {
+            memcpy(&cache_page->buf[a_page_offset], a_buf, a_buf_size);
+        }
+        pifs_cache_touch(cache_page, TRUE);
+#if PIFS_READ_AHEAD_PAGE_NUM
+        pifs_read_ahead_drop(a_block_address, a_page_address, 1);
 #endif
-                {
-                    /* Only part of page is written */
-                    ret = pifs_flash_read(a_block_address,
-                                          PIFS_LP2FP(a_page_address) + PIFS_LOGICAL_PAGE_IDX(i),
-                                          0,
-                                          pifs.cache_page_buf + PIFS_LOGICAL_PAGE_IDX(i * PIFS_FLASH_PAGE_SIZE_BYTE),
-                                          PIFS_FLASH_PAGE_SIZE_BYTE);
-                }
-            }
+#if PIFS_ENABLE_ERASED_BITMAP
+        pifs_set_page_verified_erased(a_block_address, a_page_address, 1, FALSE);
+#endif
+    }
 
-            if (a_buf)
-            {
-                memcpy(&pifs.cache_page_buf[a_page_offset], a_buf, a_buf_size);
-            }
-            pifs.cache_page_buf_address.block_address = a_block_address;
-            pifs.cache_page_buf_address.page_address = a_page_address;
-            pifs.cache_page_buf_is_dirty = TRUE;
+    return ret;
+}
+
+#if PIFS_DELTA_PATCH_PAGE_NUM
+/**
+ * @brief pifs_write_through Program bytes of a logical page directly, only
+ * the flash pages of the given range are programmed. Cached copy of the
+ * page is updated, but it does not become dirty.
+ * The range shall be erased or contain the same data.
+ *
+ * @param[in] a_block_address   Block address of page to write.
+ * @param[in] a_page_address    Page address of page to write.
+ * @param[in] a_page_offset     Offset in page.
+ * @param[in] a_buf             Pointer to buffer to write.
+ * @param[in] a_buf_size        Size of buffer.
+ * @return PIFS_SUCCESS if data written successfully.
+ */
+pifs_status_t pifs_write_through(pifs_block_address_t a_block_address,
+                                 pifs_page_address_t a_page_address,
+                                 pifs_page_offset_t a_page_offset,
+                                 const void * const a_buf,
+                                 pifs_size_t a_buf_size)
+{
+    pifs_status_t       ret = PIFS_SUCCESS;
+    const uint8_t     * buf = (const uint8_t*) a_buf;
+    pifs_cache_page_t * cache_page;
+    pifs_page_address_t fpa = PIFS_LP2FP(a_page_address) + a_page_offset / PIFS_FLASH_PAGE_SIZE_BYTE;
+    pifs_page_offset_t  fpo = a_page_offset % PIFS_FLASH_PAGE_SIZE_BYTE;
+    pifs_size_t         size = a_buf_size;
+    pifs_size_t         chunk_size;
+
+    PIFS_ASSERT(a_page_offset + a_buf_size <= PIFS_LOGICAL_PAGE_SIZE_BYTE);
+    /* Flash driver can program inside of one flash page */
+    while (size && ret == PIFS_SUCCESS)
+    {
+        chunk_size = PIFS_MIN(size, PIFS_FLASH_PAGE_SIZE_BYTE - fpo);
+        ret = pifs_flash_write(a_block_address, fpa, fpo, buf, chunk_size);
+#if PIFS_ENABLE_STATISTICS
+        pifs.flash_write_cntr++;
+        pifs.flash_write_byte_cntr += chunk_size;
+#endif
+        buf += chunk_size;
+        size -= chunk_size;
+        fpa++;
+        fpo = 0;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        cache_page = pifs_cache_find(a_block_address, a_page_address);
+        if (cache_page)
+        {
+            memcpy(&cache_page->buf[a_page_offset], a_buf, a_buf_size);
         }
+#if PIFS_READ_AHEAD_PAGE_NUM
+        pifs_read_ahead_drop(a_block_address, a_page_address, 1);
+#endif
+#if PIFS_ENABLE_ERASED_BITMAP
+        pifs_set_page_verified_erased(a_block_address, a_page_address, 1, FALSE);
+#endif
     }
 
     return ret;
 }
+#endif
 
 /**
  * @brief pifs_erase  Cached erase.
@@ -248,26 +634,63 @@ pifs_status_t pifs_write(pifs_block_address_t a_block_address,
  * @return PIFS_SUCCESS if data erased successfully.
  */
 pifs_status_t pifs_erase(pifs_block_address_t a_block_address, pifs_header_t * a_old_header, pifs_header_t * a_new_header)
+{
+    return pifs_erase_blocks(a_block_address, 1, a_old_header, a_new_header);
+}
+
+/**
+ * @brief pifs_erase_blocks  Cached erase of consecutive blocks by one
+ * flash operation.
+ *
+ * @param[in] a_block_address   Block address of first block to erase.
+ * @param[in] a_block_count     Number of blocks to erase.
+ * @param[in] a_old_header      Old file system's header.
+ * @param[in] a_new_header      New (not yet used) file system's header.
+ * @return PIFS_SUCCESS if data erased successfully.
+ */
+pifs_status_t pifs_erase_blocks(pifs_block_address_t a_block_address, pifs_size_t a_block_count,
+                                pifs_header_t * a_old_header, pifs_header_t * a_new_header)
 {
     pifs_status_t           ret = PIFS_ERROR_GENERAL;
+    pifs_size_t             i;
 
     (void) a_old_header;
 
-    PIFS_DEBUG_MSG("Erasing block %i\r\n", a_block_address)
-    ret = pifs_flash_erase(a_block_address);
+    PIFS_DEBUG_MSG("Erasing block %i, %i blocks\r\n", a_block_address, a_block_count);
+    ret = pifs_flash_erase_blocks(a_block_address, a_block_count);
+#if PIFS_ENABLE_STATISTICS
+    pifs.flash_erase_cntr += a_block_count;
+#endif
 
-    if (a_block_address == pifs.cache_page_buf_address.block_address)
+    for (i = 0; i < PIFS_CACHE_PAGE_NUM; i++)
     {
-        /* If the block was erased which contains the cached page, simply forget it */
-        pifs.cache_page_buf_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
-        pifs.cache_page_buf_address.page_address = PIFS_PAGE_ADDRESS_INVALID;
-        pifs.cache_page_buf_is_dirty = FALSE;
+        if (pifs.cache[i].address.block_address >= a_block_address
+                && pifs.cache[i].address.block_address < a_block_address + a_block_count)
+        {
+            /* If the block was erased which contains the cached page, simply forget it */
+            pifs.cache[i].address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+            pifs.cache[i].address.page_address = PIFS_PAGE_ADDRESS_INVALID;
+            pifs.cache[i].is_dirty = FALSE;
+        }
     }
 
-    if (ret == PIFS_SUCCESS && a_new_header)
+    for (i = 0; i < a_block_count; i++)
     {
-        /* Increase wear level */
-        ret = pifs_inc_wear_level(a_block_address, a_new_header);
+#if PIFS_READ_AHEAD_PAGE_NUM
+        pifs_read_ahead_drop(a_block_address + i, 0, PIFS_LOGICAL_PAGE_PER_BLOCK);
+#endif
+#if PIFS_ENABLE_ERASED_BITMAP
+        pifs_set_page_verified_erased(a_block_address + i, 0, PIFS_LOGICAL_PAGE_PER_BLOCK,
+                                      ret == PIFS_SUCCESS);
+#endif
+#if PIFS_ENABLE_ALLOC_CURSOR
+        pifs_alloc_cursor_erased(a_block_address + i);
+#endif
+        if (ret == PIFS_SUCCESS && a_new_header)
+        {
+            /* Increase wear level */
+            ret = pifs_inc_wear_level(a_block_address + i, a_new_header);
+        }
     }
 
     return ret;
@@ -315,7 +738,7 @@ pifs_status_t pifs_header_init(pifs_block_address_t a_block_address,
 #if PIFS_ENABLE_CONFIG_IN_FLASH
     /* Flash configuration */
     a_header->flash_block_num_all = PIFS_FLASH_BLOCK_NUM_ALL;
-    a_header->flash_block_reserved_num = PIFS_FLASH_BLOCK_RESERVED_NUM;
+    a_header->flash_block_reserved_num = PIFS_FLASH_BLOCK_FIRST_FS;
     a_header->flash_page_per_block = PIFS_FLASH_PAGE_PER_BLOCK;
     a_header->flash_page_size_byte = PIFS_FLASH_PAGE_SIZE_BYTE;
     /* File system configuration */
@@ -390,6 +813,9 @@ pifs_status_t pifs_header_write(pifs_block_address_t a_block_address,
         pifs.is_header_found = TRUE;
         pifs.header_address.block_address = a_block_address;
         pifs.header_address.page_address = a_page_address;
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+        pifs_block_type_table_init(a_header);
+#endif
         if (a_header->counter == 0)
         {
             /* Initialize wear level list for the very first header */
@@ -398,6 +824,9 @@ pifs_status_t pifs_header_write(pifs_block_address_t a_block_address,
     }
     if (a_mark_pages)
     {
+#if PIFS_ENABLE_FSBM_BATCH
+        pifs_fsbm_batch_begin();
+#endif
         if (ret == PIFS_SUCCESS)
         {
             /* Mark file system header as used */
@@ -436,6 +865,9 @@ pifs_status_t pifs_header_write(pifs_block_address_t a_block_address,
                                  a_header->wear_level_list_address.page_address,
                                  PIFS_WEAR_LEVEL_LIST_SIZE_PAGE, TRUE, FALSE);
         }
+#if PIFS_ENABLE_FSBM_BATCH
+        ret = pifs_fsbm_batch_end(ret, FALSE);
+#endif
     }
     PIFS_INFO_MSG("Counter: %i\r\n",
                   a_header->counter);
@@ -471,6 +903,379 @@ pifs_status_t pifs_header_write(pifs_block_address_t a_block_address,
     return ret;
 }
 
+/**
+ * @brief pifs_is_header_config_valid Check if flash and file system
+ * configuration stored in the header matches to the actual one.
+ *
+ * @param[in] a_header Pointer to the header.
+ * @return TRUE: configuration is valid.
+ */
+static bool_t pifs_is_header_config_valid(pifs_header_t * a_header)
+{
+    bool_t is_valid = TRUE;
+
+#if PIFS_ENABLE_CONFIG_IN_FLASH
+    is_valid = a_header->flash_block_num_all == PIFS_FLASH_BLOCK_NUM_ALL
+            && a_header->flash_block_reserved_num == PIFS_FLASH_BLOCK_FIRST_FS
+            && a_header->flash_page_per_block == PIFS_FLASH_PAGE_PER_BLOCK
+            && a_header->flash_page_size_byte == PIFS_FLASH_PAGE_SIZE_BYTE
+            && a_header->logical_page_size_byte == PIFS_LOGICAL_PAGE_SIZE_BYTE
+            && a_header->filename_len_max == PIFS_FILENAME_LEN_MAX
+            && a_header->entry_num_max == PIFS_ENTRY_NUM_MAX
+            && a_header->user_data_size_byte == PIFS_USER_DATA_SIZE_BYTE
+            && a_header->management_block_num == PIFS_MANAGEMENT_BLOCK_NUM
+            && a_header->least_weared_block_num == PIFS_LEAST_WEARED_BLOCK_NUM
+            && a_header->most_weared_block_num == PIFS_MOST_WEARED_BLOCK_NUM
+            && a_header->delta_map_page_num == PIFS_DELTA_MAP_PAGE_NUM
+            && a_header->map_page_count_size == PIFS_MAP_PAGE_COUNT_SIZE
+            && a_header->use_delta_for_entries == PIFS_USE_DELTA_FOR_ENTRIES
+            && a_header->enable_directories == PIFS_ENABLE_DIRECTORIES
+            && a_header->enable_crc == PIFS_ENABLE_CRC;
+#else
+    (void) a_header;
+#endif
+
+    return is_valid;
+}
+
+#if PIFS_ENABLE_MOUNT_HINT
+/**
+ * @brief pifs_is_header_valid Check magic, version, checksum and configuration
+ * of a header.
+ *
+ * @param[in] a_header Pointer to the header.
+ * @return TRUE: header is valid.
+ */
+static bool_t pifs_is_header_valid(pifs_header_t * a_header)
+{
+    return a_header->magic == PIFS_MAGIC
+#if PIFS_ENABLE_VERSION
+            && a_header->majorVersion == PIFS_MAJOR_VERSION
+            && a_header->minorVersion == PIFS_MINOR_VERSION
+#endif
+            && a_header->checksum == pifs_calc_header_checksum(a_header)
+            && pifs_is_header_config_valid(a_header);
+}
+
+/**
+ * @brief pifs_calc_mount_hint_checksum Calculate checksum of mount hint.
+ *
+ * @param[in] a_hint Pointer to the mount hint.
+ * @return The calculated checksum.
+ */
+static pifs_checksum_t pifs_calc_mount_hint_checksum(pifs_mount_hint_t * a_hint)
+{
+    pifs_checksum_t checksum;
+
+    checksum = pifs_calc_checksum(a_hint, offsetof(pifs_mount_hint_t, checksum));
+
+    return checksum;
+}
+
+/**
+ * @brief pifs_is_mount_hint_valid Check magic and checksum of a mount hint.
+ *
+ * @param[in] a_hint Pointer to the mount hint.
+ * @return TRUE: mount hint is valid.
+ */
+static bool_t pifs_is_mount_hint_valid(pifs_mount_hint_t * a_hint)
+{
+    return a_hint->magic == PIFS_MAGIC
+            && a_hint->checksum == pifs_calc_mount_hint_checksum(a_hint);
+}
+
+/**
+ * @brief pifs_mount_hint_address Calculate flash address of a mount hint.
+ *
+ * @param[in] a_hint_idx        Index of mount hint in mount hint blocks.
+ * @param[out] a_block_address  Block address.
+ * @param[out] a_page_address   Flash page address.
+ * @param[out] a_page_offset    Offset of mount hint in flash page.
+ */
+static void pifs_mount_hint_address(pifs_size_t a_hint_idx,
+                                    pifs_block_address_t * a_block_address,
+                                    pifs_page_address_t * a_page_address,
+                                    pifs_page_offset_t * a_page_offset)
+{
+    *a_block_address = PIFS_MOUNT_HINT_BLOCK_ADDRESS + a_hint_idx / PIFS_MOUNT_HINT_PER_BLOCK;
+    *a_page_address = (a_hint_idx % PIFS_MOUNT_HINT_PER_BLOCK) / PIFS_MOUNT_HINT_PER_PAGE;
+    *a_page_offset = (a_hint_idx % PIFS_MOUNT_HINT_PER_PAGE) * PIFS_MOUNT_HINT_SIZE_BYTE;
+}
+
+/**
+ * @brief pifs_mount_hint_read_idx Read a mount hint from flash memory.
+ *
+ * @param[in] a_hint_idx Index of mount hint in mount hint blocks.
+ * @param[out] a_hint    Mount hint read.
+ * @return PIFS_SUCCESS if flash memory was read successfully.
+ */
+static pifs_status_t pifs_mount_hint_read_idx(pifs_size_t a_hint_idx, pifs_mount_hint_t * a_hint)
+{
+    pifs_status_t        ret;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_offset_t   po;
+
+    pifs_mount_hint_address(a_hint_idx, &ba, &pa, &po);
+    ret = pifs_flash_read(ba, pa, po, a_hint, sizeof(pifs_mount_hint_t));
+#if PIFS_ENABLE_STATISTICS
+    pifs.flash_read_cntr++;
+#endif
+
+    return ret;
+}
+
+/**
+ * @brief pifs_mount_hint_find Find the latest mount hint. Mount hint blocks
+ * are filled one after the other, so the latest hint is in the block whose
+ * first hint has the greatest sequence number. Hints are written one after
+ * the other in a block, so binary search is used to find the first erased
+ * hint in it. Partially written hints are not erased.
+ *
+ * @param[out] a_hint_idx   Index of the first erased hint after the latest
+ *                          hint. 0 if there is no valid hint.
+ * @param[out] a_sequence   Sequence number of first hint of the block.
+ * @return PIFS_SUCCESS if flash memory was read successfully.
+ */
+static pifs_status_t pifs_mount_hint_find(pifs_size_t * a_hint_idx, uint32_t * a_sequence)
+{
+    pifs_status_t     ret = PIFS_SUCCESS;
+    pifs_size_t       low = 0;
+    pifs_size_t       high = 0;
+    pifs_size_t       middle;
+    pifs_size_t       i;
+    bool_t            is_found = FALSE;
+    pifs_mount_hint_t hint;
+
+    *a_sequence = 0;
+    for (i = 0; i < PIFS_MOUNT_HINT_BLOCK_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_mount_hint_read_idx(i * PIFS_MOUNT_HINT_PER_BLOCK, &hint);
+        if (ret == PIFS_SUCCESS && pifs_is_mount_hint_valid(&hint)
+                && (!is_found || (int32_t)(hint.sequence - *a_sequence) > 0))
+        {
+            is_found = TRUE;
+            *a_sequence = hint.sequence;
+            /* First hint of the block is written */
+            low = i * PIFS_MOUNT_HINT_PER_BLOCK + 1;
+            high = (i + 1) * PIFS_MOUNT_HINT_PER_BLOCK;
+        }
+    }
+    while (low < high && ret == PIFS_SUCCESS)
+    {
+        middle = (low + high) / 2;
+        ret = pifs_mount_hint_read_idx(middle, &hint);
+        if (pifs_is_buffer_erased(&hint, sizeof(hint)))
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+    *a_hint_idx = low;
+
+    return ret;
+}
+
+/**
+ * @brief pifs_mount_hint_read Find file system's header by the latest mount
+ * hint. The hint is stale if the header was moved after it was written.
+ *
+ * @param[out] a_header Header found.
+ * @param[out] a_hint   Latest mount hint.
+ * @return TRUE: header found by hint. FALSE: blocks shall be scanned.
+ */
+static bool_t pifs_mount_hint_read(pifs_header_t * a_header, pifs_mount_hint_t * a_hint)
+{
+    pifs_status_t        ret;
+    bool_t               is_found = FALSE;
+    pifs_block_address_t ba;
+    pifs_header_t        next_header;
+    pifs_size_t          i;
+    pifs_mount_hint_t    hint;
+    bool_t               is_valid;
+
+    pifs.is_mount_hint_clean = FALSE;
+    ret = pifs_mount_hint_find(&pifs.mount_hint_idx, &pifs.mount_hint_sequence);
+    if (ret == PIFS_SUCCESS && pifs.mount_hint_idx > 0)
+    {
+        ret = pifs_mount_hint_read_idx(pifs.mount_hint_idx - 1, a_hint);
+        ba = a_hint->header_address.block_address;
+        if (ret == PIFS_SUCCESS && !pifs_is_mount_hint_valid(a_hint))
+        {
+            /* Latest hint is torn, sequence of next hint shall be greater */
+            /* than the sequence of the latest valid hint of the block */
+            is_valid = FALSE;
+            for (i = pifs.mount_hint_idx - 1; i % PIFS_MOUNT_HINT_PER_BLOCK && !is_valid && ret == PIFS_SUCCESS; i--)
+            {
+                ret = pifs_mount_hint_read_idx(i - 1, &hint);
+                is_valid = (ret == PIFS_SUCCESS && pifs_is_mount_hint_valid(&hint));
+                if (is_valid)
+                {
+                    pifs.mount_hint_sequence = hint.sequence;
+                }
+            }
+        }
+        else if (ret == PIFS_SUCCESS)
+        {
+            pifs.mount_hint_sequence = a_hint->sequence;
+            if (ba >= PIFS_FLASH_BLOCK_FIRST_FS && ba < PIFS_FLASH_BLOCK_NUM_ALL
+                    && a_hint->header_address.page_address < PIFS_LOGICAL_PAGE_PER_BLOCK)
+            {
+                ret = pifs_read(ba, a_hint->header_address.page_address, 0, a_header, sizeof(pifs_header_t));
+                is_found = (ret == PIFS_SUCCESS && pifs_is_header_valid(a_header)
+                            && a_header->counter == a_hint->counter);
+            }
+        }
+    }
+    if (is_found)
+    {
+        /* New header is written to the next management block by merge. */
+        /* If it is valid, the hint was not written or merge was interrupted. */
+        ba = a_header->next_management_block_address;
+        if (ba >= PIFS_FLASH_BLOCK_FIRST_FS && ba < PIFS_FLASH_BLOCK_NUM_ALL)
+        {
+            ret = pifs_read(ba, 0, 0, &next_header, sizeof(next_header));
+            is_found = (ret == PIFS_SUCCESS && !pifs_is_header_valid(&next_header));
+        }
+    }
+    if (is_found)
+    {
+        PIFS_NOTICE_MSG("Header found by mount hint at %s\r\n",
+                        pifs_address2str(&a_hint->header_address));
+#if PIFS_ENABLE_PAGE_CNTR
+        pifs.is_mount_hint_clean = (a_hint->dirty == PIFS_MOUNT_HINT_CLEAN);
+#endif
+    }
+    else
+    {
+        PIFS_NOTICE_MSG("No valid mount hint, scanning blocks...\r\n");
+    }
+
+    return is_found;
+}
+
+/**
+ * @brief pifs_mount_hint_write Write address of actual header and page
+ * counters after the latest mount hint. Several hints are stored in a flash
+ * page. Mount hint blocks are used in rotation: the next block is erased
+ * when a block is full, so the latest hint is always kept in flash memory.
+ *
+ * @param[in] a_is_clean TRUE: page counters are valid until free space bitmap
+ *                       is changed. FALSE: only address of header is valid.
+ * @return PIFS_SUCCESS if hint was written successfully.
+ */
+pifs_status_t pifs_mount_hint_write(bool_t a_is_clean)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_mount_hint_t    hint;
+    pifs_mount_hint_t    old_hint;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_offset_t   po;
+    bool_t               is_erased = FALSE;
+
+    memset(&hint, PIFS_FLASH_ERASED_BYTE_VALUE, sizeof(hint));
+    hint.magic = PIFS_MAGIC;
+    hint.sequence = pifs.mount_hint_sequence + 1;
+    hint.counter = pifs.header.counter;
+    hint.header_address = pifs.header_address;
+#if PIFS_ENABLE_PAGE_CNTR
+    hint.free_management_page_cntr = pifs.free_management_page_cntr;
+    hint.free_data_page_cntr = pifs.free_data_page_cntr;
+    hint.to_be_released_management_page_cntr = pifs.to_be_released_management_page_cntr;
+    hint.to_be_released_data_page_cntr = pifs.to_be_released_data_page_cntr;
+#endif
+    hint.checksum = pifs_calc_mount_hint_checksum(&hint);
+    hint.dirty = PIFS_MOUNT_HINT_DIRTY;
+#if PIFS_ENABLE_PAGE_CNTR
+    if (a_is_clean && pifs.is_page_cntr_valid)
+    {
+        hint.dirty = PIFS_MOUNT_HINT_CLEAN;
+    }
+#else
+    (void) a_is_clean;
+#endif
+
+    while (ret == PIFS_SUCCESS && !is_erased)
+    {
+        if (pifs.mount_hint_idx >= PIFS_MOUNT_HINT_NUM)
+        {
+            pifs.mount_hint_idx = 0;
+        }
+        pifs_mount_hint_address(pifs.mount_hint_idx, &ba, &pa, &po);
+        if (pifs.mount_hint_idx % PIFS_MOUNT_HINT_PER_BLOCK == 0)
+        {
+            /* Previous block keeps the latest hint until this one is written */
+            PIFS_NOTICE_MSG("Erasing mount hint block %i\r\n", ba);
+            ret = pifs_flash_erase(ba);
+#if PIFS_ENABLE_STATISTICS
+            pifs.flash_erase_cntr++;
+#endif
+            is_erased = TRUE;
+        }
+        else
+        {
+            /* Hint may be partially written if power was lost */
+            ret = pifs_mount_hint_read_idx(pifs.mount_hint_idx, &old_hint);
+            is_erased = pifs_is_buffer_erased(&old_hint, sizeof(old_hint));
+            if (!is_erased)
+            {
+                pifs.mount_hint_idx++;
+            }
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_flash_write(ba, pa, po, &hint, sizeof(hint));
+#if PIFS_ENABLE_STATISTICS
+        pifs.flash_write_cntr++;
+        pifs.flash_write_byte_cntr += sizeof(hint);
+#endif
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        pifs.mount_hint_idx++;
+        pifs.mount_hint_sequence = hint.sequence;
+        pifs.is_mount_hint_clean = (hint.dirty == PIFS_MOUNT_HINT_CLEAN);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_mount_hint_set_dirty Invalidate page counters of the latest
+ * mount hint. It shall be called before free space bitmap is changed.
+ *
+ * @return PIFS_SUCCESS if hint was programmed successfully.
+ */
+pifs_status_t pifs_mount_hint_set_dirty(void)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    uint8_t              dirty = PIFS_MOUNT_HINT_DIRTY;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_offset_t   po;
+
+    if (pifs.is_mount_hint_clean)
+    {
+        pifs.is_mount_hint_clean = FALSE;
+        /* Clean hint was written, so it is not the first one of the first block */
+        pifs_mount_hint_address(pifs.mount_hint_idx - 1, &ba, &pa, &po);
+        ret = pifs_flash_write(ba, pa, po + offsetof(pifs_mount_hint_t, dirty),
+                               &dirty, sizeof(dirty));
+#if PIFS_ENABLE_STATISTICS
+        pifs.flash_write_cntr++;
+        pifs.flash_write_byte_cntr += sizeof(dirty);
+#endif
+    }
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_fs_info Print information about flash memory and filesystem.
  */
@@ -505,6 +1310,17 @@ void pifs_print_fs_info(void)
     PIFS_PRINT_MSG("Number of delta entries/page:       %lu\r\n", PIFS_DELTA_ENTRY_PER_PAGE);
     PIFS_PRINT_MSG("Number of delta entries:            %lu\r\n", PIFS_DELTA_ENTRY_PER_PAGE * PIFS_DELTA_MAP_PAGE_NUM);
     PIFS_PRINT_MSG("Delta map size:                     %u bytes, %u logical pages\r\n", PIFS_DELTA_MAP_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_DELTA_MAP_PAGE_NUM);
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    PIFS_PRINT_MSG("Chained delta map pages:            %u logical pages at most\r\n", PIFS_DELTA_MAP_EXT_PAGE_NUM);
+#endif
+#if PIFS_DELTA_FILTER_PAGE_NUM
+    PIFS_PRINT_MSG("Delta presence filter size:         %u bytes, %u logical pages/bit\r\n",
+                   PIFS_DELTA_FILTER_WORD_NUM * 4u, PIFS_DELTA_FILTER_PAGE_NUM);
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+    PIFS_PRINT_MSG("Patch pages:                        %u logical pages at most, %u bytes/patch\r\n",
+                   PIFS_DELTA_PATCH_PAGE_NUM, PIFS_DELTA_PATCH_SIZE_MAX);
+#endif
     PIFS_PRINT_MSG("Wear level entry size:              %lu bytes\r\n", PIFS_WEAR_LEVEL_ENTRY_SIZE_BYTE);
     PIFS_PRINT_MSG("Number of wear level entries/page:  %lu\r\n", PIFS_WEAR_LEVEL_ENTRY_PER_PAGE);
     PIFS_PRINT_MSG("Number of wear level entries:       %lu\r\n", PIFS_FLASH_BLOCK_NUM_FS);
@@ -589,6 +1405,29 @@ void pifs_print_free_space_info(void)
 }
 
 
+#if PIFS_ENABLE_STATISTICS
+/**
+ * @brief pifs_print_cache_info Print statistics of page cache.
+ */
+void pifs_print_cache_info(void)
+{
+    uint32_t access_cntr = pifs.cache_hit_cntr + pifs.cache_miss_cntr;
+
+    PIFS_PRINT_MSG("Cache pages:                        %u, %u way(s), %u set(s)\r\n",
+                   PIFS_CACHE_PAGE_NUM, PIFS_CACHE_WAY_NUM, PIFS_CACHE_SET_NUM);
+    PIFS_PRINT_MSG("Cache hits:                         %lu\r\n", (unsigned long) pifs.cache_hit_cntr);
+    PIFS_PRINT_MSG("Cache misses:                       %lu\r\n", (unsigned long) pifs.cache_miss_cntr);
+    PIFS_PRINT_MSG("Cache hit ratio:                    %lu%%\r\n",
+                   access_cntr ? (unsigned long) (100ull * pifs.cache_hit_cntr / access_cntr) : 0ul);
+    PIFS_PRINT_MSG("Pages written back:                 %lu\r\n", (unsigned long) pifs.cache_write_back_cntr);
+    PIFS_PRINT_MSG("Flash pages read:                   %lu\r\n", (unsigned long) pifs.flash_read_cntr);
+    PIFS_PRINT_MSG("Flash pages programmed:             %lu\r\n", (unsigned long) pifs.flash_write_cntr);
+    PIFS_PRINT_MSG("Flash bytes programmed:             %lu\r\n", (unsigned long) pifs.flash_write_byte_cntr);
+    PIFS_PRINT_MSG("Flash blocks erased:                %lu\r\n", (unsigned long) pifs.flash_erase_cntr);
+    PIFS_PRINT_MSG("Merges:                             %lu\r\n", (unsigned long) pifs.merge_cntr);
+}
+#endif
+
 /**
  * @brief pifs_init Initialize flash driver and file system.
  *
@@ -604,6 +1443,10 @@ pifs_status_t pifs_init(void)
     pifs_checksum_t      checksum;
     pifs_size_t          i;
     uint8_t              retry_cntr = 5;
+    bool_t               is_mount_hint_found = FALSE;
+#if PIFS_ENABLE_MOUNT_HINT
+    pifs_mount_hint_t    hint;
+#endif
 
 #if PIFS_ENABLE_OS
     pifs_mutex = PIFS_OS_CREATE_MUTEX(pifs_mutex);
@@ -618,10 +1461,41 @@ pifs_status_t pifs_init(void)
     pifs.is_merging = FALSE;
     pifs.is_wear_leveling = FALSE;
     memset(&pifs.header, 0, PIFS_HEADER_SIZE_BYTE);
-    memset(pifs.cache_page_buf, 0, PIFS_LOGICAL_PAGE_SIZE_BYTE);
-    pifs.cache_page_buf_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
-    pifs.cache_page_buf_address.page_address = PIFS_PAGE_ADDRESS_INVALID;
-    pifs.cache_page_buf_is_dirty = FALSE;
+    pifs_cache_init();
+#if PIFS_ENABLE_FSBM_IN_RAM
+    pifs.is_fsbm_ram_valid = FALSE;
+#endif
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+    pifs.is_page_reserved_by_write = FALSE;
+#endif
+#if PIFS_ENABLE_PAGE_CNTR
+    pifs.is_page_cntr_valid = FALSE;
+#endif
+#if PIFS_ENABLE_MOUNT_HINT
+    pifs.mount_hint_idx = 0;
+    pifs.mount_hint_sequence = 0;
+    pifs.is_mount_hint_clean = FALSE;
+    pifs.is_fsbm_deferred = FALSE;
+#endif
+#if PIFS_ENABLE_FSBM_BATCH
+    pifs.fsbm_batch_cntr = 0;
+#endif
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    pifs_entry_index_reset();
+#endif
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+    pifs_merge_pre_erase_reset();
+#endif
+#if PIFS_ENABLE_ALLOC_CURSOR
+    pifs_alloc_cursor_reset();
+#endif
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+    pifs.block_type_table_mgmt_ba = PIFS_BLOCK_ADDRESS_INVALID;
+    pifs.block_type_table_next_mgmt_ba = PIFS_BLOCK_ADDRESS_INVALID;
+#endif
+#if PIFS_ENABLE_ERASED_BITMAP
+    memset(pifs.erased_bitmap, 0, sizeof(pifs.erased_bitmap));
+#endif
     memset(pifs.file, 0, sizeof(pifs.file));
     memset(&pifs.internal_file, 0, sizeof(pifs.internal_file));
     memset(pifs.dir, 0, sizeof(pifs.dir));
@@ -666,6 +1540,26 @@ pifs_status_t pifs_init(void)
         ret = PIFS_ERROR_CONFIGURATION;
     }
 
+#if PIFS_ENABLE_DELTA_INDEX
+    if (PIFS_DELTA_ENTRY_NUM >= PIFS_DELTA_INDEX_EMPTY)
+    {
+        PIFS_ERROR_MSG("Delta map has too many entries (%lu) for delta index!\r\n"
+                       "Decrease PIFS_DELTA_MAP_PAGE_NUM, PIFS_DELTA_MAP_EXT_PAGE_NUM or disable PIFS_ENABLE_DELTA_INDEX!\r\n",
+                       PIFS_DELTA_ENTRY_NUM);
+        ret = PIFS_ERROR_CONFIGURATION;
+    }
+#endif
+
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    if (PIFS_ENTRY_LIST_ENTRY_NUM >= PIFS_ENTRY_INDEX_DELETED)
+    {
+        PIFS_ERROR_MSG("Entry list has too many entries (%lu) for entry index!\r\n"
+                       "Decrease PIFS_ENTRY_NUM_MAX or set PIFS_ENTRY_INDEX_LIST_NUM to 0!\r\n",
+                       PIFS_ENTRY_LIST_ENTRY_NUM);
+        ret = PIFS_ERROR_CONFIGURATION;
+    }
+#endif
+
     if (PIFS_MANAGEMENT_BLOCK_NUM_MIN > PIFS_MANAGEMENT_BLOCK_NUM)
     {
         PIFS_ERROR_MSG("Cannot fit data in management block!\r\n");
@@ -701,8 +1595,18 @@ pifs_status_t pifs_init(void)
 
     if (ret == PIFS_SUCCESS)
     {
-        /* Find latest management block */
-        for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM; ba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS; ba++)
+#if PIFS_ENABLE_MOUNT_HINT
+        is_mount_hint_found = pifs_mount_hint_read(&prev_header, &hint);
+        if (is_mount_hint_found)
+        {
+            pifs.is_header_found = TRUE;
+            pifs.header_address = hint.header_address;
+        }
+#endif
+        /* Find latest management block, if mount hint is not valid */
+        for (ba = PIFS_FLASH_BLOCK_FIRST_FS;
+             ba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS && !is_mount_hint_found;
+             ba++)
         {
             pa = 0;
             ret = pifs_read(ba, pa, 0, &header, sizeof(header));
@@ -723,10 +1627,8 @@ pifs_status_t pifs_init(void)
                         PIFS_WARNING_MSG("Previous management page was not erased! Erasing...\r\n");
                         /* This can happen when pifs_merge() was interrupted before step #11 */
                         /* Erase old management area */
-                        for (i = 0; i < PIFS_MANAGEMENT_BLOCK_NUM && ret == PIFS_SUCCESS; i++)
-                        {
-                            ret = pifs_erase(prev_header.management_block_address + i, &prev_header, &header);
-                        }
+                        ret = pifs_erase_blocks(prev_header.management_block_address, PIFS_MANAGEMENT_BLOCK_NUM,
+                                                &prev_header, &header);
                         if (ret == PIFS_SUCCESS)
                         {
                             PIFS_WARNING_MSG("Done.\r\n");
@@ -734,37 +1636,18 @@ pifs_status_t pifs_init(void)
                     }
                     if (!pifs.is_header_found || prev_header.counter < pifs.header.counter)
                     {
-#if PIFS_ENABLE_CONFIG_IN_FLASH
                         /* Check flash and file system configuration */
-                        if (header.flash_block_num_all == PIFS_FLASH_BLOCK_NUM_ALL
-                                && header.flash_block_reserved_num == PIFS_FLASH_BLOCK_RESERVED_NUM
-                                && header.flash_page_per_block == PIFS_FLASH_PAGE_PER_BLOCK
-                                && header.flash_page_size_byte == PIFS_FLASH_PAGE_SIZE_BYTE
-                                && header.logical_page_size_byte == PIFS_LOGICAL_PAGE_SIZE_BYTE
-                                && header.filename_len_max == PIFS_FILENAME_LEN_MAX
-                                && header.entry_num_max == PIFS_ENTRY_NUM_MAX
-                                && header.user_data_size_byte == PIFS_USER_DATA_SIZE_BYTE
-                                && header.management_block_num == PIFS_MANAGEMENT_BLOCK_NUM
-                                && header.least_weared_block_num == PIFS_LEAST_WEARED_BLOCK_NUM
-                                && header.most_weared_block_num == PIFS_MOST_WEARED_BLOCK_NUM
-                                && header.delta_map_page_num == PIFS_DELTA_MAP_PAGE_NUM
-                                && header.map_page_count_size == PIFS_MAP_PAGE_COUNT_SIZE
-                                && header.use_delta_for_entries == PIFS_USE_DELTA_FOR_ENTRIES
-                                && header.enable_directories == PIFS_ENABLE_DIRECTORIES
-                                && header.enable_crc == PIFS_ENABLE_CRC)
-#endif
+                        if (pifs_is_header_config_valid(&header))
                         {
                             pifs.is_header_found = TRUE;
                             pifs.header_address.block_address = ba;
                             pifs.header_address.page_address = pa;
                             memcpy(&prev_header, &header, sizeof(prev_header));
                         }
-#if PIFS_ENABLE_CONFIG_IN_FLASH
                         else
                         {
                             PIFS_WARNING_MSG("Invalid flash/file system configuration!\r\n");
                         }
-#endif
                     }
                 }
                 else
@@ -778,29 +1661,77 @@ pifs_status_t pifs_init(void)
         if (pifs.is_header_found)
         {
             memcpy(&pifs.header, &prev_header, sizeof(pifs.header));
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+            pifs_block_type_table_init(&pifs.header);
+#endif
+#if PIFS_ENABLE_MOUNT_HINT && PIFS_ENABLE_PAGE_CNTR
+            if (pifs.is_mount_hint_clean)
+            {
+                /* Page counters of mount hint are valid, free space bitmap */
+                /* is loaded when it is needed first */
+                pifs.free_management_page_cntr = hint.free_management_page_cntr;
+                pifs.free_data_page_cntr = hint.free_data_page_cntr;
+                pifs.to_be_released_management_page_cntr = hint.to_be_released_management_page_cntr;
+                pifs.to_be_released_data_page_cntr = hint.to_be_released_data_page_cntr;
+                pifs.is_page_cntr_valid = TRUE;
+                pifs.is_fsbm_deferred = TRUE;
+            }
+            else
+#endif
+            {
+#if PIFS_ENABLE_FSBM_IN_RAM
+                ret = pifs_fsbm_ram_load();
+#endif
+#if PIFS_ENABLE_PAGE_CNTR
+                if (ret == PIFS_SUCCESS)
+                {
+                    pifs_page_cntr_load();
+                }
+#endif
+            }
         }
         else
         {
             /* No file system header found, so create brand new one */
             PIFS_WARNING_MSG("No file system header found, creating...\r\n");
             pifs.header.counter = 0;
-            ba = PIFS_FLASH_BLOCK_RESERVED_NUM;
+            ba = PIFS_FLASH_BLOCK_FIRST_FS;
             pa = 0;
             ret = pifs_header_init(ba, pa, ba + PIFS_MANAGEMENT_BLOCK_NUM, &pifs.header);
             if (ret == PIFS_SUCCESS)
             {
                 PIFS_WARNING_MSG("Erasing all blocks...\r\n");
-                for (i = PIFS_FLASH_BLOCK_RESERVED_NUM; i < PIFS_FLASH_BLOCK_NUM_ALL; i++)
+                ret = pifs_flash_erase_blocks(PIFS_FLASH_BLOCK_FIRST_FS, PIFS_FLASH_BLOCK_NUM_FS);
+#if PIFS_ENABLE_STATISTICS
+                pifs.flash_erase_cntr += PIFS_FLASH_BLOCK_NUM_FS;
+#endif
+#if PIFS_ENABLE_ERASED_BITMAP
+                if (ret == PIFS_SUCCESS)
                 {
-                    ret = pifs_flash_erase(i);
-                    /* TODO mark bad blocks */
+                    pifs_set_page_verified_erased(PIFS_FLASH_BLOCK_FIRST_FS, 0,
+                                                  PIFS_LOGICAL_PAGE_NUM_FS, TRUE);
                 }
+#endif
+                /* TODO mark bad blocks */
                 PIFS_WARNING_MSG("Done.\r\n");
             }
+#if PIFS_ENABLE_FSBM_IN_RAM
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = pifs_fsbm_ram_load();
+            }
+#endif
             if (ret == PIFS_SUCCESS)
             {
                 ret = pifs_header_write(ba, pa, &pifs.header, TRUE);
             }
+#if PIFS_ENABLE_PAGE_CNTR
+            if (ret == PIFS_SUCCESS)
+            {
+                /* Header is active, pages can be counted */
+                pifs_page_cntr_load();
+            }
+#endif
         }
 
         if (pifs.is_header_found && ret == PIFS_SUCCESS)
@@ -813,6 +1744,14 @@ pifs_status_t pifs_init(void)
             }
 #endif
             ret = pifs_get_free_pages(&i, &pifs.free_data_page_num);
+#if PIFS_ENABLE_MOUNT_HINT
+            if (!is_mount_hint_found)
+            {
+                /* Deliberately avoiding return code, file system can be */
+                /* used without mount hint */
+                (void)pifs_mount_hint_write(FALSE);
+            }
+#endif
             pifs_initialized = TRUE;
 #if PIFS_DEBUG_LEVEL >= 6
             print_buffer(&pifs.header, sizeof(pifs.header), 0);
@@ -837,13 +1776,27 @@ pifs_status_t pifs_init(void)
 pifs_status_t pifs_delete(void)
 {
     pifs_status_t ret = PIFS_ERROR_GENERAL;
+    pifs_status_t flash_ret;
 
     if (pifs_initialized)
     {
         /* Flush cache */
         ret = pifs_flush();
 
-        ret = pifs_flash_delete();
+#if PIFS_ENABLE_MOUNT_HINT
+        if (ret == PIFS_SUCCESS && pifs.is_header_found && !pifs.is_mount_hint_clean)
+        {
+            /* Page counters can be used at next mount */
+            ret = pifs_mount_hint_write(TRUE);
+        }
+#endif
+
+        /* Flash I/F is deleted even if flushing failed */
+        flash_ret = pifs_flash_delete();
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = flash_ret;
+        }
 
 #if PIFS_ENABLE_OS
         PIFS_OS_DELETE_MUTEX(pifs_mutex);
@@ -880,7 +1833,7 @@ pifs_status_t pifs_mark_page_check(uint8_t * a_free_page_buf,
     while (a_page_count-- && ret == PIFS_SUCCESS)
     {
         /* Calculate address of block in the temporary buffer */
-        bit_pos = ((a_block_address - PIFS_FLASH_BLOCK_RESERVED_NUM) * PIFS_LOGICAL_PAGE_PER_BLOCK + a_page_address);
+        bit_pos = ((a_block_address - PIFS_FLASH_BLOCK_FIRST_FS) * PIFS_LOGICAL_PAGE_PER_BLOCK + a_page_address);
         byte_pos = bit_pos / PIFS_BYTE_BITS;
         bit_pos %= PIFS_BYTE_BITS;
 
@@ -913,7 +1866,7 @@ bool_t pifs_is_page_free_check(uint8_t * a_free_page_buf,
     pifs_bit_pos_t  bit_pos;
     pifs_size_t     byte_pos;
 
-    bit_pos = ((a_block_address - PIFS_FLASH_BLOCK_RESERVED_NUM) * PIFS_LOGICAL_PAGE_PER_BLOCK + a_page_address);
+    bit_pos = ((a_block_address - PIFS_FLASH_BLOCK_FIRST_FS) * PIFS_LOGICAL_PAGE_PER_BLOCK + a_page_address);
     byte_pos = bit_pos / PIFS_BYTE_BITS;
     bit_pos %= PIFS_BYTE_BITS;
 
@@ -1121,7 +2074,7 @@ pifs_status_t pifs_check_free_page_buf(uint8_t * a_free_page_buf)
     bool_t          is_free_fsbm; /* Page is free in free space bitmap (flash memory) */
     bool_t          is_tbr_fsbm; /* Page is to be released in free space bitmap (flash memory) */
 
-    address.block_address = PIFS_FLASH_BLOCK_RESERVED_NUM;
+    address.block_address = PIFS_FLASH_BLOCK_FIRST_FS;
     address.page_address = 0;
 
     page_cntr = PIFS_LOGICAL_PAGE_NUM_FS;
@@ -1150,7 +2103,8 @@ pifs_status_t pifs_check_free_page_buf(uint8_t * a_free_page_buf)
             /* Read to page cache */
             pifs_read(address.block_address, address.page_address, 0,
                       NULL, 0);
-            print_buffer(pifs.cache_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE,
+            print_buffer(pifs_get_cache_page_buf(address.block_address, address.page_address),
+                         PIFS_LOGICAL_PAGE_SIZE_BYTE,
                          address.block_address * PIFS_FLASH_BLOCK_SIZE_BYTE
                          + address.page_address * PIFS_LOGICAL_PAGE_SIZE_BYTE);
 #endif
@@ -1175,6 +2129,15 @@ pifs_status_t pifs_check(void)
     pifs_char_t * path = PIFS_ROOT_STR;
     pifs_status_t ret = PIFS_ERROR_NO_MORE_RESOURCE;
     uint8_t     * free_page_buf;
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    pifs_size_t   ext_page_num;
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+    pifs_size_t   patch_page_num;
+#endif
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM || PIFS_DELTA_PATCH_PAGE_NUM
+    pifs_size_t   i;
+#endif
 
 #if PIFS_FSCHECK_USE_STATIC_MEMORY
     free_page_buf = pifs.free_pages_buf;
@@ -1232,6 +2195,34 @@ pifs_status_t pifs_check(void)
                                        pifs.header.delta_map_address.page_address,
                                        PIFS_DELTA_MAP_PAGE_NUM);
         }
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+        if (ret == PIFS_SUCCESS)
+        {
+            /* Mark chained delta map pages as used */
+            ret = pifs_get_delta_map_ext_page_num(&ext_page_num, &pifs.header);
+            for (i = 0; i < ext_page_num && ret == PIFS_SUCCESS; i++)
+            {
+                ret = pifs_mark_page_check(free_page_buf,
+                                           pifs.delta_map_ext_address[i].block_address,
+                                           pifs.delta_map_ext_address[i].page_address,
+                                           1);
+            }
+        }
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+        if (ret == PIFS_SUCCESS)
+        {
+            /* Mark patch pages as used */
+            ret = pifs_get_delta_patch_page_num(&patch_page_num, &pifs.header);
+            for (i = 0; i < patch_page_num && ret == PIFS_SUCCESS; i++)
+            {
+                ret = pifs_mark_page_check(free_page_buf,
+                                           pifs.delta_patch_address[i].block_address,
+                                           pifs.delta_patch_address[i].page_address,
+                                           1);
+            }
+        }
+#endif
         if (ret == PIFS_SUCCESS)
         {
             /* Mark wear level list as used */
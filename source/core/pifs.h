@@ -86,6 +86,16 @@ extern "C" {
 #define PIFS_ENTRY_LIST_SIZE_PAGE           ((PIFS_ENTRY_NUM_MAX + PIFS_ENTRY_PER_PAGE - 1) / PIFS_ENTRY_PER_PAGE)
 /** Size of entry list in bytes */
 #define PIFS_ENTRY_LIST_SIZE_BYTE           (PIFS_ENTRY_LIST_SIZE_PAGE * PIFS_LOGICAL_PAGE_SIZE_BYTE)
+/** Number of entries in an entry list */
+#define PIFS_ENTRY_LIST_ENTRY_NUM           (PIFS_ENTRY_LIST_SIZE_PAGE * PIFS_ENTRY_PER_PAGE)
+#if PIFS_ENTRY_INDEX_LIST_NUM
+/** Number of slots in hash table of an entry list. At most half of them are used. */
+#define PIFS_ENTRY_INDEX_SIZE               (2 * PIFS_ENTRY_LIST_ENTRY_NUM + 1)
+/** Slot of entry index is empty */
+#define PIFS_ENTRY_INDEX_EMPTY              UINT16_MAX
+/** Slot of entry index was used, but entry was deleted */
+#define PIFS_ENTRY_INDEX_DELETED            (UINT16_MAX - 1u)
+#endif
 
 /******************************************************************************/
 /*** MAP ENTRY                                                              ***/
@@ -104,12 +114,74 @@ extern "C" {
 #define PIFS_FREE_SPACE_BITMAP_SIZE_BYTE    (PIFS_FSBM_BITS_PER_PAGE * ((PIFS_LOGICAL_PAGE_NUM_FS + PIFS_BYTE_BITS - 1) / PIFS_BYTE_BITS))
 /** Size of free space bitmap in pages */
 #define PIFS_FREE_SPACE_BITMAP_SIZE_PAGE    ((PIFS_FREE_SPACE_BITMAP_SIZE_BYTE + PIFS_LOGICAL_PAGE_SIZE_BYTE - 1) / PIFS_LOGICAL_PAGE_SIZE_BYTE)
+#if PIFS_ENABLE_FSBM_IN_RAM
+/** Size of free space bitmap's copy in RAM in 32-bit words */
+#define PIFS_FSBM_RAM_WORD_NUM              ((PIFS_FREE_SPACE_BITMAP_SIZE_BYTE + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+#endif
+#if PIFS_ENABLE_MOUNT_HINT
+/** Mount hint blocks follow the reserved blocks */
+#define PIFS_MOUNT_HINT_BLOCK_ADDRESS       PIFS_FLASH_BLOCK_RESERVED_NUM
+#define PIFS_MOUNT_HINT_SIZE_BYTE           (sizeof(pifs_mount_hint_t))
+/** Mount hints are packed in flash pages, a hint does not cross page boundary */
+#define PIFS_MOUNT_HINT_PER_PAGE            (PIFS_FLASH_PAGE_SIZE_BYTE / PIFS_MOUNT_HINT_SIZE_BYTE)
+#define PIFS_MOUNT_HINT_PER_BLOCK           (PIFS_MOUNT_HINT_PER_PAGE * PIFS_FLASH_PAGE_PER_BLOCK)
+#define PIFS_MOUNT_HINT_NUM                 (PIFS_MOUNT_HINT_PER_BLOCK * PIFS_MOUNT_HINT_BLOCK_NUM)
+#define PIFS_MOUNT_HINT_CLEAN               PIFS_FLASH_ERASED_BYTE_VALUE
+#define PIFS_MOUNT_HINT_DIRTY               PIFS_FLASH_PROGRAMMED_BYTE_VALUE
+#endif
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+/** Size of bitmap of blocks erased in advance of merge in 32-bit words */
+#define PIFS_MERGE_ERASED_WORD_NUM          ((PIFS_FLASH_BLOCK_NUM_ALL + 31u) / 32u)
+#define PIFS_MERGE_ERASED_WORD_IDX(ba)      ((ba) / 32u)
+#define PIFS_MERGE_ERASED_BIT(ba)           (1u << ((ba) % 32u))
+#endif
+#if PIFS_ENABLE_EXTENT_ALLOC
+/** Longest free run of block shall be calculated */
+#define PIFS_EXTENT_INVALID                 UINT16_MAX
+#endif
+#if PIFS_ENABLE_FALLOCATE
+/** Number of data pages in file's map shall be counted */
+#define PIFS_ALLOC_PAGE_COUNT_UNKNOWN       ((pifs_size_t) -1)
+#endif
+#if PIFS_ENABLE_ALLOC_CURSOR
+/** Number of allocation cursors: data and primary management pages */
+#define PIFS_ALLOC_CURSOR_NUM               2u
+#endif
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+/** Size of block type table in bytes, type of a block is stored in 4 bits */
+#define PIFS_BLOCK_TYPE_TABLE_SIZE_BYTE     ((PIFS_FLASH_BLOCK_NUM_ALL + 1u) / 2u)
+#endif
+#if PIFS_ENABLE_ERASED_BITMAP
+/** Size of bitmap of pages verified to be erased in 32-bit words */
+#define PIFS_ERASED_BITMAP_WORD_NUM         ((PIFS_LOGICAL_PAGE_NUM_ALL + 31u) / 32u)
+#define PIFS_ERASED_BITMAP_IDX(ba, pa)      ((ba) * PIFS_LOGICAL_PAGE_PER_BLOCK + (pa))
+#endif
 
 /******************************************************************************/
 /*** DELTA PAGES                                                            ***/
 /******************************************************************************/
 #define PIFS_DELTA_ENTRY_SIZE_BYTE          (sizeof(pifs_delta_entry_t))
 #define PIFS_DELTA_ENTRY_PER_PAGE           (PIFS_LOGICAL_PAGE_SIZE_BYTE / PIFS_DELTA_ENTRY_SIZE_BYTE)
+/** Maximum number of delta map pages including the chained ones */
+#define PIFS_DELTA_MAP_PAGE_NUM_MAX         (PIFS_DELTA_MAP_PAGE_NUM + PIFS_DELTA_MAP_EXT_PAGE_NUM)
+/** Number of entries in delta map */
+#define PIFS_DELTA_ENTRY_NUM                (PIFS_DELTA_MAP_PAGE_NUM_MAX * PIFS_DELTA_ENTRY_PER_PAGE)
+#if PIFS_ENABLE_DELTA_INDEX
+/** Number of slots in hash table of delta map. At most half of them are used. */
+#define PIFS_DELTA_INDEX_SIZE               (2 * PIFS_DELTA_ENTRY_NUM + 1)
+/** Empty slot in hash table of delta map */
+#define PIFS_DELTA_INDEX_EMPTY              UINT16_MAX
+#endif
+#if PIFS_DELTA_FILTER_PAGE_NUM
+/** Size of delta presence filter in 32-bit words */
+#define PIFS_DELTA_FILTER_WORD_NUM          (((PIFS_LOGICAL_PAGE_NUM_ALL + PIFS_DELTA_FILTER_PAGE_NUM - 1u) \
+                                              / PIFS_DELTA_FILTER_PAGE_NUM + 31u) / 32u)
+#define PIFS_DELTA_FILTER_IDX(ba, pa)       (((ba) * PIFS_LOGICAL_PAGE_PER_BLOCK + (pa)) / PIFS_DELTA_FILTER_PAGE_NUM)
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+/** Size of patch's header, patched bytes follow the header */
+#define PIFS_DELTA_PATCH_HEADER_SIZE_BYTE   (sizeof(pifs_delta_patch_t))
+#endif
 
 /******************************************************************************/
 /*** WEAR LEVEL LIST                                                        ***/
@@ -266,6 +338,12 @@ typedef uint8_t pifs_wear_level_bits_t;
 #if PIFS_ENABLE_DIRECTORIES && !PIFS_ENABLE_ATTRIBUTES
 #error PIFS_ENABLE_ATTRIBUTES shall be 1 if PIFS_ENABLE_DIRECTORIES is 1!
 #endif
+#if PIFS_ENABLE_PAGE_CNTR && PIFS_LOGICAL_PAGE_PER_BLOCK > UINT16_MAX
+#error PIFS_LOGICAL_PAGE_PER_BLOCK shall not be greater than 65535 if PIFS_ENABLE_PAGE_CNTR is 1!
+#endif
+#if PIFS_ENABLE_MOUNT_HINT && PIFS_MOUNT_HINT_BLOCK_NUM < 2
+#error PIFS_MOUNT_HINT_BLOCK_NUM shall be 2 at minimum if PIFS_ENABLE_MOUNT_HINT is 1!
+#endif
 
 #define PIFS_INIT_ATTRIB(attrib)    do { \
         (attrib) = PIFS_FLASH_ERASED_BYTE_VALUE; \
@@ -275,6 +353,42 @@ typedef uint8_t pifs_wear_level_bits_t;
 #error Invalid PIFS_PATH_SEPARATOR_CHAR! Forward slash '/' or backslash '\\' are supported!
 #endif
 
+#if PIFS_CACHE_PAGE_NUM < 1
+#error PIFS_CACHE_PAGE_NUM shall be 1 at minimum!
+#endif
+#if PIFS_CACHE_WAY_NUM < 1 || PIFS_CACHE_WAY_NUM > PIFS_CACHE_PAGE_NUM
+#error PIFS_CACHE_WAY_NUM shall be between 1 and PIFS_CACHE_PAGE_NUM!
+#endif
+#if (PIFS_CACHE_PAGE_NUM % PIFS_CACHE_WAY_NUM) != 0
+#error PIFS_CACHE_PAGE_NUM shall be multiple of PIFS_CACHE_WAY_NUM!
+#endif
+#if PIFS_MERGE_PRE_ERASE_AUTO_NUM && !PIFS_ENABLE_MERGE_PRE_ERASE
+#error PIFS_MERGE_PRE_ERASE_AUTO_NUM needs PIFS_ENABLE_MERGE_PRE_ERASE!
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM && !PIFS_ENABLE_DELTA_INDEX
+#error PIFS_DELTA_PATCH_PAGE_NUM needs PIFS_ENABLE_DELTA_INDEX!
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM && PIFS_DELTA_PATCH_SIZE_MAX > 255
+#error PIFS_DELTA_PATCH_SIZE_MAX shall not be greater than 255!
+#endif
+#if PIFS_ENABLE_EXTENT_ALLOC && !PIFS_ENABLE_FSBM_IN_RAM
+#error PIFS_ENABLE_EXTENT_ALLOC needs PIFS_ENABLE_FSBM_IN_RAM!
+#endif
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY && !PIFS_ENABLE_FSBM_IN_RAM
+#error PIFS_ENABLE_DEFERRED_MAP_ENTRY needs PIFS_ENABLE_FSBM_IN_RAM!
+#endif
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY && !PIFS_CHECK_IF_PAGE_IS_ERASED
+#error PIFS_ENABLE_DEFERRED_MAP_ENTRY needs PIFS_CHECK_IF_PAGE_IS_ERASED!
+#endif
+#if PIFS_ENABLE_EXTENT_ALLOC && PIFS_LOGICAL_PAGE_PER_BLOCK >= UINT16_MAX
+#error PIFS_LOGICAL_PAGE_PER_BLOCK shall be less than 65535 if PIFS_ENABLE_EXTENT_ALLOC is 1!
+#endif
+
+/** Number of sets in page cache */
+#define PIFS_CACHE_SET_NUM              (PIFS_CACHE_PAGE_NUM / PIFS_CACHE_WAY_NUM)
+/** Set of page cache where the logical page can be stored */
+#define PIFS_CACHE_SET_IDX(ba, pa)      ((((pifs_size_t)(ba) * PIFS_LOGICAL_PAGE_PER_BLOCK) + (pa)) % PIFS_CACHE_SET_NUM)
+
 #define PIFS_FREE_PAGE_BUF_SIZE         (PIFS_FLASH_PAGE_NUM_FS / PIFS_BYTE_BITS)
 
 #define PIFS_SET_ERRNO(status)          do { \
@@ -357,7 +471,7 @@ typedef struct PIFS_PACKED_ATTRIBUTE
 #if PIFS_ENABLE_CONFIG_IN_FLASH
     /* Flash configuration */
     uint16_t                flash_block_num_all;        /**< Number of all blocks in the flash memory */
-    uint16_t                flash_block_reserved_num;   /**< Reserved blocks at the beginning of the flash memory */
+    uint16_t                flash_block_reserved_num;   /**< Blocks at the beginning of the flash memory which are not used by the file system: reserved and mount hint blocks */
     uint16_t                flash_page_per_block;       /**< Number of flash (physical) pages in a block */
     uint16_t                flash_page_size_byte;       /**< Size of flash (physical) page in bytes */
     /* File system configuration */
@@ -389,6 +503,33 @@ typedef struct PIFS_PACKED_ATTRIBUTE
     pifs_checksum_t         checksum;                       /**< Checksum of file system's header */
 } pifs_header_t;
 
+#if PIFS_ENABLE_MOUNT_HINT
+/**
+ * Mount hint. It is written after the previous hint in mount hint blocks
+ * when the file system header is moved and when the file system is deleted.
+ * pifs_init() finds the header by the latest hint instead of scanning
+ * every block.
+ * This structure is used in RAM and flash memory as well.
+ */
+typedef struct PIFS_PACKED_ATTRIBUTE
+{
+    uint32_t                magic;                      /**< PIFS_MAGIC */
+    uint32_t                sequence;                   /**< Incremented by every hint, the latest hint has the greatest */
+    uint32_t                counter;                    /**< Counter of file system's header */
+    pifs_address_t          header_address;             /**< Address of file system's header */
+#if PIFS_ENABLE_PAGE_CNTR
+    uint32_t                free_management_page_cntr;  /**< Number of free primary management pages */
+    uint32_t                free_data_page_cntr;        /**< Number of free data pages */
+    uint32_t                to_be_released_management_page_cntr; /**< Number of to be released primary management pages */
+    uint32_t                to_be_released_data_page_cntr;        /**< Number of to be released data pages */
+#endif
+    pifs_checksum_t         checksum;                   /**< Checksum of fields above */
+    /** PIFS_MOUNT_HINT_CLEAN: page counters are valid. It is programmed to
+     * PIFS_MOUNT_HINT_DIRTY before free space bitmap is changed. */
+    uint8_t                 dirty;
+} pifs_mount_hint_t;
+#endif
+
 /**
  * File or directory entry.
  * This structure is used in RAM and flash memory as well.
@@ -459,6 +600,46 @@ typedef struct PIFS_PACKED_ATTRIBUTE
     pifs_checksum_t         checksum;
 } pifs_delta_entry_t;
 
+#if PIFS_DELTA_PATCH_PAGE_NUM
+/**
+ * Header of patch: sub-page delta record of a small overwrite.
+ * Patched bytes follow the header in the patch page.
+ * This structure is used in RAM and flash memory as well.
+ */
+typedef struct PIFS_PACKED_ATTRIBUTE
+{
+    pifs_address_t          orig_address;   /**< Address of original page */
+    /** Address of page which is patched: original or delta page. If the
+     * page gets a new delta page, the patch is obsolete. */
+    pifs_address_t          base_address;
+    pifs_page_offset_t      offset;         /**< Offset of patched bytes in the page */
+    pifs_page_offset_t      size;           /**< Number of patched bytes */
+    pifs_checksum_t         data_checksum;  /**< Checksum of patched bytes */
+    /** Checksum shall be the last element! */
+    pifs_checksum_t         checksum;
+} pifs_delta_patch_t;
+#endif
+
+#if PIFS_ENABLE_DELTA_INDEX
+/** Index of an entry in delta map */
+typedef uint16_t pifs_delta_index_t;
+#endif
+
+#if PIFS_EXTENT_CACHE_NUM
+/**
+ * Map entry of an opened file and its position in the file and in the map.
+ * This structure is used only in RAM.
+ */
+typedef struct
+{
+    pifs_size_t             page_idx;           /**< Index of extent's first page in the file */
+    pifs_address_t          map_address;        /**< Address of map which contains the entry */
+    pifs_size_t             map_entry_idx;      /**< Entry's index in the map */
+    pifs_address_t          address;            /**< Address of extent's first page */
+    pifs_map_page_count_t   page_count;         /**< Number of pages */
+} pifs_extent_t;
+#endif
+
 /**
  * Actual status and parameters of an opened file.
  * This structure is used only in RAM.
@@ -485,8 +666,74 @@ typedef struct
     size_t                  rw_pos;             /**< Position in file after last read/write */
     pifs_address_t          rw_address;         /**< Last read/write page's address */
     pifs_page_count_t       rw_page_count;      /**< Page count to be read/write from 'rw_address' */
+#if PIFS_ENABLE_FALLOCATE
+    pifs_size_t             alloc_page_count;   /**< Number of data pages in map, pages after file size were reserved by pifs_fallocate() */
+#endif
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+    pifs_address_t          pending_map_address;    /**< First page of map entry which is not written yet */
+    pifs_page_count_t       pending_map_page_count; /**< Number of pages of pending map entry, 0: no pending entry */
+#endif
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+    pifs_address_t          tail_map_address;   /**< Address of last map page */
+    pifs_size_t             tail_map_entry_idx; /**< Index of first free entry in last map page, 0: position is not known */
+#if PIFS_EXTENT_CACHE_NUM
+    pifs_size_t             tail_map_page_idx;  /**< Index of first page after last map entry in the file */
+#endif
+#endif
+#if PIFS_EXTENT_CACHE_NUM
+    pifs_size_t             map_entry_page_idx; /**< Index of actual map entry's first page in the file */
+    pifs_address_t          extent_map_address; /**< First map's address which extents belong to */
+    pifs_size_t             extent_count;       /**< Number of valid extents */
+    pifs_extent_t           extent[PIFS_EXTENT_CACHE_NUM]; /**< Known map entries, sorted by page index */
+#endif
+#if PIFS_READ_AHEAD_PAGE_NUM
+    uint8_t                 advice;             /**< Access pattern set by pifs_fadvise(), @see pifs_fadvise_advice_t */
+    size_t                  read_end_pos;       /**< Position in file after last read, to detect sequential reading */
+    pifs_address_t          read_ahead_address; /**< Address of first page in read-ahead buffer */
+    pifs_page_count_t       read_ahead_page_count; /**< Number of valid pages in read-ahead buffer */
+    uint8_t                 read_ahead_buf[PIFS_READ_AHEAD_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE]; /**< Pages of actual map entry read in advance */
+#endif
 } pifs_file_t;
 
+/**
+ * One page of the page cache.
+ * This structure is used only in RAM.
+ */
+typedef struct
+{
+    pifs_address_t          address;            /**< Address of cached logical page, invalid if not used */
+    bool_t                  is_dirty PIFS_BOOL_SIZE; /**< TRUE: page was changed and needs to be written to flash memory */
+    uint32_t                last_used;          /**< Value of pifs_t.cache_use_cntr at last access, for LRU replacement */
+    uint32_t                dirty_seq;          /**< Value of pifs_t.cache_dirty_cntr when page became dirty, for write back ordering */
+    uint8_t                 buf[PIFS_LOGICAL_PAGE_SIZE_BYTE];  /**< Flash page buffer for cache */
+} pifs_cache_page_t;
+
+#if PIFS_ENTRY_INDEX_LIST_NUM
+/**
+ * One slot of entry index.
+ * This structure is used only in RAM.
+ */
+typedef struct
+{
+    uint16_t                name_hash;          /**< Upper 16 bits of hash of file name */
+    uint16_t                entry_idx;          /**< Index of entry in entry list or PIFS_ENTRY_INDEX_EMPTY/DELETED */
+} pifs_entry_index_slot_t;
+
+/**
+ * Hash table of file names of an entry list (directory).
+ * This structure is used only in RAM.
+ */
+typedef struct
+{
+    pifs_address_t          entry_list_address; /**< Address of indexed entry list, invalid if not used */
+    uint32_t                last_used;          /**< Value of pifs_t.entry_index_use_cntr at last access, for LRU replacement */
+    pifs_size_t             free_entry_idx;     /**< Index of first erased entry */
+    pifs_size_t             free_entry_count;   /**< Number of erased entries */
+    pifs_size_t             to_be_released_entry_count; /**< Number of deleted entries */
+    pifs_entry_index_slot_t slot[PIFS_ENTRY_INDEX_SIZE];
+} pifs_entry_index_t;
+#endif
+
 /**
  * Internal structure used by pifs_opendir(), pifs_readdir(), pifs_closedir().
  * This structure is used only in RAM.
@@ -515,19 +762,118 @@ typedef struct
     pifs_header_t           header;                                       /**< Actual header. */
     pifs_entry_t            entry;                                        /**< For merging */
     /* Page cache */
-    pifs_address_t          cache_page_buf_address;                       /**< Address of cache_page_buf */
-    uint8_t                 cache_page_buf[PIFS_LOGICAL_PAGE_SIZE_BYTE];  /**< Flash page buffer for cache */
-    bool_t                  cache_page_buf_is_dirty;                      /**< TRUE: cache page was changed and needs to be written to flash memory */
+    pifs_cache_page_t       cache[PIFS_CACHE_PAGE_NUM];                   /**< Pages of cache, ordered by set then way */
+    pifs_cache_page_t     * cache_mru;                                    /**< Most recently used page of cache */
+    uint32_t                cache_use_cntr;                               /**< Incremented when other page of cache is accessed than the most recently used one */
+    uint32_t                cache_dirty_cntr;                             /**< Incremented when a cached page becomes dirty */
+#if PIFS_ENABLE_STATISTICS
+    uint32_t                cache_hit_cntr;                               /**< Number of cache hits */
+    uint32_t                cache_miss_cntr;                              /**< Number of cache misses */
+    uint32_t                cache_write_back_cntr;                        /**< Number of pages written back to flash memory */
+    uint32_t                flash_read_cntr;                              /**< Number of flash pages read */
+    uint32_t                flash_write_cntr;                             /**< Number of flash pages programmed */
+    uint32_t                flash_write_byte_cntr;                        /**< Number of bytes programmed */
+    uint32_t                flash_erase_cntr;                             /**< Number of flash blocks erased */
+    uint32_t                merge_cntr;                                   /**< Number of merges */
+#endif
+#if PIFS_ENABLE_FSBM_IN_RAM
+    /** Copy of actual header's free space bitmap. Bit N of the bitmap is
+     * bit (N % 32) of word (N / 32). */
+    uint32_t                fsbm_ram_buf[PIFS_FSBM_RAM_WORD_NUM];
+    bool_t                  is_fsbm_ram_valid PIFS_BOOL_SIZE;             /**< TRUE: fsbm_ram_buf's content is valid */
+#endif
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+    bool_t                  is_page_reserved_by_write PIFS_BOOL_SIZE;     /**< TRUE: pifs_write_delta() reserves new data pages instead of marking them */
+#endif
+#if PIFS_ENABLE_PAGE_CNTR
+    uint16_t                block_free_page_cntr[PIFS_FLASH_BLOCK_NUM_ALL];           /**< Number of free pages of blocks */
+    uint16_t                block_to_be_released_page_cntr[PIFS_FLASH_BLOCK_NUM_ALL]; /**< Number of to be released pages of blocks */
+    pifs_size_t             free_management_page_cntr;                    /**< Number of free primary management pages */
+    pifs_size_t             free_data_page_cntr;                          /**< Number of free data pages */
+    pifs_size_t             to_be_released_management_page_cntr;          /**< Number of to be released primary management pages */
+    pifs_size_t             to_be_released_data_page_cntr;                /**< Number of to be released data pages */
+    bool_t                  is_page_cntr_valid PIFS_BOOL_SIZE;            /**< TRUE: page counters are valid */
+#endif
+#if PIFS_ENABLE_MOUNT_HINT
+    pifs_size_t             mount_hint_idx;                               /**< Index of next mount hint to write in mount hint blocks */
+    uint32_t                mount_hint_sequence;                          /**< Sequence number of the latest mount hint */
+    bool_t                  is_mount_hint_clean PIFS_BOOL_SIZE;           /**< TRUE: page counters of latest mount hint are valid */
+    bool_t                  is_fsbm_deferred PIFS_BOOL_SIZE;              /**< TRUE: free space bitmap is not loaded to RAM yet, page counters of blocks are invalid */
+#endif
+#if PIFS_ENABLE_FSBM_BATCH
+    uint8_t                 fsbm_batch_cntr;                              /**< Nesting level of pifs_fsbm_batch_begin() calls */
+#endif
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    pifs_entry_index_t      entry_index[PIFS_ENTRY_INDEX_LIST_NUM];       /**< File name indexes of recently used entry lists */
+    uint32_t                entry_index_use_cntr;                         /**< Incremented at every access of entry indexes */
+#endif
     /* Opened files and directories */
     pifs_file_t             file[PIFS_OPEN_FILE_NUM_MAX];                 /**< Opened files */
     pifs_file_t             internal_file;                                /**< Internally opened files */
     pifs_dir_t              dir[PIFS_OPEN_DIR_NUM_MAX];                   /**< Opened directories */
     /** Page buffer of delta map */
-    uint8_t                 delta_map_page_buf[PIFS_DELTA_MAP_PAGE_NUM][PIFS_LOGICAL_PAGE_SIZE_BYTE];
+    uint8_t                 delta_map_page_buf[PIFS_DELTA_MAP_PAGE_NUM_MAX][PIFS_LOGICAL_PAGE_SIZE_BYTE];
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    /** Number of delta map pages in use, including chained pages */
+    pifs_size_t             delta_map_page_num;
+    /** Addresses of chained delta map pages */
+    pifs_address_t          delta_map_ext_address[PIFS_DELTA_MAP_EXT_PAGE_NUM];
+#endif
     /** TRUE: delta_map_page_buf's content is valid */
     bool_t                  delta_map_page_is_read PIFS_BOOL_SIZE;
     /** TRUE: delta_map_page_buf is inconsistent, it shall be written to the flash memory */
     bool_t                  delta_map_page_is_dirty PIFS_BOOL_SIZE;
+#if PIFS_ENABLE_DELTA_INDEX
+    /** Hash table of delta map: original address -> index of latest delta entry */
+    pifs_delta_index_t      delta_index[PIFS_DELTA_INDEX_SIZE];
+    /** Number of erased entries in delta map */
+    pifs_size_t             delta_map_free_entry_num;
+#endif
+#if PIFS_DELTA_FILTER_PAGE_NUM
+    /** Bit is set if delta map may contain entries of the page range */
+    uint32_t                delta_filter[PIFS_DELTA_FILTER_WORD_NUM];
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+    /** Page buffer of patches */
+    uint8_t                 delta_patch_page_buf[PIFS_DELTA_PATCH_PAGE_NUM][PIFS_LOGICAL_PAGE_SIZE_BYTE];
+    /** Addresses of patch pages */
+    pifs_address_t          delta_patch_address[PIFS_DELTA_PATCH_PAGE_NUM];
+    /** Size of valid patches in the patch pages in bytes */
+    pifs_size_t             delta_patch_size[PIFS_DELTA_PATCH_PAGE_NUM];
+    pifs_size_t             delta_patch_page_num;       /**< Number of patch pages */
+    pifs_size_t             delta_patch_write_pos;      /**< Position of next patch in last patch page */
+    /** Number of pages which have patches. Same number of delta entries are
+     * reserved to fold patches before merge. */
+    pifs_size_t             delta_patched_page_num;
+#endif
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+    /** Blocks erased by pifs_merge_pre_erase(), merge does not erase them again */
+    uint32_t                merge_erased_block_bitmap[PIFS_MERGE_ERASED_WORD_NUM];
+    pifs_block_address_t    merge_pre_erase_block_address;                /**< Next block to be checked by pifs_merge_pre_erase() */
+    bool_t                  is_merge_prepared PIFS_BOOL_SIZE;             /**< TRUE: no more block to erase before merge */
+#endif
+#if PIFS_ENABLE_EXTENT_ALLOC
+    /** Number of pages of longest free run in blocks or PIFS_EXTENT_INVALID */
+    uint16_t                extent_page_count[PIFS_FLASH_BLOCK_NUM_ALL];
+    /** First page of longest free run in blocks */
+    uint16_t                extent_page_address[PIFS_FLASH_BLOCK_NUM_ALL];
+#endif
+#if PIFS_ENABLE_ALLOC_CURSOR
+    /** No free page before these addresses: [0]: data pages, [1]: primary
+     * management pages */
+    pifs_address_t          alloc_cursor[PIFS_ALLOC_CURSOR_NUM];
+#endif
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+    /** Type of blocks, two blocks per byte, lower nibble is the even block */
+    uint8_t                 block_type_table[PIFS_BLOCK_TYPE_TABLE_SIZE_BYTE];
+    pifs_block_address_t    block_type_table_mgmt_ba;                     /**< Management block address of header which table belongs to */
+    pifs_block_address_t    block_type_table_next_mgmt_ba;                /**< Next management block address of header which table belongs to */
+#endif
+#if PIFS_ENABLE_ERASED_BITMAP
+    /** Pages verified to be erased since last erase of their block.
+     * Bit is cleared when page is written. */
+    uint32_t                erased_bitmap[PIFS_ERASED_BITMAP_WORD_NUM];
+#endif
     /** General page buffer used by pifs_write_delta(),
      * pifs_copy_fsbm(), pifs_wear_level_list_init(), dmw=delta, merge, wear */
     uint8_t                 dmw_page_buf[PIFS_LOGICAL_PAGE_SIZE_BYTE];
@@ -553,17 +899,34 @@ typedef struct
 extern pifs_t pifs;
 
 pifs_status_t pifs_flush(void);
+uint8_t * pifs_get_cache_page_buf(pifs_block_address_t a_block_address,
+                                  pifs_page_address_t a_page_address);
 pifs_status_t pifs_read(pifs_block_address_t a_block_address,
                         pifs_page_address_t a_page_address,
                         pifs_page_offset_t a_page_offset,
                         void * const a_buf,
                         pifs_size_t a_buf_size);
+#if PIFS_DIRECT_READ_PAGE_NUM_MAX || PIFS_READ_AHEAD_PAGE_NUM
+pifs_status_t pifs_read_direct(pifs_block_address_t a_block_address,
+                               pifs_page_address_t a_page_address,
+                               pifs_page_count_t a_page_count,
+                               void * const a_buf);
+#endif
 pifs_status_t pifs_write(pifs_block_address_t a_block_address,
                          pifs_page_address_t a_page_address,
                          pifs_page_offset_t a_page_offset,
                          const void * const a_buf,
                          pifs_size_t a_buf_size);
+#if PIFS_DELTA_PATCH_PAGE_NUM
+pifs_status_t pifs_write_through(pifs_block_address_t a_block_address,
+                                 pifs_page_address_t a_page_address,
+                                 pifs_page_offset_t a_page_offset,
+                                 const void * const a_buf,
+                                 pifs_size_t a_buf_size);
+#endif
 pifs_status_t pifs_erase(pifs_block_address_t a_block_address, pifs_header_t *a_old_header, pifs_header_t *a_new_header);
+pifs_status_t pifs_erase_blocks(pifs_block_address_t a_block_address, pifs_size_t a_block_count,
+                                pifs_header_t *a_old_header, pifs_header_t *a_new_header);
 pifs_status_t pifs_merge(void);
 pifs_status_t pifs_header_init(pifs_block_address_t a_block_address,
                                pifs_page_address_t a_page_address,
@@ -572,6 +935,10 @@ pifs_status_t pifs_header_init(pifs_block_address_t a_block_address,
 pifs_status_t pifs_header_write(pifs_block_address_t a_block_address,
                                 pifs_page_address_t a_page_address,
                                 pifs_header_t * a_header, bool_t a_mark_pages);
+#if PIFS_ENABLE_MOUNT_HINT
+pifs_status_t pifs_mount_hint_write(bool_t a_is_clean);
+pifs_status_t pifs_mount_hint_set_dirty(void);
+#endif
 
 #ifdef __cplusplus
 }
@@ -35,8 +35,472 @@
 #include "pifs_helper.h"
 #include "pifs_delta.h"
 
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+/** Number of delta map pages in use */
+#define PIFS_DELTA_MAP_PAGE_NUM_USED    (pifs.delta_map_page_num)
+#else
+#define PIFS_DELTA_MAP_PAGE_NUM_USED    PIFS_DELTA_MAP_PAGE_NUM
+#endif
+
+/**
+ * @brief pifs_get_delta_entry Get an entry of delta map buffer.
+ *
+ * @param[in] a_delta_entry_idx Index of entry (0..PIFS_DELTA_ENTRY_NUM-1).
+ * @return Pointer to the entry.
+ */
+static inline pifs_delta_entry_t * pifs_get_delta_entry(pifs_size_t a_delta_entry_idx)
+{
+    pifs_delta_entry_t * delta_entry;
+
+    delta_entry = (pifs_delta_entry_t*) &pifs.delta_map_page_buf[a_delta_entry_idx / PIFS_DELTA_ENTRY_PER_PAGE];
+
+    return &delta_entry[a_delta_entry_idx % PIFS_DELTA_ENTRY_PER_PAGE];
+}
+
+/**
+ * @brief pifs_is_delta_link_slot Check if an entry of delta map is reserved
+ * for the address of next delta map page. Last entry of a page is reserved
+ * if the next page can be chained.
+ *
+ * @param[in] a_delta_entry_idx Index of entry (0..PIFS_DELTA_ENTRY_NUM-1).
+ * @return TRUE: entry is reserved, it is not used for delta pages.
+ */
+static inline bool_t pifs_is_delta_link_slot(pifs_size_t a_delta_entry_idx)
+{
+    bool_t ret = FALSE;
+
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    ret = (a_delta_entry_idx % PIFS_DELTA_ENTRY_PER_PAGE == PIFS_DELTA_ENTRY_PER_PAGE - 1
+           && a_delta_entry_idx / PIFS_DELTA_ENTRY_PER_PAGE >= PIFS_DELTA_MAP_PAGE_NUM - 1
+           && a_delta_entry_idx / PIFS_DELTA_ENTRY_PER_PAGE < PIFS_DELTA_MAP_PAGE_NUM_MAX - 1);
+#else
+    (void) a_delta_entry_idx;
+#endif
+
+    return ret;
+}
+
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+/**
+ * @brief pifs_get_delta_link Get address of next delta map page.
+ * Link is a delta entry with invalid original address in the reserved
+ * entry of the page.
+ *
+ * @param[in] a_delta_map_page_idx  Index of delta map page.
+ * @param[out] a_address            Address of next page.
+ * @return TRUE: next page is chained.
+ */
+static bool_t pifs_get_delta_link(pifs_size_t a_delta_map_page_idx, pifs_address_t * a_address)
+{
+    bool_t               ret = FALSE;
+    pifs_size_t          delta_entry_idx = (a_delta_map_page_idx + 1) * PIFS_DELTA_ENTRY_PER_PAGE - 1;
+    pifs_delta_entry_t * delta_entry = pifs_get_delta_entry(delta_entry_idx);
+
+    if (pifs_is_delta_link_slot(delta_entry_idx)
+            && delta_entry->orig_address.block_address == PIFS_BLOCK_ADDRESS_INVALID
+            && delta_entry->orig_address.page_address == PIFS_PAGE_ADDRESS_INVALID
+            && pifs_calc_checksum(delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE)
+            == delta_entry->checksum)
+    {
+        *a_address = delta_entry->delta_address;
+        ret = TRUE;
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_DELTA_FILTER_PAGE_NUM
+/**
+ * @brief pifs_delta_filter_set Mark page range of an original page in delta
+ * presence filter.
+ *
+ * @param[in] a_block_address   Block address of original page.
+ * @param[in] a_page_address    Page address of original page.
+ */
+static inline void pifs_delta_filter_set(pifs_block_address_t a_block_address,
+                                         pifs_page_address_t a_page_address)
+{
+    pifs_size_t idx = PIFS_DELTA_FILTER_IDX(a_block_address, a_page_address);
+
+    pifs.delta_filter[idx / 32u] |= 1u << (idx % 32u);
+}
+
+/**
+ * @brief pifs_is_delta_filter_set Check if delta map may contain an entry
+ * of a page.
+ *
+ * @param[in] a_block_address   Block address of original page.
+ * @param[in] a_page_address    Page address of original page.
+ * @return FALSE: page has no delta page, TRUE: delta map shall be searched.
+ */
+static inline bool_t pifs_is_delta_filter_set(pifs_block_address_t a_block_address,
+                                              pifs_page_address_t a_page_address)
+{
+    pifs_size_t idx = PIFS_DELTA_FILTER_IDX(a_block_address, a_page_address);
+
+    return (pifs.delta_filter[idx / 32u] & (1u << (idx % 32u))) != 0;
+}
+
+#if !PIFS_ENABLE_DELTA_INDEX
+/**
+ * @brief pifs_delta_filter_build Build delta presence filter from delta map
+ * buffer.
+ */
+static void pifs_delta_filter_build(void)
+{
+    pifs_size_t          i;
+    pifs_delta_entry_t * delta_entry;
+
+    memset(pifs.delta_filter, 0, sizeof(pifs.delta_filter));
+    for (i = 0; i < PIFS_DELTA_MAP_PAGE_NUM_USED * PIFS_DELTA_ENTRY_PER_PAGE; i++)
+    {
+        delta_entry = pifs_get_delta_entry(i);
+        if (!pifs_is_delta_link_slot(i)
+                && pifs_calc_checksum(delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE)
+                == delta_entry->checksum)
+        {
+            pifs_delta_filter_set(delta_entry->orig_address.block_address,
+                                  delta_entry->orig_address.page_address);
+        }
+    }
+}
+#endif
+#endif
+
+#if PIFS_ENABLE_DELTA_INDEX
+/**
+ * @brief pifs_delta_index_hash Calculate first slot of an address in
+ * delta index.
+ *
+ * @param[in] a_block_address   Block address of original page.
+ * @param[in] a_page_address    Page address of original page.
+ * @return Index of slot.
+ */
+static inline pifs_size_t pifs_delta_index_hash(pifs_block_address_t a_block_address,
+                                                pifs_page_address_t a_page_address)
+{
+    uint32_t hash = (uint32_t)a_block_address * PIFS_LOGICAL_PAGE_PER_BLOCK + a_page_address;
+
+    /* Multiplicative hashing (Knuth) */
+    hash *= 2654435761u;
+
+    return (pifs_size_t)(hash % PIFS_DELTA_INDEX_SIZE);
+}
+
+/**
+ * @brief pifs_delta_index_find Find slot of an original address in delta
+ * index.
+ *
+ * @param[in] a_block_address   Block address of original page.
+ * @param[in] a_page_address    Page address of original page.
+ * @return Index of slot which contains the address or index of empty slot.
+ */
+static pifs_size_t pifs_delta_index_find(pifs_block_address_t a_block_address,
+                                         pifs_page_address_t a_page_address)
+{
+    pifs_size_t          slot = pifs_delta_index_hash(a_block_address, a_page_address);
+    pifs_delta_entry_t * delta_entry;
+    bool_t               found = FALSE;
+
+    while (!found && pifs.delta_index[slot] != PIFS_DELTA_INDEX_EMPTY)
+    {
+        delta_entry = pifs_get_delta_entry(pifs.delta_index[slot]);
+        if (delta_entry->orig_address.block_address == a_block_address
+                && delta_entry->orig_address.page_address == a_page_address)
+        {
+            found = TRUE;
+        }
+        else
+        {
+            /* Linear probing */
+            slot++;
+            if (slot == PIFS_DELTA_INDEX_SIZE)
+            {
+                slot = 0;
+            }
+        }
+    }
+
+    return slot;
+}
+
+/**
+ * @brief pifs_delta_index_add Add an entry of delta map to delta index.
+ * If the original address is already indexed, the new entry replaces
+ * the old one, as the later entry is the valid one.
+ *
+ * @param[in] a_delta_entry_idx Index of entry in delta map.
+ */
+static void pifs_delta_index_add(pifs_size_t a_delta_entry_idx)
+{
+    pifs_delta_entry_t * delta_entry = pifs_get_delta_entry(a_delta_entry_idx);
+    pifs_size_t          slot;
+
+    slot = pifs_delta_index_find(delta_entry->orig_address.block_address,
+                                 delta_entry->orig_address.page_address);
+    pifs.delta_index[slot] = (pifs_delta_index_t)a_delta_entry_idx;
+}
+
+/**
+ * @brief pifs_delta_index_build Build delta index and delta presence filter
+ * from delta map buffer.
+ */
+static void pifs_delta_index_build(void)
+{
+    pifs_size_t          i;
+    pifs_delta_entry_t * delta_entry;
+    pifs_checksum_t      checksum;
+
+    memset(pifs.delta_index, 0xFF, sizeof(pifs.delta_index));
+#if PIFS_DELTA_FILTER_PAGE_NUM
+    memset(pifs.delta_filter, 0, sizeof(pifs.delta_filter));
+#endif
+    pifs.delta_map_free_entry_num = 0;
+#if PIFS_DELTA_PATCH_PAGE_NUM
+    pifs.delta_patch_page_num = 0;
+#endif
+    for (i = 0; i < PIFS_DELTA_MAP_PAGE_NUM_USED * PIFS_DELTA_ENTRY_PER_PAGE; i++)
+    {
+        delta_entry = pifs_get_delta_entry(i);
+        checksum = pifs_calc_checksum(delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE);
+        if (checksum == delta_entry->checksum)
+        {
+            if (delta_entry->orig_address.block_address == PIFS_BLOCK_ADDRESS_INVALID)
+            {
+                /* Link of chained page or address of patch page, not indexed */
+#if PIFS_DELTA_PATCH_PAGE_NUM
+                if (delta_entry->orig_address.page_address < PIFS_DELTA_PATCH_PAGE_NUM)
+                {
+                    pifs.delta_patch_address[delta_entry->orig_address.page_address] = delta_entry->delta_address;
+                    if (pifs.delta_patch_page_num <= delta_entry->orig_address.page_address)
+                    {
+                        pifs.delta_patch_page_num = delta_entry->orig_address.page_address + 1;
+                    }
+                }
+#endif
+            }
+            else
+            {
+                pifs_delta_index_add(i);
+#if PIFS_DELTA_FILTER_PAGE_NUM
+                pifs_delta_filter_set(delta_entry->orig_address.block_address,
+                                      delta_entry->orig_address.page_address);
+#endif
+            }
+        }
+        else if (pifs_is_buffer_erased(delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE)
+                 && !pifs_is_delta_link_slot(i))
+        {
+            pifs.delta_map_free_entry_num++;
+        }
+    }
+}
+#endif
+
+#if PIFS_DELTA_PATCH_PAGE_NUM
+/**
+ * @brief pifs_is_delta_patch_valid Check if a patch is valid: its base page
+ * is the latest page of the original page. Patch is obsolete if the
+ * original page got a new delta page after the patch.
+ *
+ * @param[in] a_patch   Pointer to patch.
+ * @return TRUE: patch is valid.
+ */
+static bool_t pifs_is_delta_patch_valid(pifs_delta_patch_t * a_patch)
+{
+    pifs_size_t          slot;
+    pifs_block_address_t ba = a_patch->orig_address.block_address;
+    pifs_page_address_t  pa = a_patch->orig_address.page_address;
+
+    slot = pifs_delta_index_find(ba, pa);
+    if (pifs.delta_index[slot] != PIFS_DELTA_INDEX_EMPTY)
+    {
+        ba = pifs_get_delta_entry(pifs.delta_index[slot])->delta_address.block_address;
+        pa = pifs_get_delta_entry(pifs.delta_index[slot])->delta_address.page_address;
+    }
+
+    return (a_patch->base_address.block_address == ba
+            && a_patch->base_address.page_address == pa);
+}
+
+/**
+ * @brief pifs_count_delta_patched_pages Count pages which have valid patches.
+ *
+ * @return Number of patched pages.
+ */
+static pifs_size_t pifs_count_delta_patched_pages(void)
+{
+    pifs_size_t          page_num = 0;
+    pifs_size_t          i;
+    pifs_size_t          j;
+    pifs_size_t          pos;
+    pifs_size_t          prev_pos;
+    pifs_delta_patch_t * patch;
+    pifs_delta_patch_t * prev_patch;
+    bool_t               is_counted;
+
+    for (i = 0; i < pifs.delta_patch_page_num; i++)
+    {
+        pos = 0;
+        while (pos < pifs.delta_patch_size[i])
+        {
+            patch = (pifs_delta_patch_t*) &pifs.delta_patch_page_buf[i][pos];
+            if (pifs_is_delta_patch_valid(patch))
+            {
+                /* Check if page is counted at a previous patch */
+                is_counted = FALSE;
+                for (j = 0; j <= i && !is_counted; j++)
+                {
+                    prev_pos = 0;
+                    while (prev_pos < (j == i ? pos : pifs.delta_patch_size[j]) && !is_counted)
+                    {
+                        prev_patch = (pifs_delta_patch_t*) &pifs.delta_patch_page_buf[j][prev_pos];
+                        is_counted = (prev_patch->orig_address.block_address == patch->orig_address.block_address
+                                      && prev_patch->orig_address.page_address == patch->orig_address.page_address
+                                      && prev_patch->base_address.block_address == patch->base_address.block_address
+                                      && prev_patch->base_address.page_address == patch->base_address.page_address);
+                        prev_pos += PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + prev_patch->size;
+                    }
+                }
+                if (!is_counted)
+                {
+                    page_num++;
+                }
+            }
+            pos += PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + patch->size;
+        }
+    }
+
+    return page_num;
+}
+
+/**
+ * @brief pifs_apply_delta_patch Apply patches of a page to a buffer.
+ * Patches are applied in order of writing, so later patch overrides
+ * earlier one.
+ *
+ * @param[in] a_block_address       Block address of original page.
+ * @param[in] a_page_address        Page address of original page.
+ * @param[in] a_base_block_address  Block address of latest page (original or delta page).
+ * @param[in] a_base_page_address   Page address of latest page (original or delta page).
+ * @param[in] a_page_offset         Offset of buffer in the page.
+ * @param[out] a_buf                Buffer to patch or NULL to check patches only.
+ * @param[in] a_buf_size            Size of buffer.
+ * @return TRUE: page has patch.
+ */
+static bool_t pifs_apply_delta_patch(pifs_block_address_t a_block_address,
+                                     pifs_page_address_t a_page_address,
+                                     pifs_block_address_t a_base_block_address,
+                                     pifs_page_address_t a_base_page_address,
+                                     pifs_page_offset_t a_page_offset,
+                                     uint8_t * a_buf,
+                                     pifs_size_t a_buf_size)
+{
+    bool_t               ret = FALSE;
+    pifs_size_t          i;
+    pifs_size_t          pos;
+    pifs_size_t          start;
+    pifs_size_t          end;
+    pifs_delta_patch_t * patch;
+
+#if PIFS_DELTA_FILTER_PAGE_NUM
+    if (pifs_is_delta_filter_set(a_block_address, a_page_address))
+#endif
+    {
+        for (i = 0; i < pifs.delta_patch_page_num; i++)
+        {
+            pos = 0;
+            while (pos < pifs.delta_patch_size[i])
+            {
+                patch = (pifs_delta_patch_t*) &pifs.delta_patch_page_buf[i][pos];
+                if (patch->orig_address.block_address == a_block_address
+                        && patch->orig_address.page_address == a_page_address
+                        && patch->base_address.block_address == a_base_block_address
+                        && patch->base_address.page_address == a_base_page_address)
+                {
+                    ret = TRUE;
+                    start = PIFS_MAX(patch->offset, a_page_offset);
+                    end = PIFS_MIN(patch->offset + patch->size, a_page_offset + a_buf_size);
+                    if (a_buf && start < end)
+                    {
+                        memcpy(&a_buf[start - a_page_offset],
+                               &pifs.delta_patch_page_buf[i][pos + PIFS_DELTA_PATCH_HEADER_SIZE_BYTE
+                                                             + start - patch->offset],
+                               end - start);
+                    }
+                }
+                pos += PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + patch->size;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_read_delta_patch_page Read patch pages to memory buffer and
+ * check patches. Patches after an invalid one (e.g. interrupted write) are
+ * ignored and no more patch is written to that page.
+ *
+ * @return PIFS_SUCCESS if read successfully.
+ */
+static pifs_status_t pifs_read_delta_patch_page(void)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_size_t          i;
+    pifs_size_t          pos;
+    pifs_delta_patch_t * patch;
+    bool_t               is_valid = TRUE;
+
+    memset(pifs.delta_patch_page_buf, PIFS_FLASH_ERASED_BYTE_VALUE, sizeof(pifs.delta_patch_page_buf));
+    /* New patch page is needed for the first patch */
+    pifs.delta_patch_write_pos = PIFS_LOGICAL_PAGE_SIZE_BYTE;
+    for (i = 0; i < pifs.delta_patch_page_num && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_read(pifs.delta_patch_address[i].block_address,
+                        pifs.delta_patch_address[i].page_address, 0,
+                        pifs.delta_patch_page_buf[i], PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        pos = 0;
+        is_valid = TRUE;
+        while (ret == PIFS_SUCCESS && is_valid
+               && pos + PIFS_DELTA_PATCH_HEADER_SIZE_BYTE <= PIFS_LOGICAL_PAGE_SIZE_BYTE
+               && !pifs_is_buffer_erased(&pifs.delta_patch_page_buf[i][pos], PIFS_DELTA_PATCH_HEADER_SIZE_BYTE))
+        {
+            patch = (pifs_delta_patch_t*) &pifs.delta_patch_page_buf[i][pos];
+            is_valid = (pifs_calc_checksum(patch, PIFS_DELTA_PATCH_HEADER_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE)
+                        == patch->checksum
+                        && patch->size <= PIFS_DELTA_PATCH_SIZE_MAX
+                        && patch->offset + patch->size <= PIFS_LOGICAL_PAGE_SIZE_BYTE
+                        && pos + PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + patch->size <= PIFS_LOGICAL_PAGE_SIZE_BYTE
+                        && pifs_calc_checksum(&pifs.delta_patch_page_buf[i][pos + PIFS_DELTA_PATCH_HEADER_SIZE_BYTE],
+                                              patch->size) == patch->data_checksum);
+            if (is_valid)
+            {
+#if PIFS_DELTA_FILTER_PAGE_NUM
+                pifs_delta_filter_set(patch->orig_address.block_address,
+                                      patch->orig_address.page_address);
+#endif
+                pos += PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + patch->size;
+            }
+            else
+            {
+                PIFS_WARNING_MSG("Invalid patch at %s, offset %lu\r\n",
+                                 pifs_address2str(&pifs.delta_patch_address[i]), (unsigned long) pos);
+            }
+        }
+        pifs.delta_patch_size[i] = pos;
+        pifs.delta_patch_write_pos = is_valid ? pos : PIFS_LOGICAL_PAGE_SIZE_BYTE;
+    }
+    pifs.delta_patched_page_num = pifs_count_delta_patched_pages();
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_read_delta_map_page Read delta map pages to memory buffer.
+ * Chained pages are followed.
  *
  * @param[in] a_header          File system's header to use.
  *
@@ -48,6 +512,9 @@ static pifs_status_t pifs_read_delta_map_page(pifs_header_t * a_header)
     pifs_page_address_t  pa = a_header->delta_map_address.page_address;
     pifs_size_t          i;
     pifs_status_t        ret = PIFS_SUCCESS;
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    pifs_address_t       address;
+#endif
 
     for (i = 0; i < PIFS_DELTA_MAP_PAGE_NUM && ret == PIFS_SUCCESS; i++)
     {
@@ -57,9 +524,30 @@ static pifs_status_t pifs_read_delta_map_page(pifs_header_t * a_header)
             ret = pifs_inc_ba_pa(&ba, &pa);
         }
     }
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    pifs.delta_map_page_num = PIFS_DELTA_MAP_PAGE_NUM;
+    memset(pifs.delta_map_page_buf[PIFS_DELTA_MAP_PAGE_NUM], PIFS_FLASH_ERASED_BYTE_VALUE,
+           PIFS_DELTA_MAP_EXT_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE);
+    while (ret == PIFS_SUCCESS && pifs_get_delta_link(pifs.delta_map_page_num - 1, &address))
+    {
+        PIFS_DEBUG_MSG("Chained delta map page %s\r\n", pifs_address2str(&address));
+        pifs.delta_map_ext_address[pifs.delta_map_page_num - PIFS_DELTA_MAP_PAGE_NUM] = address;
+        ret = pifs_read(address.block_address, address.page_address, 0,
+                        &pifs.delta_map_page_buf[pifs.delta_map_page_num], PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        pifs.delta_map_page_num++;
+    }
+#endif
     if (ret == PIFS_SUCCESS)
     {
         pifs.delta_map_page_is_read = TRUE;
+#if PIFS_ENABLE_DELTA_INDEX
+        pifs_delta_index_build();
+#elif PIFS_DELTA_FILTER_PAGE_NUM
+        pifs_delta_filter_build();
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+        ret = pifs_read_delta_patch_page();
+#endif
     }
 
     return ret;
@@ -81,12 +569,20 @@ static pifs_status_t pifs_write_delta_map_page(pifs_size_t a_delta_map_page_idx,
     if (a_delta_map_page_idx < PIFS_DELTA_MAP_PAGE_NUM)
     {
         ret = pifs_add_ba_pa(&ba, &pa, a_delta_map_page_idx);
-        if (ret == PIFS_SUCCESS)
-        {
-            ret = pifs_write(ba, pa, 0, &pifs.delta_map_page_buf[a_delta_map_page_idx],
-                             PIFS_LOGICAL_PAGE_SIZE_BYTE);
-            PIFS_WARNING_MSG("%s ret: %i\r\n", pifs_ba_pa2str(ba, pa), ret);
-        }
+    }
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    else if (a_delta_map_page_idx < pifs.delta_map_page_num)
+    {
+        /* Chained page */
+        ba = pifs.delta_map_ext_address[a_delta_map_page_idx - PIFS_DELTA_MAP_PAGE_NUM].block_address;
+        pa = pifs.delta_map_ext_address[a_delta_map_page_idx - PIFS_DELTA_MAP_PAGE_NUM].page_address;
+    }
+#endif
+    if (ret == PIFS_SUCCESS && a_delta_map_page_idx < PIFS_DELTA_MAP_PAGE_NUM_USED)
+    {
+        ret = pifs_write(ba, pa, 0, &pifs.delta_map_page_buf[a_delta_map_page_idx],
+                         PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        PIFS_WARNING_MSG("%s ret: %i\r\n", pifs_ba_pa2str(ba, pa), ret);
     }
 
     return ret;
@@ -119,12 +615,17 @@ pifs_status_t pifs_find_delta_page(pifs_block_address_t a_block_address,
                                    pifs_header_t * a_header)
 {
     pifs_status_t        ret = PIFS_SUCCESS;
-    pifs_size_t          i;
-    pifs_size_t          j;
     pifs_delta_entry_t * delta_entry;
     pifs_block_address_t ba = a_block_address;
     pifs_page_address_t  pa = a_page_address;
+    bool_t               is_filtered = FALSE;
+#if PIFS_ENABLE_DELTA_INDEX
+    pifs_size_t          slot;
+#else
+    pifs_size_t          i;
+    pifs_size_t          j;
     pifs_checksum_t      checksum;
+#endif
 
     PIFS_ASSERT(a_block_address < PIFS_BLOCK_ADDRESS_INVALID);
     PIFS_ASSERT(a_page_address < PIFS_PAGE_ADDRESS_INVALID);
@@ -133,14 +634,47 @@ pifs_status_t pifs_find_delta_page(pifs_block_address_t a_block_address,
     {
         ret = pifs_read_delta_map_page(a_header);
     }
+#if PIFS_DELTA_FILTER_PAGE_NUM
     if (ret == PIFS_SUCCESS)
+    {
+        /* Page range has no delta page, lookup is not needed */
+        is_filtered = !pifs_is_delta_filter_set(a_block_address, a_page_address);
+    }
+#endif
+#if PIFS_ENABLE_DELTA_INDEX
+    if (ret == PIFS_SUCCESS)
+    {
+        if (a_is_map_full)
+        {
+            *a_is_map_full = (pifs.delta_map_free_entry_num == 0);
+        }
+        if (!is_filtered)
+        {
+            slot = pifs_delta_index_find(a_block_address, a_page_address);
+            if (pifs.delta_index[slot] != PIFS_DELTA_INDEX_EMPTY)
+            {
+                delta_entry = pifs_get_delta_entry(pifs.delta_index[slot]);
+                ba = delta_entry->delta_address.block_address;
+                pa = delta_entry->delta_address.page_address;
+                PIFS_DEBUG_MSG("delta found %s -> ",
+                               pifs_ba_pa2str(a_block_address, a_page_address));
+                PIFS_DEBUG_MSG("%s\r\n",
+                               pifs_ba_pa2str(ba, pa));
+            }
+        }
+        *a_delta_block_address = ba;
+        *a_delta_page_address = pa;
+    }
+#else
+    /* Delta map shall be searched to check if it is full */
+    if (ret == PIFS_SUCCESS && (!is_filtered || a_is_map_full))
     {
         if (a_is_map_full)
         {
             *a_is_map_full = TRUE;
         }
         /* All delta pages shall be checked to find latest delta page! */
-        for (i = 0; i < PIFS_DELTA_MAP_PAGE_NUM; i++)
+        for (i = 0; i < PIFS_DELTA_MAP_PAGE_NUM_USED; i++)
         {
             delta_entry = (pifs_delta_entry_t*) &pifs.delta_map_page_buf[i];
             for (j = 0; j < PIFS_DELTA_ENTRY_PER_PAGE; j++)
@@ -158,7 +692,8 @@ pifs_status_t pifs_find_delta_page(pifs_block_address_t a_block_address,
                                    pifs_ba_pa2str(ba, pa));
                 }
                 if (a_is_map_full && *a_is_map_full
-                        && pifs_is_buffer_erased(&delta_entry[j], sizeof(PIFS_DELTA_ENTRY_SIZE_BYTE)))
+                        && pifs_is_buffer_erased(&delta_entry[j], sizeof(PIFS_DELTA_ENTRY_SIZE_BYTE))
+                        && !pifs_is_delta_link_slot(i * PIFS_DELTA_ENTRY_PER_PAGE + j))
                 {
                     *a_is_map_full = FALSE;
                 }
@@ -167,6 +702,12 @@ pifs_status_t pifs_find_delta_page(pifs_block_address_t a_block_address,
         *a_delta_block_address = ba;
         *a_delta_page_address = pa;
     }
+    else if (ret == PIFS_SUCCESS)
+    {
+        *a_delta_block_address = ba;
+        *a_delta_page_address = pa;
+    }
+#endif
 
     return ret;
 }
@@ -193,16 +734,30 @@ static pifs_status_t pifs_append_delta_map_entry(pifs_delta_entry_t * a_new_delt
     }
     if (ret == PIFS_SUCCESS)
     {
-        for (i = 0; i < PIFS_DELTA_MAP_PAGE_NUM && !delta_written && ret == PIFS_SUCCESS; i++)
+        for (i = 0; i < PIFS_DELTA_MAP_PAGE_NUM_USED && !delta_written && ret == PIFS_SUCCESS; i++)
         {
             delta_entry = (pifs_delta_entry_t*) &pifs.delta_map_page_buf[i];
             for (j = 0; j < PIFS_DELTA_ENTRY_PER_PAGE && !delta_written && ret == PIFS_SUCCESS; j++)
             {
-                if (pifs_is_buffer_erased(&delta_entry[j], PIFS_DELTA_ENTRY_SIZE_BYTE))
+                if (pifs_is_buffer_erased(&delta_entry[j], PIFS_DELTA_ENTRY_SIZE_BYTE)
+                        && !pifs_is_delta_link_slot(i * PIFS_DELTA_ENTRY_PER_PAGE + j))
                 {
                     delta_entry[j] = *a_new_delta_entry;
                     ret = pifs_write_delta_map_page(i, a_header);
                     delta_written = TRUE;
+                    if (a_new_delta_entry->orig_address.block_address != PIFS_BLOCK_ADDRESS_INVALID)
+                    {
+#if PIFS_DELTA_FILTER_PAGE_NUM
+                        pifs_delta_filter_set(a_new_delta_entry->orig_address.block_address,
+                                              a_new_delta_entry->orig_address.page_address);
+#endif
+#if PIFS_ENABLE_DELTA_INDEX
+                        pifs_delta_index_add(i * PIFS_DELTA_ENTRY_PER_PAGE + j);
+#endif
+                    }
+#if PIFS_ENABLE_DELTA_INDEX
+                    pifs.delta_map_free_entry_num--;
+#endif
                 }
             }
         }
@@ -215,14 +770,424 @@ static pifs_status_t pifs_append_delta_map_entry(pifs_delta_entry_t * a_new_delt
     return ret;
 }
 
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+/**
+ * @brief pifs_extend_delta_map Chain a new page to the delta map.
+ * The page is allocated in the primary management blocks, so it is
+ * released by the next merge.
+ *
+ * @param[in] a_header  File system's header to use.
+ * @return PIFS_SUCCESS if page was chained. PIFS_ERROR_NO_MORE_SPACE if
+ * delta map cannot be extended.
+ */
+static pifs_status_t pifs_extend_delta_map(pifs_header_t * a_header)
+{
+    pifs_status_t        ret = PIFS_ERROR_NO_MORE_SPACE;
+    pifs_size_t          link_entry_idx = pifs.delta_map_page_num * PIFS_DELTA_ENTRY_PER_PAGE - 1;
+    pifs_delta_entry_t * link_entry = pifs_get_delta_entry(link_entry_idx);
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_count_t    page_count_found;
+
+    PIFS_ASSERT(pifs.delta_map_page_is_read);
+    if (pifs_is_delta_link_slot(link_entry_idx)
+            && pifs_is_buffer_erased(link_entry, PIFS_DELTA_ENTRY_SIZE_BYTE))
+    {
+        ret = pifs_find_free_page_wl(1, 1, PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT,
+                                     &ba, &pa, &page_count_found);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_mark_page(ba, pa, 1, TRUE, FALSE);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            PIFS_NOTICE_MSG("Chain delta map page %s\r\n", pifs_ba_pa2str(ba, pa));
+            link_entry->orig_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+            link_entry->orig_address.page_address = PIFS_PAGE_ADDRESS_INVALID;
+            link_entry->delta_address.block_address = ba;
+            link_entry->delta_address.page_address = pa;
+            link_entry->checksum = pifs_calc_checksum(link_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE);
+            ret = pifs_write_delta_map_page(pifs.delta_map_page_num - 1, a_header);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            /* Buffer of the new page is erased */
+            pifs.delta_map_ext_address[pifs.delta_map_page_num - PIFS_DELTA_MAP_PAGE_NUM].block_address = ba;
+            pifs.delta_map_ext_address[pifs.delta_map_page_num - PIFS_DELTA_MAP_PAGE_NUM].page_address = pa;
+            pifs.delta_map_page_num++;
+#if PIFS_ENABLE_DELTA_INDEX
+            pifs.delta_map_free_entry_num += PIFS_DELTA_ENTRY_PER_PAGE;
+            if (pifs_is_delta_link_slot(pifs.delta_map_page_num * PIFS_DELTA_ENTRY_PER_PAGE - 1))
+            {
+                pifs.delta_map_free_entry_num--;
+            }
+#endif
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_get_delta_map_ext_page_num Get number of chained delta map
+ * pages. Their addresses are in pifs.delta_map_ext_address[].
+ *
+ * @param[out] a_page_num   Number of chained pages.
+ * @param[in] a_header      File system's header to use.
+ * @return PIFS_SUCCESS if delta map was read successfully.
+ */
+pifs_status_t pifs_get_delta_map_ext_page_num(pifs_size_t * a_page_num, pifs_header_t * a_header)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+
+    if (!pifs.delta_map_page_is_read)
+    {
+        ret = pifs_read_delta_map_page(a_header);
+    }
+    *a_page_num = pifs.delta_map_page_num - PIFS_DELTA_MAP_PAGE_NUM;
+
+    return ret;
+}
+#endif
+
+/**
+ * @brief pifs_write_delta_page Write page buffer (pifs.dmw_page_buf) to a
+ * new delta page and add it to the delta map.
+ *
+ * @param[in] a_block_address       Block address of original page.
+ * @param[in] a_page_address        Page address of original page.
+ * @param[in] a_old_block_address   Block address of replaced page (original or previous delta page).
+ * @param[in] a_old_page_address    Page address of replaced page (original or previous delta page).
+ * @param[in] a_header              File system's header to use.
+ * @return PIFS_SUCCESS if page was written.
+ */
+static pifs_status_t pifs_write_delta_page(pifs_block_address_t a_block_address,
+                                           pifs_page_address_t a_page_address,
+                                           pifs_block_address_t a_old_block_address,
+                                           pifs_page_address_t a_old_page_address,
+                                           pifs_header_t * a_header)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_delta_entry_t   delta_entry;
+    pifs_block_address_t fba;
+    pifs_page_address_t  fpa;
+    pifs_page_count_t    page_count_found;
+
+    ret = pifs_find_free_page_wl(1, 1, PIFS_BLOCK_TYPE_DATA,
+                                 &fba, &fpa, &page_count_found);
+    if (ret == PIFS_SUCCESS)
+    {
+        PIFS_DEBUG_MSG("free page %s\r\n", pifs_ba_pa2str(fba, fpa));
+
+        delta_entry.orig_address.block_address = a_block_address;
+        delta_entry.orig_address.page_address = a_page_address;
+        delta_entry.delta_address.block_address = fba;
+        delta_entry.delta_address.page_address = fpa;
+        delta_entry.checksum = pifs_calc_checksum(&delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE);
+        PIFS_DEBUG_MSG("delta page %s -> ",
+                       pifs_ba_pa2str(a_block_address, a_page_address));
+        PIFS_DEBUG_MSG("%s\r\n",
+                       pifs_ba_pa2str(fba, fpa));
+        ret = pifs_write(fba, fpa, 0, &pifs.dmw_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_append_delta_map_entry(&delta_entry, a_header);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            /* Mark new page as used */
+            ret = pifs_mark_page(fba, fpa, 1, TRUE, FALSE);
+            PIFS_DEBUG_MSG("Mark page %s as used: %i\r\n", pifs_ba_pa2str(fba, fpa), ret);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            /* Mark old page (original or previous delta)
+             * as to be released */
+            ret = pifs_mark_page(a_old_block_address, a_old_page_address, 1, FALSE, TRUE);
+            PIFS_DEBUG_MSG("Mark page %s as to be released: %i\r\n",
+                           pifs_ba_pa2str(a_old_block_address, a_old_page_address), ret);
+        }
+    }
+
+    return ret;
+}
+
+#if PIFS_DELTA_PATCH_PAGE_NUM
+/**
+ * @brief pifs_append_delta_patch Store a small overwrite as patch.
+ * New patch page is allocated in the primary management blocks if needed,
+ * its address is stored in the delta map. A delta entry is reserved for
+ * every patched page to fold its patches before merge.
+ * Patch is programmed directly, so the rest of the patch page is not
+ * programmed again.
+ *
+ * @param[in] a_block_address       Block address of original page.
+ * @param[in] a_page_address        Page address of original page.
+ * @param[in] a_base_block_address  Block address of latest page (original or delta page).
+ * @param[in] a_base_page_address   Page address of latest page (original or delta page).
+ * @param[in] a_page_offset         Offset in page.
+ * @param[in] a_buf                 Pointer to buffer to write.
+ * @param[in] a_buf_size            Size of buffer.
+ * @param[in] a_is_patched          TRUE: page has already valid patch.
+ * @param[in] a_header              File system's header to use.
+ * @return PIFS_SUCCESS if patch was written. PIFS_ERROR_NO_MORE_SPACE if
+ * there is no space for the patch or for the reserved delta entries.
+ */
+static pifs_status_t pifs_append_delta_patch(pifs_block_address_t a_block_address,
+                                             pifs_page_address_t a_page_address,
+                                             pifs_block_address_t a_base_block_address,
+                                             pifs_page_address_t a_base_page_address,
+                                             pifs_page_offset_t a_page_offset,
+                                             const void * const a_buf,
+                                             pifs_size_t a_buf_size,
+                                             bool_t a_is_patched,
+                                             pifs_header_t * a_header)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_size_t          patch_size = PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + a_buf_size;
+    bool_t               is_new_page = (pifs.delta_patch_write_pos + patch_size > PIFS_LOGICAL_PAGE_SIZE_BYTE);
+    pifs_size_t          entry_num = pifs.delta_patched_page_num;
+    pifs_size_t          page_idx;
+    pifs_delta_entry_t   delta_entry;
+    pifs_delta_patch_t * patch;
+    uint8_t            * patch_buf;
+    pifs_block_address_t fba;
+    pifs_page_address_t  fpa;
+    pifs_page_count_t    page_count_found;
+
+    if (!a_is_patched)
+    {
+        /* Reserved entry to fold patches of the page */
+        entry_num++;
+    }
+    if (is_new_page)
+    {
+        /* Entry of the new patch page */
+        entry_num++;
+    }
+    if ((is_new_page && pifs.delta_patch_page_num == PIFS_DELTA_PATCH_PAGE_NUM)
+            || pifs.delta_map_free_entry_num < entry_num)
+    {
+        ret = PIFS_ERROR_NO_MORE_SPACE;
+    }
+    if (ret == PIFS_SUCCESS && is_new_page)
+    {
+        ret = pifs_find_free_page_wl(1, 1, PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT,
+                                     &fba, &fpa, &page_count_found);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_mark_page(fba, fpa, 1, TRUE, FALSE);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            PIFS_NOTICE_MSG("New patch page %s\r\n", pifs_ba_pa2str(fba, fpa));
+            delta_entry.orig_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+            delta_entry.orig_address.page_address = pifs.delta_patch_page_num;
+            delta_entry.delta_address.block_address = fba;
+            delta_entry.delta_address.page_address = fpa;
+            delta_entry.checksum = pifs_calc_checksum(&delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE);
+            ret = pifs_append_delta_map_entry(&delta_entry, a_header);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            pifs.delta_patch_address[pifs.delta_patch_page_num] = delta_entry.delta_address;
+            pifs.delta_patch_size[pifs.delta_patch_page_num] = 0;
+            pifs.delta_patch_page_num++;
+            pifs.delta_patch_write_pos = 0;
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        page_idx = pifs.delta_patch_page_num - 1;
+        patch_buf = &pifs.delta_patch_page_buf[page_idx][pifs.delta_patch_write_pos];
+        patch = (pifs_delta_patch_t*) patch_buf;
+        patch->orig_address.block_address = a_block_address;
+        patch->orig_address.page_address = a_page_address;
+        patch->base_address.block_address = a_base_block_address;
+        patch->base_address.page_address = a_base_page_address;
+        patch->offset = a_page_offset;
+        patch->size = a_buf_size;
+        memcpy(&patch_buf[PIFS_DELTA_PATCH_HEADER_SIZE_BYTE], a_buf, a_buf_size);
+        patch->data_checksum = pifs_calc_checksum(&patch_buf[PIFS_DELTA_PATCH_HEADER_SIZE_BYTE], a_buf_size);
+        patch->checksum = pifs_calc_checksum(patch, PIFS_DELTA_PATCH_HEADER_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE);
+        PIFS_DEBUG_MSG("patch %s offset %i size %i\r\n",
+                       pifs_ba_pa2str(a_block_address, a_page_address), a_page_offset, a_buf_size);
+        /* Only the bytes of the new patch are programmed */
+        ret = pifs_write_through(pifs.delta_patch_address[page_idx].block_address,
+                                 pifs.delta_patch_address[page_idx].page_address,
+                                 pifs.delta_patch_write_pos, patch_buf, patch_size);
+        if (ret == PIFS_SUCCESS)
+        {
+            pifs.delta_patch_write_pos += patch_size;
+            pifs.delta_patch_size[page_idx] = pifs.delta_patch_write_pos;
+#if PIFS_DELTA_FILTER_PAGE_NUM
+            pifs_delta_filter_set(a_block_address, a_page_address);
+#endif
+            if (!a_is_patched)
+            {
+                pifs.delta_patched_page_num++;
+            }
+        }
+        else
+        {
+            /* Patch may be partially written, page is not used any more */
+            pifs.delta_patch_write_pos = PIFS_LOGICAL_PAGE_SIZE_BYTE;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_drop_delta_patch Invalidate patches of a page in RAM.
+ * Patches are not valid after merge anyway.
+ *
+ * @param[in] a_block_address       Block address of original page.
+ * @param[in] a_page_address        Page address of original page.
+ * @param[in] a_base_block_address  Block address of latest page (original or delta page).
+ * @param[in] a_base_page_address   Page address of latest page (original or delta page).
+ */
+static void pifs_drop_delta_patch(pifs_block_address_t a_block_address,
+                                  pifs_page_address_t a_page_address,
+                                  pifs_block_address_t a_base_block_address,
+                                  pifs_page_address_t a_base_page_address)
+{
+    pifs_size_t          i;
+    pifs_size_t          pos;
+    pifs_delta_patch_t * patch;
+
+    for (i = 0; i < pifs.delta_patch_page_num; i++)
+    {
+        for (pos = 0; pos < pifs.delta_patch_size[i]; pos += PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + patch->size)
+        {
+            patch = (pifs_delta_patch_t*) &pifs.delta_patch_page_buf[i][pos];
+            if (patch->orig_address.block_address == a_block_address
+                    && patch->orig_address.page_address == a_page_address
+                    && patch->base_address.block_address == a_base_block_address
+                    && patch->base_address.page_address == a_base_page_address)
+            {
+                patch->base_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+            }
+        }
+    }
+}
+
+/**
+ * @brief pifs_fold_delta_patch Write patched pages to new delta pages.
+ * It shall be called before merge, because patch pages are released by
+ * merge. Reserved delta entries are used for the new delta pages.
+ *
+ * @param[in] a_header  File system's header to use.
+ * @return PIFS_SUCCESS if patches were folded.
+ */
+pifs_status_t pifs_fold_delta_patch(pifs_header_t * a_header)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_size_t          i;
+    pifs_size_t          pos;
+    pifs_delta_patch_t * patch;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_block_address_t base_ba;
+    pifs_page_address_t  base_pa;
+
+    if (!pifs.delta_map_page_is_read)
+    {
+        ret = pifs_read_delta_map_page(a_header);
+    }
+    for (i = 0; i < pifs.delta_patch_page_num && ret == PIFS_SUCCESS; i++)
+    {
+        pos = 0;
+        while (pos < pifs.delta_patch_size[i] && ret == PIFS_SUCCESS)
+        {
+            patch = (pifs_delta_patch_t*) &pifs.delta_patch_page_buf[i][pos];
+            /* Next patches of the same page become obsolete when the
+             * first one is folded */
+            if (pifs_is_delta_patch_valid(patch))
+            {
+                ba = patch->orig_address.block_address;
+                pa = patch->orig_address.page_address;
+                base_ba = patch->base_address.block_address;
+                base_pa = patch->base_address.page_address;
+                PIFS_NOTICE_MSG("Fold patches of %s\r\n", pifs_ba_pa2str(ba, pa));
+                if (pifs_is_page_to_be_released(base_ba, base_pa))
+                {
+                    /* File was removed, page is not written */
+                    pifs_drop_delta_patch(ba, pa, base_ba, base_pa);
+                }
+                else
+                {
+                    ret = pifs_read(base_ba, base_pa, 0, &pifs.dmw_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+                    if (ret == PIFS_SUCCESS)
+                    {
+                        /* Deliberately avoiding return value: page has patch */
+                        (void)pifs_apply_delta_patch(ba, pa, base_ba, base_pa, 0,
+                                                     pifs.dmw_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+                        ret = pifs_write_delta_page(ba, pa, base_ba, base_pa, a_header);
+                    }
+                }
+                if (ret == PIFS_SUCCESS)
+                {
+                    pifs.delta_patched_page_num--;
+                }
+            }
+            pos += PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + patch->size;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_is_delta_patched Check if a page has patch. Patched pages
+ * shall be read by pifs_read_delta().
+ *
+ * @param[in] a_block_address       Block address of original page.
+ * @param[in] a_page_address        Page address of original page.
+ * @param[in] a_base_block_address  Block address of latest page (@see pifs_find_delta_page).
+ * @param[in] a_base_page_address   Page address of latest page (@see pifs_find_delta_page).
+ * @return TRUE: page has patch.
+ */
+bool_t pifs_is_delta_patched(pifs_block_address_t a_block_address,
+                             pifs_page_address_t a_page_address,
+                             pifs_block_address_t a_base_block_address,
+                             pifs_page_address_t a_base_page_address)
+{
+    return pifs_apply_delta_patch(a_block_address, a_page_address,
+                                  a_base_block_address, a_base_page_address, 0, NULL, 0);
+}
+
+/**
+ * @brief pifs_get_delta_patch_page_num Get number of patch pages.
+ * Their addresses are in pifs.delta_patch_address[].
+ *
+ * @param[out] a_page_num   Number of patch pages.
+ * @param[in] a_header      File system's header to use.
+ * @return PIFS_SUCCESS if delta map was read successfully.
+ */
+pifs_status_t pifs_get_delta_patch_page_num(pifs_size_t * a_page_num, pifs_header_t * a_header)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+
+    if (!pifs.delta_map_page_is_read)
+    {
+        ret = pifs_read_delta_map_page(a_header);
+    }
+    *a_page_num = pifs.delta_patch_page_num;
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_read_delta  Cached read with delta page handling.
+ * Patches of the page are applied.
  *
  * @param[in] a_block_address   Block address of page to read.
  * @param[in] a_page_address    Page address of page to read.
  * @param[in] a_page_offset     Offset in page.
  * @param[out] a_buf            Pointer to buffer to fill or NULL if
- *                              pifs.cache_page_buf is used.
+ *                              cached page is used (@see pifs_get_cache_page_buf).
  * @param[in] a_buf_size        Size of buffer. Ignored if a_buf is NULL.
  * @return PIFS_SUCCESS if data read successfully.
  */
@@ -247,6 +1212,14 @@ pifs_status_t pifs_read_delta(pifs_block_address_t a_block_address,
         }
         ret = pifs_read(ba, pa, a_page_offset, a_buf, a_buf_size);
     }
+#if PIFS_DELTA_PATCH_PAGE_NUM
+    if (ret == PIFS_SUCCESS && a_buf)
+    {
+        /* Deliberately avoiding return value: page may have no patch */
+        (void)pifs_apply_delta_patch(a_block_address, a_page_address, ba, pa,
+                                     a_page_offset, a_buf, a_buf_size);
+    }
+#endif
 
     return ret;
 }
@@ -254,14 +1227,16 @@ pifs_status_t pifs_read_delta(pifs_block_address_t a_block_address,
 /**
  * @brief pifs_write  Cached write with delta page handling.
  * Note: marks written page as used!
+ * If the page cannot be programmed, a delta page is written. Small
+ * overwrites are stored as patch if PIFS_DELTA_PATCH_PAGE_NUM is not zero.
  *
  * @param[in] a_block_address   Block address of page to write.
  * @param[in] a_page_address    Page address of page to write.
  * @param[in] a_page_offset     Offset in page.
  * @param[in] a_buf             Pointer to buffer to write or NULL if
- *                              pifs.cache_page_buf is directly written.
+ *                              cached page is directly written.
  * @param[in] a_buf_size        Size of buffer. Ignored if a_buf is NULL.
- * @param[out] a_is_delta       TRUE: Delta page was written. FALSE: Normal page was written.
+ * @param[out] a_is_delta       TRUE: Delta page or patch was written. FALSE: Normal page was written.
  * @param[in] a_header          File system's header to use.
  * @return PIFS_SUCCESS if data write successfully.
  */
@@ -274,27 +1249,67 @@ pifs_status_t pifs_write_delta(pifs_block_address_t a_block_address,
                                pifs_header_t * a_header)
 {
     pifs_status_t        ret = PIFS_SUCCESS;
-    pifs_delta_entry_t   delta_entry;
     bool_t               delta_needed = FALSE;
+    bool_t               is_patched = FALSE;
+    bool_t               is_patch_written = FALSE;
     pifs_block_address_t ba;
     pifs_page_address_t  pa;
-    pifs_block_address_t fba;
-    pifs_page_address_t  fpa;
-    pifs_page_count_t    page_count_found;
+    pifs_block_address_t orig_ba = a_block_address;
+    pifs_page_address_t  orig_pa = a_page_address;
     bool_t               is_delta_map_full;
 
     ret = pifs_find_delta_page(a_block_address, a_page_address, &ba, &pa, &is_delta_map_full, a_header);
+#if PIFS_DELTA_PATCH_PAGE_NUM
     if (ret == PIFS_SUCCESS)
     {
-        /* Read to page buffer */
-        ret = pifs_read(ba, pa, 0, &pifs.dmw_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        is_patched = pifs_is_delta_patched(a_block_address, a_page_address, ba, pa);
+        /* Delta entries are reserved to fold patches of other pages */
+        is_delta_map_full = (pifs.delta_map_free_entry_num
+                             <= pifs.delta_patched_page_num - (is_patched ? 1 : 0));
     }
-    /* TODO more safe to write ALWAYS delta page! */
+#endif
+#if PIFS_SKIP_FREE_PAGE_READ
+    /* Erased page is always programmable, it is not read */
+    if (ret == PIFS_SUCCESS && (is_patched || !pifs_is_page_known_erased(ba, pa)))
+#else
     if (ret == PIFS_SUCCESS)
+#endif
     {
-        delta_needed = !pifs_is_buffer_programmable(&pifs.dmw_page_buf[a_page_offset],
+        /* Read to page buffer */
+        ret = pifs_read(ba, pa, 0, &pifs.dmw_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        /* TODO more safe to write ALWAYS delta page! */
+        if (ret == PIFS_SUCCESS)
+        {
+            /* Patched page is not programmed, because its patches */
+            /* would override the new data */
+            delta_needed = is_patched
+                    || !pifs_is_buffer_programmable(&pifs.dmw_page_buf[a_page_offset],
                                                     a_buf, a_buf_size);
+        }
+#if PIFS_DELTA_PATCH_PAGE_NUM
+        if (ret == PIFS_SUCCESS && is_patched)
+        {
+            (void)pifs_apply_delta_patch(a_block_address, a_page_address, ba, pa, 0,
+                                         pifs.dmw_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        }
+#endif
     }
+#if PIFS_DELTA_PATCH_PAGE_NUM
+    if (ret == PIFS_SUCCESS && delta_needed && a_buf_size <= PIFS_DELTA_PATCH_SIZE_MAX
+            && !pifs.is_merging)
+    {
+        /* Small overwrite is stored as patch, no delta page is needed. */
+        /* Delta page is written if there is no space for the patch. */
+        is_patch_written = (pifs_append_delta_patch(a_block_address, a_page_address, ba, pa,
+                                                    a_page_offset, a_buf, a_buf_size,
+                                                    is_patched, a_header) == PIFS_SUCCESS);
+        delta_needed = !is_patch_written;
+        if (is_patch_written && a_is_delta)
+        {
+            *a_is_delta = TRUE;
+        }
+    }
+#endif
     if (ret == PIFS_SUCCESS)
     {
         if (delta_needed)
@@ -304,50 +1319,56 @@ pifs_status_t pifs_write_delta(pifs_block_address_t a_block_address,
             {
                 *a_is_delta = TRUE;
             }
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
             if (is_delta_map_full)
             {
-                PIFS_WARNING_MSG("Management blocks shall be merged!\r\n");
-                ret = pifs_merge();
+                /* Merge is needed only if no more page can be chained */
+                is_delta_map_full = (pifs_extend_delta_map(a_header) != PIFS_SUCCESS);
             }
-            if (ret == PIFS_SUCCESS)
-            {
-                ret = pifs_find_free_page_wl(1, 1, PIFS_BLOCK_TYPE_DATA,
-                                             &fba, &fpa, &page_count_found);
-            }
-            if (ret == PIFS_SUCCESS)
+#endif
+            if (is_delta_map_full)
             {
-                PIFS_DEBUG_MSG("free page %s\r\n", pifs_ba_pa2str(fba, fpa));
-
-                delta_entry.orig_address.block_address = a_block_address;
-                delta_entry.orig_address.page_address = a_page_address;
-                delta_entry.delta_address.block_address = fba;
-                delta_entry.delta_address.page_address = fpa;
-                delta_entry.checksum = pifs_calc_checksum(&delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE);
-                PIFS_DEBUG_MSG("delta page %s -> ",
-                               pifs_ba_pa2str(a_block_address, a_page_address));
-                PIFS_DEBUG_MSG("%s\r\n",
-                               pifs_ba_pa2str(fba, fpa));
-                ret = pifs_write(fba, fpa, a_page_offset, a_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+                PIFS_WARNING_MSG("Management blocks shall be merged!\r\n");
+#if PIFS_DELTA_PATCH_PAGE_NUM
+                /* Patches are folded to delta pages before merge, */
+                /* so the latest page of the original page may change */
+                ret = pifs_fold_delta_patch(a_header);
                 if (ret == PIFS_SUCCESS)
                 {
-                    ret = pifs_append_delta_map_entry(&delta_entry, a_header);
+                    ret = pifs_find_delta_page(a_block_address, a_page_address, &ba, &pa, NULL, a_header);
                 }
+                is_patched = FALSE;
+#endif
                 if (ret == PIFS_SUCCESS)
                 {
-                    /* Mark new page as used */
-                    ret = pifs_mark_page(fba, fpa, 1, TRUE, FALSE);
-                    PIFS_DEBUG_MSG("Mark page %s as used: %i\r\n", pifs_ba_pa2str(fba, fpa), ret);
+                    ret = pifs_merge();
                 }
+                /* Merge replaced original pages with their latest delta
+                 * pages in the map, so the page to be overwritten is the
+                 * original page from now. */
+                orig_ba = ba;
+                orig_pa = pa;
                 if (ret == PIFS_SUCCESS)
                 {
-                    /* Mark old page (original or previous delta)
-                     * as to be released */
-                    ret = pifs_mark_page(ba, pa, 1, FALSE, TRUE);
-                    PIFS_DEBUG_MSG("Mark page %s as to be released: %i\r\n", pifs_ba_pa2str(a_block_address, a_page_address), ret);
+                    /* Page buffer was used by merge */
+                    ret = pifs_read(ba, pa, 0, &pifs.dmw_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
                 }
             }
+            if (ret == PIFS_SUCCESS)
+            {
+                /* Rest of the page is kept */
+                memcpy(&pifs.dmw_page_buf[a_page_offset], a_buf, a_buf_size);
+                ret = pifs_write_delta_page(orig_ba, orig_pa, ba, pa, a_header);
+            }
+#if PIFS_DELTA_PATCH_PAGE_NUM
+            if (ret == PIFS_SUCCESS && is_patched)
+            {
+                /* Patches of the page are obsolete */
+                pifs.delta_patched_page_num--;
+            }
+#endif
         }
-        else
+        else if (!is_patch_written)
         {
             /* No delta page needed, simple write */
             if (a_is_delta)
@@ -357,8 +1378,18 @@ pifs_status_t pifs_write_delta(pifs_block_address_t a_block_address,
             ret = pifs_write(ba, pa, a_page_offset, a_buf, a_buf_size);
             if (ret == PIFS_SUCCESS && pifs_is_page_free(ba, pa))
             {
-                /* Mark new page as used */
-                ret = pifs_mark_page(ba, pa, 1, TRUE, FALSE);
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+                if (pifs.is_page_reserved_by_write && pifs_is_page_reservable())
+                {
+                    /* Page is marked when its map entry is written */
+                    ret = pifs_reserve_page(ba, pa, 1);
+                }
+                else
+#endif
+                {
+                    /* Mark new page as used */
+                    ret = pifs_mark_page(ba, pa, 1, TRUE, FALSE);
+                }
             }
         }
     }
@@ -372,7 +1403,25 @@ pifs_status_t pifs_write_delta(pifs_block_address_t a_block_address,
 void pifs_reset_delta(void)
 {
     memset(pifs.delta_map_page_buf, PIFS_FLASH_ERASED_BYTE_VALUE,
-           PIFS_DELTA_MAP_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE);
+           PIFS_DELTA_MAP_PAGE_NUM_MAX * PIFS_LOGICAL_PAGE_SIZE_BYTE);
     pifs.delta_map_page_is_dirty = FALSE;
     pifs.delta_map_page_is_read = FALSE;
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    /* Chained pages are released by merge */
+    pifs.delta_map_page_num = PIFS_DELTA_MAP_PAGE_NUM;
+#endif
+#if PIFS_ENABLE_DELTA_INDEX
+    memset(pifs.delta_index, 0xFF, sizeof(pifs.delta_index));
+    pifs.delta_map_free_entry_num = 0;
+#endif
+#if PIFS_DELTA_FILTER_PAGE_NUM
+    memset(pifs.delta_filter, 0, sizeof(pifs.delta_filter));
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+    /* Patch pages are released by merge */
+    memset(pifs.delta_patch_page_buf, PIFS_FLASH_ERASED_BYTE_VALUE, sizeof(pifs.delta_patch_page_buf));
+    pifs.delta_patch_page_num = 0;
+    pifs.delta_patch_write_pos = PIFS_LOGICAL_PAGE_SIZE_BYTE;
+    pifs.delta_patched_page_num = 0;
+#endif
 }
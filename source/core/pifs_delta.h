@@ -53,6 +53,17 @@ pifs_status_t pifs_write_delta(pifs_block_address_t a_block_address,
                                bool_t * a_is_delta,
                                pifs_header_t * a_header);
 void pifs_reset_delta(void);
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+pifs_status_t pifs_get_delta_map_ext_page_num(pifs_size_t * a_page_num, pifs_header_t * a_header);
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+pifs_status_t pifs_fold_delta_patch(pifs_header_t * a_header);
+bool_t pifs_is_delta_patched(pifs_block_address_t a_block_address,
+                             pifs_page_address_t a_page_address,
+                             pifs_block_address_t a_base_block_address,
+                             pifs_page_address_t a_base_page_address);
+pifs_status_t pifs_get_delta_patch_page_num(pifs_size_t * a_page_num, pifs_header_t * a_header);
+#endif
 
 #ifdef __cplusplus
 }
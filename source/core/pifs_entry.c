@@ -38,6 +38,286 @@
 #include "pifs_merge.h"
 #include "buffer.h" /* DEBUG */
 
+#if PIFS_ENTRY_INDEX_LIST_NUM
+/**
+ * @brief pifs_entry_index_hash Calculate hash of file name (FNV-1a).
+ * Only the first PIFS_FILENAME_LEN_MAX characters are used, same as
+ * comparison of names.
+ *
+ * @param[in] a_name Pointer to file name.
+ * @return Hash of file name.
+ */
+static uint32_t pifs_entry_index_hash(const pifs_char_t * a_name)
+{
+    uint32_t    hash = 2166136261u;
+    pifs_size_t i;
+
+    for (i = 0; i < PIFS_FILENAME_LEN_MAX && a_name[i] != PIFS_EOS; i++)
+    {
+        hash ^= (uint8_t)a_name[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief pifs_entry_index_insert Add a file name to entry index.
+ *
+ * @param[in] a_index       Pointer to entry index.
+ * @param[in] a_name        Pointer to file name.
+ * @param[in] a_entry_idx   Index of entry in entry list.
+ */
+static void pifs_entry_index_insert(pifs_entry_index_t * a_index,
+                                    const pifs_char_t * a_name,
+                                    pifs_size_t a_entry_idx)
+{
+    uint32_t    hash = pifs_entry_index_hash(a_name);
+    pifs_size_t slot = hash % PIFS_ENTRY_INDEX_SIZE;
+    pifs_size_t i;
+    bool_t      inserted = FALSE;
+
+    for (i = 0; i < PIFS_ENTRY_INDEX_SIZE && !inserted; i++)
+    {
+        if (a_index->slot[slot].entry_idx == PIFS_ENTRY_INDEX_EMPTY
+                || a_index->slot[slot].entry_idx == PIFS_ENTRY_INDEX_DELETED)
+        {
+            a_index->slot[slot].name_hash = (uint16_t)(hash >> 16);
+            a_index->slot[slot].entry_idx = (uint16_t)a_entry_idx;
+            inserted = TRUE;
+        }
+        /* Linear probing */
+        slot = (slot + 1) % PIFS_ENTRY_INDEX_SIZE;
+    }
+    PIFS_ASSERT(inserted);
+}
+
+/**
+ * @brief pifs_entry_index_remove Remove a file name from entry index.
+ *
+ * @param[in] a_index       Pointer to entry index.
+ * @param[in] a_name        Pointer to file name.
+ * @param[in] a_entry_idx   Index of entry in entry list.
+ */
+static void pifs_entry_index_remove(pifs_entry_index_t * a_index,
+                                    const pifs_char_t * a_name,
+                                    pifs_size_t a_entry_idx)
+{
+    pifs_size_t slot = pifs_entry_index_hash(a_name) % PIFS_ENTRY_INDEX_SIZE;
+    pifs_size_t i;
+    bool_t      removed = FALSE;
+
+    for (i = 0; i < PIFS_ENTRY_INDEX_SIZE && !removed
+         && a_index->slot[slot].entry_idx != PIFS_ENTRY_INDEX_EMPTY; i++)
+    {
+        if (a_index->slot[slot].entry_idx == a_entry_idx)
+        {
+            /* Slot cannot be emptied, it may be part of a probe sequence */
+            a_index->slot[slot].entry_idx = PIFS_ENTRY_INDEX_DELETED;
+            removed = TRUE;
+        }
+        slot = (slot + 1) % PIFS_ENTRY_INDEX_SIZE;
+    }
+}
+
+/**
+ * @brief pifs_entry_index_build Read whole entry list and build its index.
+ *
+ * @param[in] a_index                    Pointer to entry index to fill.
+ * @param[in] a_entry_list_block_address Block address of entry list.
+ * @param[in] a_entry_list_page_address  Page address of entry list.
+ * @return PIFS_SUCCESS if index can be used.
+ */
+static pifs_status_t pifs_entry_index_build(pifs_entry_index_t * a_index,
+                                            pifs_block_address_t a_entry_list_block_address,
+                                            pifs_page_address_t a_entry_list_page_address)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_address_t ba = a_entry_list_block_address;
+    pifs_page_address_t  pa = a_entry_list_page_address;
+    pifs_entry_t         entry;
+    bool_t               is_erased = FALSE;
+    pifs_size_t          i;
+    pifs_size_t          j;
+
+    a_index->entry_list_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+    a_index->entry_list_address.page_address = PIFS_PAGE_ADDRESS_INVALID;
+    memset(a_index->slot, 0xFF, sizeof(a_index->slot));
+    a_index->free_entry_idx = PIFS_ENTRY_LIST_ENTRY_NUM;
+    a_index->free_entry_count = 0;
+    a_index->to_be_released_entry_count = 0;
+
+    for (j = 0; j < PIFS_ENTRY_LIST_SIZE_PAGE && ret == PIFS_SUCCESS; j++)
+    {
+        for (i = 0; i < PIFS_ENTRY_PER_PAGE && ret == PIFS_SUCCESS; i++)
+        {
+            ret = pifs_read_entry(ba, pa, i, &entry, &is_erased);
+            if (ret == PIFS_SUCCESS)
+            {
+                if (is_erased)
+                {
+                    a_index->free_entry_count++;
+                    if (a_index->free_entry_idx == PIFS_ENTRY_LIST_ENTRY_NUM)
+                    {
+                        a_index->free_entry_idx = j * PIFS_ENTRY_PER_PAGE + i;
+                    }
+                }
+                else if (a_index->free_entry_idx != PIFS_ENTRY_LIST_ENTRY_NUM)
+                {
+                    /* Entries are appended, so used entry shall not be */
+                    /* after an erased one. Linear search shall be used. */
+                    PIFS_WARNING_MSG("Used entry after erased entry %s\r\n", pifs_ba_pa2str(ba, pa));
+                    ret = PIFS_ERROR_GENERAL;
+                }
+                else if (pifs_is_entry_deleted(&entry))
+                {
+                    a_index->to_be_released_entry_count++;
+                }
+                else
+                {
+                    pifs_entry_index_insert(a_index, (pifs_char_t*)entry.name, j * PIFS_ENTRY_PER_PAGE + i);
+                }
+            }
+        }
+        if (ret == PIFS_SUCCESS && j < PIFS_ENTRY_LIST_SIZE_PAGE - 1)
+        {
+            ret = pifs_inc_ba_pa(&ba, &pa);
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        a_index->entry_list_address.block_address = a_entry_list_block_address;
+        a_index->entry_list_address.page_address = a_entry_list_page_address;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_entry_index_get Get index of an entry list. If the entry list
+ * is not indexed yet, the least recently used index is replaced.
+ *
+ * @param[in] a_entry_list_block_address Block address of entry list.
+ * @param[in] a_entry_list_page_address  Page address of entry list.
+ * @return Pointer to entry index or NULL if entry list cannot be indexed.
+ */
+static pifs_entry_index_t * pifs_entry_index_get(pifs_block_address_t a_entry_list_block_address,
+                                                 pifs_page_address_t a_entry_list_page_address)
+{
+    pifs_entry_index_t * index = NULL;
+    pifs_entry_index_t * victim = NULL;
+    pifs_size_t          i;
+
+    for (i = 0; i < PIFS_ENTRY_INDEX_LIST_NUM && !index; i++)
+    {
+        if (pifs.entry_index[i].entry_list_address.block_address == a_entry_list_block_address
+                && pifs.entry_index[i].entry_list_address.page_address == a_entry_list_page_address)
+        {
+            index = &pifs.entry_index[i];
+        }
+        else if (!victim
+                 || (victim->entry_list_address.block_address != PIFS_BLOCK_ADDRESS_INVALID
+                     && (pifs.entry_index[i].entry_list_address.block_address == PIFS_BLOCK_ADDRESS_INVALID
+                         || (pifs.entry_index_use_cntr - pifs.entry_index[i].last_used)
+                            > (pifs.entry_index_use_cntr - victim->last_used))))
+        {
+            /* Unused or least recently used index */
+            victim = &pifs.entry_index[i];
+        }
+    }
+    if (!index && victim)
+    {
+        PIFS_DEBUG_MSG("Indexing entry list %s\r\n",
+                       pifs_ba_pa2str(a_entry_list_block_address, a_entry_list_page_address));
+        if (pifs_entry_index_build(victim, a_entry_list_block_address,
+                                   a_entry_list_page_address) == PIFS_SUCCESS)
+        {
+            index = victim;
+        }
+    }
+    if (index)
+    {
+        index->last_used = ++pifs.entry_index_use_cntr;
+    }
+
+    return index;
+}
+
+/**
+ * @brief pifs_entry_index_find Find entry by name in entry index.
+ *
+ * @param[in] a_index        Pointer to entry index.
+ * @param[in] a_name         Pointer to name to find.
+ * @param[out] a_entry       Pointer to entry to fill.
+ * @param[out] a_block_address Block address of entry's page.
+ * @param[out] a_page_address  Page address of entry's page.
+ * @param[out] a_entry_idx   Index of entry in the entry list.
+ * @return PIFS_SUCCESS if entry found.
+ * PIFS_ERROR_FILE_NOT_FOUND if entry not found.
+ */
+static pifs_status_t pifs_entry_index_find(pifs_entry_index_t * a_index,
+                                           const pifs_char_t * a_name,
+                                           pifs_entry_t * a_entry,
+                                           pifs_block_address_t * a_block_address,
+                                           pifs_page_address_t * a_page_address,
+                                           pifs_size_t * a_entry_idx)
+{
+    pifs_status_t        ret = PIFS_ERROR_FILE_NOT_FOUND;
+    uint32_t             hash = pifs_entry_index_hash(a_name);
+    pifs_size_t          slot = hash % PIFS_ENTRY_INDEX_SIZE;
+    pifs_size_t          entry_idx;
+    pifs_size_t          i;
+    bool_t               is_erased = FALSE;
+
+    for (i = 0; i < PIFS_ENTRY_INDEX_SIZE && ret == PIFS_ERROR_FILE_NOT_FOUND
+         && a_index->slot[slot].entry_idx != PIFS_ENTRY_INDEX_EMPTY; i++)
+    {
+        entry_idx = a_index->slot[slot].entry_idx;
+        if (entry_idx != PIFS_ENTRY_INDEX_DELETED
+                && a_index->slot[slot].name_hash == (uint16_t)(hash >> 16))
+        {
+            *a_block_address = a_index->entry_list_address.block_address;
+            *a_page_address = a_index->entry_list_address.page_address;
+            *a_entry_idx = entry_idx;
+            ret = pifs_add_ba_pa(a_block_address, a_page_address, entry_idx / PIFS_ENTRY_PER_PAGE);
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = pifs_read_entry(*a_block_address, *a_page_address, entry_idx % PIFS_ENTRY_PER_PAGE,
+                                      a_entry, &is_erased);
+            }
+            if (ret == PIFS_SUCCESS
+                    && (is_erased
+                        || strncmp((char*)a_entry->name, a_name, sizeof(a_entry->name)) != 0
+                        || pifs_is_entry_deleted(a_entry)))
+            {
+                /* Hash collision */
+                ret = PIFS_ERROR_FILE_NOT_FOUND;
+            }
+        }
+        slot = (slot + 1) % PIFS_ENTRY_INDEX_SIZE;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_entry_index_reset Forget all entry indexes. It shall be
+ * called when entry lists are moved, for example after merge.
+ */
+void pifs_entry_index_reset(void)
+{
+    pifs_size_t i;
+
+    for (i = 0; i < PIFS_ENTRY_INDEX_LIST_NUM; i++)
+    {
+        pifs.entry_index[i].entry_list_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+        pifs.entry_index[i].entry_list_address.page_address = PIFS_PAGE_ADDRESS_INVALID;
+        pifs.entry_index[i].last_used = 0;
+    }
+    pifs.entry_index_use_cntr = 0;
+}
+#endif
+
 /**
  * @brief pifs_read_entry Read one file or directory entry from entry list.
  *
@@ -141,10 +421,14 @@ pifs_status_t pifs_append_entry(pifs_entry_t * const a_entry,
     bool_t               created = FALSE;
     bool_t               is_erased = FALSE;
     pifs_entry_t         entry;
-    pifs_size_t          i;
-    pifs_size_t          j;
+    pifs_size_t          i = 0;
+    pifs_size_t          j = 0;
     pifs_size_t          free_entry_count;
     pifs_size_t          to_be_released_entry_count;
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    pifs_entry_index_t * index;
+    pifs_size_t          entry_idx = 0;
+#endif
 
     PIFS_DEBUG_MSG("name: [%s] entry list address: %s\r\n", a_entry->name,
                    pifs_ba_pa2str(ba, pa));
@@ -165,9 +449,19 @@ pifs_status_t pifs_append_entry(pifs_entry_t * const a_entry,
         }
     }
 
-    for (j = 0; j < PIFS_ENTRY_LIST_SIZE_PAGE && !created && ret == PIFS_SUCCESS; j++)
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    index = pifs_entry_index_get(a_entry_list_block_address, a_entry_list_page_address);
+    if (ret == PIFS_SUCCESS && index)
+    {
+        /* Start searching at the first erased entry */
+        j = index->free_entry_idx / PIFS_ENTRY_PER_PAGE;
+        i = index->free_entry_idx % PIFS_ENTRY_PER_PAGE;
+        ret = pifs_add_ba_pa(&ba, &pa, j);
+    }
+#endif
+    for ( ; j < PIFS_ENTRY_LIST_SIZE_PAGE && !created && ret == PIFS_SUCCESS; j++)
     {
-        for (i = 0; i < PIFS_ENTRY_PER_PAGE && !created && ret == PIFS_SUCCESS; i++)
+        for ( ; i < PIFS_ENTRY_PER_PAGE && !created && ret == PIFS_SUCCESS; i++)
         {
             is_erased = FALSE;
             ret = pifs_read_entry(ba, pa, i, &entry, &is_erased);
@@ -178,6 +472,9 @@ pifs_status_t pifs_append_entry(pifs_entry_t * const a_entry,
                 if (ret == PIFS_SUCCESS)
                 {
                     created = TRUE;
+#if PIFS_ENTRY_INDEX_LIST_NUM
+                    entry_idx = j * PIFS_ENTRY_PER_PAGE + i;
+#endif
                 }
                 else
                 {
@@ -186,6 +483,7 @@ pifs_status_t pifs_append_entry(pifs_entry_t * const a_entry,
                 }
             }
         }
+        i = 0;
         ret = pifs_inc_ba_pa(&ba, &pa);
     }
     if (ret == PIFS_SUCCESS && !created)
@@ -193,6 +491,22 @@ pifs_status_t pifs_append_entry(pifs_entry_t * const a_entry,
         PIFS_ERROR_MSG("No more space!\r\n");
         ret = PIFS_ERROR_NO_MORE_ENTRY;
     }
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    if (index)
+    {
+        if (created)
+        {
+            pifs_entry_index_insert(index, (pifs_char_t*)a_entry->name, entry_idx);
+            index->free_entry_idx = entry_idx + 1;
+            index->free_entry_count--;
+        }
+        else
+        {
+            /* Index will be rebuilt at next access */
+            index->entry_list_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+        }
+    }
+#endif
 
     return ret;
 }
@@ -218,60 +532,108 @@ pifs_status_t pifs_update_entry(const pifs_char_t * a_name, pifs_entry_t * const
     pifs_status_t        ret = PIFS_SUCCESS;
     pifs_block_address_t ba = a_entry_list_block_address;
     pifs_page_address_t  pa = a_entry_list_page_address;
+    pifs_block_address_t entry_ba = PIFS_BLOCK_ADDRESS_INVALID;
+    pifs_page_address_t  entry_pa = PIFS_PAGE_ADDRESS_INVALID;
+    pifs_size_t          entry_idx = 0;
     bool_t               found = FALSE;
     bool_t               is_erased = FALSE;
     pifs_entry_t         entry;
     pifs_size_t          i;
     pifs_size_t          j;
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    pifs_entry_index_t * index;
+#endif
 
     PIFS_DEBUG_MSG("name: [%s] entry list address: %s\r\n", a_name,
                    pifs_ba_pa2str(ba, pa));
 
-    for (j = 0; j < PIFS_ENTRY_LIST_SIZE_PAGE && !found && ret == PIFS_SUCCESS; j++)
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    index = pifs_entry_index_get(a_entry_list_block_address, a_entry_list_page_address);
+    if (index)
     {
-        for (i = 0; i < PIFS_ENTRY_PER_PAGE && !found && ret == PIFS_SUCCESS; i++)
+        ret = pifs_entry_index_find(index, a_name, &entry, &entry_ba, &entry_pa, &entry_idx);
+        if (ret == PIFS_SUCCESS)
         {
-            ret = pifs_read_entry(ba, pa, i, &entry, &is_erased);
-            /* Check if name matches and not deleted */
-            if (ret == PIFS_SUCCESS
-                    && !is_erased
-                    && (strncmp((char*)entry.name, a_name, sizeof(entry.name)) == 0)
-                    && !pifs_is_entry_deleted(&entry))
+            found = TRUE;
+        }
+        else if (ret == PIFS_ERROR_FILE_NOT_FOUND)
+        {
+            ret = PIFS_SUCCESS;
+        }
+    }
+    else
+#endif
+    {
+        for (j = 0; j < PIFS_ENTRY_LIST_SIZE_PAGE && !found && ret == PIFS_SUCCESS; j++)
+        {
+            for (i = 0; i < PIFS_ENTRY_PER_PAGE && !found && ret == PIFS_SUCCESS; i++)
             {
-                /* Entry found */
-                /* Copy entry */
-#if PIFS_USE_DELTA_FOR_ENTRIES
-                ret = pifs_write_entry(ba, pa, i, TRUE, a_entry);
-#else
-                /* Clear entry because file content will be re-used */
-                memset(&entry, PIFS_FLASH_PROGRAMMED_BYTE_VALUE, PIFS_ENTRY_SIZE_BYTE);
-                ret = pifs_write_entry(ba, pa, i, FALSE, &entry);
-                if (ret == PIFS_SUCCESS)
+                ret = pifs_read_entry(ba, pa, i, &entry, &is_erased);
+                /* Check if name matches and not deleted */
+                if (ret == PIFS_SUCCESS
+                        && !is_erased
+                        && (strncmp((char*)entry.name, a_name, sizeof(entry.name)) == 0)
+                        && !pifs_is_entry_deleted(&entry))
                 {
-                    ret = pifs_append_entry(a_entry,
-                            a_entry_list_block_address,
-                            a_entry_list_page_address);
-                    if (ret == PIFS_ERROR_NO_MORE_ENTRY)
-                    {
-                        /* If there is not enough space, nothing to do */
-                        /* pifs_merge_check() tries to release enough space */
-                        /* to be able to close all opened files for merge. */
-                        PIFS_ERROR_MSG("Cannot update entry!\r\n");
-                    }
-                    else
-                    {
-                        PIFS_NOTICE_MSG("Entry appended\r\n");
-                    }
-                    if (a_is_merge_allowed)
-                    {
-                        ret = pifs_merge_check(NULL, 0);
-                    }
+                    /* Entry found */
+                    entry_ba = ba;
+                    entry_pa = pa;
+                    entry_idx = j * PIFS_ENTRY_PER_PAGE + i;
+                    found = TRUE;
                 }
+            }
+            if (!found)
+            {
+                ret = pifs_inc_ba_pa(&ba, &pa);
+            }
+        }
+    }
+
+    if (ret == PIFS_SUCCESS && found)
+    {
+        /* Copy entry */
+#if PIFS_USE_DELTA_FOR_ENTRIES
+        ret = pifs_write_entry(entry_ba, entry_pa, entry_idx % PIFS_ENTRY_PER_PAGE, TRUE, a_entry);
+#if PIFS_ENTRY_INDEX_LIST_NUM
+        if (index)
+        {
+            pifs_entry_index_remove(index, a_name, entry_idx);
+            pifs_entry_index_insert(index, (pifs_char_t*)a_entry->name, entry_idx);
+        }
+#endif
+#else
+#if PIFS_ENTRY_INDEX_LIST_NUM
+        if (index)
+        {
+            pifs_entry_index_remove(index, a_name, entry_idx);
+            index->to_be_released_entry_count++;
+        }
 #endif
-                found = TRUE;
+        /* Clear entry because file content will be re-used */
+        memset(&entry, PIFS_FLASH_PROGRAMMED_BYTE_VALUE, PIFS_ENTRY_SIZE_BYTE);
+        ret = pifs_write_entry(entry_ba, entry_pa, entry_idx % PIFS_ENTRY_PER_PAGE, FALSE, &entry);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_append_entry(a_entry,
+                    a_entry_list_block_address,
+                    a_entry_list_page_address);
+            if (ret == PIFS_ERROR_NO_MORE_ENTRY)
+            {
+                /* If there is not enough space, nothing to do */
+                /* pifs_merge_check() tries to release enough space */
+                /* to be able to close all opened files for merge. */
+                PIFS_ERROR_MSG("Cannot update entry!\r\n");
+            }
+            else
+            {
+                PIFS_NOTICE_MSG("Entry appended\r\n");
+            }
+            if (a_is_merge_allowed)
+            {
+                ret = pifs_merge_check(NULL, 0);
             }
         }
-        ret = pifs_inc_ba_pa(&ba, &pa);
+#endif
     }
 
     if (ret == PIFS_SUCCESS && !found)
@@ -324,47 +686,85 @@ pifs_status_t pifs_find_entry(pifs_entry_cmd_t a_entry_cmd,
     pifs_status_t        ret = PIFS_SUCCESS;
     pifs_block_address_t ba = a_entry_list_block_address;
     pifs_page_address_t  pa = a_entry_list_page_address;
+    pifs_block_address_t entry_ba = PIFS_BLOCK_ADDRESS_INVALID;
+    pifs_page_address_t  entry_pa = PIFS_PAGE_ADDRESS_INVALID;
+    pifs_size_t          entry_idx = 0;
     bool_t               found = FALSE;
     bool_t               is_erased = FALSE;
     pifs_entry_t         entry;
     pifs_size_t          i;
     pifs_size_t          j;
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    pifs_entry_index_t * index;
+#endif
 
     PIFS_DEBUG_MSG("cmd: %i, name: [%s], entry list address: %s\r\n",
                    a_entry_cmd, a_name, pifs_ba_pa2str(ba, pa));
 
-    for (j = 0; j < PIFS_ENTRY_LIST_SIZE_PAGE && !found && !is_erased && ret == PIFS_SUCCESS; j++)
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    index = pifs_entry_index_get(a_entry_list_block_address, a_entry_list_page_address);
+    if (index)
     {
-        for (i = 0; i < PIFS_ENTRY_PER_PAGE && !found && !is_erased && ret == PIFS_SUCCESS; i++)
+        ret = pifs_entry_index_find(index, a_name, &entry, &entry_ba, &entry_pa, &entry_idx);
+        if (ret == PIFS_SUCCESS)
         {
-            ret = pifs_read_entry(ba, pa, i, &entry, &is_erased);
-            /* Check if name matches and not deleted */
-            if (ret == PIFS_SUCCESS
-                    && (strncmp((char*)entry.name, a_name, sizeof(entry.name)) == 0)
-                    && !pifs_is_entry_deleted(&entry))
+            found = TRUE;
+        }
+        else if (ret == PIFS_ERROR_FILE_NOT_FOUND)
+        {
+            ret = PIFS_SUCCESS;
+        }
+    }
+    else
+#endif
+    {
+        for (j = 0; j < PIFS_ENTRY_LIST_SIZE_PAGE && !found && !is_erased && ret == PIFS_SUCCESS; j++)
+        {
+            for (i = 0; i < PIFS_ENTRY_PER_PAGE && !found && !is_erased && ret == PIFS_SUCCESS; i++)
             {
-                /* Entry found */
-                if (a_entry)
-                {
-                    /* Copy entry */
-                    memcpy(a_entry, &entry, PIFS_ENTRY_SIZE_BYTE);
-                    PIFS_DEBUG_MSG("file size: %i bytes\r\n", a_entry->file_size);
-                }
-                if (a_entry_cmd == PIFS_FIND_ENTRY)
-                {
-                    /* Already copied */
-                }
-                else if (a_entry_cmd == PIFS_DELETE_ENTRY)
+                ret = pifs_read_entry(ba, pa, i, &entry, &is_erased);
+                /* Check if name matches and not deleted */
+                if (ret == PIFS_SUCCESS
+                        && (strncmp((char*)entry.name, a_name, sizeof(entry.name)) == 0)
+                        && !pifs_is_entry_deleted(&entry))
                 {
-                    memset(&entry, PIFS_FLASH_PROGRAMMED_BYTE_VALUE, PIFS_ENTRY_SIZE_BYTE);
-                    ret = pifs_write_entry(ba, pa, i, FALSE, &entry);
+                    /* Entry found */
+                    entry_ba = ba;
+                    entry_pa = pa;
+                    entry_idx = j * PIFS_ENTRY_PER_PAGE + i;
+                    found = TRUE;
                 }
-                found = TRUE;
+            }
+            if (!found && j < PIFS_ENTRY_LIST_SIZE_PAGE - 1)
+            {
+                ret = pifs_inc_ba_pa(&ba, &pa);
             }
         }
-        if (j < PIFS_ENTRY_LIST_SIZE_PAGE - 1)
+    }
+
+    if (ret == PIFS_SUCCESS && found)
+    {
+        if (a_entry)
         {
-            ret = pifs_inc_ba_pa(&ba, &pa);
+            /* Copy entry */
+            memcpy(a_entry, &entry, PIFS_ENTRY_SIZE_BYTE);
+            PIFS_DEBUG_MSG("file size: %i bytes\r\n", a_entry->file_size);
+        }
+        if (a_entry_cmd == PIFS_FIND_ENTRY)
+        {
+            /* Already copied */
+        }
+        else if (a_entry_cmd == PIFS_DELETE_ENTRY)
+        {
+#if PIFS_ENTRY_INDEX_LIST_NUM
+            if (index)
+            {
+                pifs_entry_index_remove(index, a_name, entry_idx);
+                index->to_be_released_entry_count++;
+            }
+#endif
+            memset(&entry, PIFS_FLASH_PROGRAMMED_BYTE_VALUE, PIFS_ENTRY_SIZE_BYTE);
+            ret = pifs_write_entry(entry_ba, entry_pa, entry_idx % PIFS_ENTRY_PER_PAGE, FALSE, &entry);
         }
     }
 
@@ -421,25 +821,37 @@ pifs_status_t pifs_count_entries(pifs_size_t * a_free_entry_count, pifs_size_t *
     pifs_size_t          free_entry_count = 0;
     pifs_size_t          to_be_released_entry_count = 0;
     bool_t               is_erased = FALSE;
+#if PIFS_ENTRY_INDEX_LIST_NUM
+    pifs_entry_index_t * index;
 
-    for (j = 0; j < PIFS_ENTRY_LIST_SIZE_PAGE && ret == PIFS_SUCCESS; j++)
+    index = pifs_entry_index_get(a_entry_list_block_address, a_entry_list_page_address);
+    if (index)
     {
-        for (i = 0; i < PIFS_ENTRY_PER_PAGE && ret == PIFS_SUCCESS; i++)
+        free_entry_count = index->free_entry_count;
+        to_be_released_entry_count = index->to_be_released_entry_count;
+    }
+    else
+#endif
+    {
+        for (j = 0; j < PIFS_ENTRY_LIST_SIZE_PAGE && ret == PIFS_SUCCESS; j++)
         {
-            ret = pifs_read_entry(ba, pa, i, &entry, &is_erased);
-            /* Check if this area is used */
-            if (is_erased)
-            {
-                /* Empty entry found */
-                free_entry_count++;
-            }
-            if (pifs_is_entry_deleted(&entry))
+            for (i = 0; i < PIFS_ENTRY_PER_PAGE && ret == PIFS_SUCCESS; i++)
             {
-                /* Cleared entry found */
-                to_be_released_entry_count++;
+                ret = pifs_read_entry(ba, pa, i, &entry, &is_erased);
+                /* Check if this area is used */
+                if (is_erased)
+                {
+                    /* Empty entry found */
+                    free_entry_count++;
+                }
+                if (pifs_is_entry_deleted(&entry))
+                {
+                    /* Cleared entry found */
+                    to_be_released_entry_count++;
+                }
             }
+            ret = pifs_inc_ba_pa(&ba, &pa);
         }
-        ret = pifs_inc_ba_pa(&ba, &pa);
     }
     *a_free_entry_count = free_entry_count;
     *a_to_be_released_entry_count = to_be_released_entry_count;
@@ -117,6 +117,22 @@ pifs_status_t pifs_internal_open(pifs_file_t * a_file,
     a_file->actual_map_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
     a_file->actual_map_address.page_address = PIFS_PAGE_ADDRESS_INVALID;
     a_file->is_entry_changed = FALSE;
+#if PIFS_ENABLE_FALLOCATE
+    a_file->alloc_page_count = PIFS_ALLOC_PAGE_COUNT_UNKNOWN;
+#endif
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+    a_file->pending_map_page_count = 0;
+#endif
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+    a_file->tail_map_entry_idx = 0;
+#endif
+#if PIFS_EXTENT_CACHE_NUM
+    pifs_extent_reset(a_file);
+#endif
+#if PIFS_READ_AHEAD_PAGE_NUM
+    a_file->read_end_pos = 0;
+    a_file->read_ahead_page_count = 0;
+#endif
     if (a_modes)
     {
         pifs_parse_open_mode(a_file, a_modes);
@@ -212,7 +228,9 @@ pifs_status_t pifs_internal_open(pifs_file_t * a_file,
                                                         PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT,
                                                         &ba, &pa, &page_count_found);
             }
-            if (a_file->status == PIFS_SUCCESS)
+            /* When file is re-opened by merge, entry list address is */
+            /* already updated by pifs_copy_entry_list() */
+            if (a_file->status == PIFS_SUCCESS && a_update_entry_list_address)
             {
                 /* Update entry list address, as it may changed during merge! */
 #if PIFS_ENABLE_DIRECTORIES
@@ -236,6 +254,10 @@ pifs_status_t pifs_internal_open(pifs_file_t * a_file,
                 if (a_file->status == PIFS_SUCCESS)
                 {
                     a_file->is_opened = TRUE;
+#if PIFS_ENABLE_FALLOCATE
+                    /* New map is empty */
+                    a_file->alloc_page_count = 0;
+#endif
                 }
             }
         }
@@ -286,6 +308,9 @@ P_FILE * pifs_fopen(const pifs_char_t * a_filename, const pifs_char_t * a_modes)
         if (file->status == PIFS_SUCCESS && file->is_opened)
         {
             PIFS_NOTICE_MSG("file size: %i\r\n", file->entry.file_size);
+#if PIFS_READ_AHEAD_PAGE_NUM
+            file->advice = PIFS_FADV_NORMAL;
+#endif
         }
         else
         {
@@ -394,6 +419,58 @@ pifs_status_t pifs_inc_rw_address(pifs_file_t * a_file, bool_t a_is_read)
     return a_file->status;
 }
 
+/**
+ * @brief pifs_find_file_pages Find free data pages to append to file.
+ * Pages are searched in the block of file's actual (or pending) map entry
+ * first.
+ *
+ * @param[in] a_file                Pointer to the internal file structure.
+ * @param[in] a_page_count          Number of pages needed.
+ * @param[out] a_block_address      Block address of first free page.
+ * @param[out] a_page_address       Page address of first free page.
+ * @param[out] a_page_count_found   Number of free pages found.
+ * @return PIFS_SUCCESS if at least one free page found.
+ */
+static pifs_status_t pifs_find_file_pages(pifs_file_t * a_file,
+                                          pifs_page_count_t a_page_count,
+                                          pifs_block_address_t * a_block_address,
+                                          pifs_page_address_t * a_page_address,
+                                          pifs_page_count_t * a_page_count_found)
+{
+    pifs_status_t        ret = PIFS_ERROR_NO_MORE_SPACE;
+    pifs_block_address_t ba = a_file->map_entry.address.block_address;
+
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+    if (a_file->pending_map_page_count)
+    {
+        /* Continue pending map entry */
+        ba = a_file->pending_map_address.block_address;
+    }
+#endif
+#if PIFS_ENABLE_EXTENT_ALLOC
+    if (a_page_count > 1)
+    {
+        /* Find contiguous pages, preferably in the previous data block */
+        ret = pifs_find_extent(a_page_count, ba,
+                               a_block_address, a_page_address, a_page_count_found);
+    }
+    if (ret != PIFS_SUCCESS)
+#endif
+    {
+        /* Find a block in the previous data block */
+        ret = pifs_find_page(1, a_page_count, PIFS_BLOCK_TYPE_DATA, TRUE, FALSE,
+                             ba, a_block_address, a_page_address, a_page_count_found);
+        if (ret == PIFS_ERROR_NO_MORE_SPACE || *a_block_address != ba)
+        {
+            /* If last used block is full, try to find a not so weared block */
+            ret = pifs_find_free_page_wl(1, a_page_count, PIFS_BLOCK_TYPE_DATA,
+                                         a_block_address, a_page_address, a_page_count_found);
+        }
+    }
+
+    return ret;
+}
+
 /**
  * @brief pifs_fwrite Write to file. Works like fwrite().
  *
@@ -448,16 +525,31 @@ size_t pifs_internal_fwrite(const void * a_data, size_t a_size, size_t a_count,
     bool_t               is_free_map_entry;
     pifs_size_t          free_management_page_count = 0;
     pifs_size_t          free_data_page_count = 0;
+#if PIFS_ENABLE_FALLOCATE
+    pifs_size_t          pos;
+#endif
 
     PIFS_NOTICE_MSG("filename: '%s', size: %i, count: %i\r\n", file->entry.name, a_size, a_count);
     if (pifs.is_header_found && file && file->is_opened && file->mode_write)
     {
         file->status = PIFS_SUCCESS;
+#if PIFS_ENABLE_FSBM_BATCH
+        /* Free space bitmap and map are written by pifs_fflush() or when */
+        /* they are replaced in the cache */
+        pifs_fsbm_batch_begin();
+#endif
         /* If opened in "a" mode always jump to end of file */
         if (file->mode_append && file->rw_pos != file->entry.file_size
                 && file->entry.file_size != PIFS_FILE_SIZE_ERASED)
         {
             pifs_internal_fseek(file, 0, PIFS_SEEK_END);
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+            if (file->status == PIFS_SUCCESS)
+            {
+                /* Map was walked to the end, it need not be walked again */
+                file->status = pifs_seed_map_tail(file);
+            }
+#endif
         }
         if (file->status == PIFS_SUCCESS)
         {
@@ -482,6 +574,47 @@ size_t pifs_internal_fwrite(const void * a_data, size_t a_size, size_t a_count,
                 }
             }
         }
+#if PIFS_ENABLE_FALLOCATE
+        pos = file->rw_pos + written_size;
+        if (data_size > 0 && file->status == PIFS_SUCCESS
+                && (file->entry.file_size == PIFS_FILE_SIZE_ERASED || pos >= file->entry.file_size))
+        {
+            if (file->alloc_page_count == PIFS_ALLOC_PAGE_COUNT_UNKNOWN)
+            {
+                file->status = pifs_count_map_pages(file, &file->alloc_page_count);
+            }
+            if (file->status == PIFS_SUCCESS && written_size && !(pos % PIFS_LOGICAL_PAGE_SIZE_BYTE)
+                    && pos < file->alloc_page_count * PIFS_LOGICAL_PAGE_SIZE_BYTE)
+            {
+                /* Last page is full, step to the first reserved page */
+                file->status = pifs_inc_rw_address(file, FALSE);
+            }
+            /* Pages reserved by pifs_fallocate() are already in the map and */
+            /* marked as used, so they are written without allocation */
+            while (data_size > 0 && pos < file->alloc_page_count * PIFS_LOGICAL_PAGE_SIZE_BYTE
+                   && file->status == PIFS_SUCCESS)
+            {
+                chunk_size = PIFS_MIN(data_size, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+                PIFS_ASSERT(pifs_is_address_valid(&file->rw_address));
+                file->status = pifs_write_delta(file->rw_address.block_address,
+                                                file->rw_address.page_address,
+                                                0, data, chunk_size, &is_delta,
+                                                &pifs.header);
+                if (file->status == PIFS_SUCCESS)
+                {
+                    data += chunk_size;
+                    data_size -= chunk_size;
+                    written_size += chunk_size;
+                    pos += chunk_size;
+                    if (chunk_size == PIFS_LOGICAL_PAGE_SIZE_BYTE
+                            && pos < file->alloc_page_count * PIFS_LOGICAL_PAGE_SIZE_BYTE)
+                    {
+                        file->status = pifs_inc_rw_address(file, FALSE);
+                    }
+                }
+            }
+        }
+#endif
 
         if (data_size > 0)
         {
@@ -553,20 +686,8 @@ size_t pifs_internal_fwrite(const void * a_data, size_t a_size, size_t a_count,
                     {
                         page_count_needed_limited = PIFS_MAP_PAGE_COUNT_INVALID - 1;
                     }
-                    /* Find a block in the previous data block */
-                    file->status = pifs_find_page(1, page_count_needed_limited,
-                                                  PIFS_BLOCK_TYPE_DATA,
-                                                  TRUE, FALSE,
-                                                  file->map_entry.address.block_address,
-                                                  &ba, &pa, &page_count_found);
-                    if (file->status == PIFS_ERROR_NO_MORE_SPACE
-                            || ba != file->map_entry.address.block_address)
-                    {
-                        /* If last used block is full, try to find a not so weared block */
-                        file->status = pifs_find_free_page_wl(1, page_count_needed_limited,
-                                                              PIFS_BLOCK_TYPE_DATA,
-                                                              &ba, &pa, &page_count_found);
-                    }
+                    file->status = pifs_find_file_pages(file, page_count_needed_limited,
+                                                        &ba, &pa, &page_count_found);
                     PIFS_DEBUG_MSG("%u pages found. %s, status: %i\r\n",
                                    page_count_found, pifs_ba_pa2str(ba, pa), file->status);
                     if (file->status == PIFS_SUCCESS)
@@ -584,8 +705,15 @@ size_t pifs_internal_fwrite(const void * a_data, size_t a_size, size_t a_count,
                             {
                                 chunk_size = data_size;
                             }
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+                            /* New pages are marked when pending map entry is written */
+                            pifs.is_page_reserved_by_write = TRUE;
+#endif
                             file->status = pifs_write_delta(ba, pa, 0, data, chunk_size, &is_delta,
                                                             &pifs.header);
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+                            pifs.is_page_reserved_by_write = FALSE;
+#endif
                             PIFS_DEBUG_MSG("%s is_delta: %i status: %i\r\n", pifs_ba_pa2str(ba, pa),
                                            is_delta, file->status);
                             /* Save last page's address for future use */
@@ -605,13 +733,27 @@ size_t pifs_internal_fwrite(const void * a_data, size_t a_size, size_t a_count,
                         if (file->status == PIFS_SUCCESS && !is_delta)
                         {
                             /* Write pages to file map entry after successfully write */
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+                            file->status = pifs_defer_map_entry(file, ba_start, pa_start, page_cound_found_start);
+#else
                             file->status = pifs_append_map_entry(file, ba_start, pa_start, page_cound_found_start);
+#endif
                             //PIFS_ASSERT(file->status == PIFS_SUCCESS);
                         }
+#if PIFS_ENABLE_FALLOCATE
+                        if (file->status == PIFS_SUCCESS && !is_delta
+                                && file->alloc_page_count != PIFS_ALLOC_PAGE_COUNT_UNKNOWN)
+                        {
+                            file->alloc_page_count += page_cound_found_start;
+                        }
+#endif
                     }
                 } while (page_count_needed && file->status == PIFS_SUCCESS);
             }
         }
+#if PIFS_ENABLE_FSBM_BATCH
+        file->status = pifs_fsbm_batch_end(file->status, TRUE);
+#endif
         if (file->status == PIFS_SUCCESS)
         {
             file->rw_pos += written_size;
@@ -635,6 +777,169 @@ size_t pifs_internal_fwrite(const void * a_data, size_t a_size, size_t a_count,
     return written_size / a_size;
 }
 
+#if PIFS_DIRECT_READ_PAGE_NUM_MAX
+/**
+ * @brief pifs_fread_direct Read whole pages of file directly to the buffer.
+ * Pages are collected from map entries while they follow each other in the
+ * same block and they have no delta page. Read/write address is incremented.
+ *
+ * @param[in] a_file        Pointer to file.
+ * @param[out] a_data       Buffer to fill.
+ * @param[in] a_page_count  Maximum number of pages to read.
+ * @return Number of pages read. 0: first page shall be read by pifs_read_delta().
+ */
+static pifs_page_count_t pifs_fread_direct(pifs_file_t * a_file, uint8_t * a_data,
+                                           pifs_page_count_t a_page_count)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_page_count_t    page_count = 0;
+    pifs_block_address_t ba = a_file->rw_address.block_address;
+    pifs_page_address_t  pa = a_file->rw_address.page_address;
+    pifs_block_address_t delta_ba;
+    pifs_page_address_t  delta_pa;
+    bool_t               is_contiguous = TRUE;
+
+    while (page_count < a_page_count && is_contiguous
+           && ret == PIFS_SUCCESS && a_file->status == PIFS_SUCCESS)
+    {
+        ret = pifs_find_delta_page(a_file->rw_address.block_address,
+                                   a_file->rw_address.page_address,
+                                   &delta_ba, &delta_pa, NULL, &pifs.header);
+        /* Page without delta page is found at its original address */
+        is_contiguous = (delta_ba == a_file->rw_address.block_address
+                         && delta_pa == a_file->rw_address.page_address);
+#if PIFS_DELTA_PATCH_PAGE_NUM
+        /* Patched page is read by pifs_read_delta() */
+        is_contiguous = is_contiguous
+                && !pifs_is_delta_patched(a_file->rw_address.block_address,
+                                          a_file->rw_address.page_address,
+                                          delta_ba, delta_pa);
+#endif
+        if (ret == PIFS_SUCCESS && is_contiguous)
+        {
+            page_count++;
+            /* End of file is reported after the last page like in pifs_fread() */
+            (void)pifs_inc_rw_address(a_file, TRUE);
+            is_contiguous = (a_file->rw_address.block_address == ba
+                             && a_file->rw_address.page_address == pa + page_count);
+        }
+    }
+    if (ret == PIFS_SUCCESS && page_count)
+    {
+        ret = pifs_read_direct(ba, pa, page_count, a_data);
+    }
+    if (ret != PIFS_SUCCESS)
+    {
+        a_file->status = ret;
+    }
+
+    return page_count;
+}
+#endif
+
+#if PIFS_READ_AHEAD_PAGE_NUM
+/**
+ * @brief pifs_read_ahead_drop Forget read-ahead buffers which contain any of
+ * the given pages. It shall be called when the pages are written or erased.
+ *
+ * @param[in] a_block_address   Block address of first page.
+ * @param[in] a_page_address    Page address of first page.
+ * @param[in] a_page_count      Number of pages.
+ */
+void pifs_read_ahead_drop(pifs_block_address_t a_block_address,
+                          pifs_page_address_t a_page_address,
+                          pifs_page_count_t a_page_count)
+{
+    pifs_size_t   i;
+    pifs_file_t * file;
+
+    for (i = 0; i <= PIFS_OPEN_FILE_NUM_MAX; i++)
+    {
+        file = (i < PIFS_OPEN_FILE_NUM_MAX) ? &pifs.file[i] : &pifs.internal_file;
+        if (file->read_ahead_page_count
+                && file->read_ahead_address.block_address == a_block_address
+                && file->read_ahead_address.page_address < a_page_address + a_page_count
+                && a_page_address < file->read_ahead_address.page_address + file->read_ahead_page_count)
+        {
+            file->read_ahead_page_count = 0;
+        }
+    }
+}
+
+/**
+ * @brief pifs_fread_page Read part of actual page of file.
+ * If read-ahead is enabled and the page is not in the read-ahead buffer, rest
+ * of actual map entry is read to the buffer by one flash read. Pages which
+ * have delta page or patch are read by pifs_read_delta().
+ *
+ * @param[in] a_file            Pointer to file.
+ * @param[in] a_is_read_ahead   TRUE: read-ahead buffer can be filled.
+ * @param[in] a_pos             Position in file to read from.
+ * @param[out] a_data           Buffer to fill.
+ * @param[in] a_size            Number of bytes to read, shall not exceed the page.
+ * @return PIFS_SUCCESS if data read successfully.
+ */
+static pifs_status_t pifs_fread_page(pifs_file_t * a_file, bool_t a_is_read_ahead,
+                                     pifs_size_t a_pos, uint8_t * a_data, pifs_size_t a_size)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_address_t ba = a_file->rw_address.block_address;
+    pifs_page_address_t  pa = a_file->rw_address.page_address;
+    pifs_page_offset_t   po = a_pos % PIFS_LOGICAL_PAGE_SIZE_BYTE;
+    pifs_block_address_t delta_ba;
+    pifs_page_address_t  delta_pa;
+    pifs_size_t          page_count;
+    bool_t               is_buffered;
+
+    is_buffered = (a_file->read_ahead_page_count
+                   && a_file->read_ahead_address.block_address == ba
+                   && a_file->read_ahead_address.page_address <= pa
+                   && pa < a_file->read_ahead_address.page_address + a_file->read_ahead_page_count);
+    if (!is_buffered && a_is_read_ahead)
+    {
+        /* Pages of map entry are contiguous, read them until end of file */
+        page_count = PIFS_MIN(a_file->rw_page_count, PIFS_READ_AHEAD_PAGE_NUM);
+        page_count = PIFS_MIN(page_count, PIFS_LOGICAL_PAGE_PER_BLOCK - pa);
+        page_count = PIFS_MIN(page_count, (a_file->entry.file_size - (a_pos - po)
+                                           + PIFS_LOGICAL_PAGE_SIZE_BYTE - 1) / PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        if (page_count > 1)
+        {
+            a_file->read_ahead_page_count = 0;
+            ret = pifs_read_direct(ba, pa, page_count, a_file->read_ahead_buf);
+            if (ret == PIFS_SUCCESS)
+            {
+                a_file->read_ahead_address = a_file->rw_address;
+                a_file->read_ahead_page_count = page_count;
+                is_buffered = TRUE;
+            }
+        }
+    }
+    if (ret == PIFS_SUCCESS && is_buffered)
+    {
+        ret = pifs_find_delta_page(ba, pa, &delta_ba, &delta_pa, NULL, &pifs.header);
+        if (ret == PIFS_SUCCESS && delta_ba == ba && delta_pa == pa
+#if PIFS_DELTA_PATCH_PAGE_NUM
+                && !pifs_is_delta_patched(ba, pa, delta_ba, delta_pa)
+#endif
+           )
+        {
+            memcpy(a_data, &a_file->read_ahead_buf[(pa - a_file->read_ahead_address.page_address)
+                                                   * PIFS_LOGICAL_PAGE_SIZE_BYTE + po], a_size);
+        }
+        else
+        {
+            is_buffered = FALSE;
+        }
+    }
+    if (ret == PIFS_SUCCESS && !is_buffered)
+    {
+        ret = pifs_read_delta(ba, pa, po, a_data, a_size);
+    }
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_fread File read. Works like fread().
  *
@@ -653,6 +958,12 @@ size_t pifs_fread(void * a_data, size_t a_size, size_t a_count, P_FILE * a_file)
     pifs_size_t          data_size = a_size * a_count;
     pifs_size_t          page_count = 0;
     pifs_page_offset_t   po;
+#if PIFS_DIRECT_READ_PAGE_NUM_MAX
+    pifs_page_count_t    direct_page_count;
+#endif
+#if PIFS_READ_AHEAD_PAGE_NUM
+    bool_t               is_read_ahead = FALSE;
+#endif
 
     PIFS_GET_MUTEX();
 
@@ -666,6 +977,11 @@ size_t pifs_fread(void * a_data, size_t a_size, size_t a_count, P_FILE * a_file)
                              file->entry.file_size);
             data_size = file->entry.file_size - file->rw_pos;
         }
+#if PIFS_READ_AHEAD_PAGE_NUM
+        is_read_ahead = (file->advice == PIFS_FADV_SEQUENTIAL
+                         || file->advice == PIFS_FADV_NOREUSE
+                         || (file->advice == PIFS_FADV_NORMAL && file->rw_pos == file->read_end_pos));
+#endif
         po = file->rw_pos % PIFS_LOGICAL_PAGE_SIZE_BYTE;
         /* Check if last page was not fully read */
         if (po)
@@ -676,9 +992,13 @@ size_t pifs_fread(void * a_data, size_t a_size, size_t a_count, P_FILE * a_file)
             chunk_size = PIFS_MIN(data_size, PIFS_LOGICAL_PAGE_SIZE_BYTE - po);
             PIFS_DEBUG_MSG("--------> pos: %i po: %i data_size: %i chunk_size: %i\r\n",
                            file->rw_pos, po, data_size, chunk_size);
+#if PIFS_READ_AHEAD_PAGE_NUM
+            file->status = pifs_fread_page(file, is_read_ahead, file->rw_pos, data, chunk_size);
+#else
             file->status = pifs_read_delta(file->rw_address.block_address,
                                            file->rw_address.page_address,
                                            po, data, chunk_size);
+#endif
             //pifs_print_cache();
             //          print_buffer(data, chunk_size, 0);
             if (file->status == PIFS_SUCCESS)
@@ -705,20 +1025,50 @@ size_t pifs_fread(void * a_data, size_t a_size, size_t a_count, P_FILE * a_file)
                 PIFS_NOTICE_MSG("read %s, page_count: %i, chunk size: %i\r\n",
                                pifs_address2str(&file->rw_address), page_count, chunk_size);
                 PIFS_ASSERT(pifs_is_address_valid(&file->rw_address));
-                file->status = pifs_read_delta(file->rw_address.block_address,
-                                               file->rw_address.page_address,
-                                               0, data, chunk_size);
-                if (file->status == PIFS_SUCCESS && chunk_size == PIFS_LOGICAL_PAGE_SIZE_BYTE)
+#if PIFS_DIRECT_READ_PAGE_NUM_MAX
+                direct_page_count = 0;
+                /* Small reads are served from read-ahead buffer */
+                if (chunk_size == PIFS_LOGICAL_PAGE_SIZE_BYTE
+#if PIFS_READ_AHEAD_PAGE_NUM
+                        && (!is_read_ahead || data_size >= PIFS_READ_AHEAD_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE)
+#endif
+                   )
                 {
-                    pifs_inc_rw_address(file, TRUE);
+                    direct_page_count = pifs_fread_direct(file, data,
+                                                          PIFS_MIN(data_size / PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                                                                   PIFS_DIRECT_READ_PAGE_NUM_MAX));
+                }
+                if (direct_page_count)
+                {
+                    chunk_size = direct_page_count * PIFS_LOGICAL_PAGE_SIZE_BYTE;
+                    page_count -= direct_page_count;
+                }
+                else
+#endif
+                {
+#if PIFS_READ_AHEAD_PAGE_NUM
+                    file->status = pifs_fread_page(file, is_read_ahead, file->rw_pos + read_size,
+                                                   data, chunk_size);
+#else
+                    file->status = pifs_read_delta(file->rw_address.block_address,
+                                                   file->rw_address.page_address,
+                                                   0, data, chunk_size);
+#endif
+                    if (file->status == PIFS_SUCCESS && chunk_size == PIFS_LOGICAL_PAGE_SIZE_BYTE)
+                    {
+                        pifs_inc_rw_address(file, TRUE);
+                    }
+                    page_count--;
                 }
                 data += chunk_size;
                 data_size -= chunk_size;
                 read_size += chunk_size;
-                page_count--;
             }
         }
         file->rw_pos += read_size;
+#if PIFS_READ_AHEAD_PAGE_NUM
+        file->read_end_pos = file->rw_pos;
+#endif
     }
 
     PIFS_SET_ERRNO(file->status);
@@ -759,15 +1109,20 @@ int pifs_internal_fflush(P_FILE * a_file, bool_t a_is_merge_allowed, bool_t a_is
 {
     int             ret = PIFS_EOF;
     pifs_file_t   * file = (pifs_file_t*) a_file;
+    pifs_status_t   map_status = PIFS_SUCCESS;
 
     PIFS_NOTICE_MSG("filename: '%s'\r\n", file->entry.name);
     if (pifs.is_header_found && file && file->is_opened)
     {
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+        /* Map shall contain every page before file size is updated */
+        map_status = pifs_commit_map_entry(file);
+#endif
 
         PIFS_DEBUG_MSG("mode_write: %i, is_entry_changed: %i, file_size: %i\r\n",
                        file->mode_write, file->is_entry_changed,
                        file->entry.file_size);
-        if (a_is_entry_update_allowed
+        if (a_is_entry_update_allowed && map_status == PIFS_SUCCESS
                 && (file->is_entry_changed || !file->entry.file_size))
         {
             file->status = pifs_update_entry(file->entry.name, &file->entry,
@@ -905,6 +1260,11 @@ int pifs_internal_fseek(P_FILE * a_file, long int a_offset, int a_origin)
                      file->entry.name, file->entry.file_size, a_offset, a_origin, file->rw_pos);
     if (pifs.is_header_found && file && file->is_opened)
     {
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+        /* Seeking walks the map. Deliberately avoiding return code, */
+        /* status of file is set if entry cannot be written. */
+        (void)pifs_commit_map_entry(file);
+#endif
         switch (a_origin)
         {
             case PIFS_SEEK_CUR:
@@ -942,7 +1302,8 @@ int pifs_internal_fseek(P_FILE * a_file, long int a_offset, int a_origin)
                 }
                 else
                 {
-                    data_size = file->entry.file_size + a_offset;
+                    target_pos = file->entry.file_size + a_offset;
+                    data_size = target_pos;
                     if (data_size >= file->rw_pos)
                     {
                         data_size -= file->rw_pos;
@@ -951,13 +1312,21 @@ int pifs_internal_fseek(P_FILE * a_file, long int a_offset, int a_origin)
                     {
                         pifs_internal_rewind(file); /* Zeroing file->rw_pos! */
                     }
-                    target_pos = data_size;
                 }
                 break;
             default:
                 break;
         }
 
+#if PIFS_EXTENT_CACHE_NUM
+        if (file->status == PIFS_SUCCESS && file->entry.file_size != PIFS_FILE_SIZE_ERASED
+                && target_pos > file->rw_pos)
+        {
+            /* Jump to the closest known map entry instead of walking the map */
+            file->status = pifs_extent_seek(file, PIFS_MIN(target_pos, file->entry.file_size));
+            data_size = target_pos - file->rw_pos;
+        }
+#endif
         if (file->status == PIFS_SUCCESS)
         {
             if (file->entry.file_size != PIFS_FILE_SIZE_ERASED)
@@ -986,6 +1355,11 @@ int pifs_internal_fseek(P_FILE * a_file, long int a_offset, int a_origin)
                     if (po + chunk_size >= PIFS_LOGICAL_PAGE_SIZE_BYTE)
                     {
                         pifs_inc_rw_address(file, TRUE);
+                        if (file->status == PIFS_ERROR_END_OF_FILE)
+                        {
+                            /* Reaching end of file is not an error */
+                            file->status = PIFS_SUCCESS;
+                        }
                     }
                 }
             }
@@ -1084,6 +1458,11 @@ void pifs_internal_rewind(P_FILE * a_file)
     PIFS_NOTICE_MSG("filename: '%s'\r\n", file->entry.name);
     if (pifs.is_header_found && file && file->is_opened)
     {
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+        /* Map is read from the first entry. Deliberately avoiding */
+        /* return code, map is read anyway. */
+        (void)pifs_commit_map_entry(file);
+#endif
         file->rw_pos = 0;
         file->rw_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
         file->rw_address.page_address = PIFS_PAGE_ADDRESS_INVALID;
@@ -1122,6 +1501,137 @@ long int pifs_ftell(P_FILE * a_file)
     return pos;
 }
 
+#if PIFS_READ_AHEAD_PAGE_NUM
+/**
+ * @brief pifs_fadvise Non-standard function to declare access pattern of
+ * file. Works like posix_fadvise() for the whole file.
+ *
+ * @param[in] a_file    Pointer to file.
+ * @param[in] a_advice  Access pattern, @see pifs_fadvise_advice_t.
+ * @return 0 if success.
+ */
+int pifs_fadvise(P_FILE * a_file, int a_advice)
+{
+    pifs_status_t  ret = PIFS_ERROR_GENERAL;
+    pifs_file_t  * file = (pifs_file_t*) a_file;
+
+    PIFS_GET_MUTEX();
+
+    if (file && file->is_opened
+            && a_advice >= PIFS_FADV_NORMAL && a_advice <= PIFS_FADV_NOREUSE)
+    {
+        file->advice = a_advice;
+        if (a_advice == PIFS_FADV_RANDOM)
+        {
+            file->read_ahead_page_count = 0;
+        }
+        ret = PIFS_SUCCESS;
+    }
+
+    PIFS_SET_ERRNO(ret);
+
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+#endif
+
+#if PIFS_ENABLE_FALLOCATE
+/**
+ * @brief pifs_fallocate Non-standard function to reserve pages for file.
+ * Works like posix_fallocate(), but file size is not changed. Reserved pages
+ * are added to the file's map and pifs_fwrite() writes them without
+ * searching and marking free pages. They are released with the file.
+ *
+ * @param[in] a_file    Pointer to file.
+ * @param[in] a_offset  Start of range to reserve in bytes.
+ * @param[in] a_length  Size of range to reserve in bytes.
+ * @return 0 if success.
+ */
+int pifs_fallocate(P_FILE * a_file, long int a_offset, long int a_length)
+{
+    pifs_status_t        ret = PIFS_ERROR_GENERAL;
+    pifs_file_t        * file = (pifs_file_t*) a_file;
+    pifs_size_t          page_count_needed = 0;
+    pifs_page_count_t    page_count_needed_limited;
+    pifs_page_count_t    page_count_found = 0;
+    pifs_block_address_t ba = PIFS_BLOCK_ADDRESS_INVALID;
+    pifs_page_address_t  pa = PIFS_PAGE_ADDRESS_INVALID;
+
+    PIFS_GET_MUTEX();
+
+    if (pifs.is_header_found && file && file->is_opened && file->mode_write
+            && a_offset >= 0 && a_length > 0)
+    {
+        file->status = PIFS_SUCCESS;
+        if (file->alloc_page_count == PIFS_ALLOC_PAGE_COUNT_UNKNOWN)
+        {
+            file->status = pifs_count_map_pages(file, &file->alloc_page_count);
+        }
+        if (file->status == PIFS_SUCCESS)
+        {
+            page_count_needed = (a_offset + a_length + PIFS_LOGICAL_PAGE_SIZE_BYTE - 1) / PIFS_LOGICAL_PAGE_SIZE_BYTE;
+            if (page_count_needed > file->alloc_page_count)
+            {
+                page_count_needed -= file->alloc_page_count;
+            }
+            else
+            {
+                /* Range is already allocated */
+                page_count_needed = 0;
+            }
+        }
+        if (file->status == PIFS_SUCCESS && page_count_needed)
+        {
+#if PIFS_ENABLE_FSBM_BATCH
+            pifs_fsbm_batch_begin();
+#endif
+            file->status = pifs_merge_check(file, page_count_needed);
+            while (page_count_needed && file->status == PIFS_SUCCESS)
+            {
+                page_count_needed_limited = PIFS_MIN(page_count_needed, PIFS_MAP_PAGE_COUNT_INVALID - 1);
+                file->status = pifs_find_file_pages(file, page_count_needed_limited,
+                                                    &ba, &pa, &page_count_found);
+                if (file->status == PIFS_SUCCESS)
+                {
+                    file->status = pifs_mark_page(ba, pa, page_count_found, TRUE, FALSE);
+                }
+                if (file->status == PIFS_SUCCESS)
+                {
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+                    /* Map entry is written by pifs_internal_fseek() below */
+                    file->status = pifs_defer_map_entry(file, ba, pa, page_count_found);
+#else
+                    file->status = pifs_append_map_entry(file, ba, pa, page_count_found);
+#endif
+                }
+                if (file->status == PIFS_SUCCESS)
+                {
+                    file->alloc_page_count += page_count_found;
+                    page_count_needed -= page_count_found;
+                }
+            }
+#if PIFS_ENABLE_FSBM_BATCH
+            file->status = pifs_fsbm_batch_end(file->status, TRUE);
+#endif
+            if (file->status == PIFS_SUCCESS)
+            {
+                /* Actual map entry was moved to the end of map, */
+                /* read/write address shall be found again */
+                file->status = pifs_internal_fseek(file, file->rw_pos, PIFS_SEEK_SET);
+            }
+        }
+        ret = file->status;
+    }
+
+    PIFS_SET_ERRNO(ret);
+
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+#endif
+
 #if PIFS_ENABLE_USER_DATA
 /**
  * @brief pifs_fgetuserdata Non-standard function to get user defined data of
@@ -1413,6 +1923,7 @@ int pifs_copy(const pifs_char_t * a_oldname, const pifs_char_t * a_newname)
         file2 = pifs_fopen(a_newname, "w");
         if (file2)
         {
+            ret = PIFS_SUCCESS;
 #if PIFS_ENABLE_USER_DATA
             ret = pifs_fgetuserdata(file, &user_data);
             if (ret == PIFS_SUCCESS)
@@ -1439,13 +1950,37 @@ int pifs_copy(const pifs_char_t * a_oldname, const pifs_char_t * a_newname)
                     }
                 } while (read_bytes > 0 && read_bytes == written_bytes && ret == PIFS_SUCCESS);
             }
-            ret = pifs_fclose(file2);
+            /* First error is kept */
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = pifs_fclose(file2);
+            }
+            else
+            {
+                /* Deliberately avoiding return code */
+                (void)pifs_fclose(file2);
+            }
+            if (ret != PIFS_SUCCESS)
+            {
+                /* Incomplete copy shall not be left behind, as it
+                 * could be renamed over the original file */
+                /* Deliberately avoiding return code */
+                (void)pifs_remove(a_newname);
+            }
         }
         else
         {
             PIFS_ERROR_MSG("Cannot open file '%s'\r\n", a_newname);
         }
-        ret = pifs_fclose(file);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_fclose(file);
+        }
+        else
+        {
+            /* Deliberately avoiding return code */
+            (void)pifs_fclose(file);
+        }
     }
     else
     {
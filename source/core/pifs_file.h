@@ -48,6 +48,11 @@ bool_t pifs_internal_is_file_exist(const pifs_char_t * a_filename);
 void pifs_internal_rewind(P_FILE * a_file);
 int pifs_internal_fsetuserdata(P_FILE * a_file, const pifs_user_data_t * a_user_data, bool_t a_is_merge_allowed);
 int pifs_internal_remove(const pifs_char_t * a_filename, bool_t a_is_merge_allowed);
+#if PIFS_READ_AHEAD_PAGE_NUM
+void pifs_read_ahead_drop(pifs_block_address_t a_block_address,
+                          pifs_page_address_t a_page_address,
+                          pifs_page_count_t a_page_count);
+#endif
 
 #ifdef __cplusplus
 }
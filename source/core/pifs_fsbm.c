@@ -61,7 +61,7 @@ pifs_status_t pifs_calc_free_space_pos(const pifs_address_t * a_free_space_bitma
             && a_page_address < PIFS_PAGE_ADDRESS_INVALID)
     {
         /* Shift left by one (<< 1) due to two bits are stored in free space bitmap */
-        bit_pos = ((a_block_address - PIFS_FLASH_BLOCK_RESERVED_NUM) * PIFS_LOGICAL_PAGE_PER_BLOCK + a_page_address) << PIFS_FSBM_BITS_PER_PAGE_SHIFT;
+        bit_pos = ((a_block_address - PIFS_FLASH_BLOCK_FIRST_FS) * PIFS_LOGICAL_PAGE_PER_BLOCK + a_page_address) << PIFS_FSBM_BITS_PER_PAGE_SHIFT;
         //PIFS_DEBUG_MSG("BA%i/PA%i bit_pos: %i\r\n", a_block_address, a_page_address, bit_pos);
         *a_free_space_block_address = a_free_space_bitmap_address->block_address
                 + (bit_pos / PIFS_BYTE_BITS / PIFS_FLASH_BLOCK_SIZE_BYTE);
@@ -96,7 +96,7 @@ void pifs_calc_address(pifs_bit_pos_t a_bit_pos,
 {
     /* Shift right by one (>> 1) due to two bits are stored in free space bitmap */
     a_bit_pos >>= PIFS_FSBM_BITS_PER_PAGE_SHIFT;
-    *a_block_address = (a_bit_pos / PIFS_LOGICAL_PAGE_PER_BLOCK) + PIFS_FLASH_BLOCK_RESERVED_NUM;
+    *a_block_address = (a_bit_pos / PIFS_LOGICAL_PAGE_PER_BLOCK) + PIFS_FLASH_BLOCK_FIRST_FS;
     a_bit_pos %= PIFS_LOGICAL_PAGE_PER_BLOCK;
     *a_page_address = a_bit_pos;
 }
@@ -134,23 +134,300 @@ static inline bool_t pifs_check_bits(bool_t a_is_free, bool_t a_is_to_be_release
     return ret;
 }
 
+#if PIFS_ENABLE_FSBM_IN_RAM
+#define PIFS_FSBM_RAM_WORD_BITS     32u
+/** Mask of free bits (bit 0 of every page) in a word of free space bitmap */
+#define PIFS_FSBM_RAM_MASK_FREE     0x55555555u
+/** Index of page in the file system */
+#define PIFS_FSBM_RAM_PAGE_IDX(ba, pa) \
+    ((pifs_size_t)((ba) - PIFS_FLASH_BLOCK_FIRST_FS) * PIFS_LOGICAL_PAGE_PER_BLOCK + (pa))
+
+#if defined(__GNUC__)
+#define PIFS_CTZ32(x)       ((pifs_size_t)__builtin_ctz(x))
+#define PIFS_POPCOUNT32(x)  ((pifs_size_t)__builtin_popcount(x))
+#else
 /**
- * @brief pifs_is_page_free Check if page is used.
+ * @brief pifs_ctz32 Count trailing zeros.
  *
- * @param[in] a_block_address   Block address of page(s).
- * @param[in] a_page_address    Page address of page(s).
+ * @param[in] a_value Value to examine. Shall not be zero.
+ * @return Number of trailing zero bits.
+ */
+static pifs_size_t pifs_ctz32(uint32_t a_value)
+{
+    pifs_size_t cntr = 0;
+
+    while (!(a_value & 1u))
+    {
+        a_value >>= 1;
+        cntr++;
+    }
+
+    return cntr;
+}
+
+/**
+ * @brief pifs_popcount32 Count bits which are set.
+ *
+ * @param[in] a_value Value to examine.
+ * @return Number of one bits.
+ */
+static pifs_size_t pifs_popcount32(uint32_t a_value)
+{
+    pifs_size_t cntr = 0;
+
+    while (a_value)
+    {
+        a_value &= a_value - 1u;
+        cntr++;
+    }
+
+    return cntr;
+}
+#define PIFS_CTZ32(x)       pifs_ctz32(x)
+#define PIFS_POPCOUNT32(x)  pifs_popcount32(x)
+#endif
+
+/**
+ * @brief pifs_fsbm_ram_load Load free space bitmap of actual header to RAM.
+ * It shall be called when a new header is activated.
+ *
+ * @return PIFS_SUCCESS if free space bitmap was read successfully.
+ */
+pifs_status_t pifs_fsbm_ram_load(void)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_address_t ba = pifs.header.free_space_bitmap_address.block_address;
+    pifs_page_address_t  pa = pifs.header.free_space_bitmap_address.page_address;
+    pifs_size_t          i;
+    pifs_page_offset_t   po = 0;
+    uint8_t            * fsbm_buf = NULL;
+
+    pifs.is_fsbm_ram_valid = FALSE;
+    memset(pifs.fsbm_ram_buf, 0, sizeof(pifs.fsbm_ram_buf));
+#if PIFS_ENABLE_EXTENT_ALLOC
+    /* Longest free runs are calculated on demand */
+    memset(pifs.extent_page_count, 0xFF, sizeof(pifs.extent_page_count));
+#endif
+    for (i = 0; i < PIFS_FREE_SPACE_BITMAP_SIZE_BYTE && ret == PIFS_SUCCESS; i++)
+    {
+        if (po == 0)
+        {
+            ret = pifs_read(ba, pa, 0, NULL, 0);
+            fsbm_buf = pifs_get_cache_page_buf(ba, pa);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            pifs.fsbm_ram_buf[i / sizeof(uint32_t)] |= (uint32_t)fsbm_buf[po] << ((i % sizeof(uint32_t)) * PIFS_BYTE_BITS);
+            po++;
+            if (po == PIFS_LOGICAL_PAGE_SIZE_BYTE)
+            {
+                po = 0;
+                ret = pifs_inc_ba_pa(&ba, &pa);
+            }
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        pifs.is_fsbm_ram_valid = TRUE;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_fsbm_ram_is_usable Check if copy of free space bitmap in RAM
+ * belongs to the given header.
+ *
+ * @param[in] a_header Pointer to file system header.
+ * @return TRUE: RAM copy can be used instead of flash memory.
+ */
+static bool_t pifs_fsbm_ram_is_usable(const pifs_header_t * a_header)
+{
+    return pifs.is_fsbm_ram_valid
+            && a_header->free_space_bitmap_address.block_address == pifs.header.free_space_bitmap_address.block_address
+            && a_header->free_space_bitmap_address.page_address == pifs.header.free_space_bitmap_address.page_address;
+}
+
+/**
+ * @brief pifs_fsbm_ram_get_bits Get the two bits of a page from RAM copy of
+ * free space bitmap.
+ *
+ * @param[in] a_page_idx Index of page in file system (0..PIFS_LOGICAL_PAGE_NUM_FS-1).
+ * @return Bit 0: page is free, bit 1: page is not to be released.
+ */
+static inline uint8_t pifs_fsbm_ram_get_bits(pifs_size_t a_page_idx)
+{
+    pifs_size_t bit_pos = a_page_idx << PIFS_FSBM_BITS_PER_PAGE_SHIFT;
+
+    return (pifs.fsbm_ram_buf[bit_pos / PIFS_FSBM_RAM_WORD_BITS] >> (bit_pos % PIFS_FSBM_RAM_WORD_BITS)) & 3u;
+}
+
+/**
+ * @brief pifs_fsbm_ram_set_bits Set the two bits of a page in RAM copy of
+ * free space bitmap.
+ *
+ * @param[in] a_page_idx Index of page in file system (0..PIFS_LOGICAL_PAGE_NUM_FS-1).
+ * @param[in] a_bits     Bit 0: page is free, bit 1: page is not to be released.
+ */
+static inline void pifs_fsbm_ram_set_bits(pifs_size_t a_page_idx, uint8_t a_bits)
+{
+    pifs_size_t bit_pos = a_page_idx << PIFS_FSBM_BITS_PER_PAGE_SHIFT;
+    uint32_t  * word = &pifs.fsbm_ram_buf[bit_pos / PIFS_FSBM_RAM_WORD_BITS];
+
+    *word &= ~(3u << (bit_pos % PIFS_FSBM_RAM_WORD_BITS));
+    *word |= (uint32_t)(a_bits & 3u) << (bit_pos % PIFS_FSBM_RAM_WORD_BITS);
+}
+
+/**
+ * @brief pifs_fsbm_ram_mask Select pages of a word which fulfill the
+ * search criteria.
+ *
+ * @param[in] a_word            Word of free space bitmap.
+ * @param[in] a_is_free         TRUE: select free pages.
+ * @param[in] a_is_to_be_released TRUE: select to be released pages.
+ * @return Bit 0 of the selected pages are set.
+ */
+static inline uint32_t pifs_fsbm_ram_mask(uint32_t a_word, bool_t a_is_free, bool_t a_is_to_be_released)
+{
+    uint32_t mask = 0;
+
+    if (a_is_free)
+    {
+        mask |= a_word & PIFS_FSBM_RAM_MASK_FREE;
+    }
+    if (a_is_to_be_released)
+    {
+        mask |= (~a_word >> 1) & PIFS_FSBM_RAM_MASK_FREE;
+    }
+
+    return mask;
+}
+
+/**
+ * @brief pifs_fsbm_ram_find_next Find next free or to be released page in
+ * RAM copy of free space bitmap. 16 pages are checked at once.
+ *
+ * @param[in] a_page_idx        Index of first page to check.
+ * @param[in] a_is_free         TRUE: find free page.
+ * @param[in] a_is_to_be_released TRUE: find to be released page.
+ * @return Index of page found or PIFS_LOGICAL_PAGE_NUM_FS if not found.
+ */
+static pifs_size_t pifs_fsbm_ram_find_next(pifs_size_t a_page_idx, bool_t a_is_free, bool_t a_is_to_be_released)
+{
+    pifs_size_t bit_pos = a_page_idx << PIFS_FSBM_BITS_PER_PAGE_SHIFT;
+    pifs_size_t word_idx = bit_pos / PIFS_FSBM_RAM_WORD_BITS;
+    uint32_t    mask = 0;
+
+    if (word_idx < PIFS_FSBM_RAM_WORD_NUM)
+    {
+        mask = pifs_fsbm_ram_mask(pifs.fsbm_ram_buf[word_idx], a_is_free, a_is_to_be_released);
+        /* Ignore pages before start page */
+        mask &= ~0u << (bit_pos % PIFS_FSBM_RAM_WORD_BITS);
+        while (!mask && ++word_idx < PIFS_FSBM_RAM_WORD_NUM)
+        {
+            mask = pifs_fsbm_ram_mask(pifs.fsbm_ram_buf[word_idx], a_is_free, a_is_to_be_released);
+        }
+    }
+    if (mask)
+    {
+        a_page_idx = (word_idx * PIFS_FSBM_RAM_WORD_BITS + PIFS_CTZ32(mask)) >> PIFS_FSBM_BITS_PER_PAGE_SHIFT;
+    }
+    if (!mask || a_page_idx >= PIFS_LOGICAL_PAGE_NUM_FS)
+    {
+        /* Padding bits at the end of bitmap are not pages */
+        a_page_idx = PIFS_LOGICAL_PAGE_NUM_FS;
+    }
+
+    return a_page_idx;
+}
+
+/**
+ * @brief pifs_fsbm_ram_count Count free or to be released pages in RAM copy
+ * of free space bitmap.
+ *
+ * @param[in] a_page_idx        Index of first page to check.
+ * @param[in] a_page_count      Number of pages to check.
+ * @param[in] a_is_free         TRUE: count free pages.
+ * @param[in] a_is_to_be_released TRUE: count to be released pages.
+ * @return Number of pages found.
+ */
+static pifs_size_t pifs_fsbm_ram_count(pifs_size_t a_page_idx, pifs_size_t a_page_count,
+                                       bool_t a_is_free, bool_t a_is_to_be_released)
+{
+    pifs_size_t bit_pos = a_page_idx << PIFS_FSBM_BITS_PER_PAGE_SHIFT;
+    pifs_size_t bit_end = (a_page_idx + a_page_count) << PIFS_FSBM_BITS_PER_PAGE_SHIFT;
+    pifs_size_t bit_cnt;
+    pifs_size_t cntr = 0;
+    uint32_t    mask;
+
+    while (bit_pos < bit_end)
+    {
+        mask = pifs_fsbm_ram_mask(pifs.fsbm_ram_buf[bit_pos / PIFS_FSBM_RAM_WORD_BITS],
+                                  a_is_free, a_is_to_be_released);
+        mask >>= bit_pos % PIFS_FSBM_RAM_WORD_BITS;
+        bit_cnt = PIFS_FSBM_RAM_WORD_BITS - (bit_pos % PIFS_FSBM_RAM_WORD_BITS);
+        if (bit_cnt > bit_end - bit_pos)
+        {
+            bit_cnt = bit_end - bit_pos;
+            mask &= (1u << bit_cnt) - 1u;
+        }
+        cntr += PIFS_POPCOUNT32(mask);
+        bit_pos += bit_cnt;
+    }
+
+    return cntr;
+}
+#endif
+
+#if PIFS_SKIP_FREE_PAGE_READ
+/**
+ * @brief pifs_is_page_known_erased Check if page is erased without reading
+ * it. Free pages of data blocks are erased: they are checked when they are
+ * found (PIFS_CHECK_IF_PAGE_IS_ERASED) and marked as used after writing.
+ *
+ * @param[in] a_block_address   Block address of page.
+ * @param[in] a_page_address    Page address of page.
+ * @return TRUE: page is erased. FALSE: page shall be read to know its content.
+ */
+bool_t pifs_is_page_known_erased(pifs_block_address_t a_block_address,
+                                 pifs_page_address_t a_page_address)
+{
+    bool_t is_erased = FALSE;
+
+#if PIFS_ENABLE_ERASED_BITMAP
+    if (pifs_is_page_verified_erased(a_block_address, a_page_address))
+    {
+        is_erased = TRUE;
+    }
+    else
+#endif
+    if (pifs.is_header_found && !pifs.is_merging
+            && pifs_is_block_type(a_block_address, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+    {
+        is_erased = pifs_is_page_free(a_block_address, a_page_address);
+    }
+
+    return is_erased;
+}
+#endif
+
+/**
+ * @brief pifs_is_page_free_flash Check if page is used in free space bitmap
+ * of flash memory (or cache). Copy of free space bitmap in RAM is not used.
+ *
+ * @param[in] a_block_address   Block address of page.
+ * @param[in] a_page_address    Page address of page.
  * @return TRUE: page is free. FALSE: page is used.
  */
-bool_t pifs_is_page_free(pifs_block_address_t a_block_address,
-                         pifs_page_address_t a_page_address)
+static bool_t pifs_is_page_free_flash(pifs_block_address_t a_block_address,
+                                      pifs_page_address_t a_page_address)
 {
     pifs_status_t        ret = PIFS_SUCCESS;
     pifs_bit_pos_t       bit_pos;
     pifs_block_address_t ba = PIFS_BLOCK_ADDRESS_INVALID;
     pifs_page_address_t  pa = PIFS_PAGE_ADDRESS_INVALID;
     bool_t               is_free_space = FALSE;
-
-    PIFS_ASSERT(pifs.is_header_found);
+    uint8_t            * fsbm_buf;
 
     ret = pifs_calc_free_space_pos(&pifs.header.free_space_bitmap_address,
                                    a_block_address, a_page_address, &ba, &pa, &bit_pos);
@@ -162,12 +439,43 @@ bool_t pifs_is_page_free(pifs_block_address_t a_block_address,
     if (ret == PIFS_SUCCESS)
     {
         PIFS_ASSERT((bit_pos / PIFS_BYTE_BITS) < PIFS_LOGICAL_PAGE_SIZE_BYTE);
-        is_free_space = pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] & (1u << (bit_pos % PIFS_BYTE_BITS));
+        fsbm_buf = pifs_get_cache_page_buf(ba, pa);
+        is_free_space = fsbm_buf[bit_pos / PIFS_BYTE_BITS] & (1u << (bit_pos % PIFS_BYTE_BITS));
     }
 
     return is_free_space ? TRUE : FALSE;
 }
 
+/**
+ * @brief pifs_is_page_free Check if page is used.
+ *
+ * @param[in] a_block_address   Block address of page(s).
+ * @param[in] a_page_address    Page address of page(s).
+ * @return TRUE: page is free. FALSE: page is used.
+ */
+bool_t pifs_is_page_free(pifs_block_address_t a_block_address,
+                         pifs_page_address_t a_page_address)
+{
+    bool_t is_free_space = FALSE;
+
+    PIFS_ASSERT(pifs.is_header_found);
+
+#if PIFS_ENABLE_FSBM_IN_RAM
+    if (pifs.is_fsbm_ram_valid)
+    {
+        PIFS_ASSERT(a_block_address < PIFS_FLASH_BLOCK_NUM_ALL && a_page_address < PIFS_LOGICAL_PAGE_PER_BLOCK);
+        is_free_space = (pifs_fsbm_ram_get_bits(PIFS_FSBM_RAM_PAGE_IDX(a_block_address, a_page_address)) & 1u)
+                ? TRUE : FALSE;
+    }
+    else
+#endif
+    {
+        is_free_space = pifs_is_page_free_flash(a_block_address, a_page_address);
+    }
+
+    return is_free_space;
+}
+
 /**
  * @brief pifs_is_page_to_be_released Mark page(s) as used (or to be released) in free space
  * memory bitmap.
@@ -184,25 +492,344 @@ bool_t pifs_is_page_to_be_released(pifs_block_address_t a_block_address,
     pifs_block_address_t ba = PIFS_BLOCK_ADDRESS_INVALID;
     pifs_page_address_t  pa = PIFS_PAGE_ADDRESS_INVALID;
     bool_t               is_not_to_be_released = FALSE;
+    uint8_t            * fsbm_buf;
 
     PIFS_ASSERT(pifs.is_header_found);
 
-    ret = pifs_calc_free_space_pos(&pifs.header.free_space_bitmap_address,
-                                   a_block_address, a_page_address, &ba, &pa, &bit_pos);
-    if (ret == PIFS_SUCCESS)
+#if PIFS_ENABLE_FSBM_IN_RAM
+    if (pifs.is_fsbm_ram_valid)
     {
-        /* Read actual status of free space memory bitmap (or cache) */
-        ret = pifs_read(ba, pa, 0, NULL, 0);
+        PIFS_ASSERT(a_block_address < PIFS_FLASH_BLOCK_NUM_ALL && a_page_address < PIFS_LOGICAL_PAGE_PER_BLOCK);
+        is_not_to_be_released = pifs_fsbm_ram_get_bits(PIFS_FSBM_RAM_PAGE_IDX(a_block_address, a_page_address)) & 2u;
     }
-    if (ret == PIFS_SUCCESS)
+    else
+#endif
     {
-        PIFS_ASSERT((bit_pos / PIFS_BYTE_BITS) < PIFS_LOGICAL_PAGE_SIZE_BYTE);
-        is_not_to_be_released = pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] & (1u << ((bit_pos % PIFS_BYTE_BITS) + 1));
+        ret = pifs_calc_free_space_pos(&pifs.header.free_space_bitmap_address,
+                                       a_block_address, a_page_address, &ba, &pa, &bit_pos);
+        if (ret == PIFS_SUCCESS)
+        {
+            /* Read actual status of free space memory bitmap (or cache) */
+            ret = pifs_read(ba, pa, 0, NULL, 0);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            PIFS_ASSERT((bit_pos / PIFS_BYTE_BITS) < PIFS_LOGICAL_PAGE_SIZE_BYTE);
+            fsbm_buf = pifs_get_cache_page_buf(ba, pa);
+            is_not_to_be_released = fsbm_buf[bit_pos / PIFS_BYTE_BITS] & (1u << ((bit_pos % PIFS_BYTE_BITS) + 1));
+        }
     }
 
     return !is_not_to_be_released;
 }
 
+#if PIFS_ENABLE_PAGE_CNTR
+/**
+ * @brief pifs_page_cntr_load Count free and to be released pages of every
+ * block. It shall be called when a new header is activated and its
+ * management blocks are final (after pifs_fsbm_ram_load()).
+ * Later pifs_mark_page() keeps the counters up-to-date.
+ */
+void pifs_page_cntr_load(void)
+{
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_size_t          free_cntr;
+    pifs_size_t          to_be_released_cntr;
+
+    memset(pifs.block_free_page_cntr, 0, sizeof(pifs.block_free_page_cntr));
+    memset(pifs.block_to_be_released_page_cntr, 0, sizeof(pifs.block_to_be_released_page_cntr));
+    pifs.free_management_page_cntr = 0;
+    pifs.free_data_page_cntr = 0;
+    pifs.to_be_released_management_page_cntr = 0;
+    pifs.to_be_released_data_page_cntr = 0;
+    for (ba = PIFS_FLASH_BLOCK_FIRST_FS; ba < PIFS_FLASH_BLOCK_NUM_ALL; ba++)
+    {
+        free_cntr = 0;
+        to_be_released_cntr = 0;
+#if PIFS_ENABLE_FSBM_IN_RAM
+        if (pifs.is_fsbm_ram_valid)
+        {
+            free_cntr = pifs_fsbm_ram_count(PIFS_FSBM_RAM_PAGE_IDX(ba, 0),
+                                            PIFS_LOGICAL_PAGE_PER_BLOCK, TRUE, FALSE);
+            to_be_released_cntr = pifs_fsbm_ram_count(PIFS_FSBM_RAM_PAGE_IDX(ba, 0),
+                                                      PIFS_LOGICAL_PAGE_PER_BLOCK, FALSE, TRUE);
+        }
+        else
+#endif
+        {
+            for (pa = 0; pa < PIFS_LOGICAL_PAGE_PER_BLOCK; pa++)
+            {
+                if (pifs_is_page_free(ba, pa))
+                {
+                    free_cntr++;
+                }
+                else if (pifs_is_page_to_be_released(ba, pa))
+                {
+                    to_be_released_cntr++;
+                }
+            }
+        }
+        pifs.block_free_page_cntr[ba] = free_cntr;
+        pifs.block_to_be_released_page_cntr[ba] = to_be_released_cntr;
+        if (pifs_is_block_type(ba, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+        {
+            pifs.free_data_page_cntr += free_cntr;
+            pifs.to_be_released_data_page_cntr += to_be_released_cntr;
+        }
+        else if (pifs_is_block_type(ba, PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT, &pifs.header))
+        {
+            /* Only count primary management, like pifs_get_pages() */
+            pifs.free_management_page_cntr += free_cntr;
+            pifs.to_be_released_management_page_cntr += to_be_released_cntr;
+        }
+    }
+    pifs.is_page_cntr_valid = TRUE;
+}
+
+#if PIFS_ENABLE_MOUNT_HINT
+/**
+ * @brief pifs_fsbm_load_deferred Load free space bitmap to RAM and count pages
+ * of blocks if it was deferred at mount.
+ */
+void pifs_fsbm_load_deferred(void)
+{
+    if (pifs.is_fsbm_deferred)
+    {
+        pifs.is_fsbm_deferred = FALSE;
+#if PIFS_ENABLE_FSBM_IN_RAM
+        /* Deliberately avoiding return code, flash memory is used if */
+        /* free space bitmap cannot be loaded */
+        (void)pifs_fsbm_ram_load();
+#endif
+        pifs_page_cntr_load();
+    }
+}
+#endif
+
+/**
+ * @brief pifs_page_cntr_mark Update page counters when a page is marked.
+ *
+ * @param[in] a_block_address   Block address of page.
+ * @param[in] a_is_used         TRUE: free page became used,
+ *                              FALSE: used page became to be released.
+ */
+static void pifs_page_cntr_mark(pifs_block_address_t a_block_address, bool_t a_is_used)
+{
+    if (pifs.is_page_cntr_valid)
+    {
+        if (a_is_used)
+        {
+            pifs.block_free_page_cntr[a_block_address]--;
+            if (pifs_is_block_type(a_block_address, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+            {
+                pifs.free_data_page_cntr--;
+            }
+            else if (pifs_is_block_type(a_block_address, PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT, &pifs.header))
+            {
+                pifs.free_management_page_cntr--;
+            }
+        }
+        else
+        {
+            pifs.block_to_be_released_page_cntr[a_block_address]++;
+            if (pifs_is_block_type(a_block_address, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+            {
+                pifs.to_be_released_data_page_cntr++;
+            }
+            else if (pifs_is_block_type(a_block_address, PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT, &pifs.header))
+            {
+                pifs.to_be_released_management_page_cntr++;
+            }
+        }
+    }
+}
+#endif
+
+#if PIFS_ENABLE_FSBM_BATCH
+/**
+ * @brief pifs_fsbm_batch_begin Start a batch of page markings.
+ * Until the batch is finished pifs_mark_page() does not flush the cache, so
+ * changed pages of free space bitmap are programmed only once. Data pages
+ * can be written back before management pages during the batch.
+ * Batches can be nested.
+ */
+void pifs_fsbm_batch_begin(void)
+{
+    PIFS_ASSERT(pifs.fsbm_batch_cntr < UINT8_MAX);
+    pifs.fsbm_batch_cntr++;
+}
+
+/**
+ * @brief pifs_fsbm_batch_end Finish a batch of page markings. Cache is
+ * flushed when the outermost batch is finished.
+ *
+ * @param[in] a_status              Status of operations in the batch.
+ * @param[in] a_is_flush_deferred   TRUE: cache is not flushed, changed pages
+ *                                  are written back in order by a later flush
+ *                                  (e.g. pifs_fflush()) or when they are
+ *                                  replaced in the cache.
+ * @return a_status if it is an error, otherwise result of flush.
+ */
+pifs_status_t pifs_fsbm_batch_end(pifs_status_t a_status, bool_t a_is_flush_deferred)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+
+    PIFS_ASSERT(pifs.fsbm_batch_cntr);
+    pifs.fsbm_batch_cntr--;
+    if (!pifs.fsbm_batch_cntr && !a_is_flush_deferred)
+    {
+        ret = pifs_flush();
+    }
+    if (a_status != PIFS_SUCCESS)
+    {
+        ret = a_status;
+    }
+
+    return ret;
+}
+#endif
+
+/**
+ * @brief pifs_update_used_page Update information kept in RAM when a free
+ * page became used.
+ *
+ * @param[in] a_block_address   Block address of page.
+ * @param[in] a_page_address    Page address of page.
+ */
+static void pifs_update_used_page(pifs_block_address_t a_block_address,
+                                  pifs_page_address_t a_page_address)
+{
+    /* Parameters are not used when features below are disabled */
+    (void)a_block_address;
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+    /* Block is not erased anymore, merge shall check it again */
+    pifs.merge_erased_block_bitmap[PIFS_MERGE_ERASED_WORD_IDX(a_block_address)]
+        &= ~PIFS_MERGE_ERASED_BIT(a_block_address);
+#endif
+#if PIFS_ENABLE_PAGE_CNTR
+    pifs_page_cntr_mark(a_block_address, TRUE);
+#endif
+#if PIFS_ENABLE_EXTENT_ALLOC
+    if (a_page_address >= pifs.extent_page_address[a_block_address]
+            && a_page_address < pifs.extent_page_address[a_block_address]
+                                + pifs.extent_page_count[a_block_address])
+    {
+        /* Longest free run of block is broken */
+        pifs.extent_page_count[a_block_address] = PIFS_EXTENT_INVALID;
+    }
+#else
+    (void)a_page_address;
+#endif
+}
+
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+/**
+ * @brief pifs_is_page_reserved Check if page was reserved by
+ * pifs_reserve_page() and it is not marked in free space bitmap yet.
+ * It shall be called when free space bitmap shows the page free.
+ *
+ * @param[in] a_block_address   Block address of page.
+ * @param[in] a_page_address    Page address of page.
+ * @return TRUE: page is reserved.
+ */
+static bool_t pifs_is_page_reserved(pifs_block_address_t a_block_address,
+                                    pifs_page_address_t a_page_address)
+{
+    return pifs.is_fsbm_ram_valid
+            && !(pifs_fsbm_ram_get_bits(PIFS_FSBM_RAM_PAGE_IDX(a_block_address, a_page_address)) & 1u);
+}
+
+/**
+ * @brief pifs_is_page_reservable Check if pages can be reserved by
+ * pifs_reserve_page().
+ *
+ * @return TRUE: copy of free space bitmap in RAM is usable.
+ */
+bool_t pifs_is_page_reservable(void)
+{
+    return pifs_fsbm_ram_is_usable(&pifs.header) && !pifs.is_merging;
+}
+
+/**
+ * @brief pifs_reserve_page Mark page(s) as used in the copy of free space
+ * bitmap in RAM only, so they are not allocated again.
+ * Free space bitmap in flash memory is changed by pifs_mark_page() when the
+ * pages are referenced by a map entry. Therefore if the map entry is not
+ * written due to a reset, the pages are free after mount. Their content is
+ * found by PIFS_CHECK_IF_PAGE_IS_ERASED and they are marked to be released.
+ *
+ * @param[in] a_block_address   Block address of page(s).
+ * @param[in] a_page_address    Page address of page(s).
+ * @param[in] a_page_count      Number of pages.
+ * @return PIFS_SUCCESS: if pages were reserved.
+ */
+pifs_status_t pifs_reserve_page(pifs_block_address_t a_block_address,
+                                pifs_page_address_t a_page_address,
+                                pifs_page_count_t a_page_count)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    pifs_size_t   page_idx;
+
+    PIFS_ASSERT(pifs_is_page_reservable());
+    while (a_page_count > 0 && ret == PIFS_SUCCESS)
+    {
+        PIFS_DEBUG_MSG("Reserve page %s\r\n", pifs_ba_pa2str(a_block_address, a_page_address));
+        page_idx = PIFS_FSBM_RAM_PAGE_IDX(a_block_address, a_page_address);
+        if (pifs_fsbm_ram_get_bits(page_idx) & 1u)
+        {
+            /* Clear free bit, keep to be released bit */
+            pifs_fsbm_ram_set_bits(page_idx, pifs_fsbm_ram_get_bits(page_idx) & ~1u);
+            pifs_update_used_page(a_block_address, a_page_address);
+        }
+        else
+        {
+            PIFS_FATAL_ERROR_MSG("Page has already allocated! %s\r\n", pifs_ba_pa2str(a_block_address, a_page_address));
+            ret = PIFS_ERROR_INTERNAL_ALLOCATION;
+        }
+        a_page_count--;
+        if (a_page_count > 0 && ret == PIFS_SUCCESS)
+        {
+            ret = pifs_inc_ba_pa(&a_block_address, &a_page_address);
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_mark_reserved_page Mark page(s) as used in free space bitmap
+ * which were reserved by pifs_reserve_page(). Pages which are already marked
+ * are skipped.
+ *
+ * @param[in] a_block_address   Block address of page(s).
+ * @param[in] a_page_address    Page address of page(s).
+ * @param[in] a_page_count      Number of pages.
+ * @return PIFS_SUCCESS: if pages were marked.
+ */
+pifs_status_t pifs_mark_reserved_page(pifs_block_address_t a_block_address,
+                                      pifs_page_address_t a_page_address,
+                                      pifs_page_count_t a_page_count)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+
+    while (a_page_count > 0 && ret == PIFS_SUCCESS)
+    {
+        if (pifs_is_page_free_flash(a_block_address, a_page_address))
+        {
+            ret = pifs_mark_page(a_block_address, a_page_address, 1, TRUE, FALSE);
+        }
+        a_page_count--;
+        if (a_page_count > 0 && ret == PIFS_SUCCESS)
+        {
+            ret = pifs_inc_ba_pa(&a_block_address, &a_page_address);
+        }
+    }
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_mark_page Mark page(s) as used (or to be released) in free space
  * memory bitmap.
@@ -226,9 +853,22 @@ pifs_status_t pifs_mark_page(pifs_block_address_t a_block_address,
     pifs_page_address_t  pa = PIFS_PAGE_ADDRESS_INVALID;
     bool_t               is_free_space;
     bool_t               is_not_to_be_released;
+    uint8_t            * fsbm_buf;
 
     PIFS_ASSERT(pifs.is_header_found);
 
+#if PIFS_ENABLE_MOUNT_HINT
+    /* Page counters of mount hint will be invalid */
+    ret = pifs_mount_hint_set_dirty();
+    pifs_fsbm_load_deferred();
+#endif
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+    if (a_mark_to_be_released)
+    {
+        /* A block may became erasable */
+        pifs.is_merge_prepared = FALSE;
+    }
+#endif
     while (a_page_count > 0 && ret == PIFS_SUCCESS)
     {
         PIFS_DEBUG_MSG("Mark page %s as%s%s\r\n",
@@ -246,14 +886,15 @@ pifs_status_t pifs_mark_page(pifs_block_address_t a_block_address,
         if (ret == PIFS_SUCCESS)
         {
             PIFS_ASSERT((bit_pos / PIFS_BYTE_BITS) < PIFS_LOGICAL_PAGE_SIZE_BYTE);
-            //print_buffer(pifs.cache_page_buf, sizeof(pifs.cache_page_buf), 0);
-            //PIFS_DEBUG_MSG("-Free space byte:    0x%02X\r\n", pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS]);
-            is_free_space = pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] & (1u << (bit_pos % PIFS_BYTE_BITS));
-            is_not_to_be_released = pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] & (1u << ((bit_pos % PIFS_BYTE_BITS) + 1));
+            fsbm_buf = pifs_get_cache_page_buf(ba, pa);
+            //print_buffer(fsbm_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE, 0);
+            //PIFS_DEBUG_MSG("-Free space byte:    0x%02X\r\n", fsbm_buf[bit_pos / PIFS_BYTE_BITS]);
+            is_free_space = fsbm_buf[bit_pos / PIFS_BYTE_BITS] & (1u << (bit_pos % PIFS_BYTE_BITS));
+            is_not_to_be_released = fsbm_buf[bit_pos / PIFS_BYTE_BITS] & (1u << ((bit_pos % PIFS_BYTE_BITS) + 1));
             //PIFS_DEBUG_MSG("-Free space bit:     %i\r\n", is_free_space);
             //PIFS_DEBUG_MSG("-Release space bit:  %i\r\n", is_not_to_be_released);
-            //PIFS_DEBUG_MSG("-Free space bit:     %i\r\n", (pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] >> (bit_pos % PIFS_BYTE_BITS)) & 1);
-            //PIFS_DEBUG_MSG("-Release space bit:  %i\r\n", (pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] >> ((bit_pos % PIFS_BYTE_BITS) + 1)) & 1);
+            //PIFS_DEBUG_MSG("-Free space bit:     %i\r\n", (fsbm_buf[bit_pos / PIFS_BYTE_BITS] >> (bit_pos % PIFS_BYTE_BITS)) & 1);
+            //PIFS_DEBUG_MSG("-Release space bit:  %i\r\n", (fsbm_buf[bit_pos / PIFS_BYTE_BITS] >> ((bit_pos % PIFS_BYTE_BITS) + 1)) & 1);
             if (a_mark_used)
             {
                 /* Mark page used */
@@ -261,8 +902,15 @@ pifs_status_t pifs_mark_page(pifs_block_address_t a_block_address,
                 {
                     //PIFS_NOTICE_MSG("MARK %s\r\n", pifs_ba_pa2str(a_block_address, a_page_address));
                     /* Clear free bit */
-                    pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] &= ~(1u << (bit_pos % PIFS_BYTE_BITS));
+                    fsbm_buf[bit_pos / PIFS_BYTE_BITS] &= ~(1u << (bit_pos % PIFS_BYTE_BITS));
                     is_free_space = FALSE;
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+                    /* Reserved page was already updated by pifs_reserve_page() */
+                    if (!pifs_is_page_reserved(a_block_address, a_page_address))
+#endif
+                    {
+                        pifs_update_used_page(a_block_address, a_page_address);
+                    }
                 }
                 else
                 {
@@ -280,7 +928,10 @@ pifs_status_t pifs_mark_page(pifs_block_address_t a_block_address,
                     if (is_not_to_be_released)
                     {
                         /* Clear release bit */
-                        pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] &= ~(1u << ((bit_pos % PIFS_BYTE_BITS) + 1));
+                        fsbm_buf[bit_pos / PIFS_BYTE_BITS] &= ~(1u << ((bit_pos % PIFS_BYTE_BITS) + 1));
+#if PIFS_ENABLE_PAGE_CNTR
+                        pifs_page_cntr_mark(a_block_address, FALSE);
+#endif
                     }
                     else
                     {
@@ -298,25 +949,138 @@ pifs_status_t pifs_mark_page(pifs_block_address_t a_block_address,
                     ret = PIFS_ERROR_INTERNAL_ALLOCATION;
                 }
             }
-            //PIFS_DEBUG_MSG("+Free space byte:    0x%02X\r\n", pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS]);
-            //PIFS_DEBUG_MSG("+Free space bit:     %i\r\n", (pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] >> (bit_pos % PIFS_BYTE_BITS)) & 1);
-            //PIFS_DEBUG_MSG("+Release space bit:  %i\r\n", (pifs.cache_page_buf[bit_pos / PIFS_BYTE_BITS] >> ((bit_pos % PIFS_BYTE_BITS) + 1)) & 1);
+#if PIFS_ENABLE_FSBM_IN_RAM
+            if (pifs.is_fsbm_ram_valid)
+            {
+                /* Keep copy in RAM coherent */
+                pifs_fsbm_ram_set_bits(PIFS_FSBM_RAM_PAGE_IDX(a_block_address, a_page_address),
+                                       fsbm_buf[bit_pos / PIFS_BYTE_BITS] >> (bit_pos % PIFS_BYTE_BITS));
+            }
+#endif
+            //PIFS_DEBUG_MSG("+Free space byte:    0x%02X\r\n", fsbm_buf[bit_pos / PIFS_BYTE_BITS]);
+            //PIFS_DEBUG_MSG("+Free space bit:     %i\r\n", (fsbm_buf[bit_pos / PIFS_BYTE_BITS] >> (bit_pos % PIFS_BYTE_BITS)) & 1);
+            //PIFS_DEBUG_MSG("+Release space bit:  %i\r\n", (fsbm_buf[bit_pos / PIFS_BYTE_BITS] >> ((bit_pos % PIFS_BYTE_BITS) + 1)) & 1);
             /* Write new status to cache */
             ret = pifs_write(ba, pa, 0, NULL, 0);
         }
         a_page_count--;
         if (a_page_count > 0)
         {
-            ret = pifs_inc_ba_pa(&a_block_address, &a_page_address);
+            ret = pifs_inc_ba_pa(&a_block_address, &a_page_address);
+        }
+        else
+#if PIFS_ENABLE_FSBM_BATCH
+        /* In a batch cache is flushed by pifs_fsbm_batch_end() */
+        if (!pifs.fsbm_batch_cntr)
+#endif
+        {
+            ret = pifs_flush();
+        }
+    }
+
+    return ret;
+}
+
+#if PIFS_ENABLE_ALLOC_CURSOR
+/**
+ * @brief pifs_alloc_cursor_reset Start allocation from beginning of flash
+ * memory. It shall be called when pages may become free (mount, merge).
+ */
+void pifs_alloc_cursor_reset(void)
+{
+    pifs_size_t i;
+
+    for (i = 0; i < PIFS_ALLOC_CURSOR_NUM; i++)
+    {
+        pifs.alloc_cursor[i].block_address = PIFS_FLASH_BLOCK_FIRST_FS;
+        pifs.alloc_cursor[i].page_address = 0;
+    }
+}
+
+/**
+ * @brief pifs_alloc_cursor_erased Move allocation cursors back to the
+ * beginning of an erased block if it is before them.
+ *
+ * @param[in] a_block_address Address of erased block.
+ */
+void pifs_alloc_cursor_erased(pifs_block_address_t a_block_address)
+{
+    pifs_size_t i;
+
+    for (i = 0; i < PIFS_ALLOC_CURSOR_NUM; i++)
+    {
+        if (pifs.alloc_cursor[i].block_address >= a_block_address)
+        {
+            pifs.alloc_cursor[i].block_address = PIFS_MAX(a_block_address, PIFS_FLASH_BLOCK_FIRST_FS);
+            pifs.alloc_cursor[i].page_address = 0;
+        }
+    }
+}
+
+/**
+ * @brief pifs_alloc_cursor_get Get allocation cursor of block type.
+ *
+ * @param[in] a_block_type  Block type to find.
+ * @return Pointer to allocation cursor or NULL if block type has no cursor.
+ */
+static pifs_address_t * pifs_alloc_cursor_get(pifs_block_type_t a_block_type)
+{
+    pifs_address_t * cursor = NULL;
+
+    if (a_block_type == PIFS_BLOCK_TYPE_DATA)
+    {
+        cursor = &pifs.alloc_cursor[0];
+    }
+    else if (a_block_type == PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT)
+    {
+        cursor = &pifs.alloc_cursor[1];
+    }
+
+    return cursor;
+}
+
+/**
+ * @brief pifs_alloc_cursor_advance Move allocation cursor to the first free
+ * page. Pages before the cursor are used or to be released, they can only be
+ * freed by erase or merge, so the cursor only moves forward between them.
+ *
+ * @param[in] a_cursor      Pointer to allocation cursor.
+ * @param[in] a_find        Find parameters of allocation.
+ * @return PIFS_SUCCESS: if free page found. PIFS_ERROR_NO_MORE_SPACE: if no
+ * free page found after the cursor.
+ */
+static pifs_status_t pifs_alloc_cursor_advance(pifs_address_t * a_cursor, pifs_find_t * a_find)
+{
+    pifs_status_t        ret = PIFS_ERROR_NO_MORE_SPACE;
+    pifs_find_t          find = *a_find;
+    pifs_page_count_t    page_count_found;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+
+    if (a_cursor->block_address < PIFS_FLASH_BLOCK_NUM_ALL)
+    {
+        find.page_count_minimum = 1;
+        find.page_count_desired = 1;
+        find.start_block_address = a_cursor->block_address;
+        find.start_page_address = a_cursor->page_address;
+        find.end_block_address = PIFS_FLASH_BLOCK_NUM_ALL - 1;
+        /* Cursor is packed, its members cannot be passed by pointer */
+        ret = pifs_find_page_adv(&find, &ba, &pa, &page_count_found);
+        if (ret == PIFS_SUCCESS)
+        {
+            a_cursor->block_address = ba;
+            a_cursor->page_address = pa;
         }
-        else
+        else if (ret == PIFS_ERROR_NO_MORE_SPACE)
         {
-            ret = pifs_flush();
+            a_cursor->block_address = PIFS_FLASH_BLOCK_NUM_ALL;
+            a_cursor->page_address = 0;
         }
     }
 
     return ret;
 }
+#endif
 
 /**
  * @brief pifs_find_free_page Find free page(s) in free space memory bitmap.
@@ -341,6 +1105,9 @@ pifs_status_t pifs_find_free_page_wl(pifs_page_count_t a_page_count_minimum,
     pifs_status_t   ret = PIFS_ERROR_NO_MORE_SPACE;
     pifs_find_t     find;
     pifs_size_t     i;
+#if PIFS_ENABLE_ALLOC_CURSOR
+    pifs_address_t * cursor = pifs_alloc_cursor_get(a_block_type);
+#endif
 
     if (a_block_type != PIFS_BLOCK_TYPE_DATA
             || pifs.is_wear_leveling
@@ -352,6 +1119,7 @@ pifs_status_t pifs_find_free_page_wl(pifs_page_count_t a_page_count_minimum,
         find.is_free = TRUE;
         find.is_to_be_released = FALSE;
         find.is_same_block = FALSE;
+        find.start_page_address = 0;
         find.header = &pifs.header;
 
         if (a_block_type == PIFS_BLOCK_TYPE_DATA)
@@ -368,7 +1136,17 @@ pifs_status_t pifs_find_free_page_wl(pifs_page_count_t a_page_count_minimum,
                     find.end_block_address = find.start_block_address;
                     if (find.start_block_address < PIFS_FLASH_BLOCK_NUM_ALL)
                     {
+#if PIFS_ENABLE_ALLOC_CURSOR
+                        /* Block before the cursor has no free page */
+                        if (find.start_block_address >= cursor->block_address)
+                        {
+                            find.start_page_address = (find.start_block_address == cursor->block_address)
+                                    ? cursor->page_address : 0;
+                            ret = pifs_find_page_adv(&find, a_block_address, a_page_address, a_page_count_found);
+                        }
+#else
                         ret = pifs_find_page_adv(&find, a_block_address, a_page_address, a_page_count_found);
+#endif
                     }
                     else
                     {
@@ -407,9 +1185,26 @@ pifs_status_t pifs_find_free_page_wl(pifs_page_count_t a_page_count_minimum,
                 PIFS_WARNING_MSG("Dynamic/static wear leveling failed!\r\n");
             }
             /* No success, try to find page anywhere */
-            find.start_block_address = PIFS_FLASH_BLOCK_RESERVED_NUM;
+            find.start_block_address = PIFS_FLASH_BLOCK_FIRST_FS;
+            find.start_page_address = 0;
             find.end_block_address = PIFS_FLASH_BLOCK_NUM_ALL - 1;
-            ret = pifs_find_page_adv(&find, a_block_address, a_page_address, a_page_count_found);
+#if PIFS_ENABLE_ALLOC_CURSOR
+            if (cursor)
+            {
+                /* Continue from the first free page */
+                ret = pifs_alloc_cursor_advance(cursor, &find);
+                find.start_block_address = cursor->block_address;
+                find.start_page_address = cursor->page_address;
+            }
+            else
+            {
+                ret = PIFS_SUCCESS;
+            }
+            if (ret == PIFS_SUCCESS)
+#endif
+            {
+                ret = pifs_find_page_adv(&find, a_block_address, a_page_address, a_page_count_found);
+            }
         }
 
         if (ret == PIFS_SUCCESS && a_block_type == PIFS_BLOCK_TYPE_DATA)
@@ -422,6 +1217,167 @@ pifs_status_t pifs_find_free_page_wl(pifs_page_count_t a_page_count_minimum,
     return ret;
 }
 
+#if PIFS_ENABLE_EXTENT_ALLOC
+/**
+ * @brief pifs_extent_get Get longest run of free pages in a block. It is
+ * calculated from RAM copy of free space bitmap if it is not known.
+ *
+ * @param[in] a_block_address   Block address.
+ * @param[out] a_page_address   First page of the run.
+ * @return Number of pages in the run.
+ */
+static pifs_page_count_t pifs_extent_get(pifs_block_address_t a_block_address,
+                                         pifs_page_address_t * a_page_address)
+{
+    pifs_size_t         page_idx = PIFS_FSBM_RAM_PAGE_IDX(a_block_address, 0);
+    pifs_page_address_t pa;
+    pifs_page_address_t pa_start = 0;
+    pifs_page_count_t   page_count = 0;
+
+    if (pifs.extent_page_count[a_block_address] == PIFS_EXTENT_INVALID)
+    {
+        pifs.extent_page_count[a_block_address] = 0;
+        pifs.extent_page_address[a_block_address] = 0;
+        for (pa = 0; pa < PIFS_LOGICAL_PAGE_PER_BLOCK; pa++)
+        {
+            if (pifs_fsbm_ram_get_bits(page_idx + pa) & 1u)
+            {
+                if (page_count == 0)
+                {
+                    pa_start = pa;
+                }
+                page_count++;
+                if (page_count > pifs.extent_page_count[a_block_address])
+                {
+                    pifs.extent_page_count[a_block_address] = page_count;
+                    pifs.extent_page_address[a_block_address] = pa_start;
+                }
+            }
+            else
+            {
+                page_count = 0;
+            }
+        }
+    }
+    *a_page_address = pifs.extent_page_address[a_block_address];
+
+    return pifs.extent_page_count[a_block_address];
+}
+
+/**
+ * @brief pifs_extent_check Check if data block has longer free run than the
+ * best one found so far.
+ *
+ * @param[in] a_block_address       Block address to check.
+ * @param[in,out] a_block_address_best  Block address of best run.
+ * @param[in,out] a_page_address_best   First page of best run.
+ * @param[in,out] a_page_count_best     Number of pages of best run.
+ */
+static void pifs_extent_check(pifs_block_address_t a_block_address,
+                              pifs_block_address_t * a_block_address_best,
+                              pifs_page_address_t * a_page_address_best,
+                              pifs_page_count_t * a_page_count_best)
+{
+    pifs_page_address_t pa;
+    pifs_page_count_t   page_count;
+
+    if (a_block_address < PIFS_FLASH_BLOCK_NUM_ALL
+            && pifs_is_block_type(a_block_address, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+    {
+        page_count = pifs_extent_get(a_block_address, &pa);
+        if (page_count > *a_page_count_best)
+        {
+            *a_block_address_best = a_block_address;
+            *a_page_address_best = pa;
+            *a_page_count_best = page_count;
+        }
+    }
+}
+
+/**
+ * @brief pifs_find_extent Find contiguous free data pages in one block.
+ * Candidates are checked in order: the given block, least weared blocks, then
+ * every data block. First block which has enough pages is used, otherwise
+ * the longest run of flash memory.
+ *
+ * @param[in] a_page_count          Number of pages needed.
+ * @param[in] a_block_address_near  Preferred block, for example last block of file.
+ * @param[out] a_block_address      Block address of first page.
+ * @param[out] a_page_address       Page address of first page.
+ * @param[out] a_page_count_found   Number of contiguous free pages found.
+ * @return PIFS_SUCCESS: if free pages found. PIFS_ERROR_NO_MORE_SPACE: if
+ * contiguous free pages cannot be found, pifs_find_free_page_wl() can be tried.
+ */
+pifs_status_t pifs_find_extent(pifs_page_count_t a_page_count,
+                               pifs_block_address_t a_block_address_near,
+                               pifs_block_address_t * a_block_address,
+                               pifs_page_address_t * a_page_address,
+                               pifs_page_count_t * a_page_count_found)
+{
+    pifs_status_t        ret = PIFS_ERROR_NO_MORE_SPACE;
+    pifs_block_address_t ba = PIFS_FLASH_BLOCK_FIRST_FS;
+    pifs_block_address_t ba_best = PIFS_BLOCK_ADDRESS_INVALID;
+    pifs_page_address_t  pa_best = 0;
+    pifs_page_count_t    page_count_best = 0;
+    pifs_size_t          i;
+
+    PIFS_ASSERT(pifs.is_header_found);
+
+#if PIFS_ENABLE_MOUNT_HINT
+    pifs_fsbm_load_deferred();
+#endif
+    /* Static wear leveling and its reserved pages are handled by */
+    /* pifs_find_free_page_wl() */
+    if (pifs_fsbm_ram_is_usable(&pifs.header) && !pifs.is_wear_leveling
+            && pifs.free_data_page_num >= PIFS_STATIC_WEAR_RSV_BLOCK_NUM * PIFS_FLASH_PAGE_PER_BLOCK)
+    {
+        pifs_extent_check(a_block_address_near, &ba_best, &pa_best, &page_count_best);
+        for (i = 0; i < PIFS_LEAST_WEARED_BLOCK_NUM && page_count_best < a_page_count; i++)
+        {
+            pifs_extent_check(pifs.header.least_weared_blocks[i].block_address,
+                              &ba_best, &pa_best, &page_count_best);
+        }
+#if PIFS_ENABLE_ALLOC_CURSOR
+        /* Blocks before the cursor have no free page */
+        ba = pifs.alloc_cursor[0].block_address;
+#endif
+        for (ba = pifs_next_block_type(ba, PIFS_BLOCK_TYPE_DATA, &pifs.header);
+             ba < PIFS_FLASH_BLOCK_NUM_ALL && page_count_best < a_page_count;
+             ba = pifs_next_block_type(ba + 1, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+        {
+            pifs_extent_check(ba, &ba_best, &pa_best, &page_count_best);
+        }
+        if (page_count_best > 0)
+        {
+            page_count_best = PIFS_MIN(page_count_best, a_page_count);
+#if PIFS_CHECK_IF_PAGE_IS_ERASED
+            for (i = 0; i < page_count_best; i++)
+            {
+                if (!pifs_is_page_erased(ba_best, pa_best + i))
+                {
+                    PIFS_WARNING_MSG("Flash page should be erased, but it is not! %s\r\n",
+                                     pifs_ba_pa2str(ba_best, pa_best + i));
+                    /* Mark page as to be released as this page should erased */
+                    (void)pifs_mark_page(ba_best, pa_best + i, 1, TRUE, TRUE);
+                    page_count_best = i;
+                }
+            }
+#endif
+        }
+        if (page_count_best > 0)
+        {
+            *a_block_address = ba_best;
+            *a_page_address = pa_best;
+            *a_page_count_found = page_count_best;
+            pifs.free_data_page_num -= page_count_best;
+            ret = PIFS_SUCCESS;
+        }
+    }
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_find_page Find free or to be released page(s) in free space
  * memory bitmap.
@@ -435,7 +1391,7 @@ pifs_status_t pifs_find_free_page_wl(pifs_page_count_t a_page_count_minimum,
  *                                 FALSE: find to be released page.
  * @param[in] a_is_same_block      TRUE: find pages in same block,
  *                                 FALSE: pages can be in different block.
- * @param[in] a_start_block_address Start block address. Example: PIFS_FLASH_BLOCK_RESERVED_NUM
+ * @param[in] a_start_block_address Start block address. Example: PIFS_FLASH_BLOCK_FIRST_FS
  * @param[out] a_block_address     Block address of page(s).
  * @param[out] a_page_address      Page address of page(s).
  * @param[out] a_page_count_found  Number of free pages found.
@@ -460,17 +1416,18 @@ pifs_status_t pifs_find_page(pifs_page_count_t a_page_count_minimum,
     find.is_to_be_released = !a_is_free;
     find.is_same_block = a_is_same_block;
     find.start_block_address = a_start_block_address;
+    find.start_page_address = 0;
     find.end_block_address = PIFS_FLASH_BLOCK_NUM_ALL - 1;
     find.header = &pifs.header;
 
     return pifs_find_page_adv(&find, a_block_address, a_page_address, a_page_count_found);
 }
 
+#if PIFS_ENABLE_FSBM_IN_RAM
 /**
- * @brief pifs_find_page_adv Find free or to be released page(s) in free space
- * memory bitmap. Advanced version.
- * It tries to find 'page_count_desired' pages, but at least
- * 'page_count_minimum'.
+ * @brief pifs_find_page_ram Find free or to be released page(s) in the RAM
+ * copy of free space bitmap. Same as pifs_find_page_flash(), but pages which
+ * cannot be used are skipped word by word.
  *
  * @param[in] a_find               Find parameters.
  * @param[out] a_block_address     Block address of page(s).
@@ -478,10 +1435,164 @@ pifs_status_t pifs_find_page(pifs_page_count_t a_page_count_minimum,
  * @param[out] a_page_count_found  Number of free pages found.
  * @return PIFS_SUCCESS: if free pages found. PIFS_ERROR_NO_MORE_SPACE: if no free pages found.
  */
-pifs_status_t pifs_find_page_adv(pifs_find_t * a_find,
-                                 pifs_block_address_t * a_block_address,
-                                 pifs_page_address_t * a_page_address,
-                                 pifs_page_count_t * a_page_count_found)
+static pifs_status_t pifs_find_page_ram(pifs_find_t * a_find,
+                                        pifs_block_address_t * a_block_address,
+                                        pifs_page_address_t * a_page_address,
+                                        pifs_page_count_t * a_page_count_found)
+{
+    pifs_status_t           ret = PIFS_SUCCESS;
+    pifs_block_address_t    fba = a_find->start_block_address;
+    pifs_page_address_t     fpa = 0;
+    pifs_block_address_t    fba_start = PIFS_BLOCK_ADDRESS_INVALID;
+    pifs_page_address_t     fpa_start = PIFS_PAGE_ADDRESS_INVALID;
+    pifs_block_address_t    fba_next;
+    pifs_size_t             page_idx;
+    pifs_page_count_t       page_count_found = 0;
+    bool_t                  found = FALSE;
+    bool_t                  is_block_type;
+
+#if PIFS_FLASH_BLOCK_FIRST_FS
+    fba = PIFS_MAX(PIFS_FLASH_BLOCK_FIRST_FS, a_find->start_block_address);
+#endif
+    /* Check if start block address is valid */
+    if (fba >= PIFS_FLASH_BLOCK_NUM_ALL)
+    {
+        PIFS_NOTICE_MSG("Start block address corrected from %i to %i\r\n",
+                         fba, PIFS_FLASH_BLOCK_FIRST_FS);
+        fba = PIFS_FLASH_BLOCK_FIRST_FS;
+    }
+    if (fba == a_find->start_block_address)
+    {
+        fpa = a_find->start_page_address;
+    }
+
+    *a_page_count_found = 0;
+    page_idx = PIFS_FSBM_RAM_PAGE_IDX(fba, fpa);
+    is_block_type = pifs_is_block_type(fba, a_find->block_type, a_find->header);
+    while (ret == PIFS_SUCCESS && !found && fba < PIFS_FLASH_BLOCK_NUM_ALL)
+    {
+        if (page_count_found == 0)
+        {
+            /* No sequence is in progress, jump to next usable page */
+            if (!is_block_type)
+            {
+                /* Skip blocks of other type */
+                fba_next = pifs_next_block_type(fba + 1, a_find->block_type, a_find->header);
+                page_idx = PIFS_FSBM_RAM_PAGE_IDX(fba_next, 0);
+            }
+            page_idx = pifs_fsbm_ram_find_next(page_idx, a_find->is_free, a_find->is_to_be_released);
+            fba_next = (page_idx / PIFS_LOGICAL_PAGE_PER_BLOCK) + PIFS_FLASH_BLOCK_FIRST_FS;
+            fpa = page_idx % PIFS_LOGICAL_PAGE_PER_BLOCK;
+            if (fba_next != fba)
+            {
+                fba = fba_next;
+                if ((fba >= PIFS_FLASH_BLOCK_NUM_ALL || fba > a_find->end_block_address) && !(*a_page_count_found))
+                {
+                    ret = PIFS_ERROR_NO_MORE_SPACE;
+                }
+                else if (fba < PIFS_FLASH_BLOCK_NUM_ALL)
+                {
+                    is_block_type = pifs_is_block_type(fba, a_find->block_type, a_find->header);
+                }
+            }
+        }
+        if (ret == PIFS_SUCCESS && fba < PIFS_FLASH_BLOCK_NUM_ALL
+                && (page_count_found || is_block_type))
+        {
+            if (is_block_type
+                    && pifs_check_bits(a_find->is_free, a_find->is_to_be_released,
+                                       pifs_fsbm_ram_get_bits(page_idx)))
+            {
+#if PIFS_CHECK_IF_PAGE_IS_ERASED
+                if (a_find->is_to_be_released || (a_find->is_free && pifs_is_page_erased(fba, fpa)))
+#endif
+                {
+                    PIFS_DEBUG_MSG("Free page %s\r\n", pifs_ba_pa2str(fba, fpa));
+                    if (page_count_found == 0)
+                    {
+                        fba_start = fba;
+                        fpa_start = fpa;
+                    }
+                    page_count_found++;
+                    if (page_count_found >= a_find->page_count_minimum)
+                    {
+                        *a_block_address = fba_start;
+                        *a_page_address = fpa_start;
+                        *a_page_count_found = page_count_found;
+                        PIFS_DEBUG_MSG("page_count_found: %i, %s\r\n", page_count_found,
+                                       pifs_ba_pa2str(fba_start, fpa_start));
+                    }
+                    if (page_count_found == a_find->page_count_desired)
+                    {
+                        found = TRUE;
+                    }
+                }
+#if PIFS_CHECK_IF_PAGE_IS_ERASED
+                else
+                {
+                    PIFS_WARNING_MSG("Flash page should be erased, but it is not! %s\r\n", pifs_ba_pa2str(fba, fpa));
+                    /* Mark page as used */
+                    /* Mark page as to be released as this page should erased */
+                    (void)pifs_mark_page(fba, fpa, 1, TRUE, TRUE);
+                    /* Sequence is broken, page cannot be used */
+                    page_count_found = 0;
+                }
+#endif
+            }
+            else
+            {
+                page_count_found = 0;
+            }
+            if (!found)
+            {
+                page_idx++;
+                fpa++;
+                if (fpa == PIFS_LOGICAL_PAGE_PER_BLOCK)
+                {
+                    fpa = 0;
+                    fba++;
+                    if (a_find->is_same_block
+                            && (a_find->page_count_minimum < PIFS_LOGICAL_PAGE_PER_BLOCK
+                                || (fpa_start > 0 && a_find->page_count_desired >= PIFS_LOGICAL_PAGE_PER_BLOCK)))
+                    {
+                        page_count_found = 0;
+                    }
+                    if ((fba >= PIFS_FLASH_BLOCK_NUM_ALL || fba > a_find->end_block_address) && !(*a_page_count_found))
+                    {
+                        ret = PIFS_ERROR_NO_MORE_SPACE;
+                    }
+                    else if (fba < PIFS_FLASH_BLOCK_NUM_ALL)
+                    {
+                        is_block_type = pifs_is_block_type(fba, a_find->block_type, a_find->header);
+                    }
+                }
+            }
+        }
+    }
+
+    if (ret == PIFS_SUCCESS && !(*a_page_count_found))
+    {
+        ret = PIFS_ERROR_NO_MORE_SPACE;
+    }
+
+    return ret;
+}
+#endif
+
+/**
+ * @brief pifs_find_page_flash Find free or to be released page(s) in free
+ * space memory bitmap, which is read from flash memory (or cache).
+ *
+ * @param[in] a_find               Find parameters.
+ * @param[out] a_block_address     Block address of page(s).
+ * @param[out] a_page_address      Page address of page(s).
+ * @param[out] a_page_count_found  Number of free pages found.
+ * @return PIFS_SUCCESS: if free pages found. PIFS_ERROR_NO_MORE_SPACE: if no free pages found.
+ */
+static pifs_status_t pifs_find_page_flash(pifs_find_t * a_find,
+                                          pifs_block_address_t * a_block_address,
+                                          pifs_page_address_t * a_page_address,
+                                          pifs_page_count_t * a_page_count_found)
 {
     pifs_status_t           ret = PIFS_ERROR_NO_MORE_SPACE;
     pifs_block_address_t    fba = a_find->start_block_address;
@@ -495,23 +1606,31 @@ pifs_status_t pifs_find_page_adv(pifs_find_t * a_find,
     pifs_page_count_t       page_count_found = 0;
     uint8_t                 free_space_bitmap = 0;
     bool_t                  found = FALSE;
+    bool_t                  is_block_type;
     pifs_size_t             byte_cntr = PIFS_FREE_SPACE_BITMAP_SIZE_BYTE;
     pifs_bit_pos_t          bit_pos = 0;
 
     PIFS_ASSERT(pifs.is_header_found);
 
-#if PIFS_FLASH_BLOCK_RESERVED_NUM
-    fba = PIFS_MAX(PIFS_FLASH_BLOCK_RESERVED_NUM, a_find->start_block_address);
+#if PIFS_FLASH_BLOCK_FIRST_FS
+    fba = PIFS_MAX(PIFS_FLASH_BLOCK_FIRST_FS, a_find->start_block_address);
 #endif
     /* Check if start block address is valid */
     if (fba >= PIFS_FLASH_BLOCK_NUM_ALL)
     {
         PIFS_NOTICE_MSG("Start block address corrected from %i to %i\r\n",
-                         fba, PIFS_FLASH_BLOCK_RESERVED_NUM);
-        fba = PIFS_FLASH_BLOCK_RESERVED_NUM;
+                         fba, PIFS_FLASH_BLOCK_FIRST_FS);
+        fba = PIFS_FLASH_BLOCK_FIRST_FS;
+    }
+    if (fba == a_find->start_block_address)
+    {
+        /* Bitmap is processed byte by byte */
+        fpa = a_find->start_page_address
+                - a_find->start_page_address % (PIFS_BYTE_BITS / PIFS_FSBM_BITS_PER_PAGE);
     }
 
     *a_page_count_found = 0;
+    is_block_type = pifs_is_block_type(fba, a_find->block_type, a_find->header);
     ret = pifs_calc_free_space_pos(&a_find->header->free_space_bitmap_address,
                                    fba, fpa, &fsbm_ba, &fsbm_pa, &bit_pos);
     if (ret == PIFS_SUCCESS)
@@ -526,8 +1645,8 @@ pifs_status_t pifs_find_page_adv(pifs_find_t * a_find,
                 //PIFS_DEBUG_MSG("%s %i 0x%X\r\n", pifs_ba_pa2str(ba, pa), po, free_space_bitmap);
                 for (i = 0; i < (PIFS_BYTE_BITS / PIFS_FSBM_BITS_PER_PAGE) && !found; i++)
                 {
-                    if (pifs_check_bits(a_find->is_free, a_find->is_to_be_released, free_space_bitmap)
-                            && pifs_is_block_type(fba, a_find->block_type, a_find->header))
+                    if (is_block_type
+                            && pifs_check_bits(a_find->is_free, a_find->is_to_be_released, free_space_bitmap))
                     {
 #if PIFS_CHECK_IF_PAGE_IS_ERASED
                         if (a_find->is_to_be_released || (a_find->is_free && pifs_is_page_erased(fba, fpa)))
@@ -576,6 +1695,8 @@ pifs_status_t pifs_find_page_adv(pifs_find_t * a_find,
                             /* Mark page as used */
                             /* Mark page as to be released as this page should erased */
                             (void)pifs_mark_page(fba, fpa, 1, TRUE, TRUE);
+                            /* Sequence is broken, page cannot be used */
+                            page_count_found = 0;
                         }
 #endif
                     }
@@ -601,6 +1722,10 @@ pifs_status_t pifs_find_page_adv(pifs_find_t * a_find,
                             {
                                 ret = PIFS_ERROR_NO_MORE_SPACE;
                             }
+                            else if (fba < PIFS_FLASH_BLOCK_NUM_ALL)
+                            {
+                                is_block_type = pifs_is_block_type(fba, a_find->block_type, a_find->header);
+                            }
                         }
                     }
                 }
@@ -631,6 +1756,44 @@ pifs_status_t pifs_find_page_adv(pifs_find_t * a_find,
     return ret;
 }
 
+/**
+ * @brief pifs_find_page_adv Find free or to be released page(s) in free space
+ * memory bitmap. Advanced version.
+ * It tries to find 'page_count_desired' pages, but at least
+ * 'page_count_minimum'.
+ *
+ * @param[in] a_find               Find parameters.
+ * @param[out] a_block_address     Block address of page(s).
+ * @param[out] a_page_address      Page address of page(s).
+ * @param[out] a_page_count_found  Number of free pages found.
+ * @return PIFS_SUCCESS: if free pages found. PIFS_ERROR_NO_MORE_SPACE: if no free pages found.
+ */
+pifs_status_t pifs_find_page_adv(pifs_find_t * a_find,
+                                 pifs_block_address_t * a_block_address,
+                                 pifs_page_address_t * a_page_address,
+                                 pifs_page_count_t * a_page_count_found)
+{
+    pifs_status_t ret;
+
+    PIFS_ASSERT(pifs.is_header_found);
+
+#if PIFS_ENABLE_MOUNT_HINT
+    pifs_fsbm_load_deferred();
+#endif
+#if PIFS_ENABLE_FSBM_IN_RAM
+    if (pifs_fsbm_ram_is_usable(a_find->header))
+    {
+        ret = pifs_find_page_ram(a_find, a_block_address, a_page_address, a_page_count_found);
+    }
+    else
+#endif
+    {
+        ret = pifs_find_page_flash(a_find, a_block_address, a_page_address, a_page_count_found);
+    }
+
+    return ret;
+}
+
 /**
  * @brief pifs_find_block_wl Find free/to be released block with wear leveling.
  *
@@ -660,6 +1823,7 @@ pifs_status_t pifs_find_block_wl(pifs_size_t a_block_count,
     find.is_free = a_is_free;
     find.is_to_be_released = TRUE;
     find.is_same_block = TRUE;
+    find.start_page_address = 0;
     find.header = a_header;
 
     /* Dynamic wear leveling */
@@ -674,7 +1838,7 @@ pifs_status_t pifs_find_block_wl(pifs_size_t a_block_count,
     {
         PIFS_DEBUG_MSG("Dynamic wear leveling failed!\r\n");
         /* Not found, try to find anywhere */
-        find.start_block_address = PIFS_FLASH_BLOCK_RESERVED_NUM;
+        find.start_block_address = PIFS_FLASH_BLOCK_FIRST_FS;
         find.end_block_address = PIFS_FLASH_BLOCK_NUM_ALL - 1;
         ret = pifs_find_page_adv(&find, &ba, &pa, &page_count);
     }
@@ -696,7 +1860,7 @@ pifs_status_t pifs_find_block_wl(pifs_size_t a_block_count,
  *
  * @param[in] a_block_count         Number of blocks. Example: PIFS_FLASH_BLOCK_NUM_FS
  * @param[in] a_block_type          Block type to find.
- * @param[in] a_start_block_address Start block address. Example: PIFS_FLASH_BLOCK_RESERVED_NUM
+ * @param[in] a_start_block_address Start block address. Example: PIFS_FLASH_BLOCK_FIRST_FS
  * @param[in] a_end_block_address   End address of search. Example: PIFS_FLASH_BLOCK_NUM_ALL
  * @param[in] a_header              Pointer to file system header.
  * @param[out] a_block_address      Block address of page to be released if found.
@@ -722,6 +1886,7 @@ pifs_status_t pifs_find_to_be_released_block(pifs_size_t a_block_count,
     find.is_to_be_released = TRUE;
     find.is_same_block = TRUE;
     find.start_block_address = a_start_block_address;
+    find.start_page_address = 0;
     find.end_block_address = a_end_block_address;
     find.header = a_header;
 
@@ -740,7 +1905,7 @@ pifs_status_t pifs_find_to_be_released_block(pifs_size_t a_block_count,
  *
  * @param[in] a_is_free                 TRUE: find free page,
  *                                      FALSE: find to be released page.
- * @param[in] a_start_block_address     Start block address. Example: PIFS_FLASH_BLOCK_RESERVED_NUM
+ * @param[in] a_start_block_address     Start block address. Example: PIFS_FLASH_BLOCK_FIRST_FS
  * @param[in] a_block_count             Number of blocks. Example: PIFS_FLASH_BLOCK_NUM_FS
  * @param[out] a_management_page_count  Number of management pages found.
  * @param[out] a_data_page_count        Number of data pages found.
@@ -779,9 +1944,76 @@ pifs_status_t pifs_get_pages(bool_t a_is_free,
     *a_management_page_count = 0;
     *a_data_page_count = 0;
 
-    ret = pifs_calc_free_space_pos(&pifs.header.free_space_bitmap_address,
-                                   fba, fpa, &fsbm_ba, &fsbm_pa, &bit_pos);
-    if (ret == PIFS_SUCCESS)
+#if PIFS_ENABLE_MOUNT_HINT
+    if (a_start_block_address != PIFS_FLASH_BLOCK_FIRST_FS
+            || a_block_count < PIFS_FLASH_BLOCK_NUM_FS)
+    {
+        /* Page counters of blocks are needed */
+        pifs_fsbm_load_deferred();
+    }
+#endif
+#if PIFS_ENABLE_PAGE_CNTR
+    if (pifs.is_page_cntr_valid)
+    {
+        if (a_start_block_address == PIFS_FLASH_BLOCK_FIRST_FS
+                && a_block_count >= PIFS_FLASH_BLOCK_NUM_FS)
+        {
+            /* Whole file system: use global counters */
+            *a_management_page_count = a_is_free ? pifs.free_management_page_cntr
+                                                 : pifs.to_be_released_management_page_cntr;
+            *a_data_page_count = a_is_free ? pifs.free_data_page_cntr
+                                           : pifs.to_be_released_data_page_cntr;
+        }
+        else
+        {
+            for ( ; fba < PIFS_FLASH_BLOCK_NUM_ALL && a_block_count; fba++, a_block_count--)
+            {
+                if (pifs_is_block_type(fba, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+                {
+                    *a_data_page_count += a_is_free ? pifs.block_free_page_cntr[fba]
+                                                    : pifs.block_to_be_released_page_cntr[fba];
+                }
+                else if (pifs_is_block_type(fba, PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT, &pifs.header))
+                {
+                    *a_management_page_count += a_is_free ? pifs.block_free_page_cntr[fba]
+                                                          : pifs.block_to_be_released_page_cntr[fba];
+                }
+            }
+        }
+        end = TRUE;
+        ret = PIFS_SUCCESS;
+    }
+    else
+#endif
+#if PIFS_ENABLE_FSBM_IN_RAM
+    if (pifs.is_fsbm_ram_valid)
+    {
+        for ( ; fba < PIFS_FLASH_BLOCK_NUM_ALL && a_block_count; fba++, a_block_count--)
+        {
+            if (pifs_is_block_type(fba, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+            {
+                *a_data_page_count += pifs_fsbm_ram_count(PIFS_FSBM_RAM_PAGE_IDX(fba, 0),
+                                                          PIFS_LOGICAL_PAGE_PER_BLOCK,
+                                                          a_is_free, !a_is_free);
+            }
+            else if (pifs_is_block_type(fba, PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT, &pifs.header))
+            {
+                /* Only count primary management, see below */
+                *a_management_page_count += pifs_fsbm_ram_count(PIFS_FSBM_RAM_PAGE_IDX(fba, 0),
+                                                                PIFS_LOGICAL_PAGE_PER_BLOCK,
+                                                                a_is_free, !a_is_free);
+            }
+        }
+        end = TRUE;
+        ret = PIFS_SUCCESS;
+    }
+    else
+#endif
+    {
+        ret = pifs_calc_free_space_pos(&pifs.header.free_space_bitmap_address,
+                                       fba, fpa, &fsbm_ba, &fsbm_pa, &bit_pos);
+    }
+    if (ret == PIFS_SUCCESS && !end)
     {
         po = bit_pos / PIFS_BYTE_BITS;
 
@@ -855,7 +2087,7 @@ pifs_status_t pifs_get_to_be_released_pages(pifs_size_t * a_free_management_page
                                             pifs_size_t * a_free_data_page_count)
 {
     return pifs_get_pages(FALSE,
-                          PIFS_FLASH_BLOCK_RESERVED_NUM,
+                          PIFS_FLASH_BLOCK_FIRST_FS,
                           PIFS_FLASH_BLOCK_NUM_FS,
                           a_free_management_page_count, a_free_data_page_count);
 }
@@ -872,7 +2104,7 @@ pifs_status_t pifs_get_free_pages(pifs_size_t * a_free_management_page_count,
                                   pifs_size_t * a_free_data_page_count)
 {
     return pifs_get_pages(TRUE,
-                          PIFS_FLASH_BLOCK_RESERVED_NUM,
+                          PIFS_FLASH_BLOCK_FIRST_FS,
                           PIFS_FLASH_BLOCK_NUM_FS,
                           a_free_management_page_count, a_free_data_page_count);
 }
@@ -961,7 +2193,7 @@ pifs_status_t pifs_check_free_space(void)
     pifs_block_address_t ba;
     pifs_page_address_t  pa;
 
-    for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM; ba < PIFS_FLASH_BLOCK_NUM_ALL; ba++)
+    for (ba = PIFS_FLASH_BLOCK_FIRST_FS; ba < PIFS_FLASH_BLOCK_NUM_ALL; ba++)
     {
         for (pa = 0; pa < PIFS_LOGICAL_PAGE_PER_BLOCK; pa++)
         {
@@ -44,10 +44,28 @@ typedef struct
     bool_t               is_same_block;       /**< TRUE: find pages in same block,
                                                    FALSE: pages can be in different block. */
     pifs_block_address_t start_block_address; /**< Start address of search. */
+    pifs_page_address_t  start_page_address;  /**< Start page address in start block. */
     pifs_block_address_t end_block_address;   /**< End address of search. */
     pifs_header_t      * header;
 } pifs_find_t;
 
+#if PIFS_ENABLE_FSBM_IN_RAM
+pifs_status_t pifs_fsbm_ram_load(void);
+#endif
+#if PIFS_ENABLE_ALLOC_CURSOR
+void pifs_alloc_cursor_reset(void);
+void pifs_alloc_cursor_erased(pifs_block_address_t a_block_address);
+#endif
+#if PIFS_ENABLE_PAGE_CNTR
+void pifs_page_cntr_load(void);
+#endif
+#if PIFS_ENABLE_MOUNT_HINT
+void pifs_fsbm_load_deferred(void);
+#endif
+#if PIFS_ENABLE_FSBM_BATCH
+void pifs_fsbm_batch_begin(void);
+pifs_status_t pifs_fsbm_batch_end(pifs_status_t a_status, bool_t a_is_flush_deferred);
+#endif
 pifs_status_t pifs_calc_free_space_pos(const pifs_address_t * a_free_space_bitmap_address,
                                        pifs_block_address_t a_block_address,
                                        pifs_page_address_t a_page_address,
@@ -59,6 +77,10 @@ void pifs_calc_address(pifs_bit_pos_t a_bit_pos,
                        pifs_page_address_t * a_page_address);
 bool_t pifs_is_page_free(pifs_block_address_t a_block_address,
                          pifs_page_address_t a_page_address);
+#if PIFS_SKIP_FREE_PAGE_READ
+bool_t pifs_is_page_known_erased(pifs_block_address_t a_block_address,
+                                 pifs_page_address_t a_page_address);
+#endif
 bool_t pifs_is_page_to_be_released(pifs_block_address_t a_block_address,
                                    pifs_page_address_t a_page_address);
 pifs_status_t pifs_mark_page(pifs_block_address_t a_block_address,
@@ -66,12 +88,28 @@ pifs_status_t pifs_mark_page(pifs_block_address_t a_block_address,
                              pifs_page_count_t a_page_count,
                              bool_t a_mark_used,
                              bool_t a_mark_to_be_released);
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+bool_t pifs_is_page_reservable(void);
+pifs_status_t pifs_reserve_page(pifs_block_address_t a_block_address,
+                                pifs_page_address_t a_page_address,
+                                pifs_page_count_t a_page_count);
+pifs_status_t pifs_mark_reserved_page(pifs_block_address_t a_block_address,
+                                      pifs_page_address_t a_page_address,
+                                      pifs_page_count_t a_page_count);
+#endif
 pifs_status_t pifs_find_free_page_wl(pifs_page_count_t a_page_count_minimum,
                                      pifs_page_count_t a_page_count_desired,
                                      pifs_block_type_t a_block_type,
                                      pifs_block_address_t * a_block_address,
                                      pifs_page_address_t * a_page_address,
                                      pifs_page_count_t * a_page_count_found);
+#if PIFS_ENABLE_EXTENT_ALLOC
+pifs_status_t pifs_find_extent(pifs_page_count_t a_page_count,
+                               pifs_block_address_t a_block_address_near,
+                               pifs_block_address_t * a_block_address,
+                               pifs_page_address_t * a_page_address,
+                               pifs_page_count_t * a_page_count_found);
+#endif
 pifs_status_t pifs_find_page(pifs_page_count_t a_page_count_minimum,
                              pifs_page_count_t a_page_count_desired,
                              pifs_block_type_t a_block_type,
@@ -143,6 +143,81 @@ char * pifs_flash_ba_pa2str(pifs_block_address_t a_block_address, pifs_page_addr
     return str;
 }
 
+#if !(PIFS_FLASH_CAPABILITIES & PIFS_FLASH_CAP_READ_SG)
+/**
+ * @brief pifs_flash_read_sg Read several areas of flash memory.
+ * Flash driver does not implement it, so areas are read one by one.
+ *
+ * @param[in] a_sg      Areas to read and buffers to fill.
+ * @param[in] a_sg_num  Number of elements in a_sg.
+ * @return PIFS_SUCCESS if read successfully finished.
+ */
+pifs_status_t pifs_flash_read_sg(const pifs_flash_sg_t * a_sg, size_t a_sg_num)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    size_t        i;
+
+    for (i = 0; i < a_sg_num && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_flash_read(a_sg[i].block_address, a_sg[i].page_address,
+                              a_sg[i].page_offset, a_sg[i].buf, a_sg[i].buf_size);
+    }
+
+    return ret;
+}
+#endif
+
+#if !(PIFS_FLASH_CAPABILITIES & PIFS_FLASH_CAP_WRITE_PAGES)
+/**
+ * @brief pifs_flash_write_pages Program whole consecutive pages of a block.
+ * Flash driver does not implement it, so pages are programmed one by one.
+ *
+ * @param[in] a_block_address Address of block.
+ * @param[in] a_page_address  Address of the first page in block.
+ * @param[in] a_buf           Buffer to write.
+ * @param[in] a_page_count    Number of pages to program.
+ * @return PIFS_SUCCESS if write successfully finished.
+ */
+pifs_status_t pifs_flash_write_pages(pifs_block_address_t a_block_address, pifs_page_address_t a_page_address,
+                                     const void * const a_buf, size_t a_page_count)
+{
+    pifs_status_t   ret = PIFS_SUCCESS;
+    const uint8_t * buf = (const uint8_t*) a_buf;
+    size_t          i;
+
+    for (i = 0; i < a_page_count && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_flash_write(a_block_address, a_page_address + i, 0,
+                               &buf[i * PIFS_FLASH_PAGE_SIZE_BYTE], PIFS_FLASH_PAGE_SIZE_BYTE);
+    }
+
+    return ret;
+}
+#endif
+
+#if !(PIFS_FLASH_CAPABILITIES & PIFS_FLASH_CAP_ERASE_BLOCKS)
+/**
+ * @brief pifs_flash_erase_blocks Erase consecutive blocks.
+ * Flash driver does not implement it, so blocks are erased one by one.
+ *
+ * @param[in] a_block_address Address of first block to erase.
+ * @param[in] a_block_count   Number of blocks to erase.
+ * @return PIFS_SUCCESS if blocks were erased successfully.
+ */
+pifs_status_t pifs_flash_erase_blocks(pifs_block_address_t a_block_address, size_t a_block_count)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    size_t        i;
+
+    for (i = 0; i < a_block_count && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_flash_erase(a_block_address + i);
+    }
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_byte2bin_str Convert a byte to binary string.
  *
@@ -165,15 +240,25 @@ char * pifs_byte2bin_str(uint8_t byte)
 #endif
 
 /**
- * @brief pifs_print_cache Print content of page buffer.
+ * @brief pifs_print_cache Print content of page buffers.
  */
 void pifs_print_cache(void)
 {
 #if PIFS_DEBUG_LEVEL >= 3
-    PIFS_NOTICE_MSG("Cache page buffer:\r\n");
-    print_buffer(pifs.cache_page_buf, sizeof(pifs.cache_page_buf),
-                 pifs.cache_page_buf_address.block_address * PIFS_FLASH_BLOCK_SIZE_BYTE
-                 + pifs.cache_page_buf_address.page_address * PIFS_LOGICAL_PAGE_SIZE_BYTE);
+    pifs_size_t i;
+
+    for (i = 0; i < PIFS_CACHE_PAGE_NUM; i++)
+    {
+        if (pifs.cache[i].address.block_address != PIFS_BLOCK_ADDRESS_INVALID)
+        {
+            PIFS_NOTICE_MSG("Cache page buffer %s%s:\r\n",
+                            pifs_address2str(&pifs.cache[i].address),
+                            pifs.cache[i].is_dirty ? " (dirty)" : "");
+            print_buffer(pifs.cache[i].buf, sizeof(pifs.cache[i].buf),
+                         pifs.cache[i].address.block_address * PIFS_FLASH_BLOCK_SIZE_BYTE
+                         + pifs.cache[i].address.page_address * PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        }
+    }
 #endif
 }
 
@@ -315,17 +400,16 @@ bool_t pifs_is_address_valid(pifs_address_t * a_address)
 }
 
 /**
- * @brief pifs_is_block_type Checks if the given block address is block type.
+ * @brief pifs_calc_block_type Calculate type of block from file system's
+ * header.
  * @param[in] a_block_address Block address to check.
- * @param[in] a_block_type    Block type.
  * @param[in] a_header        Pointer to file system's header.
- * @return TRUE: If block address is equal to block type.
+ * @return Type of block.
  */
-bool_t pifs_is_block_type(pifs_block_address_t a_block_address,
-                          pifs_block_type_t a_block_type,
-                          pifs_header_t * a_header)
+static pifs_block_type_t pifs_calc_block_type(pifs_block_address_t a_block_address,
+                                              pifs_header_t * a_header)
 {
-    bool_t is_block_type = FALSE;
+    pifs_block_type_t block_type;
 
 #if PIFS_MANAGEMENT_BLOCK_NUM > 1
     if (a_block_address >= a_header->management_block_address
@@ -334,11 +418,7 @@ bool_t pifs_is_block_type(pifs_block_address_t a_block_address,
     if (a_header->management_block_address == a_block_address)
 #endif
     {
-        is_block_type |= (a_block_type & PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT);
-        if (a_block_type & PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT)
-        {
-            //PIFS_WARNING_MSG("Primary management block: %i\r\n", a_block_address);
-        }
+        block_type = PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT;
     }
     else
 #if PIFS_MANAGEMENT_BLOCK_NUM > 1
@@ -348,29 +428,119 @@ bool_t pifs_is_block_type(pifs_block_address_t a_block_address,
     if (a_header->next_management_block_address == a_block_address)
 #endif
     {
-        is_block_type |= (a_block_type & PIFS_BLOCK_TYPE_SECONDARY_MANAGEMENT);
-        if (a_block_type & PIFS_BLOCK_TYPE_SECONDARY_MANAGEMENT)
-        {
-            //PIFS_WARNING_MSG("Secondary management block: %i\r\n", a_block_address);
-        }
+        block_type = PIFS_BLOCK_TYPE_SECONDARY_MANAGEMENT;
     }
     else
-#if PIFS_FLASH_BLOCK_RESERVED_NUM
-    if (a_block_address < PIFS_FLASH_BLOCK_RESERVED_NUM)
+#if PIFS_FLASH_BLOCK_FIRST_FS
+    if (a_block_address < PIFS_FLASH_BLOCK_FIRST_FS)
+    {
+        block_type = PIFS_BLOCK_TYPE_RESERVED;
+    }
+    else
+#endif
+    {
+        block_type = PIFS_BLOCK_TYPE_DATA;
+    }
+
+    return block_type;
+}
+
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+/**
+ * @brief pifs_block_type_table_init Fill table of block types according to
+ * file system's header. It shall be called when header is changed (mount,
+ * merge).
+ *
+ * @param[in] a_header        Pointer to file system's header.
+ */
+void pifs_block_type_table_init(pifs_header_t * a_header)
+{
+    pifs_block_address_t ba;
+
+    memset(pifs.block_type_table, 0, sizeof(pifs.block_type_table));
+    for (ba = 0; ba < PIFS_FLASH_BLOCK_NUM_ALL; ba++)
     {
-        is_block_type |= (a_block_type & PIFS_BLOCK_TYPE_RESERVED);
+        pifs.block_type_table[ba / 2u] |= pifs_calc_block_type(ba, a_header) << ((ba % 2u) * 4u);
+    }
+    pifs.block_type_table_mgmt_ba = a_header->management_block_address;
+    pifs.block_type_table_next_mgmt_ba = a_header->next_management_block_address;
+}
+#endif
+
+/**
+ * @brief pifs_is_block_type Checks if the given block address is block type.
+ * @param[in] a_block_address Block address to check.
+ * @param[in] a_block_type    Block type, types can be combined.
+ * @param[in] a_header        Pointer to file system's header.
+ * @return TRUE: If block address is equal to block type.
+ */
+bool_t pifs_is_block_type(pifs_block_address_t a_block_address,
+                          pifs_block_type_t a_block_type,
+                          pifs_header_t * a_header)
+{
+    pifs_block_type_t block_type;
+
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+    /* Table is used only if it was filled according to the given header,
+     * merge checks blocks of old and new header as well */
+    if (a_header->management_block_address == pifs.block_type_table_mgmt_ba
+            && a_header->next_management_block_address == pifs.block_type_table_next_mgmt_ba)
+    {
+        block_type = (pifs_block_type_t) ((pifs.block_type_table[a_block_address / 2u]
+                                           >> ((a_block_address % 2u) * 4u)) & 0x0Fu);
     }
     else
 #endif
     {
-        is_block_type |= (a_block_type & PIFS_BLOCK_TYPE_DATA);
-        if (a_block_type & PIFS_BLOCK_TYPE_SECONDARY_MANAGEMENT)
+        block_type = pifs_calc_block_type(a_block_address, a_header);
+    }
+
+    return (block_type & a_block_type) != 0;
+}
+
+/**
+ * @brief pifs_next_block_type Find next block of given type. Blocks of
+ * other types are skipped at once.
+ *
+ * @param[in] a_block_address Block address to start from.
+ * @param[in] a_block_type    Block type, types can be combined.
+ * @param[in] a_header        Pointer to file system's header.
+ * @return Block address of first block of given type from a_block_address
+ * or PIFS_FLASH_BLOCK_NUM_ALL if there is no such block.
+ */
+pifs_block_address_t pifs_next_block_type(pifs_block_address_t a_block_address,
+                                          pifs_block_type_t a_block_type,
+                                          pifs_header_t * a_header)
+{
+    pifs_block_address_t ba = a_block_address;
+
+#if PIFS_FLASH_BLOCK_FIRST_FS
+    if (!(a_block_type & PIFS_BLOCK_TYPE_RESERVED))
+    {
+        /* Reserved blocks are at the beginning of flash memory */
+        ba = PIFS_MAX(ba, PIFS_FLASH_BLOCK_FIRST_FS);
+    }
+#endif
+    while (ba < PIFS_FLASH_BLOCK_NUM_ALL && !pifs_is_block_type(ba, a_block_type, a_header))
+    {
+        /* Blocks of a management area have the same type, skip them at once */
+        if (ba >= a_header->management_block_address
+                && ba < a_header->management_block_address + PIFS_MANAGEMENT_BLOCK_NUM)
+        {
+            ba = a_header->management_block_address + PIFS_MANAGEMENT_BLOCK_NUM;
+        }
+        else if (ba >= a_header->next_management_block_address
+                && ba < a_header->next_management_block_address + PIFS_MANAGEMENT_BLOCK_NUM)
+        {
+            ba = a_header->next_management_block_address + PIFS_MANAGEMENT_BLOCK_NUM;
+        }
+        else
         {
-            //PIFS_WARNING_MSG("Data block: %i\r\n", a_block_address);
+            ba++;
         }
     }
 
-    return is_block_type;
+    return ba;
 }
 
 /**
@@ -401,6 +571,9 @@ bool_t pifs_is_buffer_erased(const void * a_buf, pifs_size_t a_buf_size)
 
 /**
  * @brief pifs_is_page_erased Checks if the given block address is block type.
+ * Pages verified to be erased are not read again until they are written
+ * (PIFS_ENABLE_ERASED_BITMAP).
+ *
  * @param[in] a_block_address Block address to check.
  * @param[in] a_page_address  Page address to check.
  * @return TRUE: If page is erased.
@@ -411,14 +584,78 @@ bool_t pifs_is_page_erased(pifs_block_address_t a_block_address,
     pifs_status_t status;
     bool_t is_erased = FALSE;
 
-    status = pifs_read(a_block_address, a_page_address, 0, NULL, 0);
-    if (status == PIFS_SUCCESS)
+#if PIFS_ENABLE_ERASED_BITMAP
+    if (pifs_is_page_verified_erased(a_block_address, a_page_address))
     {
-        is_erased = pifs_is_buffer_erased(pifs.cache_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        is_erased = TRUE;
+    }
+    else
+#endif
+    {
+        status = pifs_read(a_block_address, a_page_address, 0, NULL, 0);
+        if (status == PIFS_SUCCESS)
+        {
+            is_erased = pifs_is_buffer_erased(pifs_get_cache_page_buf(a_block_address, a_page_address),
+                                              PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        }
+#if PIFS_ENABLE_ERASED_BITMAP
+        if (is_erased)
+        {
+            pifs_set_page_verified_erased(a_block_address, a_page_address, 1, TRUE);
+        }
+#endif
     }
     return is_erased;
 }
 
+#if PIFS_ENABLE_ERASED_BITMAP
+/**
+ * @brief pifs_is_page_verified_erased Check if page was verified to be erased
+ * and it was not written since then.
+ *
+ * @param[in] a_block_address Block address of page.
+ * @param[in] a_page_address  Page address of page.
+ * @return TRUE: page is erased, no need to read it.
+ */
+bool_t pifs_is_page_verified_erased(pifs_block_address_t a_block_address,
+                                    pifs_page_address_t a_page_address)
+{
+    pifs_size_t idx = PIFS_ERASED_BITMAP_IDX(a_block_address, a_page_address);
+
+    return (pifs.erased_bitmap[idx / 32u] & (1u << (idx % 32u))) != 0;
+}
+
+/**
+ * @brief pifs_set_page_verified_erased Mark pages as verified to be erased
+ * or clear their marks.
+ *
+ * @param[in] a_block_address Block address of first page.
+ * @param[in] a_page_address  Page address of first page.
+ * @param[in] a_page_count    Number of consecutive pages.
+ * @param[in] a_is_erased     TRUE: pages are erased. FALSE: pages are written.
+ */
+void pifs_set_page_verified_erased(pifs_block_address_t a_block_address,
+                                   pifs_page_address_t a_page_address,
+                                   pifs_size_t a_page_count,
+                                   bool_t a_is_erased)
+{
+    pifs_size_t idx = PIFS_ERASED_BITMAP_IDX(a_block_address, a_page_address);
+    pifs_size_t i;
+
+    for (i = idx; i < idx + a_page_count; i++)
+    {
+        if (a_is_erased)
+        {
+            pifs.erased_bitmap[i / 32u] |= 1u << (i % 32u);
+        }
+        else
+        {
+            pifs.erased_bitmap[i / 32u] &= ~(1u << (i % 32u));
+        }
+    }
+}
+#endif
+
 /**
  * @brief pifs_is_buffer_programmable Check if buffer is programmable or erase
  * is needed.
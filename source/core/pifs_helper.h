@@ -50,9 +50,23 @@ bool_t pifs_is_address_valid(pifs_address_t * a_address);
 bool_t pifs_is_block_type(pifs_block_address_t a_block_address,
                           pifs_block_type_t a_block_type,
                           pifs_header_t *a_header);
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+void pifs_block_type_table_init(pifs_header_t * a_header);
+#endif
+pifs_block_address_t pifs_next_block_type(pifs_block_address_t a_block_address,
+                                          pifs_block_type_t a_block_type,
+                                          pifs_header_t * a_header);
 bool_t pifs_is_buffer_erased(const void * a_buf, pifs_size_t a_buf_size);
 bool_t pifs_is_page_erased(pifs_block_address_t a_block_address,
                            pifs_page_address_t a_page_address);
+#if PIFS_ENABLE_ERASED_BITMAP
+bool_t pifs_is_page_verified_erased(pifs_block_address_t a_block_address,
+                                    pifs_page_address_t a_page_address);
+void pifs_set_page_verified_erased(pifs_block_address_t a_block_address,
+                                   pifs_page_address_t a_page_address,
+                                   pifs_size_t a_page_count,
+                                   bool_t a_is_erased);
+#endif
 bool_t pifs_is_buffer_programmable(const void * a_orig_buf, const void * a_new_buf, pifs_size_t a_buf_size);
 bool_t pifs_is_buffer_programmed(const void * a_buf, pifs_size_t a_buf_size);
 void pifs_parse_open_mode(pifs_file_t * a_file, const pifs_char_t *a_modes);
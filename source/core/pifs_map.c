@@ -36,6 +36,142 @@
 #include "pifs_delta.h"
 #include "pifs_map.h"
 
+#if PIFS_EXTENT_CACHE_NUM
+/**
+ * @brief pifs_extent_search Find position of page in the extent table.
+ *
+ * @param[in] a_file        Pointer to opened file.
+ * @param[in] a_page_idx    Index of page in the file.
+ * @return Number of extents which start at or before the page.
+ */
+static pifs_size_t pifs_extent_search(pifs_file_t * a_file, pifs_size_t a_page_idx)
+{
+    pifs_size_t lo = 0;
+    pifs_size_t hi = a_file->extent_count;
+    pifs_size_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (a_file->extent[mid].page_idx <= a_page_idx)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * @brief pifs_extent_add Store actual map entry in the extent table.
+ * If the table is full, every second extent is dropped, so the remaining
+ * extents still cover the whole file.
+ *
+ * @param[in] a_file Pointer to opened file.
+ */
+static void pifs_extent_add(pifs_file_t * a_file)
+{
+    pifs_size_t     pos;
+    pifs_size_t     i;
+    pifs_extent_t * extent;
+
+    if (!pifs_is_buffer_erased(&a_file->map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
+    {
+        pos = pifs_extent_search(a_file, a_file->map_entry_page_idx);
+        if (pos == 0 || a_file->extent[pos - 1].page_idx != a_file->map_entry_page_idx)
+        {
+            if (a_file->extent_count == PIFS_EXTENT_CACHE_NUM)
+            {
+                for (i = 1; i < (a_file->extent_count + 1) / 2; i++)
+                {
+                    a_file->extent[i] = a_file->extent[i * 2];
+                }
+                a_file->extent_count = (a_file->extent_count + 1) / 2;
+                pos = pifs_extent_search(a_file, a_file->map_entry_page_idx);
+            }
+            for (i = a_file->extent_count; i > pos; i--)
+            {
+                a_file->extent[i] = a_file->extent[i - 1];
+            }
+            extent = &a_file->extent[pos];
+            extent->page_idx = a_file->map_entry_page_idx;
+            extent->map_address = a_file->actual_map_address;
+            extent->map_entry_idx = a_file->map_entry_idx;
+            extent->address = a_file->map_entry.address;
+            extent->page_count = a_file->map_entry.page_count;
+            a_file->extent_count++;
+        }
+    }
+}
+
+/**
+ * @brief pifs_extent_reset Drop all extents of the file.
+ *
+ * @param[in] a_file Pointer to file.
+ */
+void pifs_extent_reset(pifs_file_t * a_file)
+{
+    a_file->extent_count = 0;
+    a_file->extent_map_address.block_address = PIFS_BLOCK_ADDRESS_INVALID;
+    a_file->extent_map_address.page_address = PIFS_PAGE_ADDRESS_INVALID;
+}
+
+/**
+ * @brief pifs_extent_seek Move read/write address of file to the last known
+ * page before a position, without walking the map.
+ * The file's position is only moved forward. The caller shall seek the
+ * remaining bytes.
+ *
+ * @param[in] a_file Pointer to opened file.
+ * @param[in] a_pos  Position in file to approach.
+ * @return PIFS_SUCCESS if position was moved or no extent is known.
+ */
+pifs_status_t pifs_extent_seek(pifs_file_t * a_file, pifs_size_t a_pos)
+{
+    pifs_size_t     page_idx = a_pos / PIFS_LOGICAL_PAGE_SIZE_BYTE;
+    pifs_size_t     pos;
+    pifs_size_t     offset;
+    pifs_extent_t * extent;
+
+    pos = pifs_extent_search(a_file, page_idx);
+    if (pos > 0
+            && a_file->extent_map_address.block_address == a_file->entry.first_map_address.block_address
+            && a_file->extent_map_address.page_address == a_file->entry.first_map_address.page_address)
+    {
+        extent = &a_file->extent[pos - 1];
+        offset = PIFS_MIN(page_idx - extent->page_idx, (pifs_size_t)extent->page_count - 1);
+        if ((extent->page_idx + offset) * PIFS_LOGICAL_PAGE_SIZE_BYTE > a_file->rw_pos)
+        {
+            PIFS_DEBUG_MSG("Jump to page %lu of map entry %s #%lu\r\n", extent->page_idx + offset,
+                           pifs_address2str(&extent->map_address), extent->map_entry_idx);
+            a_file->status = pifs_read(extent->map_address.block_address,
+                                       extent->map_address.page_address,
+                                       0, &a_file->map_header, PIFS_MAP_HEADER_SIZE_BYTE);
+            if (a_file->status == PIFS_SUCCESS)
+            {
+                a_file->actual_map_address = extent->map_address;
+                a_file->map_entry_idx = extent->map_entry_idx;
+                a_file->map_entry_page_idx = extent->page_idx;
+                a_file->map_entry.address = extent->address;
+                a_file->map_entry.page_count = extent->page_count;
+                a_file->map_entry.checksum = pifs_calc_checksum(&a_file->map_entry,
+                                                                PIFS_MAP_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE);
+                a_file->rw_address = extent->address;
+                a_file->rw_page_count = extent->page_count - offset;
+                a_file->rw_pos = (extent->page_idx + offset) * PIFS_LOGICAL_PAGE_SIZE_BYTE;
+                a_file->status = pifs_add_address(&a_file->rw_address, offset);
+            }
+        }
+    }
+
+    return a_file->status;
+}
+#endif
+
 /**
  * @brief pifs_read_first_map_entry Read first map's first map entry.
  *
@@ -49,6 +185,16 @@ pifs_status_t pifs_read_first_map_entry(pifs_file_t * a_file)
 
     a_file->map_entry_idx = 0;
     a_file->actual_map_address = a_file->entry.first_map_address;
+#if PIFS_EXTENT_CACHE_NUM
+    a_file->map_entry_page_idx = 0;
+    if (a_file->extent_map_address.block_address != a_file->entry.first_map_address.block_address
+            || a_file->extent_map_address.page_address != a_file->entry.first_map_address.page_address)
+    {
+        /* Extents of another file */
+        pifs_extent_reset(a_file);
+        a_file->extent_map_address = a_file->entry.first_map_address;
+    }
+#endif
     PIFS_DEBUG_MSG("Map address %s\r\n",
                    pifs_address2str(&a_file->actual_map_address));
     a_file->status = pifs_read(a_file->entry.first_map_address.block_address,
@@ -79,6 +225,9 @@ pifs_status_t pifs_read_first_map_entry(pifs_file_t * a_file)
         PIFS_DEBUG_MSG("Map entry %s, page count: %i\r\n",
                        pifs_address2str(&a_file->map_entry.address),
                        a_file->map_entry.page_count);
+#if PIFS_EXTENT_CACHE_NUM
+        pifs_extent_add(a_file);
+#endif
     }
 
     return a_file->status;
@@ -97,6 +246,12 @@ pifs_status_t pifs_read_next_map_entry(pifs_file_t * a_file)
     pifs_checksum_t checksum;
     bool_t          is_erased;
 
+#if PIFS_EXTENT_CACHE_NUM
+    if (!pifs_is_buffer_erased(&a_file->map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
+    {
+        a_file->map_entry_page_idx += a_file->map_entry.page_count;
+    }
+#endif
     a_file->map_entry_idx++;
     if (a_file->map_entry_idx >= PIFS_MAP_ENTRY_PER_PAGE)
     {
@@ -152,6 +307,9 @@ pifs_status_t pifs_read_next_map_entry(pifs_file_t * a_file)
         PIFS_DEBUG_MSG("Map entry %s, page count: %i\r\n",
                        pifs_address2str(&a_file->map_entry.address),
                        a_file->map_entry.page_count);
+#if PIFS_EXTENT_CACHE_NUM
+        pifs_extent_add(a_file);
+#endif
     }
 
     return a_file->status;
@@ -159,7 +317,7 @@ pifs_status_t pifs_read_next_map_entry(pifs_file_t * a_file)
 
 /**
  * @brief pifs_is_free_map_entry Check if free map entry exists in the actual
- * map.
+ * map. If file has pending map entry, two free entries are needed.
  *
  * @param[in] a_file               Pointer to file to use.
  * @param[out] a_is_free_map_entry TRUE: free map entry exists.
@@ -170,29 +328,120 @@ pifs_status_t pifs_is_free_map_entry(pifs_file_t * a_file,
 {
     pifs_block_address_t    ba = a_file->actual_map_address.block_address;
     pifs_page_address_t     pa = a_file->actual_map_address.page_address;
-    bool_t                  empty_entry_found = FALSE;
+    pifs_size_t             empty_entry_num = 0;
+    pifs_size_t             empty_entry_num_needed = 1;
     pifs_map_entry_t        map_entry;
     pifs_size_t             i;
 
     PIFS_DEBUG_MSG("Actual map address %s\r\n",
                    pifs_address2str(&a_file->actual_map_address));
-    for (i = 0; i < PIFS_MAP_ENTRY_PER_PAGE && !empty_entry_found && a_file->status == PIFS_SUCCESS; i++)
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+    if (a_file->pending_map_page_count)
+    {
+        /* Pending entry may be written before the new one */
+        empty_entry_num_needed = 2;
+    }
+#endif
+    for (i = 0; i < PIFS_MAP_ENTRY_PER_PAGE && empty_entry_num < empty_entry_num_needed
+         && a_file->status == PIFS_SUCCESS; i++)
     {
         a_file->status = pifs_read(ba, pa, i * PIFS_MAP_ENTRY_SIZE_BYTE,
                                    &map_entry, PIFS_MAP_ENTRY_SIZE_BYTE);
         if (pifs_is_buffer_erased(&map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
         {
-            empty_entry_found = TRUE;
+            empty_entry_num++;
         }
     }
-    PIFS_DEBUG_MSG("Empty entry found: %i\r\n", empty_entry_found);
-    *a_is_free_map_entry = empty_entry_found;
+    PIFS_DEBUG_MSG("Empty entries found: %i\r\n", empty_entry_num);
+    *a_is_free_map_entry = (empty_entry_num >= empty_entry_num_needed);
 
     return a_file->status;
 }
 
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+/**
+ * @brief pifs_seed_map_tail Store position of last map entry if the map was
+ * walked to its end, e.g. by seeking to the end of file.
+ *
+ * @param[in] a_file Pointer to opened file.
+ * @return PIFS_SUCCESS if map was read successfully.
+ */
+pifs_status_t pifs_seed_map_tail(pifs_file_t * a_file)
+{
+    pifs_status_t    ret = PIFS_SUCCESS;
+    pifs_map_entry_t map_entry;
+    bool_t           is_last = FALSE;
+    bool_t           is_page_full = FALSE;
+
+    if (!a_file->tail_map_entry_idx && pifs_is_address_valid(&a_file->actual_map_address))
+    {
+        if (pifs_is_buffer_erased(&a_file->map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
+        {
+            /* Map was walked after the last entry */
+            if (a_file->map_entry_idx)
+            {
+                a_file->tail_map_address = a_file->actual_map_address;
+                a_file->tail_map_entry_idx = a_file->map_entry_idx;
+#if PIFS_EXTENT_CACHE_NUM
+                a_file->tail_map_page_idx = a_file->map_entry_page_idx;
+#endif
+            }
+        }
+        else
+        {
+            if (!a_file->map_entry_idx)
+            {
+                /* When last entry of a full map page was walked over and */
+                /* there is no next map page, index is 0, but map entry */
+                /* is the last one of the page */
+                ret = pifs_read(a_file->actual_map_address.block_address,
+                                a_file->actual_map_address.page_address,
+                                PIFS_MAP_HEADER_SIZE_BYTE, &map_entry, PIFS_MAP_ENTRY_SIZE_BYTE);
+                is_page_full = (ret == PIFS_SUCCESS
+                                && (map_entry.address.block_address != a_file->map_entry.address.block_address
+                                    || map_entry.address.page_address != a_file->map_entry.address.page_address));
+            }
+            if (is_page_full)
+            {
+                a_file->tail_map_address = a_file->actual_map_address;
+                a_file->tail_map_entry_idx = PIFS_MAP_ENTRY_PER_PAGE;
+#if PIFS_EXTENT_CACHE_NUM
+                /* Pages of last entry are already counted */
+                a_file->tail_map_page_idx = a_file->map_entry_page_idx;
+#endif
+            }
+            else if (ret == PIFS_SUCCESS && a_file->map_entry_idx + 1 < PIFS_MAP_ENTRY_PER_PAGE)
+            {
+                ret = pifs_read(a_file->actual_map_address.block_address,
+                                a_file->actual_map_address.page_address,
+                                PIFS_MAP_HEADER_SIZE_BYTE + (a_file->map_entry_idx + 1) * PIFS_MAP_ENTRY_SIZE_BYTE,
+                                &map_entry, PIFS_MAP_ENTRY_SIZE_BYTE);
+                is_last = (ret == PIFS_SUCCESS && pifs_is_buffer_erased(&map_entry, PIFS_MAP_ENTRY_SIZE_BYTE));
+            }
+            else if (ret == PIFS_SUCCESS)
+            {
+                /* Last entry of map page, map may continue in the next page */
+                is_last = (a_file->map_header.next_map_address.block_address >= PIFS_BLOCK_ADDRESS_INVALID
+                           || a_file->map_header.next_map_address.page_address >= PIFS_PAGE_ADDRESS_INVALID);
+            }
+            if (is_last)
+            {
+                a_file->tail_map_address = a_file->actual_map_address;
+                a_file->tail_map_entry_idx = a_file->map_entry_idx + 1;
+#if PIFS_EXTENT_CACHE_NUM
+                a_file->tail_map_page_idx = a_file->map_entry_page_idx + a_file->map_entry.page_count;
+#endif
+            }
+        }
+    }
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_append_map_entry Add an entry to the file's map.
+ * If position of last map entry is known, map is not walked.
  * This function is called when file is growing and new space is needed.
  *
  * @param[in] a_file            Pointer to file to use.
@@ -214,6 +463,36 @@ pifs_status_t pifs_append_map_entry(pifs_file_t * a_file,
     PIFS_NOTICE_MSG("Actual map address %s\r\n",
                     pifs_address2str(&a_file->actual_map_address));
     PIFS_ASSERT(pifs_is_address_valid(&a_file->actual_map_address));
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+    if (a_file->tail_map_entry_idx)
+    {
+        /* Jump to last map entry, next entry is checked below */
+        ba = a_file->tail_map_address.block_address;
+        pa = a_file->tail_map_address.page_address;
+        a_file->status = pifs_read(ba, pa, 0, &a_file->map_header, PIFS_MAP_HEADER_SIZE_BYTE);
+        if (a_file->status == PIFS_SUCCESS)
+        {
+            a_file->status = pifs_read(ba, pa, PIFS_MAP_HEADER_SIZE_BYTE
+                                       + (a_file->tail_map_entry_idx - 1) * PIFS_MAP_ENTRY_SIZE_BYTE,
+                                       &a_file->map_entry, PIFS_MAP_ENTRY_SIZE_BYTE);
+        }
+        if (a_file->status == PIFS_SUCCESS
+                && !pifs_is_buffer_erased(&a_file->map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
+        {
+            a_file->actual_map_address = a_file->tail_map_address;
+            a_file->map_entry_idx = a_file->tail_map_entry_idx - 1;
+#if PIFS_EXTENT_CACHE_NUM
+            a_file->map_entry_page_idx = a_file->tail_map_page_idx - a_file->map_entry.page_count;
+#endif
+        }
+        else if (a_file->status == PIFS_SUCCESS)
+        {
+            PIFS_WARNING_MSG("Invalid map tail %s #%lu\r\n",
+                             pifs_address2str(&a_file->tail_map_address), a_file->tail_map_entry_idx);
+            a_file->status = pifs_read_first_map_entry(a_file);
+        }
+    }
+#endif
     do
     {
         if (pifs_is_buffer_erased(&a_file->map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
@@ -283,7 +562,9 @@ pifs_status_t pifs_append_map_entry(pifs_file_t * a_file,
     }
     if (empty_entry_found)
     {
-        /* Empty map entry found */
+        /* Empty map entry found, map may have been walked to next page */
+        ba = a_file->actual_map_address.block_address;
+        pa = a_file->actual_map_address.page_address;
         a_file->map_entry.address.block_address = a_block_address;
         a_file->map_entry.address.page_address = a_page_address;
         a_file->map_entry.page_count = a_page_count;
@@ -297,6 +578,22 @@ pifs_status_t pifs_append_map_entry(pifs_file_t * a_file,
                                     PIFS_MAP_ENTRY_SIZE_BYTE);
         PIFS_DEBUG_MSG("### New map entry %s ###\r\n",
                        pifs_ba_pa2str(ba, pa));
+#if PIFS_EXTENT_CACHE_NUM
+        if (a_file->status == PIFS_SUCCESS)
+        {
+            pifs_extent_add(a_file);
+        }
+#endif
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+        if (a_file->status == PIFS_SUCCESS)
+        {
+            a_file->tail_map_address = a_file->actual_map_address;
+            a_file->tail_map_entry_idx = a_file->map_entry_idx + 1;
+#if PIFS_EXTENT_CACHE_NUM
+            a_file->tail_map_page_idx = a_file->map_entry_page_idx + a_page_count;
+#endif
+        }
+#endif
 //        pifs_print_cache();
     }
     else
@@ -308,6 +605,163 @@ pifs_status_t pifs_append_map_entry(pifs_file_t * a_file,
     return a_file->status;
 }
 
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+/**
+ * @brief pifs_defer_map_entry Add pages to the file's map later.
+ * The pending map entry is extended if the pages follow it, otherwise it is
+ * written and a new pending entry is started. Therefore appending many
+ * small runs of contiguous pages produces one map entry.
+ *
+ * @param[in] a_file            Pointer to opened file.
+ * @param[in] a_block_address   Block address of first page.
+ * @param[in] a_page_address    Page address of first page.
+ * @param[in] a_page_count      Number of pages.
+ * @return PIFS_SUCCESS if pages were added.
+ */
+pifs_status_t pifs_defer_map_entry(pifs_file_t * a_file,
+                                   pifs_block_address_t a_block_address,
+                                   pifs_page_address_t a_page_address,
+                                   pifs_page_count_t a_page_count)
+{
+    if (a_file->pending_map_page_count
+            && a_file->pending_map_address.block_address == a_block_address
+            && a_file->pending_map_address.page_address + a_file->pending_map_page_count == a_page_address
+            && a_file->pending_map_page_count + a_page_count < PIFS_MAP_PAGE_COUNT_INVALID)
+    {
+        PIFS_DEBUG_MSG("Extend pending map entry %s by %i pages\r\n",
+                       pifs_address2str(&a_file->pending_map_address), a_page_count);
+        a_file->pending_map_page_count += a_page_count;
+    }
+    else
+    {
+        a_file->status = pifs_commit_map_entry(a_file);
+        if (a_file->status == PIFS_SUCCESS)
+        {
+            a_file->pending_map_address.block_address = a_block_address;
+            a_file->pending_map_address.page_address = a_page_address;
+            a_file->pending_map_page_count = a_page_count;
+        }
+    }
+
+    return a_file->status;
+}
+
+/**
+ * @brief pifs_commit_map_entry Write pending map entry of file.
+ * It shall be called before the map is read or file size is updated.
+ * Status of file is not changed if there is no pending entry.
+ *
+ * @param[in] a_file Pointer to opened file.
+ * @return PIFS_SUCCESS if there was no pending entry or it was written.
+ */
+pifs_status_t pifs_commit_map_entry(pifs_file_t * a_file)
+{
+    pifs_status_t     ret = PIFS_SUCCESS;
+    pifs_status_t     status = a_file->status;
+    pifs_page_count_t page_count = a_file->pending_map_page_count;
+
+    if (page_count)
+    {
+        a_file->pending_map_page_count = 0;
+        /* Pages are already written, entry shall be written even if last */
+        /* write failed (e.g. file system is full) */
+        a_file->status = PIFS_SUCCESS;
+        /* Pages are marked before the entry is written: if a reset occurs */
+        /* between them, pages are lost, but not allocated twice */
+        ret = pifs_mark_reserved_page(a_file->pending_map_address.block_address,
+                                      a_file->pending_map_address.page_address,
+                                      page_count);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_append_map_entry(a_file,
+                                        a_file->pending_map_address.block_address,
+                                        a_file->pending_map_address.page_address,
+                                        page_count);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            /* Keep error of last operation */
+            a_file->status = status;
+        }
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_ENABLE_FALLOCATE
+/**
+ * @brief pifs_count_map_pages Count data pages of file's map entries.
+ * Actual map entry and read/write address of file are not changed.
+ *
+ * @param[in] a_file        Pointer to opened file.
+ * @param[out] a_page_count Number of data pages in the map.
+ * @return PIFS_SUCCESS if map was read successfully.
+ */
+pifs_status_t pifs_count_map_pages(pifs_file_t * a_file, pifs_size_t * a_page_count)
+{
+    pifs_status_t           ret = PIFS_SUCCESS;
+    pifs_block_address_t    ba = a_file->entry.first_map_address.block_address;
+    pifs_page_address_t     pa = a_file->entry.first_map_address.page_address;
+    pifs_map_header_t       map_header;
+    pifs_map_entry_t        map_entry;
+    pifs_size_t             i;
+    bool_t                  end = FALSE;
+
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+    /* Pages of pending map entry are not in the map yet */
+    *a_page_count = a_file->pending_map_page_count;
+#else
+    *a_page_count = 0;
+#endif
+    do
+    {
+        ret = pifs_read(ba, pa, 0, &map_header, PIFS_MAP_HEADER_SIZE_BYTE);
+        for (i = 0; i < PIFS_MAP_ENTRY_PER_PAGE && !end && ret == PIFS_SUCCESS; i++)
+        {
+            ret = pifs_read(ba, pa, PIFS_MAP_HEADER_SIZE_BYTE + i * PIFS_MAP_ENTRY_SIZE_BYTE,
+                            &map_entry, PIFS_MAP_ENTRY_SIZE_BYTE);
+            if (ret == PIFS_SUCCESS)
+            {
+                if (pifs_is_buffer_erased(&map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
+                {
+                    end = TRUE;
+                }
+                else if (pifs_calc_checksum(&map_entry, PIFS_MAP_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE)
+                         == map_entry.checksum)
+                {
+                    *a_page_count += map_entry.page_count;
+                }
+                else
+                {
+                    ret = PIFS_ERROR_CHECKSUM;
+                }
+            }
+        }
+        if (ret == PIFS_SUCCESS && !end)
+        {
+            if (pifs_is_buffer_erased(&map_header.next_map_address, PIFS_ADDRESS_SIZE_BYTE))
+            {
+                end = TRUE;
+            }
+            else if (pifs_calc_checksum(&map_header.next_map_address, PIFS_ADDRESS_SIZE_BYTE)
+                     == map_header.next_map_checksum)
+            {
+                /* Jump to the next map page */
+                ba = map_header.next_map_address.block_address;
+                pa = map_header.next_map_address.page_address;
+            }
+            else
+            {
+                ret = PIFS_ERROR_CHECKSUM;
+            }
+        }
+    } while (!end && ret == PIFS_SUCCESS);
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_release_file_pages Mark file map and file's pages to be released.
  *
@@ -368,25 +822,22 @@ pifs_status_t pifs_walk_file_pages(pifs_file_t * a_file,
                                        page_count);
                         if (page_count && page_count < PIFS_MAP_PAGE_COUNT_INVALID)
                         {
-                            a_file->status = pifs_find_delta_page(mba, mpa,
-                                                                  &delta_ba, &delta_pa, NULL,
-                                                                  &pifs.header);
                             while (page_count-- && a_file->status == PIFS_SUCCESS)
                             {
-                                /* Call callback function */
-                                a_file->status = (*a_file_walker_func)(a_file, mba, mpa,
-                                                                       delta_ba, delta_pa,
-                                                                       FALSE, a_func_data);
-                                if (page_count)
+                                /* Every page of the entry may have its own delta page */
+                                a_file->status = pifs_find_delta_page(mba, mpa,
+                                                                      &delta_ba, &delta_pa, NULL,
+                                                                      &pifs.header);
+                                if (a_file->status == PIFS_SUCCESS)
                                 {
-                                    if (a_file->status == PIFS_SUCCESS)
-                                    {
-                                        a_file->status = pifs_inc_ba_pa(&delta_ba, &delta_pa);
-                                    }
-                                    if (a_file->status == PIFS_SUCCESS)
-                                    {
-                                        a_file->status = pifs_inc_ba_pa(&mba, &mpa);
-                                    }
+                                    /* Call callback function */
+                                    a_file->status = (*a_file_walker_func)(a_file, mba, mpa,
+                                                                           delta_ba, delta_pa,
+                                                                           FALSE, a_func_data);
+                                }
+                                if (page_count && a_file->status == PIFS_SUCCESS)
+                                {
+                                    a_file->status = pifs_inc_ba_pa(&mba, &mpa);
                                 }
                             }
                         }
@@ -488,6 +939,16 @@ pifs_status_t pifs_release_file_page(pifs_file_t * a_file,
  */
 pifs_status_t pifs_release_file_pages(pifs_file_t * a_file)
 {
-    return pifs_walk_file_pages(a_file, pifs_release_file_page, NULL);
+    pifs_status_t ret;
+
+#if PIFS_ENABLE_FSBM_BATCH
+    pifs_fsbm_batch_begin();
+#endif
+    ret = pifs_walk_file_pages(a_file, pifs_release_file_page, NULL);
+#if PIFS_ENABLE_FSBM_BATCH
+    ret = pifs_fsbm_batch_end(ret, FALSE);
+#endif
+
+    return ret;
 }
 
@@ -64,14 +64,31 @@ typedef pifs_status_t (*pifs_file_walker_func_t)(pifs_file_t * a_file,
                                                  bool_t a_map_page,
                                                  void * a_func_data);
 
+#if PIFS_EXTENT_CACHE_NUM
+void pifs_extent_reset(pifs_file_t * a_file);
+pifs_status_t pifs_extent_seek(pifs_file_t * a_file, pifs_size_t a_pos);
+#endif
 pifs_status_t pifs_read_first_map_entry(pifs_file_t * a_file);
 pifs_status_t pifs_read_next_map_entry(pifs_file_t * a_file);
 pifs_status_t pifs_is_free_map_entry(pifs_file_t * a_file,
                                      bool_t * a_is_free_map_entry);
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+pifs_status_t pifs_seed_map_tail(pifs_file_t * a_file);
+#endif
 pifs_status_t pifs_append_map_entry(pifs_file_t * a_file,
                                     pifs_block_address_t a_block_address,
                                     pifs_page_address_t a_page_address,
                                     pifs_page_count_t a_page_count);
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+pifs_status_t pifs_defer_map_entry(pifs_file_t * a_file,
+                                   pifs_block_address_t a_block_address,
+                                   pifs_page_address_t a_page_address,
+                                   pifs_page_count_t a_page_count);
+pifs_status_t pifs_commit_map_entry(pifs_file_t * a_file);
+#endif
+#if PIFS_ENABLE_FALLOCATE
+pifs_status_t pifs_count_map_pages(pifs_file_t * a_file, pifs_size_t * a_page_count);
+#endif
 pifs_status_t pifs_walk_file_pages(pifs_file_t * a_file,
                                    pifs_file_walker_func_t a_file_walker_func,
                                    void * a_func_data);
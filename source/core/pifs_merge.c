@@ -44,6 +44,54 @@
 
 #define PIFS_COPY_FSBM   0
 
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+/**
+ * @brief pifs_is_block_erased_for_merge Check if block was erased by
+ * pifs_merge_pre_erase() since last merge.
+ *
+ * @param[in] a_block_address Block address.
+ * @return TRUE: block is erased and not used since.
+ */
+static bool_t pifs_is_block_erased_for_merge(pifs_block_address_t a_block_address)
+{
+    return (pifs.merge_erased_block_bitmap[PIFS_MERGE_ERASED_WORD_IDX(a_block_address)]
+            & PIFS_MERGE_ERASED_BIT(a_block_address)) != 0;
+}
+#endif
+
+/**
+ * @brief pifs_merge_erase Erase a block during merge. If the block was
+ * already erased by pifs_merge_pre_erase(), only its wear level is incremented.
+ *
+ * @param[in] a_block_address   Block address to erase.
+ * @param[in] a_old_header      Pointer to previous file system's header.
+ * @param[in] a_new_header      Pointer to new file system's header or NULL.
+ * @return PIFS_SUCCESS if erase was successful.
+ */
+static pifs_status_t pifs_merge_erase(pifs_block_address_t a_block_address,
+                                      pifs_header_t * a_old_header,
+                                      pifs_header_t * a_new_header)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+    if (pifs_is_block_erased_for_merge(a_block_address))
+    {
+        PIFS_NOTICE_MSG("Block %i is already erased\r\n", a_block_address);
+        if (a_new_header)
+        {
+            ret = pifs_inc_wear_level(a_block_address, a_new_header);
+        }
+    }
+    else
+#endif
+    {
+        ret = pifs_erase(a_block_address, a_old_header, a_new_header);
+    }
+
+    return ret;
+}
+
 /**
  * @brief pifs_copy_fsbm Copy free space bitmap and process to be released pages.
  * It finds 'to be released' pages according to old free space bitmap and
@@ -56,10 +104,10 @@
 static pifs_status_t pifs_copy_fsbm(pifs_header_t * a_old_header, pifs_header_t * a_new_header)
 {
     pifs_status_t        ret = PIFS_SUCCESS;
-    pifs_block_address_t fba = PIFS_FLASH_BLOCK_RESERVED_NUM;
+    pifs_block_address_t fba = PIFS_FLASH_BLOCK_FIRST_FS;
     pifs_block_address_t to_be_released_ba;
 
-    for (fba = PIFS_FLASH_BLOCK_RESERVED_NUM; fba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS; fba++)
+    for (fba = PIFS_FLASH_BLOCK_FIRST_FS; fba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS; fba++)
     {
         /* Find to be released pages for whole block */
         ret = pifs_find_to_be_released_block(1, PIFS_BLOCK_TYPE_DATA,
@@ -71,7 +119,7 @@ static pifs_status_t pifs_copy_fsbm(pifs_header_t * a_old_header, pifs_header_t
             /* Check if the found block is the actual block */
             if (pifs_is_block_type(fba, PIFS_BLOCK_TYPE_DATA, a_old_header))
             {
-                ret = pifs_erase(fba, a_old_header, a_new_header);
+                ret = pifs_merge_erase(fba, a_old_header, a_new_header);
                 if (ret == PIFS_SUCCESS)
                 {
                     PIFS_NOTICE_MSG("Block %i erased\r\n", fba);
@@ -99,7 +147,7 @@ static pifs_status_t pifs_copy_fsbm(pifs_header_t * a_old_header, pifs_header_t
 static pifs_status_t pifs_copy_fsbm(pifs_header_t * a_old_header, pifs_header_t * a_new_header)
 {
     pifs_status_t        ret = PIFS_SUCCESS;
-    pifs_block_address_t fba = PIFS_FLASH_BLOCK_RESERVED_NUM;
+    pifs_block_address_t fba = PIFS_FLASH_BLOCK_FIRST_FS;
     pifs_page_address_t  fpa = 0;
     pifs_block_address_t old_fsbm_ba = a_old_header->free_space_bitmap_address.block_address;
     pifs_page_address_t  old_fsbm_pa = a_old_header->free_space_bitmap_address.page_address;
@@ -135,7 +183,7 @@ static pifs_status_t pifs_copy_fsbm(pifs_header_t * a_old_header, pifs_header_t
                     /* Check if the found block is the actual block */
                     if (pifs_is_block_type(fba, PIFS_BLOCK_TYPE_DATA, a_old_header))
                     {
-                        ret = pifs_erase(fba, a_old_header, a_new_header);
+                        ret = pifs_merge_erase(fba, a_old_header, a_new_header);
                         /* Block erased, it can be marked as free */
                         mark_block_free = TRUE;
                         PIFS_WARNING_MSG("Block %i erased\r\n", fba);
@@ -514,7 +562,7 @@ static pifs_status_t pifs_copy_entry_list(pifs_header_t * a_old_header,
                         {
                             PIFS_NOTICE_MSG("%s\r\n", pifs_ba_pa2str(new_entry_list_ba, new_entry_list_pa));
 #if PIFS_DEBUG_LEVEL >= 5
-                            print_buffer(pifs.cache_page_buf, sizeof(pifs.cache_page_buf),
+                            print_buffer(pifs_get_cache_page_buf(new_entry_list_ba, new_entry_list_pa), PIFS_LOGICAL_PAGE_SIZE_BYTE,
                                          new_entry_list_ba * PIFS_FLASH_BLOCK_SIZE_BYTE + new_entry_list_pa * PIFS_LOGICAL_PAGE_SIZE_BYTE);
 #endif
                         }
@@ -550,6 +598,7 @@ static pifs_status_t pifs_copy_entry_list(pifs_header_t * a_old_header,
  *
  * Steps of merging:
  * #0 Close opened files, but store actual file position.
+ *    Patches of delta pages are folded to new delta pages.
  * #1 Erase next management blocks.
  * #2 Initialize file system's header, but not write. Next management blocks'
  *    address is not initialized and checksum is not calculated.
@@ -587,10 +636,22 @@ pifs_status_t pifs_merge(void)
     pifs_size_t          file_pos[PIFS_OPEN_FILE_NUM_MAX] = { 0 };
     bool_t               mode_create_new_file;
     bool_t               mode_file_shall_exist;
+#if PIFS_ENABLE_FSBM_BATCH
+    uint8_t              fsbm_batch_cntr = pifs.fsbm_batch_cntr;
+#endif
 
     PIFS_INFO_MSG("start\r\n");
     PIFS_ASSERT(!pifs.is_merging);
     pifs.is_merging = TRUE;
+#if PIFS_ENABLE_STATISTICS
+    pifs.merge_cntr++;
+#endif
+#if PIFS_ENABLE_FSBM_BATCH
+    /* Merge may be called in a batch (e.g. from pifs_fwrite()), but it has */
+    /* its own batches. Pending changes are written before merge. */
+    pifs.fsbm_batch_cntr = 0;
+    ret = pifs_flush();
+#endif
     /* #0 */
     for (i = 0; i < PIFS_OPEN_FILE_NUM_MAX; i++)
     {
@@ -607,10 +668,18 @@ pifs_status_t pifs_merge(void)
             file->is_entry_list_address_updated = FALSE;
         }
     }
+#if PIFS_DELTA_PATCH_PAGE_NUM
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Patch pages are released, therefore patches are written to */
+        /* delta pages before free space bitmap is copied. */
+        ret = pifs_fold_delta_patch(&old_header);
+    }
+#endif
     /* #1 */
     for (i = 0; i < PIFS_MANAGEMENT_BLOCK_NUM && ret == PIFS_SUCCESS; i++)
     {
-        ret = pifs_erase(old_header.next_management_block_address + i, NULL, NULL);
+        ret = pifs_merge_erase(old_header.next_management_block_address + i, NULL, NULL);
         PIFS_ASSERT(ret == PIFS_SUCCESS);
     }
     /* #2 */
@@ -649,6 +718,33 @@ pifs_status_t pifs_merge(void)
     {
         /* Activate new file system header */
         pifs.header = new_header;
+#if PIFS_ENABLE_BLOCK_TYPE_TABLE
+        pifs_block_type_table_init(&pifs.header);
+#endif
+#if PIFS_ENABLE_ALLOC_CURSOR
+        pifs_alloc_cursor_reset();
+#endif
+#if PIFS_ENABLE_FSBM_IN_RAM
+        /* Load new free space bitmap to RAM */
+        ret = pifs_fsbm_ram_load();
+        PIFS_ASSERT(ret == PIFS_SUCCESS);
+#endif
+#if PIFS_ENABLE_MOUNT_HINT
+        /* Free space bitmap has just been loaded */
+        pifs.is_fsbm_deferred = FALSE;
+#endif
+#if PIFS_ENABLE_PAGE_CNTR
+        /* Block types are not final until next management block is found, */
+        /* page counters are loaded at #10 */
+        pifs.is_page_cntr_valid = FALSE;
+#endif
+#if PIFS_ENTRY_INDEX_LIST_NUM
+        /* New entry lists are built in erased blocks */
+        pifs_entry_index_reset();
+#endif
+    }
+    if (ret == PIFS_SUCCESS)
+    {
         /* Write new management area's header and mark header, entry list, */
         /* free space bitmap, delta pages, wear level list as used space. */
         ret = pifs_header_write(new_header_ba, new_header_pa, &pifs.header, TRUE);
@@ -682,10 +778,18 @@ pifs_status_t pifs_merge(void)
         {
             pifs.current_entry_list_address[i] = new_header.root_entry_list_address;
         }
+#endif
+#if PIFS_ENABLE_FSBM_BATCH
+        /* Pages of copied maps are marked, free space bitmap is written */
+        /* once before new header is written */
+        pifs_fsbm_batch_begin();
 #endif
         ret = pifs_copy_entry_list(&old_header, &new_header,
                                    &old_header.root_entry_list_address,
                                    &new_header.root_entry_list_address);
+#if PIFS_ENABLE_FSBM_BATCH
+        ret = pifs_fsbm_batch_end(ret, FALSE);
+#endif
         PIFS_ASSERT(ret == PIFS_SUCCESS);
     }
     /* #8 */
@@ -721,6 +825,10 @@ pifs_status_t pifs_merge(void)
         /* and calculate checksum */
         ret = pifs_header_init(new_header_ba, new_header_pa, next_mgmt_ba, &pifs.header);
         PIFS_ASSERT(ret == PIFS_SUCCESS);
+#if PIFS_ENABLE_PAGE_CNTR
+        /* Count pages of new free space bitmap */
+        pifs_page_cntr_load();
+#endif
     }
     /* #10 */
     if (ret == PIFS_SUCCESS)
@@ -731,17 +839,32 @@ pifs_status_t pifs_merge(void)
         /* At this point new header is valid */
         PIFS_ASSERT(ret == PIFS_SUCCESS);
     }
+#if PIFS_ENABLE_MOUNT_HINT
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Deliberately avoiding return code, file system can be */
+        /* used without mount hint */
+        (void)pifs_mount_hint_write(FALSE);
+    }
+#endif
     /* #11 */
     if (ret == PIFS_SUCCESS)
     {
         PIFS_ASSERT(old_header.management_block_address != new_header.management_block_address);
         /* Erase old management area */
-        for (i = 0; i < PIFS_MANAGEMENT_BLOCK_NUM && ret == PIFS_SUCCESS; i++)
-        {
-            PIFS_NOTICE_MSG("Erasing old management block %i\r\n", old_header.management_block_address + i);
-            ret = pifs_erase(old_header.management_block_address + i, &old_header, &new_header);
-            PIFS_ASSERT(ret == PIFS_SUCCESS);
-        }
+        PIFS_NOTICE_MSG("Erasing old management blocks %i\r\n", old_header.management_block_address);
+        ret = pifs_erase_blocks(old_header.management_block_address, PIFS_MANAGEMENT_BLOCK_NUM,
+                                &old_header, &new_header);
+        PIFS_ASSERT(ret == PIFS_SUCCESS);
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+        /* Blocks erased in advance are either used or free in the new */
+        /* free space bitmap */
+        pifs_merge_pre_erase_reset();
+#endif
+#if PIFS_ENTRY_INDEX_LIST_NUM
+        /* Drop indices of old entry lists */
+        pifs_entry_index_reset();
+#endif
     }
     /* #12 */
     if (ret == PIFS_SUCCESS)
@@ -791,6 +914,9 @@ pifs_status_t pifs_merge(void)
             }
         }
     }
+#if PIFS_ENABLE_FSBM_BATCH
+    pifs.fsbm_batch_cntr = fsbm_batch_cntr;
+#endif
     pifs.is_merging = FALSE;
     PIFS_ASSERT(ret == PIFS_SUCCESS);
     PIFS_INFO_MSG("stop\r\n");
@@ -798,6 +924,140 @@ pifs_status_t pifs_merge(void)
     return ret;
 }
 
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+/**
+ * @brief pifs_merge_pre_erase_reset Forget blocks erased in advance.
+ * It shall be called when file system's header is changed.
+ */
+void pifs_merge_pre_erase_reset(void)
+{
+    memset(pifs.merge_erased_block_bitmap, 0, sizeof(pifs.merge_erased_block_bitmap));
+    pifs.merge_pre_erase_block_address = PIFS_FLASH_BLOCK_FIRST_FS;
+    pifs.is_merge_prepared = FALSE;
+}
+
+/**
+ * @brief pifs_internal_merge_pre_erase Erase one block in advance, which would be
+ * erased by the next merge: next management block or data block which
+ * contains only to be released pages. The block remains to be released
+ * until merge, merge will not erase it again.
+ * Note: the caller shall provide mutex protection!
+ *
+ * @param[out] a_is_merge_prepared TRUE: no more block to erase.
+ * @return PIFS_SUCCESS if block was erased or nothing to do.
+ */
+pifs_status_t pifs_internal_merge_pre_erase(bool_t * a_is_merge_prepared)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_address_t ba;
+    pifs_block_address_t to_be_released_ba;
+    pifs_page_address_t  pa;
+    pifs_page_count_t    page_count;
+    pifs_find_t          find;
+    pifs_size_t          i;
+    bool_t               is_erased = FALSE;
+
+    if (pifs.is_header_found && !pifs.is_merging && !pifs.is_merge_prepared)
+    {
+        /* Next management blocks are erased at the beginning of merge */
+        for (i = 0; i < PIFS_MANAGEMENT_BLOCK_NUM && !is_erased && ret == PIFS_SUCCESS; i++)
+        {
+            ba = pifs.header.next_management_block_address + i;
+            if (!pifs_is_block_erased_for_merge(ba))
+            {
+                PIFS_NOTICE_MSG("Erasing next management block %i\r\n", ba);
+                ret = pifs_erase(ba, NULL, NULL);
+                is_erased = TRUE;
+            }
+        }
+        /* Data blocks are erased by pifs_copy_fsbm() if all pages are to be released */
+        for (i = 0; i < PIFS_FLASH_BLOCK_NUM_FS && !is_erased && ret == PIFS_SUCCESS; i++)
+        {
+            ba = pifs.merge_pre_erase_block_address;
+            pifs.merge_pre_erase_block_address++;
+            if (pifs.merge_pre_erase_block_address >= PIFS_FLASH_BLOCK_NUM_ALL)
+            {
+                pifs.merge_pre_erase_block_address = PIFS_FLASH_BLOCK_FIRST_FS;
+            }
+            if (!pifs_is_block_erased_for_merge(ba)
+                    && pifs_is_block_type(ba, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+            {
+                /* Whole block shall be free or to be released */
+                ret = pifs_find_to_be_released_block(1, PIFS_BLOCK_TYPE_DATA, ba, ba,
+                                                     &pifs.header, &to_be_released_ba);
+                if (ret == PIFS_SUCCESS)
+                {
+                    /* Block without to be released page is not worth to erase */
+                    find.page_count_minimum = 1;
+                    find.page_count_desired = 1;
+                    find.block_type = PIFS_BLOCK_TYPE_DATA;
+                    find.is_free = FALSE;
+                    find.is_to_be_released = TRUE;
+                    find.is_same_block = TRUE;
+                    find.start_block_address = ba;
+                    find.start_page_address = 0;
+                    find.end_block_address = ba;
+                    find.header = &pifs.header;
+                    ret = pifs_find_page_adv(&find, &to_be_released_ba, &pa, &page_count);
+                }
+                if (ret == PIFS_SUCCESS)
+                {
+                    PIFS_NOTICE_MSG("Erasing to be released block %i\r\n", ba);
+                    /* Wear level will be incremented by merge */
+                    ret = pifs_erase(ba, NULL, NULL);
+                    is_erased = TRUE;
+                }
+                else if (ret == PIFS_ERROR_NO_MORE_SPACE)
+                {
+                    /* It is not an error */
+                    ret = PIFS_SUCCESS;
+                }
+            }
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            if (is_erased)
+            {
+                pifs.merge_erased_block_bitmap[PIFS_MERGE_ERASED_WORD_IDX(ba)] |= PIFS_MERGE_ERASED_BIT(ba);
+            }
+            else
+            {
+                pifs.is_merge_prepared = TRUE;
+            }
+        }
+    }
+    if (a_is_merge_prepared)
+    {
+        *a_is_merge_prepared = pifs.is_merge_prepared;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_merge_pre_erase Erase one block in advance, which would be
+ * erased by the next merge. Calling it regularly when file system is idle
+ * shortens merge, therefore worst-case latency of writing files.
+ * Only erasing is done in advance: copying free space bitmap, wear level
+ * list and entries is still done by pifs_merge() at once.
+ *
+ * @param[out] a_is_merge_prepared TRUE: no more block to erase, can be NULL.
+ * @return PIFS_SUCCESS if block was erased or nothing to do.
+ */
+pifs_status_t pifs_merge_pre_erase(bool_t * a_is_merge_prepared)
+{
+    pifs_status_t ret;
+
+    PIFS_GET_MUTEX();
+
+    ret = pifs_internal_merge_pre_erase(a_is_merge_prepared);
+
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+#endif
+
 /**
  * @brief pifs_merge_check Check if data merge is needed and perform it.
  *
@@ -817,7 +1077,13 @@ pifs_status_t pifs_merge_check(pifs_file_t * a_file, pifs_size_t a_data_page_cou
     pifs_block_address_t to_be_released_ba;
     pifs_size_t   free_entries = 0;
     pifs_size_t   to_be_released_entries = 0;
+#if PIFS_MERGE_PRE_ERASE_AUTO_NUM
+    pifs_size_t   i;
+    bool_t        is_merge_prepared = FALSE;
+#endif
 
+    /* a_file is only used for debugging */
+    (void)a_file;
     PIFS_DEBUG_MSG("name: %s, data page min: %i\r\n",
                    a_file ? a_file->entry.name : "NULL", a_data_page_count_minimum);
     /* Get number of free management and data pages */
@@ -858,7 +1124,7 @@ pifs_status_t pifs_merge_check(pifs_file_t * a_file, pifs_size_t a_data_page_cou
                     /* Check if at least one data block can be erased! */
                     /* Otherwise merging will be unmeaning. */
                     ret = pifs_find_to_be_released_block(1, PIFS_BLOCK_TYPE_DATA,
-                                                         PIFS_FLASH_BLOCK_RESERVED_NUM,
+                                                         PIFS_FLASH_BLOCK_FIRST_FS,
                                                          PIFS_FLASH_BLOCK_NUM_ALL - 1,
                                                          &pifs.header,
                                                          &to_be_released_ba);
@@ -909,23 +1175,21 @@ pifs_status_t pifs_merge_check(pifs_file_t * a_file, pifs_size_t a_data_page_cou
         if (ret == PIFS_SUCCESS && merge)
         {
             /* Some pages could be erased, do data merge */
+            /* Entry list address of every opened file (a_file as well) */
+            /* is updated by pifs_copy_entry_list() */
             ret = pifs_merge();
-            if (a_file)
-            {
-                /* Update entry list address, as it may changed during merge! */
-#if PIFS_ENABLE_DIRECTORIES
-                /* TODO all file's entry list address shall be updated! */
-                a_file->entry_list_address = *pifs_get_task_current_entry_list_address();
-#else
-                a_file->entry_list_address = pifs.header.root_entry_list_address;
-#endif
-            }
         }
         else
         {
             PIFS_NOTICE_MSG("Merge is not needed!\r\n");
         }
     }
+#if PIFS_MERGE_PRE_ERASE_AUTO_NUM
+    for (i = 0; i < PIFS_MERGE_PRE_ERASE_AUTO_NUM && ret == PIFS_SUCCESS && !merge && !is_merge_prepared; i++)
+    {
+        ret = pifs_internal_merge_pre_erase(&is_merge_prepared);
+    }
+#endif
 
     return ret;
 }
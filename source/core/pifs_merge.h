@@ -36,6 +36,10 @@ extern "C" {
 
 pifs_status_t pifs_merge(void);
 pifs_status_t pifs_merge_check(pifs_file_t * a_file, pifs_size_t a_data_page_count_minimum);
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+void pifs_merge_pre_erase_reset(void);
+pifs_status_t pifs_internal_merge_pre_erase(bool_t * a_is_merge_prepared);
+#endif
 
 #ifdef __cplusplus
 }
@@ -242,7 +242,7 @@ pifs_status_t pifs_copy_wear_level_list(pifs_header_t * a_old_header, pifs_heade
     pifs_block_address_t      ba;
     pifs_wear_level_entry_t   wear_level_entry;
 
-    for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM; ba < PIFS_FLASH_BLOCK_NUM_FS && ret == PIFS_SUCCESS; ba++)
+    for (ba = PIFS_FLASH_BLOCK_FIRST_FS; ba < PIFS_FLASH_BLOCK_NUM_FS && ret == PIFS_SUCCESS; ba++)
     {
         ret = pifs_get_wear_level(ba, a_old_header, &wear_level_entry);
         if (ret == PIFS_SUCCESS)
@@ -283,10 +283,10 @@ pifs_status_t pifs_get_block_wear_stats(pifs_block_type_t a_block_type,
     pifs_wear_level_entry_t   wear_level_entry;
     pifs_wear_level_cntr_t    wear_level_cntr_min = PIFS_WEAR_LEVEL_CNTR_MAX;
     pifs_wear_level_cntr_t    wear_level_cntr_max = 0;
-    pifs_block_address_t      ba_min = PIFS_FLASH_BLOCK_RESERVED_NUM;
-    pifs_block_address_t      ba_max = PIFS_FLASH_BLOCK_RESERVED_NUM;
+    pifs_block_address_t      ba_min = PIFS_FLASH_BLOCK_FIRST_FS;
+    pifs_block_address_t      ba_max = PIFS_FLASH_BLOCK_FIRST_FS;
 
-    for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM; ba < PIFS_FLASH_BLOCK_NUM_FS && ret == PIFS_SUCCESS; ba++)
+    for (ba = PIFS_FLASH_BLOCK_FIRST_FS; ba < PIFS_FLASH_BLOCK_NUM_FS && ret == PIFS_SUCCESS; ba++)
     {
         if (pifs_is_block_type(ba, a_block_type, a_header))
         {
@@ -364,7 +364,7 @@ pifs_status_t pifs_generate_least_weared_blocks(pifs_header_t * a_header)
     for (i = 1; i < PIFS_LEAST_WEARED_BLOCK_NUM && ret == PIFS_SUCCESS; i++)
     {
         last_wear_level_cntr = PIFS_WEAR_LEVEL_CNTR_MAX;
-        for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM; ba < PIFS_FLASH_BLOCK_NUM_FS
+        for (ba = PIFS_FLASH_BLOCK_FIRST_FS; ba < PIFS_FLASH_BLOCK_NUM_FS
              && ret == PIFS_SUCCESS; ba++)
         {
             if (pifs_is_block_type(ba, PIFS_BLOCK_TYPE_DATA, a_header))
@@ -449,7 +449,7 @@ pifs_status_t pifs_generate_most_weared_blocks(pifs_header_t * a_header)
     for (i = 1; i < PIFS_MOST_WEARED_BLOCK_NUM && ret == PIFS_SUCCESS; i++)
     {
         last_wear_level_cntr = 0;
-        for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM; ba < PIFS_FLASH_BLOCK_NUM_FS
+        for (ba = PIFS_FLASH_BLOCK_FIRST_FS; ba < PIFS_FLASH_BLOCK_NUM_FS
              && ret == PIFS_SUCCESS; ba++)
         {
             if (pifs_is_block_type(ba, PIFS_BLOCK_TYPE_DATA, a_header))
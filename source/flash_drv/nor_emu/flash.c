@@ -23,6 +23,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#if FLASH_EMU_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "api_pifs.h"
 #include "flash.h"
@@ -45,6 +51,7 @@
 #define FLASH_ERROR_MSG(...)
 #endif
 
+#define FLASH_EMU_BLOCK_FIRST   PIFS_FLASH_BLOCK_RESERVED_NUM   /**< First block which can be accessed */
 #define FLASH_EMU_FILENAME      "flash.bin" /**< Name of memory file */
 #define FLASH_STAT_FILENAME     "flash.stt" /**< Name of statistics file */
 #define FLASH_STAT_READ_CNTR    0
@@ -52,21 +59,103 @@
 #define FLASH_STAT_ERASE_CNTR   2
 #define FLASH_STAT_CNTR_NUM     3   /**< Number of counters */
 
+#if FLASH_EMU_MMAP
+static int flash_fd = -1;
+static uint8_t * flash_mem = NULL; /**< Memory file mapped to memory */
+#else
 static FILE * flash_file = NULL;
-static FILE * stat_file = NULL;
 static uint8_t flash_page_buf[PIFS_FLASH_PAGE_SIZE_BYTE] = { 0 };
+#endif
+static FILE * stat_file = NULL;
 static size_t flash_stat[FLASH_STAT_CNTR_NUM][PIFS_FLASH_BLOCK_NUM_ALL][PIFS_FLASH_PAGE_PER_BLOCK] = { { { 0  } } };
 static size_t flash_stat_temp[PIFS_FLASH_BLOCK_NUM_ALL * PIFS_FLASH_PAGE_PER_BLOCK] = { 0 };
 
-pifs_status_t pifs_flash_init(void)
+#if FLASH_EMU_MMAP
+/**
+ * @brief flash_open Open memory file and map it to memory.
+ *
+ * @param[out] a_is_created TRUE: memory file did not exist, it was created.
+ * @return PIFS_SUCCESS if memory file was mapped.
+ */
+static pifs_status_t flash_open(bool_t * a_is_created)
+{
+    pifs_status_t ret = PIFS_ERROR_FLASH_INIT;
+    struct stat   st;
+
+    PIFS_ASSERT(flash_fd == -1);
+    *a_is_created = FALSE;
+    flash_fd = open(FLASH_EMU_FILENAME, O_RDWR);
+    if (flash_fd < 0)
+    {
+        /* Memory file has not created yet */
+        flash_fd = open(FLASH_EMU_FILENAME, O_RDWR | O_CREAT, 0644);
+        *a_is_created = TRUE;
+    }
+    if (flash_fd >= 0 && fstat(flash_fd, &st) == 0)
+    {
+        /* Bytes of not yet erased area are zero, like the gaps of a file
+         * which is written by stdio. */
+        if (st.st_size >= (off_t) PIFS_FLASH_SIZE_BYTE_ALL
+                || ftruncate(flash_fd, PIFS_FLASH_SIZE_BYTE_ALL) == 0)
+        {
+            flash_mem = mmap(NULL, PIFS_FLASH_SIZE_BYTE_ALL, PROT_READ | PROT_WRITE,
+                             MAP_SHARED, flash_fd, 0);
+            if (flash_mem != MAP_FAILED)
+            {
+                ret = PIFS_SUCCESS;
+            }
+            else
+            {
+                flash_mem = NULL;
+            }
+        }
+    }
+
+    return ret;
+}
+#else
+/**
+ * @brief flash_open Open memory file.
+ *
+ * @param[out] a_is_created TRUE: memory file did not exist, it was created.
+ * @return PIFS_SUCCESS if memory file was opened.
+ */
+static pifs_status_t flash_open(bool_t * a_is_created)
 {
     pifs_status_t ret = PIFS_ERROR_FLASH_INIT;
-    pifs_block_address_t ba;
 
     PIFS_ASSERT(flash_file == NULL);
+    *a_is_created = FALSE;
     flash_file = fopen(FLASH_EMU_FILENAME, "rb+");
+    if (!flash_file)
+    {
+        /* Memory file has not created yet */
+        flash_file = fopen(FLASH_EMU_FILENAME, "wb+");
+        *a_is_created = TRUE;
+    }
     if (flash_file)
     {
+        ret = PIFS_SUCCESS;
+    }
+
+    return ret;
+}
+#endif
+
+pifs_status_t pifs_flash_init(void)
+{
+    pifs_status_t ret = PIFS_ERROR_FLASH_INIT;
+    pifs_block_address_t ba;
+    bool_t is_created = FALSE;
+
+    ret = flash_open(&is_created);
+    if (ret != PIFS_SUCCESS)
+    {
+        FLASH_ERROR_MSG("Cannot open flash file!\r\n");
+    }
+    else if (!is_created)
+    {
+        ret = PIFS_ERROR_FLASH_INIT;
         stat_file = fopen(FLASH_STAT_FILENAME, "rb+");
         if (stat_file)
         {
@@ -83,31 +172,21 @@ pifs_status_t pifs_flash_init(void)
     }
     else
     {
-        /* Memory file has not created yet */
-        flash_file = fopen(FLASH_EMU_FILENAME, "wb+");
-        if (flash_file)
+        /* Erase whole memory */
+        for (ba = FLASH_EMU_BLOCK_FIRST; ba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS; ba++)
         {
-            ret = PIFS_SUCCESS;
-            /* Erase whole memory */
-            for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM; ba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS; ba++)
-            {
-                ret = pifs_flash_erase(ba);
-            }
+            ret = pifs_flash_erase(ba);
+        }
 
-            if (ret == PIFS_SUCCESS)
+        if (ret == PIFS_SUCCESS)
+        {
+            stat_file = fopen(FLASH_STAT_FILENAME, "wb+");
+            if (!stat_file)
             {
-                stat_file = fopen(FLASH_STAT_FILENAME, "wb+");
-                if (!stat_file)
-                {
-                    FLASH_ERROR_MSG("Cannot create statistics file!\r\n");
-                    ret = PIFS_ERROR_FLASH_INIT;
-                }
+                FLASH_ERROR_MSG("Cannot create statistics file!\r\n");
+                ret = PIFS_ERROR_FLASH_INIT;
             }
         }
-        else
-        {
-            FLASH_ERROR_MSG("Cannot create flash file!\r\n");
-        }
     }
 
     return ret;
@@ -118,6 +197,26 @@ pifs_status_t pifs_flash_delete(void)
     pifs_status_t ret = PIFS_ERROR_GENERAL;
 
     //pifs_flash_print_stat();
+#if FLASH_EMU_MMAP
+    if (flash_mem)
+    {
+        /* Write back memory to the file */
+        if (!msync(flash_mem, PIFS_FLASH_SIZE_BYTE_ALL, MS_SYNC)
+                && !munmap(flash_mem, PIFS_FLASH_SIZE_BYTE_ALL))
+        {
+            ret = PIFS_SUCCESS;
+        }
+        flash_mem = NULL;
+    }
+    if (flash_fd >= 0)
+    {
+        if (close(flash_fd))
+        {
+            ret = PIFS_ERROR_GENERAL;
+        }
+        flash_fd = -1;
+    }
+#else
     if (flash_file)
     {
         if (!fclose(flash_file))
@@ -126,6 +225,7 @@ pifs_status_t pifs_flash_delete(void)
         }
         flash_file = NULL;
     }
+#endif
     if (stat_file)
     {
         ret = PIFS_ERROR_GENERAL;
@@ -151,19 +251,29 @@ pifs_status_t pifs_flash_read(pifs_block_address_t a_block_address, pifs_page_ad
             + a_page_offset;
     size_t read_count = 0;
 
+#if FLASH_EMU_MMAP
+    PIFS_ASSERT(flash_mem);
+#else
     PIFS_ASSERT(flash_file);
+#endif
     if ((offset + a_buf_size) <= PIFS_FLASH_SIZE_BYTE_ALL
-        #if PIFS_FLASH_BLOCK_RESERVED_NUM
-            && offset >= (PIFS_FLASH_BLOCK_RESERVED_NUM * PIFS_FLASH_BLOCK_SIZE_BYTE)
+        #if FLASH_EMU_BLOCK_FIRST
+            && offset >= (FLASH_EMU_BLOCK_FIRST * PIFS_FLASH_BLOCK_SIZE_BYTE)
         #endif
             )
     {
+#if FLASH_EMU_MMAP
+        (void) read_count;
+        memcpy(a_buf, &flash_mem[offset], a_buf_size);
+        ret = PIFS_SUCCESS;
+#else
         PIFS_ASSERT(fseek(flash_file, offset, SEEK_SET) == 0);
         read_count = fread(a_buf, 1, a_buf_size, flash_file);
         if (read_count == a_buf_size)
         {
             ret = PIFS_SUCCESS;
         }
+#endif
         flash_stat[FLASH_STAT_READ_CNTR][a_block_address][a_page_address]++;
     }
     else
@@ -183,19 +293,32 @@ pifs_status_t pifs_flash_write(pifs_block_address_t a_block_address, pifs_page_a
             + a_page_offset;
     size_t write_count = 0;
     size_t read_count = 0;
-    pifs_page_offset_t i;
+    size_t i;
     uint8_t * buf8 = (uint8_t*) a_buf;
+#if FLASH_EMU_MMAP
+    uint8_t * flash_page_buf;
+#endif
     
+#if FLASH_EMU_MMAP
+    PIFS_ASSERT(flash_mem);
+#else
     PIFS_ASSERT(flash_file);
+#endif
     if ((offset + a_buf_size) <= PIFS_FLASH_SIZE_BYTE_ALL
-        #if PIFS_FLASH_BLOCK_RESERVED_NUM
-            && offset >= (PIFS_FLASH_BLOCK_RESERVED_NUM * PIFS_FLASH_BLOCK_SIZE_BYTE)
+        #if FLASH_EMU_BLOCK_FIRST
+            && offset >= (FLASH_EMU_BLOCK_FIRST * PIFS_FLASH_BLOCK_SIZE_BYTE)
         #endif
             )
     {
+#if FLASH_EMU_MMAP
+        /* Check written data in place */
+        flash_page_buf = &flash_mem[offset];
+        read_count = a_buf_size;
+#else
         PIFS_ASSERT(fseek(flash_file, offset, SEEK_SET) == 0);
         /* Check if write is possible */
         read_count = fread(flash_page_buf, 1, a_buf_size, flash_file);
+#endif
         if (read_count == a_buf_size)
         {
             ret = PIFS_SUCCESS;
@@ -221,16 +344,25 @@ pifs_status_t pifs_flash_write(pifs_block_address_t a_block_address, pifs_page_a
                     ret = PIFS_ERROR_FLASH_WRITE;
                 }
             }
-            flash_stat[FLASH_STAT_WRITE_CNTR][a_block_address][a_page_address]++;
+            /* Several pages can be written in memory mapped mode */
+            for (i = 0; i < (a_page_offset + a_buf_size + PIFS_FLASH_PAGE_SIZE_BYTE - 1) / PIFS_FLASH_PAGE_SIZE_BYTE; i++)
+            {
+                flash_stat[FLASH_STAT_WRITE_CNTR][a_block_address][a_page_address + i]++;
+            }
         }
         if (ret == PIFS_SUCCESS)
         {
+#if FLASH_EMU_MMAP
+            (void) write_count;
+            memcpy(flash_page_buf, a_buf, a_buf_size);
+#else
             PIFS_ASSERT(fseek(flash_file, offset, SEEK_SET) == 0);
             write_count = fwrite(a_buf, 1, a_buf_size, flash_file);
             if (write_count != a_buf_size)
             {
                 ret = PIFS_ERROR_FLASH_WRITE;
             }
+#endif
         }
     }
     else
@@ -249,13 +381,26 @@ pifs_status_t pifs_flash_erase(pifs_block_address_t a_block_address)
     size_t write_count = 0;
     pifs_page_address_t i;
     
+#if FLASH_EMU_MMAP
+    PIFS_ASSERT(flash_mem);
+#else
     PIFS_ASSERT(flash_file);
+#endif
     if ((offset + PIFS_FLASH_BLOCK_SIZE_BYTE) <= PIFS_FLASH_SIZE_BYTE_ALL
-        #if PIFS_FLASH_BLOCK_RESERVED_NUM
-            && offset >= (PIFS_FLASH_BLOCK_RESERVED_NUM * PIFS_FLASH_BLOCK_SIZE_BYTE)
+        #if FLASH_EMU_BLOCK_FIRST
+            && offset >= (FLASH_EMU_BLOCK_FIRST * PIFS_FLASH_BLOCK_SIZE_BYTE)
         #endif
             )
     {
+#if FLASH_EMU_MMAP
+        (void) write_count;
+        memset(&flash_mem[offset], PIFS_FLASH_ERASED_BYTE_VALUE, PIFS_FLASH_BLOCK_SIZE_BYTE);
+        ret = PIFS_SUCCESS;
+        for (i = 0; i < PIFS_FLASH_PAGE_PER_BLOCK; i++)
+        {
+            flash_stat[FLASH_STAT_ERASE_CNTR][a_block_address][i]++;
+        }
+#else
         PIFS_ASSERT(fseek(flash_file, offset, SEEK_SET) == 0);
         ret = PIFS_SUCCESS;
         memset(flash_page_buf, 0xFFu, sizeof(flash_page_buf));
@@ -269,6 +414,7 @@ pifs_status_t pifs_flash_erase(pifs_block_address_t a_block_address)
             }
             flash_stat[FLASH_STAT_ERASE_CNTR][a_block_address][i]++;
         }
+#endif
     }
     else
     {
@@ -279,6 +425,92 @@ pifs_status_t pifs_flash_erase(pifs_block_address_t a_block_address)
     return ret;
 }
 
+#if PIFS_FLASH_CAPABILITIES & PIFS_FLASH_CAP_READ_SG
+pifs_status_t pifs_flash_read_sg(const pifs_flash_sg_t * a_sg, size_t a_sg_num)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    size_t i;
+
+    for (i = 0; i < a_sg_num && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_flash_read(a_sg[i].block_address, a_sg[i].page_address,
+                              a_sg[i].page_offset, a_sg[i].buf, a_sg[i].buf_size);
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_FLASH_CAPABILITIES & PIFS_FLASH_CAP_WRITE_PAGES
+pifs_status_t pifs_flash_write_pages(pifs_block_address_t a_block_address, pifs_page_address_t a_page_address, const void * const a_buf, size_t a_page_count)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+#if !FLASH_EMU_MMAP
+    size_t i;
+#endif
+
+    PIFS_ASSERT(a_page_address + a_page_count <= PIFS_FLASH_PAGE_PER_BLOCK);
+#if FLASH_EMU_MMAP
+    /* Pages are checked and programmed in place by one call */
+    ret = pifs_flash_write(a_block_address, a_page_address, 0, a_buf, a_page_count * PIFS_FLASH_PAGE_SIZE_BYTE);
+#else
+    for (i = 0; i < a_page_count && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_flash_write(a_block_address, a_page_address + i, 0,
+                               (const uint8_t*) a_buf + i * PIFS_FLASH_PAGE_SIZE_BYTE,
+                               PIFS_FLASH_PAGE_SIZE_BYTE);
+    }
+#endif
+
+    return ret;
+}
+#endif
+
+#if PIFS_FLASH_CAPABILITIES & PIFS_FLASH_CAP_ERASE_BLOCKS
+pifs_status_t pifs_flash_erase_blocks(pifs_block_address_t a_block_address, size_t a_block_count)
+{
+    pifs_status_t ret = PIFS_ERROR_FLASH_ERASE;
+#if FLASH_EMU_MMAP
+    long unsigned int offset = a_block_address * PIFS_FLASH_BLOCK_SIZE_BYTE;
+    pifs_page_address_t pa;
+#endif
+    size_t i;
+
+#if FLASH_EMU_MMAP
+    PIFS_ASSERT(flash_mem);
+    if ((offset + a_block_count * PIFS_FLASH_BLOCK_SIZE_BYTE) <= PIFS_FLASH_SIZE_BYTE_ALL
+        #if FLASH_EMU_BLOCK_FIRST
+            && offset >= (FLASH_EMU_BLOCK_FIRST * PIFS_FLASH_BLOCK_SIZE_BYTE)
+        #endif
+            )
+    {
+        memset(&flash_mem[offset], PIFS_FLASH_ERASED_BYTE_VALUE, a_block_count * PIFS_FLASH_BLOCK_SIZE_BYTE);
+        ret = PIFS_SUCCESS;
+        for (i = 0; i < a_block_count; i++)
+        {
+            for (pa = 0; pa < PIFS_FLASH_PAGE_PER_BLOCK; pa++)
+            {
+                flash_stat[FLASH_STAT_ERASE_CNTR][a_block_address + i][pa]++;
+            }
+        }
+    }
+    else
+    {
+        FLASH_ERROR_MSG("Trying to erase invalid flash address! BA%i, %lu blocks\r\n",
+                        a_block_address, (long unsigned int) a_block_count);
+    }
+#else
+    ret = PIFS_SUCCESS;
+    for (i = 0; i < a_block_count && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_flash_erase(a_block_address + i);
+    }
+#endif
+
+    return ret;
+}
+#endif
+
 void pifs_flash_sort(size_t * a_array, size_t a_array_size)
 {
     size_t i;
@@ -32,6 +32,9 @@
 #include "flash_test.h"
 #include "api_pifs.h"
 #include "pifs_test.h"
+#if ENABLE_BENCHMARK
+#include "pifs_bench.h"
+#endif
 #include "pifs_helper.h"
 #include "pifs_delta.h"
 #include "pifs_fsbm.h"
@@ -161,6 +164,9 @@ void cmdTestPifs (char* command, char* params)
     (void) params;
 
     pifs_status = pifs_test();
+#if PIFS_ENABLE_STATISTICS
+    pifs_print_cache_info();
+#endif
 }
 
 void cmdTestPifsBasic (char* command, char* params)
@@ -355,7 +361,7 @@ void cmdWearLevel (char* command, char* params)
 
     printf("Block | Erase count\r\n");
     printf("------+------------\r\n");
-    for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM;
+    for (ba = PIFS_FLASH_BLOCK_FIRST_FS;
          ba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS;
          ba++)
     {
@@ -469,6 +475,70 @@ void cmdStaticWear(char* command, char* params)
     printf("Ret: %i\r\n", ret);
 }
 
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+void cmdMergePreErase(char* command, char* params)
+{
+    pifs_status_t   ret = PIFS_SUCCESS;
+    pifs_size_t     call_num = 1;
+    pifs_size_t     i;
+    bool_t          is_merge_prepared = FALSE;
+    char          * param;
+
+    (void) command;
+
+    if (params)
+    {
+        param = PARSER_getNextParam();
+        call_num = strtoul(param, NULL, 0);
+    }
+    for (i = 0; i < call_num && ret == PIFS_SUCCESS && !is_merge_prepared; i++)
+    {
+        ret = pifs_merge_pre_erase(&is_merge_prepared);
+    }
+    printf("Calls: %i, prepared: %s, ret: %i\r\n", i, pifs_yes_no(is_merge_prepared), ret);
+}
+#endif
+
+#if ENABLE_BENCHMARK
+void cmdBench(char* command, char* params)
+{
+    pifs_status_t       ret;
+    pifs_bench_format_t format = PIFS_BENCH_FORMAT_CSV;
+    FILE              * output = stdout;
+    char              * param;
+
+    (void) command;
+
+    if (params)
+    {
+        param = PARSER_getNextParam();
+        if (strcmp(param, "json") == 0)
+        {
+            format = PIFS_BENCH_FORMAT_JSON;
+        }
+        param = PARSER_getNextParam();
+        if (param)
+        {
+            output = fopen(param, "w");
+            if (!output)
+            {
+                printf("ERROR: Cannot open output file '%s'!\r\n", param);
+            }
+        }
+    }
+    if (output)
+    {
+        ret = pifs_bench(format, output);
+        if (output != stdout)
+        {
+            fclose(output);
+        }
+        printf("Ret: %i\r\n", ret);
+        pifs_status = ret;
+    }
+}
+#endif
+
 #if tskKERNEL_VERSION_MAJOR >= 8
 void cmdTaskList(char * command, char * params)
 {
@@ -500,7 +570,7 @@ void cmdDebug (char* command, char* params)
     pifs_block_address_t ba2;
 
     printf("Find to be released block...\r\n");
-    for (ba = PIFS_FLASH_BLOCK_RESERVED_NUM; ba < PIFS_FLASH_BLOCK_NUM_ALL; ba++)
+    for (ba = PIFS_FLASH_BLOCK_FIRST_FS; ba < PIFS_FLASH_BLOCK_NUM_ALL; ba++)
     {
         ret = pifs_find_to_be_released_block(1, PIFS_BLOCK_TYPE_DATA, ba, ba,
                                              &pifs.header, &ba2);
@@ -1508,7 +1578,7 @@ const char * block_type2str(pifs_block_address_t a_block_address)
     {
         str = "SecMgmt";
     }
-#if PIFS_FLASH_BLOCK_RESERVED_NUM
+#if PIFS_FLASH_BLOCK_FIRST_FS
     else if (pifs_is_block_type(a_block_address, PIFS_BLOCK_TYPE_RESERVED, &pifs.header))
     {
         str = "Reservd";
@@ -1518,6 +1588,16 @@ const char * block_type2str(pifs_block_address_t a_block_address)
     return str;
 }
 
+#if PIFS_ENABLE_STATISTICS
+void cmdCacheInfo (char* command, char* params)
+{
+    (void) command;
+    (void) params;
+
+    pifs_print_cache_info();
+}
+#endif
+
 void cmdBlockInfo (char* command, char* params)
 {
     unsigned long int    addr = PIFS_FLASH_BLOCK_RESERVED_NUM * PIFS_FLASH_BLOCK_SIZE_BYTE;
@@ -1746,13 +1826,22 @@ parserCommand_t parserCommands[] =
     {"free",        "Print info of free space",         cmdFreeSpaceInfo},
     {"f",           "Print info of free space",         cmdFreeSpaceInfo},
     {"bi",          "Print info of block",              cmdBlockInfo},
+#if PIFS_ENABLE_STATISTICS
+    {"ci",          "Print statistics of page cache",   cmdCacheInfo},
+#endif
     {"pi",          "Check if page is free/to be released/erased", cmdPageInfo},
     {"w",           "Print wear level list",            cmdWearLevel},
     {"lw",          "Print least weared blocks' list",  cmdLeastWearedBlocks},
     {"mw",          "Print most weared blocks' list",   cmdMostWearedBlocks},
     {"eb",          "Empty block",                      cmdEmptyBlock},
     {"sw",          "Static wear leveling",             cmdStaticWear},
+#if PIFS_ENABLE_MERGE_PRE_ERASE
+    {"mpe",         "Erase blocks in advance of merge", cmdMergePreErase},
+#endif
     {"fs",          "Print flash's statistics",         cmdFlashStat},
+#if ENABLE_BENCHMARK
+    {"bench",       "Benchmark: bench [csv|json] [file]", cmdBench},
+#endif
     {"erase",       "Erase flash, WARNING: ALL DATA GET LOST!", cmdErase},
     {"tstflash",    "Test flash, WARNING: ALL DATA GET LOST!",  cmdTestFlash},
     {"tstpifs",     "Test Pi file system: all",         cmdTestPifs},
@@ -0,0 +1,1339 @@
+/**
+ * @file        pifs_bench.c
+ * @brief       Benchmark of Pi file system
+ * @author      Copyright (C) Peter Ivanov, 2017
+ *
+ * Created:     2017-06-11 09:10:19
+ * Last modify: 2017-09-05 16:33:55 ivanovp {Time-stamp}
+ * Licence:     GPL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+
+#include "api_pifs.h"
+#include "pifs.h"
+#include "flash.h"
+#include "pifs_merge.h"
+#include "pifs_wear.h"
+#include "pifs_bench.h"
+
+#define PIFS_DEBUG_LEVEL    5
+#include "pifs_debug.h"
+
+#if !PIFS_ENABLE_STATISTICS
+#error PIFS_ENABLE_STATISTICS shall be enabled for benchmark!
+#endif
+
+#define BENCH_OP_NUM_MAX        512u    /**< Maximum number of operations in a benchmark */
+/** Size of sequentially written and read file in logical pages */
+#define BENCH_SEQ_PAGE_NUM      ((PIFS_LOGICAL_PAGE_NUM_FS / 16) < BENCH_OP_NUM_MAX \
+                                 ? (PIFS_LOGICAL_PAGE_NUM_FS / 16) : BENCH_OP_NUM_MAX)
+#define BENCH_BURST_PAGE_NUM    16u     /**< Number of logical pages read by one call in burst read */
+#define BENCH_STREAM_SIZE_BYTE  64u     /**< Size of reads in stream read */
+/** Size of file of stream read in logical pages, multiple of BENCH_BURST_PAGE_NUM */
+#define BENCH_STREAM_PAGE_NUM   ((BENCH_OP_NUM_MAX * BENCH_STREAM_SIZE_BYTE / PIFS_LOGICAL_PAGE_SIZE_BYTE \
+                                  + BENCH_BURST_PAGE_NUM - 1) / BENCH_BURST_PAGE_NUM * BENCH_BURST_PAGE_NUM)
+#define BENCH_RAND_OP_NUM       256u    /**< Number of random reads and writes */
+#define BENCH_RAND_SIZE_BYTE    64u     /**< Size of random reads and writes */
+#define BENCH_DELTA_OP_NUM      64u     /**< Number of rewrites of the same page */
+#define BENCH_DELTA_LOOP_PAGE_NUM   4u  /**< Number of pages rewritten in turn in delta rewrite loop */
+#define BENCH_PATCH_PAGE_NUM    16u     /**< Size of file of small overwrites in logical pages */
+#define BENCH_PATCH_SIZE_BYTE   16u     /**< Size of small overwrites */
+#define BENCH_SMALL_FILE_NUM    32u     /**< Number of small files */
+#define BENCH_SMALL_SIZE_BYTE   100u    /**< Size of a small file */
+#define BENCH_LOOKUP_OP_NUM     256u    /**< Number of file name lookups */
+#define BENCH_MERGE_OP_NUM      2u      /**< Number of merges */
+#define BENCH_WEAR_OP_NUM       4u      /**< Number of static wear leveling calls */
+#define BENCH_MOUNT_OP_NUM      16u     /**< Number of mounts */
+#define BENCH_SEED              1u      /**< Seed of random generator, results are reproducible */
+#define BENCH_SEQ_FILENAME      "bench_seq.bin"
+#define BENCH_STREAM_FILENAME   "bench_stream.bin"
+#define BENCH_DELTA_FILENAME    "bench_delta.bin"
+#define BENCH_APPEND_FILENAME   "bench_append.bin"
+#define BENCH_SMALL_FILENAME    "bench_%03u.bin"
+
+#if PIFS_FILENAME_LEN_MAX < 16
+#error PIFS_FILENAME_LEN_MAX shall be at least 16!
+#endif
+#if BENCH_SMALL_FILE_NUM >= PIFS_ENTRY_NUM_MAX - PIFS_OPEN_FILE_NUM_MAX
+#error BENCH_SMALL_FILE_NUM is too large for PIFS_ENTRY_NUM_MAX!
+#endif
+
+#define PIFS_BENCH_ERROR_MSG(...)    do {    \
+        printf("%s:%i ERROR: ", __FUNCTION__, __LINE__); \
+        printf(__VA_ARGS__);                \
+    } while (0);
+
+/**
+ * Result of a benchmark.
+ */
+typedef struct
+{
+    const char * name;
+    uint32_t     op_num;            /**< Number of logical operations */
+    uint64_t     byte_num;          /**< Number of bytes read or written by user */
+    uint64_t     write_byte_num;    /**< Number of bytes written by user */
+    double       time_s;            /**< Elapsed time of whole benchmark */
+    double       p50_us;            /**< Median latency of an operation */
+    double       p99_us;            /**< 99th percentile latency of an operation */
+    uint32_t     flash_read_cntr;   /**< Flash pages read during benchmark */
+    uint32_t     flash_write_cntr;  /**< Flash pages programmed during benchmark */
+    uint32_t     flash_write_byte_cntr; /**< Bytes programmed during benchmark */
+    uint32_t     flash_erase_cntr;  /**< Flash blocks erased during benchmark */
+    uint32_t     merge_cntr;        /**< Merges of management blocks during benchmark */
+    double       start_us;
+    double       op_start_us;
+} pifs_bench_result_t;
+
+static uint8_t bench_buf[PIFS_LOGICAL_PAGE_SIZE_BYTE] __attribute__((aligned(4)));
+static uint8_t bench_burst_buf[BENCH_BURST_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE] __attribute__((aligned(4)));
+static double  bench_latency_us[BENCH_OP_NUM_MAX];
+
+/**
+ * @brief bench_now_us Get monotonic time.
+ *
+ * @return Time in microseconds.
+ */
+static double bench_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static int bench_compare_double(const void * a_a, const void * a_b)
+{
+    double a = *(const double*) a_a;
+    double b = *(const double*) a_b;
+
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief bench_begin Start a benchmark: store counters and time.
+ *
+ * @param[out] a_result Result to initialize.
+ * @param[in] a_name    Name of benchmark.
+ */
+static void bench_begin(pifs_bench_result_t * a_result, const char * a_name)
+{
+    memset(a_result, 0, sizeof(pifs_bench_result_t));
+    a_result->name = a_name;
+    a_result->flash_read_cntr = pifs.flash_read_cntr;
+    a_result->flash_write_cntr = pifs.flash_write_cntr;
+    a_result->flash_write_byte_cntr = pifs.flash_write_byte_cntr;
+    a_result->flash_erase_cntr = pifs.flash_erase_cntr;
+    a_result->merge_cntr = pifs.merge_cntr;
+    a_result->start_us = bench_now_us();
+}
+
+static void bench_op_begin(pifs_bench_result_t * a_result)
+{
+    a_result->op_start_us = bench_now_us();
+}
+
+static void bench_op_end(pifs_bench_result_t * a_result)
+{
+    if (a_result->op_num < BENCH_OP_NUM_MAX)
+    {
+        bench_latency_us[a_result->op_num] = bench_now_us() - a_result->op_start_us;
+        a_result->op_num++;
+    }
+}
+
+/**
+ * @brief bench_end Finish a benchmark: calculate elapsed time, flash
+ * operations and percentiles of latency.
+ *
+ * @param[in,out] a_result Result to finish.
+ */
+static void bench_end(pifs_bench_result_t * a_result)
+{
+    a_result->time_s = (bench_now_us() - a_result->start_us) / 1000000.0;
+    a_result->flash_read_cntr = pifs.flash_read_cntr - a_result->flash_read_cntr;
+    a_result->flash_write_cntr = pifs.flash_write_cntr - a_result->flash_write_cntr;
+    a_result->flash_write_byte_cntr = pifs.flash_write_byte_cntr - a_result->flash_write_byte_cntr;
+    a_result->flash_erase_cntr = pifs.flash_erase_cntr - a_result->flash_erase_cntr;
+    a_result->merge_cntr = pifs.merge_cntr - a_result->merge_cntr;
+    if (a_result->op_num)
+    {
+        qsort(bench_latency_us, a_result->op_num, sizeof(double), bench_compare_double);
+        a_result->p50_us = bench_latency_us[(a_result->op_num - 1) * 50 / 100];
+        a_result->p99_us = bench_latency_us[(a_result->op_num - 1) * 99 / 100];
+    }
+    printf("Benchmark %s finished, %lu operations\r\n", a_result->name,
+           (unsigned long) a_result->op_num);
+}
+
+/**
+ * @brief bench_print Print result of a benchmark.
+ *
+ * @param[in] a_format  Output format.
+ * @param[in] a_output  Output stream.
+ * @param[in] a_result  Result to print.
+ * @param[in] a_is_first TRUE: first result is printed.
+ */
+static void bench_print(pifs_bench_format_t a_format, FILE * a_output,
+                        const pifs_bench_result_t * a_result, bool_t a_is_first)
+{
+    double op_num = a_result->op_num ? a_result->op_num : 1;
+    double ops = a_result->time_s > 0 ? a_result->op_num / a_result->time_s : 0;
+    double mbps = a_result->time_s > 0 ? a_result->byte_num / a_result->time_s / 1000000.0 : 0;
+    double wa = 0;
+
+    if (a_result->write_byte_num)
+    {
+        wa = (double) a_result->flash_write_byte_cntr / a_result->write_byte_num;
+    }
+    if (a_format == PIFS_BENCH_FORMAT_JSON)
+    {
+        fprintf(a_output, "%s    {\"name\": \"%s\", \"ops\": %lu, \"bytes\": %llu, "
+                "\"time_s\": %.6f, \"ops_per_s\": %.1f, \"mb_per_s\": %.3f, "
+                "\"p50_us\": %.1f, \"p99_us\": %.1f, "
+                "\"flash_reads_per_op\": %.3f, \"flash_programs_per_op\": %.3f, "
+                "\"flash_program_bytes_per_op\": %.1f, "
+                "\"flash_erases_per_op\": %.3f, \"write_amplification\": %.3f, "
+                "\"merges_per_1k_ops\": %.3f}",
+                a_is_first ? "" : ",\n",
+                a_result->name, (unsigned long) a_result->op_num,
+                (unsigned long long) a_result->byte_num,
+                a_result->time_s, ops, mbps, a_result->p50_us, a_result->p99_us,
+                a_result->flash_read_cntr / op_num, a_result->flash_write_cntr / op_num,
+                a_result->flash_write_byte_cntr / op_num,
+                a_result->flash_erase_cntr / op_num, wa, a_result->merge_cntr * 1000.0 / op_num);
+    }
+    else
+    {
+        if (a_is_first)
+        {
+            fprintf(a_output, "name,ops,bytes,time_s,ops_per_s,mb_per_s,p50_us,p99_us,"
+                    "flash_reads_per_op,flash_programs_per_op,flash_program_bytes_per_op,flash_erases_per_op,"
+                    "write_amplification,merges_per_1k_ops\n");
+        }
+        fprintf(a_output, "%s,%lu,%llu,%.6f,%.1f,%.3f,%.1f,%.1f,%.3f,%.3f,%.1f,%.3f,%.3f,%.3f\n",
+                a_result->name, (unsigned long) a_result->op_num,
+                (unsigned long long) a_result->byte_num,
+                a_result->time_s, ops, mbps, a_result->p50_us, a_result->p99_us,
+                a_result->flash_read_cntr / op_num, a_result->flash_write_cntr / op_num,
+                a_result->flash_write_byte_cntr / op_num,
+                a_result->flash_erase_cntr / op_num, wa, a_result->merge_cntr * 1000.0 / op_num);
+    }
+}
+
+/**
+ * @brief bench_seq_write Write a file page by page.
+ */
+static pifs_status_t bench_seq_write(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+
+    bench_begin(a_result, "seq_write");
+    file = pifs_fopen(BENCH_SEQ_FILENAME, "w");
+    if (file)
+    {
+        for (i = 0; i < BENCH_SEQ_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            memset(bench_buf, (uint8_t) i, sizeof(bench_buf));
+            bench_op_begin(a_result);
+            if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += sizeof(bench_buf);
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    a_result->write_byte_num = a_result->byte_num;
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_seq_read Read the file of bench_seq_write() page by page.
+ */
+static pifs_status_t bench_seq_read(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+
+    bench_begin(a_result, "seq_read");
+    file = pifs_fopen(BENCH_SEQ_FILENAME, "r");
+    if (file)
+    {
+        for (i = 0; i < BENCH_SEQ_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            bench_op_begin(a_result);
+            if (pifs_fread(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot read file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += sizeof(bench_buf);
+            if (bench_buf[0] != (uint8_t) i)
+            {
+                PIFS_BENCH_ERROR_MSG("Data mismatch at page %lu!\r\n", (unsigned long) i);
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_seq_read_burst Read the file of bench_seq_write() by
+ * BENCH_BURST_PAGE_NUM pages.
+ */
+static pifs_status_t bench_seq_read_burst(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+    uint32_t      j;
+
+    bench_begin(a_result, "seq_read_burst");
+    file = pifs_fopen(BENCH_SEQ_FILENAME, "r");
+    if (file)
+    {
+        for (i = 0; i < BENCH_SEQ_PAGE_NUM / BENCH_BURST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            bench_op_begin(a_result);
+            if (pifs_fread(bench_burst_buf, 1, sizeof(bench_burst_buf), file) != sizeof(bench_burst_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot read file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += sizeof(bench_burst_buf);
+            for (j = 0; j < BENCH_BURST_PAGE_NUM && ret == PIFS_SUCCESS; j++)
+            {
+                if (bench_burst_buf[j * PIFS_LOGICAL_PAGE_SIZE_BYTE] != (uint8_t) (i * BENCH_BURST_PAGE_NUM + j))
+                {
+                    PIFS_BENCH_ERROR_MSG("Data mismatch at page %lu!\r\n",
+                                         (unsigned long) (i * BENCH_BURST_PAGE_NUM + j));
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_flash_read Read the same amount of data as
+ * bench_seq_read_burst() by the flash driver. It is the upper limit of
+ * read bandwidth.
+ */
+static pifs_status_t bench_flash_read(pifs_bench_result_t * a_result)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_address_t ba = PIFS_FLASH_BLOCK_FIRST_FS;
+    pifs_page_address_t  pa = 0;
+    uint32_t             i;
+
+    bench_begin(a_result, "flash_read");
+    for (i = 0; i < BENCH_SEQ_PAGE_NUM / BENCH_BURST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        if (pa + BENCH_BURST_PAGE_NUM > PIFS_LOGICAL_PAGE_PER_BLOCK)
+        {
+            ba++;
+            pa = 0;
+        }
+        bench_op_begin(a_result);
+        ret = pifs_flash_read(ba, PIFS_LP2FP(pa), 0, bench_burst_buf, sizeof(bench_burst_buf));
+        bench_op_end(a_result);
+        a_result->byte_num += sizeof(bench_burst_buf);
+        pa += BENCH_BURST_PAGE_NUM;
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_seq_write_burst Write a file by BENCH_BURST_PAGE_NUM pages,
+ * so its map entries contain several pages. It is read by bench_stream().
+ */
+static pifs_status_t bench_seq_write_burst(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+    uint32_t      j;
+
+    bench_begin(a_result, "seq_write_burst");
+    file = pifs_fopen(BENCH_STREAM_FILENAME, "w");
+    if (file)
+    {
+        for (i = 0; i < BENCH_STREAM_PAGE_NUM && ret == PIFS_SUCCESS; i += BENCH_BURST_PAGE_NUM)
+        {
+            for (j = 0; j < BENCH_BURST_PAGE_NUM; j++)
+            {
+                memset(&bench_burst_buf[j * PIFS_LOGICAL_PAGE_SIZE_BYTE], (uint8_t) (i + j),
+                       PIFS_LOGICAL_PAGE_SIZE_BYTE);
+            }
+            bench_op_begin(a_result);
+            if (pifs_fwrite(bench_burst_buf, 1, sizeof(bench_burst_buf), file) != sizeof(bench_burst_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += sizeof(bench_burst_buf);
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    a_result->write_byte_num = a_result->byte_num;
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_stream Read the file of bench_seq_write_burst() by small
+ * chunks from beginning to end, like replaying a log.
+ *
+ * @param[in] a_is_read_ahead TRUE: default access pattern,
+ *                            FALSE: read-ahead is disabled by pifs_fadvise().
+ */
+static pifs_status_t bench_stream(pifs_bench_result_t * a_result, bool_t a_is_read_ahead)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+    long int      pos;
+
+    bench_begin(a_result, a_is_read_ahead ? "stream_read" : "stream_read_no_ra");
+    file = pifs_fopen(BENCH_STREAM_FILENAME, "r");
+    if (file)
+    {
+#if PIFS_READ_AHEAD_PAGE_NUM
+        if (!a_is_read_ahead && pifs_fadvise(file, PIFS_FADV_RANDOM))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot set access pattern!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+#endif
+        for (i = 0; i < BENCH_OP_NUM_MAX && ret == PIFS_SUCCESS; i++)
+        {
+            pos = i * BENCH_STREAM_SIZE_BYTE;
+            bench_op_begin(a_result);
+            if (pifs_fread(bench_buf, 1, BENCH_STREAM_SIZE_BYTE, file) != BENCH_STREAM_SIZE_BYTE)
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot read file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += BENCH_STREAM_SIZE_BYTE;
+            if (ret == PIFS_SUCCESS && bench_buf[0] != (uint8_t) (pos / PIFS_LOGICAL_PAGE_SIZE_BYTE))
+            {
+                PIFS_BENCH_ERROR_MSG("Data mismatch at position %li!\r\n", pos);
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+static pifs_status_t bench_stream_read(pifs_bench_result_t * a_result)
+{
+    return bench_stream(a_result, TRUE);
+}
+
+static pifs_status_t bench_stream_read_no_ra(pifs_bench_result_t * a_result)
+{
+    return bench_stream(a_result, FALSE);
+}
+
+/**
+ * @brief bench_append Append logical pages to a new file, like a logger.
+ * Latency shows the cost of an append, time and flash operations of whole
+ * benchmark include pifs_fallocate().
+ *
+ * @param[in] a_is_fallocate TRUE: pages of file are reserved by
+ *                           pifs_fallocate() before writing.
+ */
+static pifs_status_t bench_append(pifs_bench_result_t * a_result, bool_t a_is_fallocate)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+
+    bench_begin(a_result, a_is_fallocate ? "append_fallocate" : "append");
+    file = pifs_fopen(BENCH_APPEND_FILENAME, "w");
+    if (file)
+    {
+#if PIFS_ENABLE_FALLOCATE
+        if (a_is_fallocate && pifs_fallocate(file, 0, BENCH_SEQ_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot allocate file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+#endif
+        for (i = 0; i < BENCH_SEQ_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            memset(bench_buf, (uint8_t) i, sizeof(bench_buf));
+            bench_op_begin(a_result);
+            if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += sizeof(bench_buf);
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    a_result->write_byte_num = a_result->byte_num;
+    bench_end(a_result);
+    if (ret == PIFS_SUCCESS && pifs_remove(BENCH_APPEND_FILENAME))
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot remove file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
+static pifs_status_t bench_append_no_fallocate(pifs_bench_result_t * a_result)
+{
+    return bench_append(a_result, FALSE);
+}
+
+#if PIFS_ENABLE_FALLOCATE
+static pifs_status_t bench_append_fallocate(pifs_bench_result_t * a_result)
+{
+    return bench_append(a_result, TRUE);
+}
+#endif
+
+/**
+ * @brief bench_append_seek Seek to random positions of a file which was
+ * appended page by page, like a log file, and read BENCH_RAND_SIZE_BYTE bytes.
+ * Seeking walks the map, so its length depends on the number of map entries.
+ */
+static pifs_status_t bench_append_seek(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+    long int      pos;
+
+    bench_begin(a_result, "append_seek");
+    file = pifs_fopen(BENCH_APPEND_FILENAME, "w");
+    if (file)
+    {
+        for (i = 0; i < BENCH_SEQ_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            memset(bench_buf, (uint8_t) i, sizeof(bench_buf));
+            if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    /* Writing of the file is not measured */
+    bench_begin(a_result, "append_seek");
+    file = pifs_fopen(BENCH_APPEND_FILENAME, "r");
+    if (file)
+    {
+        for (i = 0; i < BENCH_RAND_OP_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            pos = rand() % (BENCH_SEQ_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE - BENCH_RAND_SIZE_BYTE);
+            bench_op_begin(a_result);
+            if (pifs_fseek(file, pos, PIFS_SEEK_SET))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot seek file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else if (pifs_fread(bench_buf, 1, BENCH_RAND_SIZE_BYTE, file) != BENCH_RAND_SIZE_BYTE)
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot read file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else if (bench_buf[0] != (uint8_t) (pos / PIFS_LOGICAL_PAGE_SIZE_BYTE))
+            {
+                PIFS_BENCH_ERROR_MSG("Data mismatch at %li!\r\n", pos);
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += BENCH_RAND_SIZE_BYTE;
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    bench_end(a_result);
+    if (pifs_remove(BENCH_APPEND_FILENAME))
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot remove file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief bench_append_reread Append a logical page to a file and read the
+ * beginning of the file after every append, like a log which is read
+ * meanwhile. Every append needs a new map entry, cost of an append shall not
+ * depend on the length of the map.
+ */
+static pifs_status_t bench_append_reread(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+
+    bench_begin(a_result, "append_reread");
+    file = pifs_fopen(BENCH_APPEND_FILENAME, "w+");
+    if (file)
+    {
+        for (i = 0; i < BENCH_SEQ_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            memset(bench_buf, (uint8_t) i, sizeof(bench_buf));
+            bench_op_begin(a_result);
+            if (pifs_fseek(file, i * PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_SEEK_SET))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot seek file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else if (pifs_fseek(file, 0, PIFS_SEEK_SET)
+                     || pifs_fread(bench_buf, 1, BENCH_RAND_SIZE_BYTE, file) != BENCH_RAND_SIZE_BYTE)
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot read file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += PIFS_LOGICAL_PAGE_SIZE_BYTE;
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    a_result->write_byte_num = a_result->byte_num;
+    bench_end(a_result);
+    if (ret == PIFS_SUCCESS && pifs_remove(BENCH_APPEND_FILENAME))
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot remove file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief bench_rand Seek to random positions of the file of bench_seq_write()
+ * and read BENCH_RAND_SIZE_BYTE bytes or overwrite a page.
+ * Overwriting is only supported from beginning of page, therefore whole
+ * logical pages are written.
+ *
+ * @param[in] a_is_write TRUE: write, FALSE: read.
+ */
+static pifs_status_t bench_rand(pifs_bench_result_t * a_result, bool_t a_is_write)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+    long int      pos;
+    pifs_size_t   size = a_is_write ? PIFS_LOGICAL_PAGE_SIZE_BYTE : BENCH_RAND_SIZE_BYTE;
+
+    bench_begin(a_result, a_is_write ? "rand_write" : "rand_read");
+    file = pifs_fopen(BENCH_SEQ_FILENAME, a_is_write ? "r+" : "r");
+    if (file)
+    {
+        for (i = 0; i < BENCH_RAND_OP_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            if (a_is_write)
+            {
+                pos = (rand() % BENCH_SEQ_PAGE_NUM) * PIFS_LOGICAL_PAGE_SIZE_BYTE;
+            }
+            else
+            {
+                pos = rand() % (BENCH_SEQ_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE - BENCH_RAND_SIZE_BYTE);
+            }
+            bench_op_begin(a_result);
+            if (pifs_fseek(file, pos, PIFS_SEEK_SET))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot seek file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else if (a_is_write)
+            {
+                if (pifs_fwrite(bench_buf, 1, size, file) != size)
+                {
+                    PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+            else
+            {
+                if (pifs_fread(bench_buf, 1, size, file) != size)
+                {
+                    PIFS_BENCH_ERROR_MSG("Cannot read file!\r\n");
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += size;
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (a_is_write)
+    {
+        a_result->write_byte_num = a_result->byte_num;
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+static pifs_status_t bench_rand_read(pifs_bench_result_t * a_result)
+{
+    return bench_rand(a_result, FALSE);
+}
+
+static pifs_status_t bench_rand_write(pifs_bench_result_t * a_result)
+{
+    return bench_rand(a_result, TRUE);
+}
+
+/**
+ * @brief bench_delta Rewrite the same page of a file, every rewrite
+ * allocates a delta page.
+ */
+static pifs_status_t bench_delta(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+
+    bench_begin(a_result, "delta_rewrite");
+    file = pifs_fopen(BENCH_DELTA_FILENAME, "w");
+    if (file)
+    {
+        memset(bench_buf, 0x5A, sizeof(bench_buf));
+        if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+        /* First write of the page is not measured */
+        bench_begin(a_result, "delta_rewrite");
+        for (i = 0; i < BENCH_DELTA_OP_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            memset(bench_buf, (uint8_t) i, sizeof(bench_buf));
+            bench_op_begin(a_result);
+            if (pifs_fseek(file, 0, PIFS_SEEK_SET))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot seek file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += sizeof(bench_buf);
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+        a_result->write_byte_num = a_result->byte_num;
+        bench_end(a_result);
+        if (pifs_remove(BENCH_DELTA_FILENAME))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot remove file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+        bench_end(a_result);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief bench_small_create Create small files, every file is an operation.
+ */
+static pifs_status_t bench_small_create(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+    char          filename[PIFS_FILENAME_LEN_MAX];
+
+    bench_begin(a_result, "small_create");
+    memset(bench_buf, 0xA5, sizeof(bench_buf));
+    for (i = 0; i < BENCH_SMALL_FILE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        snprintf(filename, sizeof(filename), BENCH_SMALL_FILENAME, (unsigned) i);
+        bench_op_begin(a_result);
+        file = pifs_fopen(filename, "w");
+        if (file)
+        {
+            if (pifs_fwrite(bench_buf, 1, BENCH_SMALL_SIZE_BYTE, file) != BENCH_SMALL_SIZE_BYTE)
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (pifs_fclose(file))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        else
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot open file %s!\r\n", filename);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        bench_op_end(a_result);
+        a_result->byte_num += BENCH_SMALL_SIZE_BYTE;
+    }
+    a_result->write_byte_num = a_result->byte_num;
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_lookup Look up random small files by name.
+ */
+static pifs_status_t bench_lookup(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    uint32_t      i;
+    char          filename[PIFS_FILENAME_LEN_MAX];
+
+    bench_begin(a_result, "dir_lookup");
+    for (i = 0; i < BENCH_LOOKUP_OP_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        snprintf(filename, sizeof(filename), BENCH_SMALL_FILENAME,
+                 (unsigned) (rand() % BENCH_SMALL_FILE_NUM));
+        bench_op_begin(a_result);
+        if (pifs_filesize(filename) != BENCH_SMALL_SIZE_BYTE)
+        {
+            PIFS_BENCH_ERROR_MSG("Wrong size of file %s!\r\n", filename);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        bench_op_end(a_result);
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_small_delete Delete small files of bench_small_create().
+ */
+static pifs_status_t bench_small_delete(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    uint32_t      i;
+    char          filename[PIFS_FILENAME_LEN_MAX];
+
+    bench_begin(a_result, "small_delete");
+    for (i = 0; i < BENCH_SMALL_FILE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        snprintf(filename, sizeof(filename), BENCH_SMALL_FILENAME, (unsigned) i);
+        bench_op_begin(a_result);
+        if (pifs_remove(filename))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot remove file %s!\r\n", filename);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        bench_op_end(a_result);
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_merge Merge file system.
+ */
+static pifs_status_t bench_merge(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    uint32_t      i;
+
+    bench_begin(a_result, "merge");
+    for (i = 0; i < BENCH_MERGE_OP_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        bench_op_begin(a_result);
+        PIFS_GET_MUTEX();
+        ret = pifs_merge();
+        PIFS_PUT_MUTEX();
+        bench_op_end(a_result);
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_static_wear Static wear leveling of one block.
+ */
+static pifs_status_t bench_static_wear(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    uint32_t      i;
+
+    bench_begin(a_result, "static_wear");
+    for (i = 0; i < BENCH_WEAR_OP_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        bench_op_begin(a_result);
+        ret = pifs_static_wear_leveling(1);
+        bench_op_end(a_result);
+    }
+    bench_end(a_result);
+
+    return ret;
+}
+
+/**
+ * @brief bench_delta_loop Rewrite a few pages of a file in turn. Every
+ * rewrite allocates a delta page, so delta map fills up and management
+ * blocks are merged.
+ */
+static pifs_status_t bench_delta_loop(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+
+    bench_begin(a_result, "delta_rewrite_loop");
+    file = pifs_fopen(BENCH_DELTA_FILENAME, "w");
+    if (file)
+    {
+        memset(bench_buf, 0x5A, sizeof(bench_buf));
+        for (i = 0; i < BENCH_DELTA_LOOP_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        /* First write of the pages is not measured */
+        bench_begin(a_result, "delta_rewrite_loop");
+        for (i = 0; i < BENCH_OP_NUM_MAX && ret == PIFS_SUCCESS; i++)
+        {
+            memset(bench_buf, (uint8_t) i, sizeof(bench_buf));
+            bench_op_begin(a_result);
+            if (pifs_fseek(file, (i % BENCH_DELTA_LOOP_PAGE_NUM) * sizeof(bench_buf), PIFS_SEEK_SET))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot seek file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += sizeof(bench_buf);
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+        a_result->write_byte_num = a_result->byte_num;
+        bench_end(a_result);
+        if (pifs_remove(BENCH_DELTA_FILENAME))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot remove file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+        bench_end(a_result);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief bench_small_overwrite Overwrite beginning of random pages of a file
+ * with BENCH_PATCH_SIZE_BYTE bytes. Small overwrites are stored as patches
+ * if PIFS_DELTA_PATCH_PAGE_NUM is not zero, otherwise they need delta pages.
+ * Content of the file is verified at the end.
+ */
+static pifs_status_t bench_small_overwrite(pifs_bench_result_t * a_result)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      i;
+    uint32_t      page;
+    uint8_t       data[BENCH_PATCH_SIZE_BYTE];
+    uint8_t       last[BENCH_PATCH_PAGE_NUM];
+
+    bench_begin(a_result, "small_overwrite");
+    file = pifs_fopen(BENCH_DELTA_FILENAME, "w+");
+    if (file)
+    {
+        memset(bench_buf, 0x5A, sizeof(bench_buf));
+        memset(last, 0x5A, sizeof(last));
+        for (i = 0; i < BENCH_PATCH_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            if (pifs_fwrite(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        /* First write of the pages is not measured */
+        bench_begin(a_result, "small_overwrite");
+        for (i = 0; i < BENCH_RAND_OP_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            page = rand() % BENCH_PATCH_PAGE_NUM;
+            last[page] = (uint8_t) i;
+            memset(data, last[page], sizeof(data));
+            bench_op_begin(a_result);
+            if (pifs_fseek(file, page * PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_SEEK_SET))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot seek file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else if (pifs_fwrite(data, 1, sizeof(data), file) != sizeof(data))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            bench_op_end(a_result);
+            a_result->byte_num += sizeof(data);
+        }
+        a_result->write_byte_num = a_result->byte_num;
+        bench_end(a_result);
+        /* Verification is not measured */
+        for (page = 0; page < BENCH_PATCH_PAGE_NUM && ret == PIFS_SUCCESS; page++)
+        {
+            if (pifs_fseek(file, page * PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_SEEK_SET)
+                    || pifs_fread(bench_buf, 1, sizeof(bench_buf), file) != sizeof(bench_buf))
+            {
+                PIFS_BENCH_ERROR_MSG("Cannot read file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            for (i = 0; i < sizeof(bench_buf) && ret == PIFS_SUCCESS; i++)
+            {
+                if (bench_buf[i] != (i < sizeof(data) ? last[page] : 0x5A))
+                {
+                    PIFS_BENCH_ERROR_MSG("Data mismatch at page %u offset %u!\r\n", page, i);
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (pifs_remove(BENCH_DELTA_FILENAME))
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot remove file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_BENCH_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+        bench_end(a_result);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief bench_mount Shut down and mount file system.
+ * Flash statistics are cleared by pifs_init(), therefore flash operations
+ * of mounts are summed here.
+ *
+ * @param[out] a_result Result of benchmark.
+ * @param[in] a_is_scan TRUE: mount hint is invalidated before mount, so
+ *                      every block is scanned.
+ */
+static pifs_status_t bench_mount(pifs_bench_result_t * a_result, bool_t a_is_scan)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    uint32_t      i;
+    uint32_t      flash_read_cntr = 0;
+    uint32_t      flash_write_cntr = 0;
+    uint32_t      flash_write_byte_cntr = 0;
+    uint32_t      flash_erase_cntr = 0;
+    uint32_t      merge_cntr = 0;
+#if PIFS_ENABLE_MOUNT_HINT
+    uint32_t      magic = 0;
+    uint32_t      j;
+#endif
+
+    bench_begin(a_result, a_is_scan ? "mount_scan" : "mount");
+    for (i = 0; i < BENCH_MOUNT_OP_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_delete();
+#if PIFS_ENABLE_MOUNT_HINT
+        if (ret == PIFS_SUCCESS && a_is_scan)
+        {
+            /* Destroy magic of first mount hint of every block, */
+            /* so no block has valid hints */
+            ret = pifs_flash_init();
+            for (j = 0; j < PIFS_MOUNT_HINT_BLOCK_NUM && ret == PIFS_SUCCESS; j++)
+            {
+                ret = pifs_flash_write(PIFS_MOUNT_HINT_BLOCK_ADDRESS + j, 0, 0,
+                                       &magic, sizeof(magic));
+            }
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = pifs_flash_delete();
+            }
+        }
+#endif
+        if (ret == PIFS_SUCCESS)
+        {
+            bench_op_begin(a_result);
+            ret = pifs_init();
+            bench_op_end(a_result);
+            flash_read_cntr += pifs.flash_read_cntr;
+            flash_write_cntr += pifs.flash_write_cntr;
+            flash_write_byte_cntr += pifs.flash_write_byte_cntr;
+            flash_erase_cntr += pifs.flash_erase_cntr;
+            merge_cntr += pifs.merge_cntr;
+        }
+        if (ret != PIFS_SUCCESS)
+        {
+            PIFS_BENCH_ERROR_MSG("Cannot mount file system: %i\r\n", ret);
+        }
+    }
+    bench_end(a_result);
+    a_result->flash_read_cntr = flash_read_cntr;
+    a_result->flash_write_cntr = flash_write_cntr;
+    a_result->flash_write_byte_cntr = flash_write_byte_cntr;
+    a_result->flash_erase_cntr = flash_erase_cntr;
+    a_result->merge_cntr = merge_cntr;
+
+    return ret;
+}
+
+static pifs_status_t bench_mount_hint(pifs_bench_result_t * a_result)
+{
+    return bench_mount(a_result, FALSE);
+}
+
+#if PIFS_ENABLE_MOUNT_HINT
+static pifs_status_t bench_mount_scan(pifs_bench_result_t * a_result)
+{
+    return bench_mount(a_result, TRUE);
+}
+#endif
+
+/**
+ * @brief pifs_bench Run benchmarks and print results.
+ * Sequential and random read/write, burst read, stream read with and without read-ahead, delta rewrite (single page and loop), small overwrite, small file create/delete,
+ * seek in appended file, append with reread, file name lookup, merge, static wear leveling and mount are measured.
+ * Flash operations are counted by the statistics of file system.
+ *
+ * @param[in] a_format  Output format: CSV or JSON.
+ * @param[in] a_output  Output stream of results.
+ * @return PIFS_SUCCESS if all benchmarks were run successfully.
+ */
+pifs_status_t pifs_bench(pifs_bench_format_t a_format, FILE * a_output)
+{
+    pifs_status_t       ret = PIFS_SUCCESS;
+    pifs_bench_result_t result;
+    uint32_t            i;
+    pifs_status_t     (*bench_func[])(pifs_bench_result_t * a_result) =
+    {
+        bench_seq_write,
+        bench_seq_read,
+        bench_seq_read_burst,
+        bench_flash_read,
+        bench_seq_write_burst,
+        bench_stream_read,
+        bench_stream_read_no_ra,
+        bench_rand_read,
+        bench_rand_write,
+        bench_delta,
+        bench_delta_loop,
+        bench_small_overwrite,
+        bench_small_create,
+        bench_lookup,
+        bench_small_delete,
+        bench_merge,
+        bench_static_wear,
+        bench_append_no_fallocate,
+#if PIFS_ENABLE_FALLOCATE
+        bench_append_fallocate,
+#endif
+        bench_append_seek,
+        bench_append_reread,
+        bench_mount_hint,
+#if PIFS_ENABLE_MOUNT_HINT
+        bench_mount_scan
+#endif
+    };
+
+    srand(BENCH_SEED);
+    if (pifs_is_file_exist(BENCH_SEQ_FILENAME))
+    {
+        (void) pifs_remove(BENCH_SEQ_FILENAME);
+    }
+    if (pifs_is_file_exist(BENCH_STREAM_FILENAME))
+    {
+        (void) pifs_remove(BENCH_STREAM_FILENAME);
+    }
+    if (a_format == PIFS_BENCH_FORMAT_JSON)
+    {
+        fprintf(a_output, "{\n  \"config\": {\"logical_page_size\": %u, \"flash_page_size\": %u, "
+                "\"flash_pages_per_block\": %u, \"flash_blocks\": %u, \"cache_pages\": %u},\n"
+                "  \"results\": [\n",
+                PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_FLASH_PAGE_SIZE_BYTE,
+                PIFS_FLASH_PAGE_PER_BLOCK, PIFS_FLASH_BLOCK_NUM_FS, PIFS_CACHE_PAGE_NUM);
+    }
+    for (i = 0; i < sizeof(bench_func) / sizeof(bench_func[0]) && ret == PIFS_SUCCESS; i++)
+    {
+        ret = bench_func[i](&result);
+        bench_print(a_format, a_output, &result, i == 0);
+    }
+    if (a_format == PIFS_BENCH_FORMAT_JSON)
+    {
+        fprintf(a_output, "\n  ]\n}\n");
+    }
+    if (pifs_is_file_exist(BENCH_SEQ_FILENAME))
+    {
+        (void) pifs_remove(BENCH_SEQ_FILENAME);
+    }
+
+    return ret;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file        pifs_bench.h
+ * @brief       Function prototypes for benchmark of Pi file system
+ * @author      Copyright (C) Peter Ivanov, 2017
+ *
+ * Created:     2017-06-11 09:10:19
+ * Last modify: 2017-06-27 19:35:38 ivanovp {Time-stamp}
+ * Licence:     GPL
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _INCLUDE_PIFS_BENCH_H_
+#define _INCLUDE_PIFS_BENCH_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "pifs_config.h"
+
+typedef enum
+{
+    PIFS_BENCH_FORMAT_CSV = 0,
+    PIFS_BENCH_FORMAT_JSON
+} pifs_bench_format_t;
+
+pifs_status_t pifs_bench(pifs_bench_format_t a_format, FILE * a_output);
+
+#endif /* _INCLUDE_PIFS_BENCH_H_ */
@@ -22,6 +22,7 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <time.h>
 #include <string.h>
 
@@ -30,6 +31,8 @@
 #include "pifs_entry.h"
 #include "pifs_test.h"
 #include "pifs_helper.h"
+#include "pifs_delta.h"
+#include "pifs_fsbm.h"
 #include "buffer.h"
 
 #define PIFS_DEBUG_LEVEL    5
@@ -44,6 +47,7 @@
 #define ENABLE_SEEK_READ_TEST         1
 #define ENABLE_SEEK_WRITE_TEST        1
 #define ENABLE_DELTA_TEST             1
+#define ENABLE_FALLOCATE_TEST         1
 #if ENABLE_BASIC_TEST
 #define ENABLE_RENAME_TEST            1
 #endif
@@ -53,6 +57,62 @@
 #if ENABLE_SMALL_FILES_TEST
 #define ENABLE_LIST_DIRECTORY_TEST    1
 #endif
+#if PIFS_ENABLE_STATISTICS
+#define ENABLE_CACHE_TEST             1
+#endif
+#if PIFS_ENABLE_FSBM_IN_RAM
+#define ENABLE_FSBM_TEST              1
+#endif
+#if PIFS_ENABLE_DELTA_INDEX
+#define ENABLE_DELTA_INDEX_TEST       1
+#endif
+#if PIFS_ENTRY_INDEX_LIST_NUM && PIFS_ENABLE_DIRECTORIES
+#define ENABLE_ENTRY_INDEX_TEST       1
+#endif
+#if PIFS_EXTENT_CACHE_NUM
+#define ENABLE_EXTENT_CACHE_TEST      1
+#endif
+#if PIFS_ENABLE_MOUNT_HINT
+#define ENABLE_MOUNT_HINT_TEST        1
+#endif
+#if PIFS_ENABLE_FSBM_IN_RAM && PIFS_ENABLE_FSBM_BATCH && PIFS_ENABLE_STATISTICS
+#define ENABLE_FSBM_BATCH_TEST        1
+#endif
+#if PIFS_DIRECT_READ_PAGE_NUM_MAX
+#define ENABLE_DIRECT_READ_TEST       1
+#endif
+#if PIFS_READ_AHEAD_PAGE_NUM
+#define ENABLE_READ_AHEAD_TEST        1
+#endif
+#define ENABLE_BURST_TEST             1
+#if PIFS_SKIP_FREE_PAGE_READ && ENABLE_WRITE_FRAGMENT_TEST
+#define ENABLE_SKIP_READ_TEST         1
+#endif
+#if PIFS_ENABLE_ERASED_BITMAP
+#define ENABLE_ERASED_BITMAP_TEST     1
+#endif
+#define ENABLE_BLOCK_TYPE_TEST        1
+#if PIFS_ENABLE_ALLOC_CURSOR
+#define ENABLE_ALLOC_CURSOR_TEST      1
+#endif
+#if PIFS_ENABLE_EXTENT_ALLOC
+#define ENABLE_EXTENT_ALLOC_TEST      1
+#endif
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+#define ENABLE_DELTA_MAP_EXT_TEST     1
+#endif
+#if PIFS_DELTA_FILTER_PAGE_NUM
+#define ENABLE_DELTA_FILTER_TEST      1
+#endif
+#if PIFS_DELTA_PATCH_PAGE_NUM
+#define ENABLE_PATCH_TEST             1
+#endif
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+#define ENABLE_DEFERRED_MAP_TEST      1
+#endif
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+#define ENABLE_MAP_TAIL_TEST          1
+#endif
 #define PIFS_REMOVE_TEST_FILES        1
 
 #define TEST_FULL_PAGE_NUM            (PIFS_LOGICAL_PAGE_NUM_FS / 2)
@@ -67,6 +127,47 @@
 #endif
 
 #define LARGE_FILE_SIZE  (2 * PIFS_MAP_ENTRY_PER_PAGE + 2)
+#define FALLOCATE_TEST_BUF_NUM  6     /**< Number of buffers written to file of fallocate test */
+#define CACHE_TEST_BUF_NUM      4     /**< Number of buffers in files of cache test */
+#define CACHE_TEST_WRITE_SIZE   64    /**< Size of interleaved writes of cache test */
+#define FSBM_TEST_BUF_NUM       2     /**< Number of buffers in files of free space bitmap test */
+#define TEST_PAGE_BUF_PAGE_NUM  4     /**< Size of test_page_buf in logical pages */
+#define DELTA_INDEX_TEST_PAGE_NUM   TEST_PAGE_BUF_PAGE_NUM     /**< Size of file of delta index test in logical pages */
+#define DELTA_INDEX_TEST_WRITE_NUM  (2 * PIFS_DELTA_ENTRY_NUM) /**< Number of overwrites of delta index test */
+#define ENTRY_INDEX_TEST_DIR_NUM    (PIFS_ENTRY_INDEX_LIST_NUM + 1) /**< More directories than indexed entry lists */
+#define ENTRY_INDEX_TEST_FILE_NUM   3 /**< Number of files per directory of entry index test */
+#define EXTENT_TEST_PAGE_NUM    (2 * PIFS_EXTENT_CACHE_NUM + 3) /**< Fragmented file has more extents than cached */
+#define EXTENT_TEST_SEEK_NUM    (4 * EXTENT_TEST_PAGE_NUM)      /**< Number of seeks of extent cache test */
+#define EXTENT_TEST_SEEK_STEP   (7 * PIFS_LOGICAL_PAGE_SIZE_BYTE + 13)
+#define EXTENT_TEST_READ_SIZE   16    /**< Size of reads after seek of extent cache test */
+#define FSBM_BATCH_TEST_PAGE_NUM           TEST_PAGE_BUF_PAGE_NUM /**< Pages written by one call in batch test */
+#define FSBM_BATCH_TEST_MGMT_PAGE_NUM_MAX  8 /**< Map, entry and free space bitmap pages allowed to be programmed by batch test */
+#define DIRECT_READ_TEST_PAGE_NUM   TEST_PAGE_BUF_PAGE_NUM /**< Size of file of direct read test in logical pages */
+#define READ_AHEAD_TEST_PAGE_NUM    TEST_PAGE_BUF_PAGE_NUM /**< Size of file of read-ahead test in logical pages */
+#define READ_AHEAD_TEST_READ_SIZE   16 /**< Size of small reads of read-ahead test */
+#define BURST_TEST_PAGE_NUM     TEST_PAGE_BUF_PAGE_NUM /**< Number of logical pages of burst test */
+#define BURST_TEST_READ_SIZE    32    /**< Size of scattered reads of burst test */
+#define SKIP_READ_TEST_FRAGMENT_SIZE  24 /**< Size of fragments of skip free page read test */
+#define ALLOC_CURSOR_TEST_FILE_NUM  4 /**< Number of files of allocation cursor test */
+#define EXTENT_ALLOC_TEST_HOLE_NUM  8 /**< Number of holes left by extent allocation test */
+#define EXTENT_ALLOC_TEST_PAGE_NUM  TEST_PAGE_BUF_PAGE_NUM /**< Pages written by one call in extent allocation test */
+#define DELTA_FILTER_TEST_BUF_NUM   2 /**< Number of buffers in file of delta filter test */
+#define DELTA_FILTER_TEST_WRITE_NUM 3 /**< Number of overwrites of delta filter test */
+#define PATCH_TEST_PAGE_NUM     4     /**< Size of file of patch test in logical pages */
+#define PATCH_TEST_SIZE         16    /**< Size of small overwrites of patch test */
+/** Maximum number of small overwrites until patches are folded: every overwrite
+ * needs at least a patch or a delta entry */
+#define PATCH_TEST_WRITE_NUM_MAX  (PIFS_DELTA_ENTRY_NUM + PIFS_DELTA_PATCH_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE \
+                                   / (PIFS_DELTA_PATCH_HEADER_SIZE_BYTE + PATCH_TEST_SIZE))
+#define DEFERRED_TEST_PAGE_PER_BUF   (TEST_BUF_SIZE / PIFS_LOGICAL_PAGE_SIZE_BYTE)
+/** Longest pending map entry: limited by page count of map entry and by size of block */
+#define DEFERRED_TEST_PAGE_COUNT_MAX (PIFS_MIN(PIFS_MAP_PAGE_COUNT_INVALID - 1, PIFS_LOGICAL_PAGE_PER_BLOCK) \
+                                      / DEFERRED_TEST_PAGE_PER_BUF * DEFERRED_TEST_PAGE_PER_BUF)
+#define DEFERRED_TEST_BUF_NUM_MAX    (2 * PIFS_LOGICAL_PAGE_PER_BLOCK / DEFERRED_TEST_PAGE_PER_BUF) /**< Maximum number of buffers to reach longest pending map entry */
+#define DEFERRED_TEST_SHORT_BUF_NUM  4 /**< Number of buffers appended to files of deferred map entry test */
+#define MAP_TAIL_TEST_BUF_NUM        (PIFS_MAP_ENTRY_PER_PAGE + 2) /**< Number of appends of map tail test, map of file has two pages */
+#define DELTA_MAP_EXT_TEST_PAGE_NUM  PIFS_MIN(2u, PIFS_DELTA_MAP_EXT_PAGE_NUM) /**< Chained delta map pages needed by delta map extension test */
+#define DELTA_MAP_EXT_TEST_BUF_NUM   PIFS_MAX(2u, PIFS_DELTA_ENTRY_PER_PAGE * PIFS_LOGICAL_PAGE_SIZE_BYTE / TEST_BUF_SIZE) /**< Buffers of delta map extension test file, one overwrite fills a delta map page */
 
 #define PIFS_TEST_ERROR_MSG(...)    do {    \
         printf("%s:%i ERROR: ", __FUNCTION__, __LINE__); \
@@ -75,6 +176,7 @@
 
 uint8_t test_buf_w[TEST_BUF_SIZE] __attribute__((aligned(4)));
 uint8_t test_buf_r[TEST_BUF_SIZE] __attribute__((aligned(4)));
+uint8_t test_page_buf[TEST_PAGE_BUF_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE] __attribute__((aligned(4)));
 const size_t fragment_size = 5;
 
 #if PIFS_ENABLE_DIRECTORIES
@@ -176,6 +278,68 @@ pifs_status_t pifs_create_file(const char * a_filename,
     return ret;
 }
 
+/**
+ * @brief pifs_overwrite_file Overwrite an existing file from its beginning
+ * with the same content as pifs_create_file() would write.
+ *
+ * @param[in] a_filename        Name of file.
+ * @param[in] a_sequence_start  First sequence number of content.
+ * @param[in] a_write_count     Number of buffers to write.
+ * @return PIFS_SUCCESS if file was overwritten.
+ */
+pifs_status_t pifs_overwrite_file(const char * a_filename,
+                                  const uint32_t a_sequence_start,
+                                  const size_t a_write_count)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    size_t        written_size = 0;
+    size_t        i = 0;
+#if PIFS_ENABLE_USER_DATA
+    pifs_user_data_t user_data;
+#endif
+
+    file = pifs_fopen(a_filename, "r+");
+    if (file)
+    {
+        printf("File opened for overwriting %s\r\n", a_filename);
+        for (i = 0; i < a_write_count && ret == PIFS_SUCCESS; i++)
+        {
+            generate_buffer(a_sequence_start + i, a_filename);
+            written_size = pifs_fwrite(test_buf_w, 1, sizeof(test_buf_w), file);
+            if (written_size != sizeof(test_buf_w))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+#if PIFS_ENABLE_USER_DATA
+        if (ret == PIFS_SUCCESS)
+        {
+            fill_buffer(&user_data, sizeof(user_data), FILL_TYPE_SEQUENCE_BYTE, a_sequence_start);
+            ret = pifs_fsetuserdata(file, &user_data);
+            if (ret != PIFS_SUCCESS)
+            {
+                PIFS_TEST_ERROR_MSG("Cannot set user data!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+#endif
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
 pifs_status_t pifs_test_remove(const char * a_filename)
 {
     pifs_status_t ret;
@@ -1145,6 +1309,157 @@ pifs_status_t pifs_test_wseek_r(void)
     return ret;
 }
 
+#if PIFS_ENABLE_FALLOCATE
+/**
+ * @brief pifs_test_fallocate_write Write buffers in two parts to reserved
+ * pages and beyond them.
+ */
+static pifs_status_t pifs_test_fallocate_write(P_FILE * a_file, const char * a_filename,
+                                               size_t a_first, size_t a_last)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    size_t        i;
+
+    for (i = a_first; i < a_last && ret == PIFS_SUCCESS; i++)
+    {
+        generate_buffer(i, a_filename);
+        if (pifs_fwrite(test_buf_w, 1, SEEK_TEST_POS, a_file) != SEEK_TEST_POS
+                || pifs_fwrite(&test_buf_w[SEEK_TEST_POS], 1, sizeof(test_buf_w) - SEEK_TEST_POS, a_file)
+                != sizeof(test_buf_w) - SEEK_TEST_POS)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+
+    return ret;
+}
+#endif
+
+pifs_status_t pifs_test_fallocate_w(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+#if PIFS_ENABLE_FALLOCATE
+    P_FILE * file;
+    const char * filename = "falloc.tst";
+
+    printf("-------------------------------------------------\r\n");
+    printf("Fallocate test: writing file\r\n");
+    file = pifs_fopen(filename, "w");
+    if (file)
+    {
+        printf("File opened for writing %s\r\n", filename);
+        /* Third buffer is written partly to reserved pages */
+        if (pifs_fallocate(file, 0, 2 * TEST_BUF_SIZE + SEEK_TEST_POS))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot allocate file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_fallocate_write(file, filename, 0, FALLOCATE_TEST_BUF_NUM / 2);
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen(filename, "a");
+        if (file)
+        {
+            printf("File opened for appending %s\r\n", filename);
+            if (pifs_fallocate(file, pifs_ftell(file), (FALLOCATE_TEST_BUF_NUM / 2) * TEST_BUF_SIZE))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot allocate file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = pifs_test_fallocate_write(file, filename, FALLOCATE_TEST_BUF_NUM / 2,
+                                                FALLOCATE_TEST_BUF_NUM);
+            }
+            if (pifs_fclose(file))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        else
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+#endif
+
+    return ret;
+}
+
+pifs_status_t pifs_test_fallocate_remove(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+#if PIFS_ENABLE_FALLOCATE
+    ret = pifs_test_remove("falloc.tst");
+#endif
+    return ret;
+}
+
+pifs_status_t pifs_test_fallocate_r(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+#if PIFS_ENABLE_FALLOCATE
+    P_FILE * file;
+    size_t   i;
+    const char * filename = "falloc.tst";
+
+    printf("-------------------------------------------------\r\n");
+    printf("Fallocate test: reading file\r\n");
+    if (pifs_filesize(filename) != FALLOCATE_TEST_BUF_NUM * TEST_BUF_SIZE)
+    {
+        PIFS_TEST_ERROR_MSG("Invalid file size: %li!\r\n", pifs_filesize(filename));
+        ret = PIFS_ERROR_GENERAL;
+    }
+    file = pifs_fopen(filename, "r");
+    if (file)
+    {
+        printf("File opened for reading %s\r\n", filename);
+        for (i = 0; i < FALLOCATE_TEST_BUF_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            generate_buffer(i, filename);
+            if (pifs_fread(test_buf_r, 1, sizeof(test_buf_r), file) != sizeof(test_buf_r))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot read file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = check_buffers();
+            }
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+#endif
+
+    return ret;
+}
+
 pifs_status_t pifs_test_list_dir(void)
 {
     pifs_status_t ret = PIFS_SUCCESS;
@@ -1350,70 +1665,3559 @@ pifs_status_t pifs_test_delta_r(const char * a_filename)
     return ret;
 }
 
-#if PIFS_ENABLE_DIRECTORIES
-pifs_status_t pifs_test_dir_w(void)
+/**
+ * @brief pifs_test_check_fs Check consistency of the file system.
+ *
+ * @return PIFS_SUCCESS if no error found.
+ */
+pifs_status_t pifs_test_check_fs(void)
 {
-    pifs_status_t ret = PIFS_SUCCESS;
-    pifs_char_t   cwd[PIFS_PATH_LEN_MAX];
-
-    printf("-------------------------------------------------\r\n");
-    printf("Directory test: creating directories and writing files\r\n");
-
-    printf("Entering root directory...\r\n");
-    ret = pifs_chdir(PIFS_ROOT_STR);
+    pifs_status_t ret;
 
-    if (ret == PIFS_SUCCESS)
+    ret = pifs_check();
+    if (ret != PIFS_SUCCESS)
     {
-        if (strncmp(pifs_getcwd(cwd, sizeof(cwd)), PIFS_ROOT_STR, sizeof(cwd)) != 0)
-        {
-            PIFS_ERROR_MSG("Invalid directory: %s\r\n", cwd);
-            ret = PIFS_ERROR_GENERAL;
-        }
+        PIFS_TEST_ERROR_MSG("File system check failed: %i\r\n", ret);
     }
 
-    if (ret == PIFS_SUCCESS)
-    {
-        ret = pifs_mkdir("/a");
-    }
+    return ret;
+}
 
-    if (ret == PIFS_SUCCESS)
-    {
-        ret = pifs_mkdir("b");
-    }
+/**
+ * @brief pifs_test_remount Unmount and mount the file system.
+ *
+ * @return PIFS_SUCCESS if file system was mounted again.
+ */
+pifs_status_t pifs_test_remount(void)
+{
+    pifs_status_t ret;
 
+    printf("Remounting file system...\r\n");
+    ret = pifs_delete();
     if (ret == PIFS_SUCCESS)
     {
-        ret = pifs_mkdir("c");
+        ret = pifs_init();
     }
-
-    if (ret == PIFS_SUCCESS)
+    if (ret != PIFS_SUCCESS)
     {
-        ret = pifs_mkdir("a/d");
+        PIFS_TEST_ERROR_MSG("Cannot remount file system: %i\r\n", ret);
     }
 
-    if (ret == PIFS_SUCCESS)
-    {
-        ret = pifs_create_file("/a/1", 1, 1);
-    }
+    return ret;
+}
 
-    if (ret == PIFS_SUCCESS)
-    {
-        ret = pifs_create_file("/b/2", 2, 1);
-    }
+#if PIFS_ENABLE_STATISTICS
+/**
+ * @brief pifs_test_cache_check Check pages of page cache: a page shall be
+ * cached only once and pages which are not dirty shall match the flash memory.
+ *
+ * @return PIFS_SUCCESS if page cache is consistent.
+ */
+static pifs_status_t pifs_test_cache_check(void)
+{
+    pifs_status_t       ret = PIFS_SUCCESS;
+    pifs_cache_page_t * cache_page;
+    pifs_size_t         i;
+    pifs_size_t         j;
 
-    if (ret == PIFS_SUCCESS)
+    PIFS_GET_MUTEX();
+    for (i = 0; i < PIFS_CACHE_PAGE_NUM && ret == PIFS_SUCCESS; i++)
     {
-        ret = pifs_create_file("/c/3", 3, 1);
+        cache_page = &pifs.cache[i];
+        if (cache_page->address.block_address != PIFS_BLOCK_ADDRESS_INVALID)
+        {
+            for (j = i + 1; j < PIFS_CACHE_PAGE_NUM; j++)
+            {
+                if (pifs.cache[j].address.block_address == cache_page->address.block_address
+                        && pifs.cache[j].address.page_address == cache_page->address.page_address)
+                {
+                    PIFS_TEST_ERROR_MSG("Page %s is cached twice!\r\n", pifs_address2str(&cache_page->address));
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+            if (ret == PIFS_SUCCESS && !cache_page->is_dirty)
+            {
+                ret = pifs_flash_read(cache_page->address.block_address,
+                                      PIFS_LP2FP(cache_page->address.page_address), 0,
+                                      test_buf_r, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+                if (ret == PIFS_SUCCESS
+                        && memcmp(test_buf_r, cache_page->buf, PIFS_LOGICAL_PAGE_SIZE_BYTE) != 0)
+                {
+                    PIFS_TEST_ERROR_MSG("Clean cached page %s differs from flash memory!\r\n",
+                                        pifs_address2str(&cache_page->address));
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+        }
     }
+    PIFS_PUT_MUTEX();
 
-    if (ret == PIFS_SUCCESS)
-    {
-        ret = pifs_chdir("a/d");
-    }
+    return ret;
+}
 
-    if (ret == PIFS_SUCCESS)
+pifs_status_t pifs_test_cache_r(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    char          filename[PIFS_FILENAME_LEN_MAX];
+    size_t        i;
+
+    for (i = 0; i < PIFS_OPEN_FILE_NUM_MAX && ret == PIFS_SUCCESS; i++)
     {
-        ret = pifs_create_file("./4", 4, 1);
+        snprintf(filename, sizeof(filename), "cache%i.tst", (int) i);
+        ret = pifs_check_file(filename, 0, CACHE_TEST_BUF_NUM);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_cache_w Write small pieces to several files at once, so
+ * their data, map and entry pages replace each other in the page cache.
+ */
+pifs_status_t pifs_test_cache_w(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file[PIFS_OPEN_FILE_NUM_MAX];
+    char          filename[PIFS_FILENAME_LEN_MAX];
+    uint32_t      write_back_cntr = pifs.cache_write_back_cntr;
+    uint32_t      hit_cntr;
+    uint32_t      miss_cntr;
+    size_t        i;
+    size_t        j;
+    size_t        pos;
+#if PIFS_ENABLE_USER_DATA
+    pifs_user_data_t user_data;
+#endif
+
+    printf("-------------------------------------------------\r\n");
+    printf("Cache test\r\n");
+    for (i = 0; i < PIFS_OPEN_FILE_NUM_MAX; i++)
+    {
+        snprintf(filename, sizeof(filename), "cache%i.tst", (int) i);
+        file[i] = pifs_fopen(filename, "w");
+        if (!file[i])
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file %s!\r\n", filename);
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    for (i = 0; i < CACHE_TEST_BUF_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        for (pos = 0; pos < TEST_BUF_SIZE && ret == PIFS_SUCCESS; pos += CACHE_TEST_WRITE_SIZE)
+        {
+            for (j = 0; j < PIFS_OPEN_FILE_NUM_MAX && ret == PIFS_SUCCESS; j++)
+            {
+                snprintf(filename, sizeof(filename), "cache%i.tst", (int) j);
+                generate_buffer(i, filename);
+                if (pifs_fwrite(&test_buf_w[pos], 1, CACHE_TEST_WRITE_SIZE, file[j]) != CACHE_TEST_WRITE_SIZE)
+                {
+                    PIFS_TEST_ERROR_MSG("Cannot write file %s: %i!\r\n", filename, pifs_errno);
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_cache_check();
+        }
+    }
+    for (i = 0; i < PIFS_OPEN_FILE_NUM_MAX; i++)
+    {
+        if (file[i])
+        {
+#if PIFS_ENABLE_USER_DATA
+            fill_buffer(&user_data, sizeof(user_data), FILL_TYPE_SEQUENCE_BYTE, 0);
+            if (pifs_fsetuserdata(file[i], &user_data))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot set user data!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+#endif
+            if (pifs_fclose(file[i]))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_cache_check();
+    }
+    if (ret == PIFS_SUCCESS && pifs.cache_write_back_cntr == write_back_cntr)
+    {
+        PIFS_TEST_ERROR_MSG("No page was written back from cache!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    hit_cntr = pifs.cache_hit_cntr;
+    miss_cntr = pifs.cache_miss_cntr;
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_cache_r();
+    }
+    if (ret == PIFS_SUCCESS && (pifs.cache_hit_cntr == hit_cntr || pifs.cache_miss_cntr == miss_cntr))
+    {
+        PIFS_TEST_ERROR_MSG("Cache hits: %lu, misses: %lu!\r\n",
+                            (unsigned long) (pifs.cache_hit_cntr - hit_cntr),
+                            (unsigned long) (pifs.cache_miss_cntr - miss_cntr));
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_cache_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_cache_remove(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    char          filename[PIFS_FILENAME_LEN_MAX];
+    size_t        i;
+
+    for (i = 0; i < PIFS_OPEN_FILE_NUM_MAX && ret == PIFS_SUCCESS; i++)
+    {
+        snprintf(filename, sizeof(filename), "cache%i.tst", (int) i);
+        ret = pifs_test_remove(filename);
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_ENABLE_FSBM_IN_RAM
+/**
+ * @brief pifs_test_fsbm_check Compare copy of free space bitmap in RAM with
+ * the free space bitmap in flash memory. Pages of pending map entries are
+ * only reserved in RAM, so no file shall be opened for writing.
+ *
+ * @return PIFS_SUCCESS if copy in RAM is the same as in flash memory.
+ */
+static pifs_status_t pifs_test_fsbm_check(void)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_size_t          i;
+    uint8_t              fsbm_byte;
+#if PIFS_ENABLE_PAGE_CNTR
+    pifs_block_address_t page_ba;
+    pifs_size_t          page_idx;
+    pifs_size_t          free_cntr = 0;
+    pifs_size_t          to_be_released_cntr = 0;
+    pifs_size_t          free_data_cntr = 0;
+    pifs_size_t          to_be_released_data_cntr = 0;
+    uint8_t              bits;
+#endif
+
+    PIFS_GET_MUTEX();
+#if PIFS_ENABLE_FSBM_BATCH
+    if (pifs.fsbm_batch_cntr)
+    {
+        PIFS_TEST_ERROR_MSG("Batch of free space bitmap marking is not finished: %i!\r\n",
+                            pifs.fsbm_batch_cntr);
+        ret = PIFS_ERROR_GENERAL;
+    }
+#endif
+#if PIFS_ENABLE_MOUNT_HINT
+    pifs_fsbm_load_deferred();
+#endif
+    if (ret == PIFS_SUCCESS && !pifs.is_fsbm_ram_valid)
+    {
+        PIFS_TEST_ERROR_MSG("Free space bitmap is not loaded to RAM!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_flush();
+    }
+    ba = pifs.header.free_space_bitmap_address.block_address;
+    pa = pifs.header.free_space_bitmap_address.page_address;
+    for (i = 0; i < PIFS_FREE_SPACE_BITMAP_SIZE_BYTE && ret == PIFS_SUCCESS; i++)
+    {
+        if (i % PIFS_LOGICAL_PAGE_SIZE_BYTE == 0)
+        {
+            if (i)
+            {
+                ret = pifs_inc_ba_pa(&ba, &pa);
+            }
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = pifs_flash_read(ba, PIFS_LP2FP(pa), 0, test_buf_r, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+            }
+        }
+        fsbm_byte = test_buf_r[i % PIFS_LOGICAL_PAGE_SIZE_BYTE];
+        if (ret == PIFS_SUCCESS
+                && fsbm_byte != ((pifs.fsbm_ram_buf[i / sizeof(uint32_t)] >> ((i % sizeof(uint32_t)) * PIFS_BYTE_BITS)) & 0xFFu))
+        {
+            PIFS_TEST_ERROR_MSG("Byte %i of free space bitmap differs, flash: 0x%02X, RAM: 0x%08X!\r\n",
+                                (int) i, fsbm_byte, pifs.fsbm_ram_buf[i / sizeof(uint32_t)]);
+            ret = PIFS_ERROR_GENERAL;
+        }
+#if PIFS_ENABLE_PAGE_CNTR
+        /* Count pages of blocks like pifs_page_cntr_load() */
+        for (page_idx = i * PIFS_BYTE_BITS / PIFS_FSBM_BITS_PER_PAGE;
+             page_idx < (i + 1) * PIFS_BYTE_BITS / PIFS_FSBM_BITS_PER_PAGE
+             && page_idx < PIFS_LOGICAL_PAGE_NUM_FS && ret == PIFS_SUCCESS;
+             page_idx++)
+        {
+            bits = fsbm_byte >> ((page_idx << PIFS_FSBM_BITS_PER_PAGE_SHIFT) % PIFS_BYTE_BITS);
+            if (bits & 1u)
+            {
+                free_cntr++;
+            }
+            else if (!(bits & 2u))
+            {
+                to_be_released_cntr++;
+            }
+            if (page_idx % PIFS_LOGICAL_PAGE_PER_BLOCK == PIFS_LOGICAL_PAGE_PER_BLOCK - 1)
+            {
+                page_ba = page_idx / PIFS_LOGICAL_PAGE_PER_BLOCK + PIFS_FLASH_BLOCK_FIRST_FS;
+                if (pifs.block_free_page_cntr[page_ba] != free_cntr
+                        || pifs.block_to_be_released_page_cntr[page_ba] != to_be_released_cntr)
+                {
+                    PIFS_TEST_ERROR_MSG("Page counters of block %i: free %i, to be released %i, expected: %i, %i!\r\n",
+                                        page_ba, pifs.block_free_page_cntr[page_ba],
+                                        pifs.block_to_be_released_page_cntr[page_ba],
+                                        (int) free_cntr, (int) to_be_released_cntr);
+                    ret = PIFS_ERROR_GENERAL;
+                }
+                if (pifs_is_block_type(page_ba, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+                {
+                    free_data_cntr += free_cntr;
+                    to_be_released_data_cntr += to_be_released_cntr;
+                }
+                free_cntr = 0;
+                to_be_released_cntr = 0;
+            }
+        }
+#endif
+    }
+#if PIFS_ENABLE_PAGE_CNTR
+    if (ret == PIFS_SUCCESS
+            && (!pifs.is_page_cntr_valid
+                || pifs.free_data_page_cntr != free_data_cntr
+                || pifs.to_be_released_data_page_cntr != to_be_released_data_cntr))
+    {
+        PIFS_TEST_ERROR_MSG("Data page counters: free %i, to be released %i, expected: %i, %i!\r\n",
+                            (int) pifs.free_data_page_cntr, (int) pifs.to_be_released_data_page_cntr,
+                            (int) free_data_cntr, (int) to_be_released_data_cntr);
+        ret = PIFS_ERROR_GENERAL;
+    }
+#endif
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+
+pifs_status_t pifs_test_fsbm_r(void)
+{
+    pifs_status_t ret;
+
+    ret = pifs_check_file("fsbm1.tst", 1, FSBM_TEST_BUF_NUM);
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_check_file("fsbm3.tst", 3, FSBM_TEST_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_check();
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_fsbm_w Check copy of free space bitmap in RAM after
+ * writing and removing files, merge and remount.
+ */
+pifs_status_t pifs_test_fsbm_w(void)
+{
+    pifs_status_t ret;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Free space bitmap in RAM test\r\n");
+    ret = pifs_test_fsbm_check();
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_create_file("fsbm1.tst", 1, FSBM_TEST_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_create_file("fsbm2.tst", 2, FSBM_TEST_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_create_file("fsbm3.tst", 3, FSBM_TEST_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("fsbm2.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        printf("Merging...\r\n");
+        PIFS_GET_MUTEX();
+        ret = pifs_merge();
+        PIFS_PUT_MUTEX();
+        if (ret != PIFS_SUCCESS)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot merge: %i!\r\n", ret);
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_fsbm_remove(void)
+{
+    pifs_status_t ret;
+
+    ret = pifs_test_remove("fsbm1.tst");
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("fsbm3.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_check();
+    }
+
+    return ret;
+}
+
+#if PIFS_ENABLE_FSBM_BATCH && PIFS_ENABLE_STATISTICS
+/**
+ * @brief pifs_test_fsbm_batch_w Write a file by one call. Free space bitmap
+ * shall be programmed once for the pages of the call, not page by page.
+ */
+pifs_status_t pifs_test_fsbm_batch_w(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    uint32_t      write_cntr;
+    size_t        i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Free space bitmap batch test\r\n");
+    for (i = 0; i < FSBM_BATCH_TEST_PAGE_NUM; i++)
+    {
+        fill_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                    FILL_TYPE_SEQUENCE_WORD, i);
+    }
+    file = pifs_fopen("batch.tst", "w");
+    if (file)
+    {
+        write_cntr = pifs.flash_write_cntr;
+        if (pifs_fwrite(test_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE, FSBM_BATCH_TEST_PAGE_NUM, file)
+                != FSBM_BATCH_TEST_PAGE_NUM)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (pifs_fflush(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot flush file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+        write_cntr = pifs.flash_write_cntr - write_cntr;
+        if (ret == PIFS_SUCCESS
+                && write_cntr > PIFS_LP2FP(FSBM_BATCH_TEST_PAGE_NUM + FSBM_BATCH_TEST_MGMT_PAGE_NUM_MAX))
+        {
+            PIFS_TEST_ERROR_MSG("%lu flash pages programmed to write %i pages!\r\n",
+                                (unsigned long) write_cntr, FSBM_BATCH_TEST_PAGE_NUM);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("batch.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_check();
+    }
+
+    return ret;
+}
+#endif
+#endif
+
+#if PIFS_ENABLE_DELTA_INDEX
+/**
+ * @brief pifs_test_delta_lookup_check Search the latest delta page of every
+ * original page in the delta map linearly and compare it with the result of
+ * pifs_find_delta_page().
+ *
+ * @return PIFS_SUCCESS if every delta page is found.
+ */
+static pifs_status_t pifs_test_delta_lookup_check(void)
+{
+    pifs_status_t        ret;
+    pifs_delta_entry_t * delta_entry;
+    pifs_delta_entry_t * next_delta_entry;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_size_t          delta_entry_num;
+    pifs_size_t          i;
+    pifs_size_t          j;
+    bool_t               is_latest;
+
+    PIFS_GET_MUTEX();
+    /* Delta map is read by first search */
+    ret = pifs_find_delta_page(PIFS_FLASH_BLOCK_FIRST_FS, 0, &ba, &pa, NULL, &pifs.header);
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    delta_entry_num = pifs.delta_map_page_num * PIFS_DELTA_ENTRY_PER_PAGE;
+#else
+    delta_entry_num = PIFS_DELTA_MAP_PAGE_NUM * PIFS_DELTA_ENTRY_PER_PAGE;
+#endif
+    for (i = 0; i < delta_entry_num && ret == PIFS_SUCCESS; i++)
+    {
+        delta_entry = &((pifs_delta_entry_t*) pifs.delta_map_page_buf[i / PIFS_DELTA_ENTRY_PER_PAGE])
+                [i % PIFS_DELTA_ENTRY_PER_PAGE];
+        if (delta_entry->orig_address.block_address != PIFS_BLOCK_ADDRESS_INVALID
+                && pifs_calc_checksum(delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE)
+                == delta_entry->checksum)
+        {
+            /* Later entry of the same page overrides this one */
+            is_latest = TRUE;
+            for (j = i + 1; j < delta_entry_num && is_latest; j++)
+            {
+                next_delta_entry = &((pifs_delta_entry_t*) pifs.delta_map_page_buf[j / PIFS_DELTA_ENTRY_PER_PAGE])
+                        [j % PIFS_DELTA_ENTRY_PER_PAGE];
+                if (next_delta_entry->orig_address.block_address == delta_entry->orig_address.block_address
+                        && next_delta_entry->orig_address.page_address == delta_entry->orig_address.page_address
+                        && pifs_calc_checksum(next_delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE)
+                        == next_delta_entry->checksum)
+                {
+                    is_latest = FALSE;
+                }
+            }
+            if (is_latest)
+            {
+                ret = pifs_find_delta_page(delta_entry->orig_address.block_address,
+                                           delta_entry->orig_address.page_address,
+                                           &ba, &pa, NULL, &pifs.header);
+                if (ret == PIFS_SUCCESS
+                        && (ba != delta_entry->delta_address.block_address
+                            || pa != delta_entry->delta_address.page_address))
+                {
+                    PIFS_TEST_ERROR_MSG("Delta page of %s is ",
+                                        pifs_address2str(&delta_entry->orig_address));
+                    printf("%s, found: %s!\r\n", pifs_address2str(&delta_entry->delta_address),
+                           pifs_ba_pa2str(ba, pa));
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+        }
+    }
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_delta_index_check_file Compare file of delta index test
+ * with the expected content.
+ */
+static pifs_status_t pifs_test_delta_index_check_file(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    size_t        i;
+
+    file = pifs_fopen("dindex.tst", "r");
+    if (file)
+    {
+        for (i = 0; i < DELTA_INDEX_TEST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            if (pifs_fread(test_buf_r, 1, PIFS_LOGICAL_PAGE_SIZE_BYTE, file) != PIFS_LOGICAL_PAGE_SIZE_BYTE)
+            {
+                PIFS_TEST_ERROR_MSG("Cannot read file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = compare_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE],
+                                     PIFS_LOGICAL_PAGE_SIZE_BYTE, test_buf_r);
+            }
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_delta_index Overwrite pages of a file several times, so
+ * delta map gets full and merged. Every delta page shall be found through
+ * the delta index.
+ */
+pifs_status_t pifs_test_delta_index(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    size_t        i;
+    size_t        page_idx;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Delta index test\r\n");
+    for (i = 0; i < DELTA_INDEX_TEST_PAGE_NUM; i++)
+    {
+        fill_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                    FILL_TYPE_SEQUENCE_WORD, i);
+    }
+    file = pifs_fopen("dindex.tst", "w");
+    if (file)
+    {
+        if (pifs_fwrite(test_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE, DELTA_INDEX_TEST_PAGE_NUM, file)
+                != DELTA_INDEX_TEST_PAGE_NUM)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    for (i = 0; i < DELTA_INDEX_TEST_WRITE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        /* Pages are overwritten in changing order */
+        page_idx = (i * 3) % DELTA_INDEX_TEST_PAGE_NUM;
+        fill_buffer(&test_page_buf[page_idx * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                    FILL_TYPE_SEQUENCE_WORD, DELTA_INDEX_TEST_PAGE_NUM + i);
+        file = pifs_fopen("dindex.tst", "r+");
+        if (file)
+        {
+            if (pifs_fseek(file, page_idx * PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_SEEK_SET))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot seek in file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (ret == PIFS_SUCCESS
+                    && pifs_fwrite(&test_page_buf[page_idx * PIFS_LOGICAL_PAGE_SIZE_BYTE], 1,
+                                   PIFS_LOGICAL_PAGE_SIZE_BYTE, file) != PIFS_LOGICAL_PAGE_SIZE_BYTE)
+            {
+                PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (pifs_fclose(file))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        else
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_delta_lookup_check();
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_index_check_file();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_lookup_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_index_check_file();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("dindex.tst");
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_ENTRY_INDEX_LIST_NUM && PIFS_ENABLE_DIRECTORIES
+/**
+ * @brief pifs_test_entry_index_check Compare entry indexes with their entry
+ * lists.
+ *
+ * @return PIFS_SUCCESS if every used entry is indexed and free entries are
+ * counted correctly.
+ */
+static pifs_status_t pifs_test_entry_index_check(void)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_entry_index_t * index;
+    pifs_entry_t         entry;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_size_t          free_entry_idx;
+    pifs_size_t          free_entry_count;
+    pifs_size_t          to_be_released_entry_count;
+    pifs_size_t          used_entry_count;
+    pifs_size_t          indexed_entry_count;
+    pifs_size_t          entry_idx;
+    pifs_size_t          slot;
+    pifs_size_t          i;
+    pifs_size_t          k;
+    bool_t               is_erased;
+    bool_t               is_indexed;
+
+    PIFS_GET_MUTEX();
+    for (k = 0; k < PIFS_ENTRY_INDEX_LIST_NUM && ret == PIFS_SUCCESS; k++)
+    {
+        index = &pifs.entry_index[k];
+        if (index->entry_list_address.block_address != PIFS_BLOCK_ADDRESS_INVALID)
+        {
+            for (i = k + 1; i < PIFS_ENTRY_INDEX_LIST_NUM; i++)
+            {
+                if (pifs.entry_index[i].entry_list_address.block_address == index->entry_list_address.block_address
+                        && pifs.entry_index[i].entry_list_address.page_address == index->entry_list_address.page_address)
+                {
+                    PIFS_TEST_ERROR_MSG("Entry list %s is indexed twice!\r\n",
+                                        pifs_address2str(&index->entry_list_address));
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+            ba = index->entry_list_address.block_address;
+            pa = index->entry_list_address.page_address;
+            free_entry_idx = PIFS_ENTRY_LIST_ENTRY_NUM;
+            free_entry_count = 0;
+            to_be_released_entry_count = 0;
+            used_entry_count = 0;
+            for (entry_idx = 0; entry_idx < PIFS_ENTRY_LIST_ENTRY_NUM && ret == PIFS_SUCCESS; entry_idx++)
+            {
+                if (entry_idx && entry_idx % PIFS_ENTRY_PER_PAGE == 0)
+                {
+                    ret = pifs_inc_ba_pa(&ba, &pa);
+                }
+                if (ret == PIFS_SUCCESS)
+                {
+                    ret = pifs_read_entry(ba, pa, entry_idx % PIFS_ENTRY_PER_PAGE, &entry, &is_erased);
+                }
+                if (ret == PIFS_SUCCESS && is_erased)
+                {
+                    free_entry_count++;
+                    if (free_entry_idx == PIFS_ENTRY_LIST_ENTRY_NUM)
+                    {
+                        free_entry_idx = entry_idx;
+                    }
+                }
+                else if (ret == PIFS_SUCCESS && pifs_is_entry_deleted(&entry))
+                {
+                    to_be_released_entry_count++;
+                }
+                else if (ret == PIFS_SUCCESS)
+                {
+                    used_entry_count++;
+                    is_indexed = FALSE;
+                    for (slot = 0; slot < PIFS_ENTRY_INDEX_SIZE; slot++)
+                    {
+                        if (index->slot[slot].entry_idx == entry_idx)
+                        {
+                            is_indexed = TRUE;
+                        }
+                    }
+                    if (!is_indexed)
+                    {
+                        PIFS_TEST_ERROR_MSG("Entry %s #%i is not indexed!\r\n", entry.name, (int) entry_idx);
+                        ret = PIFS_ERROR_GENERAL;
+                    }
+                }
+            }
+            indexed_entry_count = 0;
+            for (slot = 0; slot < PIFS_ENTRY_INDEX_SIZE; slot++)
+            {
+                if (index->slot[slot].entry_idx != PIFS_ENTRY_INDEX_EMPTY
+                        && index->slot[slot].entry_idx != PIFS_ENTRY_INDEX_DELETED)
+                {
+                    indexed_entry_count++;
+                }
+            }
+            if (ret == PIFS_SUCCESS
+                    && (indexed_entry_count != used_entry_count
+                        || index->free_entry_idx != free_entry_idx
+                        || index->free_entry_count != free_entry_count
+                        || index->to_be_released_entry_count != to_be_released_entry_count))
+            {
+                PIFS_TEST_ERROR_MSG("Index of entry list %s: %i indexed, free from %i, %i free, %i to be released!\r\n",
+                                    pifs_address2str(&index->entry_list_address),
+                                    (int) indexed_entry_count, (int) index->free_entry_idx,
+                                    (int) index->free_entry_count, (int) index->to_be_released_entry_count);
+                printf("Entry list: %i used, free from %i, %i free, %i to be released\r\n",
+                       (int) used_entry_count, (int) free_entry_idx,
+                       (int) free_entry_count, (int) to_be_released_entry_count);
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+    }
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_entry_index Use more directories than number of entry
+ * indexes, so indexes are replaced while files are created, found, updated
+ * and removed.
+ */
+pifs_status_t pifs_test_entry_index(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    char          path[PIFS_PATH_LEN_MAX];
+    size_t        i;
+    size_t        j;
+    size_t        k;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Entry index test\r\n");
+    /* Entry lists of directories need contiguous management pages, */
+    /* released ones are reclaimed by merge */
+    printf("Merging...\r\n");
+    PIFS_GET_MUTEX();
+    ret = pifs_merge();
+    PIFS_PUT_MUTEX();
+    if (ret != PIFS_SUCCESS)
+    {
+        PIFS_TEST_ERROR_MSG("Cannot merge: %i!\r\n", ret);
+    }
+    for (i = 0; i < ENTRY_INDEX_TEST_DIR_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        snprintf(path, sizeof(path), "/ei%i", (int) i);
+        ret = pifs_mkdir(path);
+        if (ret != PIFS_SUCCESS)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot create directory %s: %i!\r\n", path, ret);
+        }
+    }
+    for (k = 0; k < 2 && ret == PIFS_SUCCESS; k++)
+    {
+        /* Files are created in every directory in turn, second round */
+        /* overwrites them */
+        for (j = 0; j < ENTRY_INDEX_TEST_FILE_NUM && ret == PIFS_SUCCESS; j++)
+        {
+            for (i = 0; i < ENTRY_INDEX_TEST_DIR_NUM && ret == PIFS_SUCCESS; i++)
+            {
+                snprintf(path, sizeof(path), "/ei%i/f%i.tst", (int) i, (int) j);
+                ret = pifs_create_file(path, i * ENTRY_INDEX_TEST_FILE_NUM + j + k, 1);
+                if (ret == PIFS_SUCCESS)
+                {
+                    ret = pifs_test_entry_index_check();
+                }
+            }
+        }
+        for (i = 0; i < ENTRY_INDEX_TEST_DIR_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            for (j = 0; j < ENTRY_INDEX_TEST_FILE_NUM && ret == PIFS_SUCCESS; j++)
+            {
+                snprintf(path, sizeof(path), "/ei%i/f%i.tst", (int) i, (int) j);
+                ret = pifs_check_file(path, i * ENTRY_INDEX_TEST_FILE_NUM + j + k, 1);
+            }
+        }
+        /* Remove a file in the middle of every directory */
+        for (i = 0; i < ENTRY_INDEX_TEST_DIR_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            snprintf(path, sizeof(path), "/ei%i/f%i.tst", (int) i, ENTRY_INDEX_TEST_FILE_NUM / 2);
+            ret = pifs_test_remove(path);
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = pifs_test_entry_index_check();
+            }
+            if (ret == PIFS_SUCCESS && pifs_is_file_exist(path))
+            {
+                PIFS_TEST_ERROR_MSG("Removed file %s exists!\r\n", path);
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+    }
+    for (i = 0; i < ENTRY_INDEX_TEST_DIR_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        for (j = 0; j < ENTRY_INDEX_TEST_FILE_NUM && ret == PIFS_SUCCESS; j++)
+        {
+            if (j != ENTRY_INDEX_TEST_FILE_NUM / 2)
+            {
+                snprintf(path, sizeof(path), "/ei%i/f%i.tst", (int) i, (int) j);
+                ret = pifs_test_remove(path);
+            }
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            snprintf(path, sizeof(path), "/ei%i", (int) i);
+            ret = pifs_rmdir(path);
+            if (ret != PIFS_SUCCESS)
+            {
+                PIFS_TEST_ERROR_MSG("Cannot remove directory %s: %i!\r\n", path, ret);
+            }
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_entry_index_check();
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_EXTENT_CACHE_NUM
+/**
+ * @brief pifs_test_extent_check Check extents of an opened file: they shall
+ * be sorted, shall not overlap and shall be the same as the map entries in
+ * the flash memory.
+ *
+ * @param[in] a_file    Pointer to opened file.
+ * @return PIFS_SUCCESS if extents are valid.
+ */
+static pifs_status_t pifs_test_extent_check(P_FILE * a_file)
+{
+    pifs_status_t      ret = PIFS_SUCCESS;
+    pifs_file_t      * file = (pifs_file_t*) a_file;
+    pifs_extent_t    * extent;
+    pifs_map_entry_t   map_entry;
+    pifs_size_t        i;
+
+    PIFS_GET_MUTEX();
+    if (file->extent_count > PIFS_EXTENT_CACHE_NUM)
+    {
+        PIFS_TEST_ERROR_MSG("Number of extents: %i!\r\n", (int) file->extent_count);
+        ret = PIFS_ERROR_GENERAL;
+    }
+    for (i = 0; i < file->extent_count && ret == PIFS_SUCCESS; i++)
+    {
+        extent = &file->extent[i];
+        if (i && extent->page_idx < file->extent[i - 1].page_idx + file->extent[i - 1].page_count)
+        {
+            PIFS_TEST_ERROR_MSG("Extent #%i at page %i overlaps previous extent!\r\n",
+                                (int) i, (int) extent->page_idx);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_read(extent->map_address.block_address, extent->map_address.page_address,
+                            PIFS_MAP_HEADER_SIZE_BYTE + extent->map_entry_idx * PIFS_MAP_ENTRY_SIZE_BYTE,
+                            &map_entry, PIFS_MAP_ENTRY_SIZE_BYTE);
+        }
+        if (ret == PIFS_SUCCESS
+                && (map_entry.address.block_address != extent->address.block_address
+                    || map_entry.address.page_address != extent->address.page_address
+                    || map_entry.page_count != extent->page_count))
+        {
+            PIFS_TEST_ERROR_MSG("Extent #%i differs from map entry %s #%i!\r\n", (int) i,
+                                pifs_address2str(&extent->map_address), (int) extent->map_entry_idx);
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_extent_cache Seek forward and backward in a file which
+ * has more map entries than extents.
+ */
+pifs_status_t pifs_test_extent_cache(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    P_FILE      * file2;
+    size_t        i;
+    size_t        pos;
+    size_t        prev_pos = 0;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Extent cache test\r\n");
+    file = pifs_fopen("extent.tst", "w");
+    /* Pages of two files are interleaved, every page of the test file */
+    /* gets its own map entry */
+    file2 = pifs_fopen("extent2.tst", "w");
+    if (file && file2)
+    {
+        for (i = 0; i < EXTENT_TEST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            generate_buffer(i, "extent.tst");
+            if (pifs_fwrite(test_buf_w, 1, PIFS_LOGICAL_PAGE_SIZE_BYTE, file) != PIFS_LOGICAL_PAGE_SIZE_BYTE
+                    || pifs_fwrite(test_buf_w, 1, PIFS_LOGICAL_PAGE_SIZE_BYTE, file2) != PIFS_LOGICAL_PAGE_SIZE_BYTE)
+            {
+                PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (ret == PIFS_SUCCESS && (pifs_fflush(file) || pifs_fflush(file2)))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot flush file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file2 && pifs_fclose(file2))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("extent.tst", "r");
+        if (!file)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    for (i = 0; i < EXTENT_TEST_SEEK_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        /* Positions jump forward and backward in the file */
+        pos = (i * EXTENT_TEST_SEEK_STEP) % (EXTENT_TEST_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE
+                                             - EXTENT_TEST_READ_SIZE);
+        if (i % 2)
+        {
+            ret = pifs_fseek(file, (long int) pos - (long int) prev_pos, PIFS_SEEK_CUR);
+        }
+        else
+        {
+            ret = pifs_fseek(file, pos, PIFS_SEEK_SET);
+        }
+        if (ret != PIFS_SUCCESS)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot seek to %i: %i!\r\n", (int) pos, ret);
+        }
+        if (ret == PIFS_SUCCESS
+                && pifs_fread(test_buf_r, 1, EXTENT_TEST_READ_SIZE, file) != EXTENT_TEST_READ_SIZE)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot read file at %i: %i!\r\n", (int) pos, pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS && pifs_ftell(file) != (long int) (pos + EXTENT_TEST_READ_SIZE))
+        {
+            PIFS_TEST_ERROR_MSG("Position is %li instead of %i!\r\n", pifs_ftell(file),
+                                (int) (pos + EXTENT_TEST_READ_SIZE));
+            ret = PIFS_ERROR_GENERAL;
+        }
+        prev_pos = pos + EXTENT_TEST_READ_SIZE;
+        /* Read data can span two pages */
+        generate_buffer(pos / PIFS_LOGICAL_PAGE_SIZE_BYTE, "extent.tst");
+        memcpy(test_page_buf, test_buf_w, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        generate_buffer(pos / PIFS_LOGICAL_PAGE_SIZE_BYTE + 1, "extent.tst");
+        memcpy(&test_page_buf[PIFS_LOGICAL_PAGE_SIZE_BYTE], test_buf_w, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = compare_buffer(&test_page_buf[pos % PIFS_LOGICAL_PAGE_SIZE_BYTE], EXTENT_TEST_READ_SIZE, test_buf_r);
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_extent_check(file);
+        }
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("extent.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("extent2.tst");
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_DIRECT_READ_PAGE_NUM_MAX
+/**
+ * @brief pifs_test_direct_read_file Read whole file and compare it with
+ * test_page_buf.
+ *
+ * @param[in] a_file    Pointer to opened file.
+ * @return PIFS_SUCCESS if content of file is the expected one.
+ */
+static pifs_status_t pifs_test_direct_read_file(P_FILE * a_file)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    size_t        pos;
+
+    pifs_rewind(a_file);
+    /* Every read has several whole pages */
+    for (pos = 0; pos < DIRECT_READ_TEST_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE && ret == PIFS_SUCCESS;
+         pos += TEST_BUF_SIZE)
+    {
+        if (pifs_fread(test_buf_r, 1, TEST_BUF_SIZE, a_file) != TEST_BUF_SIZE)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot read file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = compare_buffer(&test_page_buf[pos], TEST_BUF_SIZE, test_buf_r);
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_direct_read Read whole pages by one call while they are
+ * dirty in the page cache or they are overwritten through another handle.
+ */
+pifs_status_t pifs_test_direct_read(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    P_FILE      * file2 = NULL;
+    size_t        i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Direct read test\r\n");
+    file = pifs_fopen("direct.tst", "w+");
+    if (file)
+    {
+        /* Pages are written one by one, they are not flushed */
+        for (i = 0; i < DIRECT_READ_TEST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            fill_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                        FILL_TYPE_SEQUENCE_WORD, i + 1);
+            if (pifs_fwrite(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], 1,
+                            PIFS_LOGICAL_PAGE_SIZE_BYTE, file) != PIFS_LOGICAL_PAGE_SIZE_BYTE)
+            {
+                PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_direct_read_file(file);
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("direct.tst", "r");
+        file2 = pifs_fopen("direct.tst", "r+");
+        if (!file || !file2)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_direct_read_file(file);
+    }
+    /* Second page gets a delta page, third page is programmed in place */
+    for (i = 1; i < 3 && ret == PIFS_SUCCESS; i++)
+    {
+        if (i == 1)
+        {
+            fill_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                        FILL_TYPE_SEQUENCE_WORD, DIRECT_READ_TEST_PAGE_NUM + 1);
+        }
+        else
+        {
+            memset(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_FLASH_PROGRAMMED_BYTE_VALUE,
+                   PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        }
+        if (pifs_fseek(file2, i * PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_SEEK_SET))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot seek in file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS
+                && pifs_fwrite(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], 1,
+                               PIFS_LOGICAL_PAGE_SIZE_BYTE, file2) != PIFS_LOGICAL_PAGE_SIZE_BYTE)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_direct_read_file(file);
+        }
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file2 && pifs_fclose(file2))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("direct.tst", "r");
+        if (file)
+        {
+            ret = pifs_test_direct_read_file(file);
+            if (pifs_fclose(file))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        else
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("direct.tst");
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_READ_AHEAD_PAGE_NUM
+/**
+ * @brief pifs_test_read_ahead_check Read a page of file in small fragments
+ * and compare it with test_page_buf.
+ *
+ * @param[in] a_file        Pointer to opened file.
+ * @param[in] a_page_idx    Index of page in file.
+ * @return PIFS_SUCCESS if content of page is the expected one.
+ */
+static pifs_status_t pifs_test_read_ahead_check(P_FILE * a_file, size_t a_page_idx)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    size_t        pos;
+
+    if (pifs_fseek(a_file, a_page_idx * PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_SEEK_SET))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot seek in file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    for (pos = 0; pos < PIFS_LOGICAL_PAGE_SIZE_BYTE && ret == PIFS_SUCCESS; pos += READ_AHEAD_TEST_READ_SIZE)
+    {
+        if (pifs_fread(test_buf_r, 1, READ_AHEAD_TEST_READ_SIZE, a_file) != READ_AHEAD_TEST_READ_SIZE)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot read file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = compare_buffer(&test_page_buf[a_page_idx * PIFS_LOGICAL_PAGE_SIZE_BYTE + pos],
+                                 READ_AHEAD_TEST_READ_SIZE, test_buf_r);
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_read_ahead Read file in small fragments while its pages
+ * are overwritten through another handle.
+ */
+pifs_status_t pifs_test_read_ahead(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file = NULL;
+    P_FILE      * file2 = NULL;
+    pifs_file_t * f;
+    size_t        i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Read-ahead test\r\n");
+    for (i = 0; i < READ_AHEAD_TEST_PAGE_NUM; i++)
+    {
+        fill_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                    FILL_TYPE_SEQUENCE_WORD, i + 2);
+    }
+    file = pifs_fopen("rahead.tst", "w");
+    if (file)
+    {
+        if (pifs_fwrite(test_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE, READ_AHEAD_TEST_PAGE_NUM, file)
+                != READ_AHEAD_TEST_PAGE_NUM)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("rahead.tst", "r");
+        file2 = pifs_fopen("rahead.tst", "r+");
+        if (!file || !file2)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    f = (pifs_file_t*) file;
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_read_ahead_check(file, 0);
+    }
+    if (ret == PIFS_SUCCESS && f->read_ahead_page_count < 2)
+    {
+        PIFS_TEST_ERROR_MSG("Read-ahead buffer has %i pages!\r\n", f->read_ahead_page_count);
+        ret = PIFS_ERROR_GENERAL;
+    }
+    /* Buffered pages are overwritten: second page gets a delta page, */
+    /* third page is programmed in place */
+    for (i = 1; i < 3 && ret == PIFS_SUCCESS; i++)
+    {
+        if (i == 1)
+        {
+            fill_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                        FILL_TYPE_SEQUENCE_WORD, READ_AHEAD_TEST_PAGE_NUM + 2);
+        }
+        else
+        {
+            memset(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_FLASH_PROGRAMMED_BYTE_VALUE,
+                   PIFS_LOGICAL_PAGE_SIZE_BYTE);
+        }
+        if (pifs_fseek(file2, i * PIFS_LOGICAL_PAGE_SIZE_BYTE, PIFS_SEEK_SET))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot seek in file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS
+                && pifs_fwrite(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], 1,
+                               PIFS_LOGICAL_PAGE_SIZE_BYTE, file2) != PIFS_LOGICAL_PAGE_SIZE_BYTE)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    for (i = 1; i < READ_AHEAD_TEST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_test_read_ahead_check(file, i);
+    }
+    if (ret == PIFS_SUCCESS && pifs_fadvise(file, PIFS_FADV_RANDOM))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot set advice!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    for (i = 0; i < READ_AHEAD_TEST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_test_read_ahead_check(file, i);
+        if (ret == PIFS_SUCCESS && f->read_ahead_page_count)
+        {
+            PIFS_TEST_ERROR_MSG("Read-ahead is used for random access!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file2 && pifs_fclose(file2))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("rahead.tst");
+    }
+
+    return ret;
+}
+#endif
+
+/**
+ * @brief pifs_test_burst Compare burst operations of flash driver with
+ * reading and programming page by page.
+ */
+pifs_status_t pifs_test_burst(void)
+{
+    pifs_status_t        ret;
+    pifs_flash_sg_t      sg[BURST_TEST_PAGE_NUM];
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_count_t    page_count_found;
+    size_t               i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Burst flash operations test\r\n");
+    PIFS_GET_MUTEX();
+    ret = pifs_flush();
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_find_page(BURST_TEST_PAGE_NUM, BURST_TEST_PAGE_NUM, PIFS_BLOCK_TYPE_DATA, TRUE, TRUE,
+                             PIFS_FLASH_BLOCK_FIRST_FS, &ba, &pa, &page_count_found);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_mark_page(ba, pa, BURST_TEST_PAGE_NUM, TRUE, FALSE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        for (i = 0; i < BURST_TEST_PAGE_NUM; i++)
+        {
+            fill_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                        FILL_TYPE_SEQUENCE_WORD, i + 3);
+        }
+        ret = pifs_flash_write_pages(ba, PIFS_LP2FP(pa), test_page_buf,
+                                     PIFS_LP2FP(BURST_TEST_PAGE_NUM));
+#if PIFS_ENABLE_ERASED_BITMAP
+        /* Pages were programmed bypassing the page cache */
+        pifs_set_page_verified_erased(ba, pa, BURST_TEST_PAGE_NUM, FALSE);
+#endif
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Pages are read in reverse order with different offsets */
+        for (i = 0; i < BURST_TEST_PAGE_NUM; i++)
+        {
+            sg[i].block_address = ba;
+            sg[i].page_address = PIFS_LP2FP(pa + BURST_TEST_PAGE_NUM - 1 - i);
+            sg[i].page_offset = i;
+            sg[i].buf = &test_buf_r[i * BURST_TEST_READ_SIZE];
+            sg[i].buf_size = BURST_TEST_READ_SIZE;
+        }
+        ret = pifs_flash_read_sg(sg, BURST_TEST_PAGE_NUM);
+    }
+    for (i = 0; i < BURST_TEST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = compare_buffer(&test_page_buf[(BURST_TEST_PAGE_NUM - 1 - i) * PIFS_LOGICAL_PAGE_SIZE_BYTE + i],
+                             BURST_TEST_READ_SIZE, &test_buf_r[i * BURST_TEST_READ_SIZE]);
+    }
+    for (i = 0; i < BURST_TEST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_flash_read(ba, PIFS_LP2FP(pa + i), 0, test_buf_r, PIFS_FLASH_PAGE_SIZE_BYTE);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = compare_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE],
+                                 PIFS_FLASH_PAGE_SIZE_BYTE, test_buf_r);
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_mark_page(ba, pa, BURST_TEST_PAGE_NUM, FALSE, TRUE);
+    }
+    PIFS_PUT_MUTEX();
+    if (ret != PIFS_SUCCESS)
+    {
+        PIFS_TEST_ERROR_MSG("Burst flash operations failed: %i!\r\n", ret);
+    }
+
+    return ret;
+}
+
+#if PIFS_SKIP_FREE_PAGE_READ
+/**
+ * @brief pifs_test_skip_read Check which pages are known to be erased and
+ * write a file in fragments, so partial pages are written without reading.
+ */
+pifs_status_t pifs_test_skip_read(void)
+{
+    pifs_status_t        ret;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_count_t    page_count_found;
+    P_FILE             * file;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Skip free page read test\r\n");
+    PIFS_GET_MUTEX();
+    ret = pifs_find_page(1, 1, PIFS_BLOCK_TYPE_DATA, TRUE, FALSE,
+                         PIFS_FLASH_BLOCK_FIRST_FS, &ba, &pa, &page_count_found);
+    if (ret == PIFS_SUCCESS && !pifs_is_page_known_erased(ba, pa))
+    {
+        PIFS_TEST_ERROR_MSG("Free page %s is not known to be erased!\r\n", pifs_ba_pa2str(ba, pa));
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS
+            && pifs_is_page_known_erased(pifs.header.management_block_address, 0))
+    {
+        PIFS_TEST_ERROR_MSG("Header page is known to be erased!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    PIFS_PUT_MUTEX();
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_wfragment_w(SKIP_READ_TEST_FRAGMENT_SIZE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("fragwr.tst", "r");
+        if (file)
+        {
+            PIFS_GET_MUTEX();
+            ba = ((pifs_file_t*) file)->map_entry.address.block_address;
+            pa = ((pifs_file_t*) file)->map_entry.address.page_address;
+            if (pifs_is_page_known_erased(ba, pa))
+            {
+                PIFS_TEST_ERROR_MSG("Written page %s is known to be erased!\r\n", pifs_ba_pa2str(ba, pa));
+                ret = PIFS_ERROR_GENERAL;
+            }
+            PIFS_PUT_MUTEX();
+            if (pifs_fclose(file))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        else
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_wfragment_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_wfragment_remove();
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_ENABLE_ERASED_BITMAP
+/**
+ * @brief pifs_test_erased_bitmap Check that free page is read only once to
+ * verify that it is erased and it is read again after it is written.
+ */
+pifs_status_t pifs_test_erased_bitmap(void)
+{
+    pifs_status_t        ret;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_count_t    page_count_found;
+#if PIFS_ENABLE_STATISTICS
+    uint32_t             access_cntr;
+#endif
+
+    printf("-------------------------------------------------\r\n");
+    printf("Erased bitmap test\r\n");
+    PIFS_GET_MUTEX();
+    ret = pifs_find_page(1, 1, PIFS_BLOCK_TYPE_DATA, TRUE, FALSE,
+                         PIFS_FLASH_BLOCK_FIRST_FS, &ba, &pa, &page_count_found);
+    if (ret == PIFS_SUCCESS && !pifs_is_page_verified_erased(ba, pa))
+    {
+        PIFS_TEST_ERROR_MSG("Found page %s is not verified to be erased!\r\n", pifs_ba_pa2str(ba, pa));
+        ret = PIFS_ERROR_GENERAL;
+    }
+#if PIFS_ENABLE_STATISTICS
+    access_cntr = pifs.cache_hit_cntr + pifs.cache_miss_cntr;
+#endif
+    if (ret == PIFS_SUCCESS && !pifs_is_page_erased(ba, pa))
+    {
+        PIFS_TEST_ERROR_MSG("Found page %s is not erased!\r\n", pifs_ba_pa2str(ba, pa));
+        ret = PIFS_ERROR_GENERAL;
+    }
+#if PIFS_ENABLE_STATISTICS
+    if (ret == PIFS_SUCCESS && pifs.cache_hit_cntr + pifs.cache_miss_cntr != access_cntr)
+    {
+        PIFS_TEST_ERROR_MSG("Verified page %s is read again!\r\n", pifs_ba_pa2str(ba, pa));
+        ret = PIFS_ERROR_GENERAL;
+    }
+#endif
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_mark_page(ba, pa, 1, TRUE, FALSE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        fill_buffer(test_buf_w, PIFS_LOGICAL_PAGE_SIZE_BYTE, FILL_TYPE_SEQUENCE_WORD, 4);
+        ret = pifs_write(ba, pa, 0, test_buf_w, PIFS_LOGICAL_PAGE_SIZE_BYTE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_flush();
+    }
+    if (ret == PIFS_SUCCESS && pifs_is_page_verified_erased(ba, pa))
+    {
+        PIFS_TEST_ERROR_MSG("Written page %s is verified to be erased!\r\n", pifs_ba_pa2str(ba, pa));
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS && pifs_is_page_erased(ba, pa))
+    {
+        PIFS_TEST_ERROR_MSG("Written page %s is erased!\r\n", pifs_ba_pa2str(ba, pa));
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_mark_page(ba, pa, 1, FALSE, TRUE);
+    }
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+#endif
+
+/**
+ * @brief pifs_test_get_block_type Calculate type of block from the header.
+ *
+ * @param[in] a_block_address   Block address.
+ * @param[in] a_header          Pointer to file system's header.
+ * @return Type of block.
+ */
+static pifs_block_type_t pifs_test_get_block_type(pifs_block_address_t a_block_address,
+                                                  pifs_header_t * a_header)
+{
+    pifs_block_type_t block_type = PIFS_BLOCK_TYPE_DATA;
+
+    if (a_block_address >= a_header->management_block_address
+            && a_block_address < a_header->management_block_address + PIFS_MANAGEMENT_BLOCK_NUM)
+    {
+        block_type = PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT;
+    }
+    else if (a_block_address >= a_header->next_management_block_address
+             && a_block_address < a_header->next_management_block_address + PIFS_MANAGEMENT_BLOCK_NUM)
+    {
+        block_type = PIFS_BLOCK_TYPE_SECONDARY_MANAGEMENT;
+    }
+#if PIFS_FLASH_BLOCK_FIRST_FS
+    else if (a_block_address < PIFS_FLASH_BLOCK_FIRST_FS)
+    {
+        block_type = PIFS_BLOCK_TYPE_RESERVED;
+    }
+#endif
+
+    return block_type;
+}
+
+/**
+ * @brief pifs_test_block_type_check Check type of every block.
+ *
+ * @param[in] a_header  Pointer to file system's header.
+ * @return PIFS_SUCCESS if types of blocks are correct.
+ */
+static pifs_status_t pifs_test_block_type_check(pifs_header_t * a_header)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_address_t ba;
+    pifs_block_address_t next_data_ba = PIFS_FLASH_BLOCK_NUM_ALL;
+    pifs_block_type_t    block_type;
+
+    for (ba = PIFS_FLASH_BLOCK_NUM_ALL; ba > 0 && ret == PIFS_SUCCESS; ba--)
+    {
+        block_type = pifs_test_get_block_type(ba - 1, a_header);
+        if (block_type == PIFS_BLOCK_TYPE_DATA)
+        {
+            next_data_ba = ba - 1;
+        }
+        if (!pifs_is_block_type(ba - 1, block_type, a_header)
+                || pifs_is_block_type(ba - 1, ~block_type & (PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT
+                                                             | PIFS_BLOCK_TYPE_SECONDARY_MANAGEMENT
+                                                             | PIFS_BLOCK_TYPE_DATA
+                                                             | PIFS_BLOCK_TYPE_RESERVED), a_header))
+        {
+            PIFS_TEST_ERROR_MSG("Type of block %i is not %i!\r\n", ba - 1, block_type);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        if (ret == PIFS_SUCCESS
+                && pifs_next_block_type(ba - 1, PIFS_BLOCK_TYPE_DATA, a_header) != next_data_ba)
+        {
+            PIFS_TEST_ERROR_MSG("Next data block of block %i is not %i!\r\n", ba - 1, next_data_ba);
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_block_type Check type of blocks according to actual
+ * header, after merge and remount and according to another header.
+ */
+pifs_status_t pifs_test_block_type(void)
+{
+    pifs_status_t ret;
+    pifs_header_t header;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Block type test\r\n");
+    PIFS_GET_MUTEX();
+    ret = pifs_test_block_type_check(&pifs.header);
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Management areas of another header are calculated */
+        header = pifs.header;
+        header.management_block_address = pifs.header.next_management_block_address;
+        header.next_management_block_address = pifs.header.management_block_address;
+        ret = pifs_test_block_type_check(&header);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_merge();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_block_type_check(&pifs.header);
+    }
+    PIFS_PUT_MUTEX();
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        PIFS_GET_MUTEX();
+        ret = pifs_test_block_type_check(&pifs.header);
+        PIFS_PUT_MUTEX();
+    }
+
+    return ret;
+}
+
+#if PIFS_ENABLE_ALLOC_CURSOR
+/**
+ * @brief pifs_test_alloc_cursor_check Check that there is no free page
+ * before the allocation cursors.
+ *
+ * @return PIFS_SUCCESS if cursors are valid.
+ */
+static pifs_status_t pifs_test_alloc_cursor_check(void)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_type_t    block_type;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_size_t          i;
+
+    PIFS_GET_MUTEX();
+    for (i = 0; i < PIFS_ALLOC_CURSOR_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        block_type = i ? PIFS_BLOCK_TYPE_PRIMARY_MANAGEMENT : PIFS_BLOCK_TYPE_DATA;
+        for (ba = PIFS_FLASH_BLOCK_FIRST_FS;
+             ba <= pifs.alloc_cursor[i].block_address && ba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS;
+             ba++)
+        {
+            for (pa = 0; pa < PIFS_LOGICAL_PAGE_PER_BLOCK
+                 && (ba < pifs.alloc_cursor[i].block_address || pa < pifs.alloc_cursor[i].page_address)
+                 && ret == PIFS_SUCCESS; pa++)
+            {
+                if (pifs_is_block_type(ba, block_type, &pifs.header) && pifs_is_page_free(ba, pa))
+                {
+                    PIFS_TEST_ERROR_MSG("Free page %s is before allocation cursor ", pifs_ba_pa2str(ba, pa));
+                    printf("%s!\r\n", pifs_address2str(&pifs.alloc_cursor[i]));
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+        }
+    }
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_alloc_cursor Check allocation cursors while files are
+ * written, removed and merged.
+ */
+pifs_status_t pifs_test_alloc_cursor(void)
+{
+    pifs_status_t ret;
+    char          filename[PIFS_FILENAME_LEN_MAX];
+    size_t        i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Allocation cursor test\r\n");
+    ret = pifs_test_alloc_cursor_check();
+    for (i = 0; i < ALLOC_CURSOR_TEST_FILE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        snprintf(filename, sizeof(filename), "cursor%i.tst", (int) i);
+        ret = pifs_create_file(filename, i, i + 1);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_alloc_cursor_check();
+        }
+    }
+    for (i = 0; i < ALLOC_CURSOR_TEST_FILE_NUM && ret == PIFS_SUCCESS; i += 2)
+    {
+        snprintf(filename, sizeof(filename), "cursor%i.tst", (int) i);
+        ret = pifs_test_remove(filename);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_alloc_cursor_check();
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        PIFS_GET_MUTEX();
+        ret = pifs_merge();
+        PIFS_PUT_MUTEX();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_alloc_cursor_check();
+    }
+    for (i = 0; i < ALLOC_CURSOR_TEST_FILE_NUM && ret == PIFS_SUCCESS; i += 2)
+    {
+        snprintf(filename, sizeof(filename), "cursor%i.tst", (int) i);
+        ret = pifs_create_file(filename, i, i + 1);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_alloc_cursor_check();
+        }
+    }
+    for (i = 0; i < ALLOC_CURSOR_TEST_FILE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        snprintf(filename, sizeof(filename), "cursor%i.tst", (int) i);
+        ret = pifs_check_file(filename, i, i + 1);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_remove(filename);
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_alloc_cursor_check();
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_ENABLE_EXTENT_ALLOC
+/**
+ * @brief pifs_test_extent_alloc_check Check cached longest free runs of data
+ * blocks.
+ *
+ * @return PIFS_SUCCESS if cached runs are the longest ones.
+ */
+static pifs_status_t pifs_test_extent_alloc_check(void)
+{
+    pifs_status_t        ret = PIFS_SUCCESS;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_count_t    page_count;
+    pifs_page_count_t    page_count_max;
+
+    PIFS_GET_MUTEX();
+    for (ba = PIFS_FLASH_BLOCK_FIRST_FS; ba < PIFS_FLASH_BLOCK_NUM_ALL && ret == PIFS_SUCCESS; ba++)
+    {
+        if (pifs.extent_page_count[ba] != PIFS_EXTENT_INVALID
+                && pifs_is_block_type(ba, PIFS_BLOCK_TYPE_DATA, &pifs.header))
+        {
+            page_count = 0;
+            page_count_max = 0;
+            for (pa = 0; pa < PIFS_LOGICAL_PAGE_PER_BLOCK; pa++)
+            {
+                page_count = pifs_is_page_free(ba, pa) ? page_count + 1 : 0;
+                page_count_max = PIFS_MAX(page_count, page_count_max);
+            }
+            for (pa = pifs.extent_page_address[ba];
+                 pa < pifs.extent_page_address[ba] + pifs.extent_page_count[ba] && ret == PIFS_SUCCESS;
+                 pa++)
+            {
+                if (!pifs_is_page_free(ba, pa))
+                {
+                    PIFS_TEST_ERROR_MSG("Page %s of free run is used!\r\n", pifs_ba_pa2str(ba, pa));
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+            if (ret == PIFS_SUCCESS && pifs.extent_page_count[ba] != page_count_max)
+            {
+                PIFS_TEST_ERROR_MSG("Longest free run of block %i: %i pages, expected: %i!\r\n",
+                                    ba, pifs.extent_page_count[ba], page_count_max);
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+    }
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_extent_alloc Leave free holes of one page and write
+ * several pages by one call. Pages shall be allocated in one run, so the
+ * file has only one map entry.
+ */
+pifs_status_t pifs_test_extent_alloc(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    P_FILE      * file2;
+    size_t        i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Extent allocation test\r\n");
+    /* Pages of two files are interleaved, removing one of them leaves */
+    /* holes of one page */
+    file = pifs_fopen("ealloc1.tst", "w");
+    file2 = pifs_fopen("ealloc2.tst", "w");
+    if (file && file2)
+    {
+        fill_buffer(test_buf_w, PIFS_LOGICAL_PAGE_SIZE_BYTE, FILL_TYPE_SEQUENCE_WORD, 5);
+        for (i = 0; i < EXTENT_ALLOC_TEST_HOLE_NUM && ret == PIFS_SUCCESS; i++)
+        {
+            if (pifs_fwrite(test_buf_w, 1, PIFS_LOGICAL_PAGE_SIZE_BYTE, file) != PIFS_LOGICAL_PAGE_SIZE_BYTE
+                    || pifs_fwrite(test_buf_w, 1, PIFS_LOGICAL_PAGE_SIZE_BYTE, file2) != PIFS_LOGICAL_PAGE_SIZE_BYTE)
+            {
+                PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (ret == PIFS_SUCCESS && (pifs_fflush(file) || pifs_fflush(file2)))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot flush file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file2 && pifs_fclose(file2))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("ealloc2.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        PIFS_GET_MUTEX();
+        ret = pifs_merge();
+        PIFS_PUT_MUTEX();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_extent_alloc_check();
+    }
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        for (i = 0; i < EXTENT_ALLOC_TEST_PAGE_NUM; i++)
+        {
+            fill_buffer(&test_page_buf[i * PIFS_LOGICAL_PAGE_SIZE_BYTE], PIFS_LOGICAL_PAGE_SIZE_BYTE,
+                        FILL_TYPE_SEQUENCE_WORD, i + 6);
+        }
+        file = pifs_fopen("ealloc3.tst", "w");
+        if (file)
+        {
+            if (pifs_fwrite(test_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE, EXTENT_ALLOC_TEST_PAGE_NUM, file)
+                    != EXTENT_ALLOC_TEST_PAGE_NUM)
+            {
+                PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (pifs_fclose(file))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        else
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_extent_alloc_check();
+    }
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("ealloc3.tst", "r");
+        if (!file)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS && ((pifs_file_t*) file)->map_entry.page_count < EXTENT_ALLOC_TEST_PAGE_NUM)
+    {
+        PIFS_TEST_ERROR_MSG("First map entry has only %i pages!\r\n",
+                            ((pifs_file_t*) file)->map_entry.page_count);
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS
+            && pifs_fread(test_buf_r, 1, PIFS_LOGICAL_PAGE_SIZE_BYTE, file) != PIFS_LOGICAL_PAGE_SIZE_BYTE)
+    {
+        PIFS_TEST_ERROR_MSG("Cannot read file: %i!\r\n", pifs_errno);
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = compare_buffer(test_page_buf, PIFS_LOGICAL_PAGE_SIZE_BYTE, test_buf_r);
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("ealloc1.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("ealloc3.tst");
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+static uint32_t delta_map_ext_sequence; /**< Sequence of last overwrite of delta map extension test */
+
+/**
+ * @brief pifs_test_get_delta_map_ext_page_num Get number of chained delta
+ * map pages.
+ *
+ * @return Number of chained delta map pages.
+ */
+static pifs_size_t pifs_test_get_delta_map_ext_page_num(void)
+{
+    pifs_size_t ext_page_num = 0;
+
+    PIFS_GET_MUTEX();
+    if (pifs_get_delta_map_ext_page_num(&ext_page_num, &pifs.header) != PIFS_SUCCESS)
+    {
+        PIFS_TEST_ERROR_MSG("Cannot read delta map!\r\n");
+    }
+    PIFS_PUT_MUTEX();
+
+    return ext_page_num;
+}
+
+/**
+ * @brief pifs_test_delta_map_ext_w Overwrite a file until delta map pages
+ * are chained, then check that the chain is found after remount.
+ */
+pifs_status_t pifs_test_delta_map_ext_w(void)
+{
+    pifs_status_t ret;
+    pifs_size_t   ext_page_num = 0;
+    uint32_t      counter;
+    uint32_t      i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Delta map extension test\r\n");
+
+    /* Merge shall not be needed while delta map pages are chained, */
+    /* so released entries and pages of previous tests are reclaimed first */
+    printf("Merging...\r\n");
+    PIFS_GET_MUTEX();
+    ret = pifs_merge();
+    PIFS_PUT_MUTEX();
+    if (ret != PIFS_SUCCESS)
+    {
+        PIFS_TEST_ERROR_MSG("Cannot merge: %i!\r\n", ret);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_create_file("deltaext.tst", 0, DELTA_MAP_EXT_TEST_BUF_NUM);
+    }
+    counter = pifs.header.counter;
+    /* Every overwrite uses a new file entry, but fills a whole delta map */
+    /* page, so entries do not run out (and trigger merge) before delta */
+    /* map pages are chained */
+    for (i = 1; i <= PIFS_DELTA_ENTRY_NUM && ret == PIFS_SUCCESS && ext_page_num < DELTA_MAP_EXT_TEST_PAGE_NUM; i++)
+    {
+        ret = pifs_overwrite_file("deltaext.tst", i, DELTA_MAP_EXT_TEST_BUF_NUM);
+        ext_page_num = pifs_test_get_delta_map_ext_page_num();
+    }
+    if (ret == PIFS_SUCCESS && (ext_page_num < DELTA_MAP_EXT_TEST_PAGE_NUM || pifs.header.counter != counter))
+    {
+        PIFS_TEST_ERROR_MSG("Delta map was not extended, chained pages: %i!\r\n", ext_page_num);
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        printf("Chained delta map pages: %i\r\n", ext_page_num);
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS && pifs_test_get_delta_map_ext_page_num() != ext_page_num)
+    {
+        PIFS_TEST_ERROR_MSG("Chained delta map pages are lost at remount!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_check_file("deltaext.tst", i - 1, DELTA_MAP_EXT_TEST_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        /* New entries are appended to the chained pages */
+        ret = pifs_overwrite_file("deltaext.tst", i, DELTA_MAP_EXT_TEST_BUF_NUM);
+        delta_map_ext_sequence = i;
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_delta_map_ext_remove(void)
+{
+    return pifs_test_remove("deltaext.tst");
+}
+
+pifs_status_t pifs_test_delta_map_ext_r(void)
+{
+    printf("-------------------------------------------------\r\n");
+    printf("Delta map extension test: reading file\r\n");
+
+    return pifs_check_file("deltaext.tst", delta_map_ext_sequence, DELTA_MAP_EXT_TEST_BUF_NUM);
+}
+#endif
+
+#if PIFS_DELTA_FILTER_PAGE_NUM
+/**
+ * @brief pifs_test_delta_filter_check Check that every page which has delta
+ * page is marked in delta presence filter.
+ *
+ * @return PIFS_SUCCESS if no delta page is filtered out.
+ */
+static pifs_status_t pifs_test_delta_filter_check(void)
+{
+    pifs_status_t        ret;
+    pifs_delta_entry_t * delta_entry;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_size_t          delta_entry_num;
+    pifs_size_t          idx;
+    pifs_size_t          i;
+
+    PIFS_GET_MUTEX();
+    /* Delta map is read by first search */
+    ret = pifs_find_delta_page(PIFS_FLASH_BLOCK_FIRST_FS, 0, &ba, &pa, NULL, &pifs.header);
+#if PIFS_DELTA_MAP_EXT_PAGE_NUM
+    delta_entry_num = pifs.delta_map_page_num * PIFS_DELTA_ENTRY_PER_PAGE;
+#else
+    delta_entry_num = PIFS_DELTA_MAP_PAGE_NUM * PIFS_DELTA_ENTRY_PER_PAGE;
+#endif
+    for (i = 0; i < delta_entry_num && ret == PIFS_SUCCESS; i++)
+    {
+        delta_entry = &((pifs_delta_entry_t*) pifs.delta_map_page_buf[i / PIFS_DELTA_ENTRY_PER_PAGE])
+                [i % PIFS_DELTA_ENTRY_PER_PAGE];
+        if (delta_entry->orig_address.block_address != PIFS_BLOCK_ADDRESS_INVALID
+                && pifs_calc_checksum(delta_entry, PIFS_DELTA_ENTRY_SIZE_BYTE - PIFS_CHECKSUM_SIZE_BYTE)
+                == delta_entry->checksum)
+        {
+            idx = PIFS_DELTA_FILTER_IDX(delta_entry->orig_address.block_address,
+                                        delta_entry->orig_address.page_address);
+            if (!(pifs.delta_filter[idx / 32u] & (1u << (idx % 32u))))
+            {
+                PIFS_TEST_ERROR_MSG("Page %s has delta page, but it is filtered out!\r\n",
+                                    pifs_address2str(&delta_entry->orig_address));
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+    }
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_delta_filter Check delta presence filter after merge and
+ * overwriting pages of a file.
+ */
+pifs_status_t pifs_test_delta_filter(void)
+{
+    pifs_status_t ret;
+    size_t        i;
+    size_t        words_set = 0;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Delta filter test\r\n");
+    ret = pifs_create_file("dfilter.tst", 0, DELTA_FILTER_TEST_BUF_NUM);
+    if (ret == PIFS_SUCCESS)
+    {
+        PIFS_GET_MUTEX();
+        ret = pifs_merge();
+        /* Delta map is empty after merge */
+        for (i = 0; i < PIFS_DELTA_FILTER_WORD_NUM; i++)
+        {
+            if (pifs.delta_filter[i])
+            {
+                words_set++;
+            }
+        }
+        PIFS_PUT_MUTEX();
+        if (ret == PIFS_SUCCESS && words_set)
+        {
+            PIFS_TEST_ERROR_MSG("%i words of delta filter are set after merge!\r\n", (int) words_set);
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    for (i = 0; i < DELTA_FILTER_TEST_WRITE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_overwrite_file("dfilter.tst", i + 1, DELTA_FILTER_TEST_BUF_NUM);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_delta_filter_check();
+        }
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_check_file("dfilter.tst", i + 1, DELTA_FILTER_TEST_BUF_NUM);
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_filter_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_check_file("dfilter.tst", DELTA_FILTER_TEST_WRITE_NUM, DELTA_FILTER_TEST_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("dfilter.tst");
+    }
+
+    return ret;
+}
+#endif
+
+#if PIFS_DELTA_PATCH_PAGE_NUM
+static uint8_t patch_test_buf[PATCH_TEST_PAGE_NUM * PIFS_LOGICAL_PAGE_SIZE_BYTE]; /**< Expected content of patch test file */
+
+/**
+ * @brief pifs_test_patch_create Create file of patch test with zeros, so
+ * every overwrite needs delta page or patch.
+ *
+ * @param[in] a_filename Name of file.
+ * @return PIFS_SUCCESS if file was created.
+ */
+static pifs_status_t pifs_test_patch_create(const char * a_filename)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    size_t        pos;
+
+    memset(test_buf_w, 0, sizeof(test_buf_w));
+    file = pifs_fopen(a_filename, "w");
+    if (file)
+    {
+        for (pos = 0; pos < sizeof(patch_test_buf) && ret == PIFS_SUCCESS; pos += sizeof(test_buf_w))
+        {
+            if (pifs_fwrite(test_buf_w, 1, sizeof(test_buf_w), file) != sizeof(test_buf_w))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot write file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_patch_overwrite Overwrite PATCH_TEST_SIZE bytes at an
+ * aligned position. Consecutive overwrites are in different pages.
+ *
+ * @param[in] a_file        Opened file.
+ * @param[in] a_idx         Index of overwrite.
+ * @param[out] a_expected   Expected content of file to update or NULL.
+ * @return PIFS_SUCCESS if data was written.
+ */
+static pifs_status_t pifs_test_patch_overwrite(P_FILE * a_file, uint32_t a_idx, uint8_t * a_expected)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    size_t        pos;
+    uint8_t       data[PATCH_TEST_SIZE];
+
+    /* Overwrites are page aligned */
+    pos = (a_idx % PATCH_TEST_PAGE_NUM) * PIFS_LOGICAL_PAGE_SIZE_BYTE;
+    memset(data, (uint8_t) (a_idx + 1), sizeof(data));
+    if (pifs_fseek(a_file, pos, PIFS_SEEK_SET))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot seek!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    else if (pifs_fwrite(data, 1, sizeof(data), a_file) != sizeof(data))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+        ret = PIFS_ERROR_GENERAL;
+    }
+    else if (a_expected)
+    {
+        memcpy(&a_expected[pos], data, sizeof(data));
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_patch_check Compare file of patch test with the expected
+ * content.
+ *
+ * @return PIFS_SUCCESS if content matches.
+ */
+static pifs_status_t pifs_test_patch_check(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    P_FILE      * file;
+    size_t        pos;
+
+    file = pifs_fopen("patch.tst", "r");
+    if (file)
+    {
+        for (pos = 0; pos < sizeof(patch_test_buf) && ret == PIFS_SUCCESS; pos += sizeof(test_buf_r))
+        {
+            if (pifs_fread(test_buf_r, 1, sizeof(test_buf_r), file) != sizeof(test_buf_r))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot read file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+            else
+            {
+                ret = compare_buffer(&patch_test_buf[pos], sizeof(test_buf_r), test_buf_r);
+            }
+        }
+        if (pifs_fclose(file))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_patch_w Overwrite small parts of a file, which are
+ * stored as patches. Patches shall survive remount, they shall be folded
+ * when patch pages or delta entries run out, and patches of a removed file
+ * shall be dropped.
+ */
+pifs_status_t pifs_test_patch_w(void)
+{
+    pifs_status_t ret;
+    P_FILE      * file = NULL;
+    uint32_t      i;
+    uint32_t      counter;
+    bool_t        is_patch_page_full = FALSE;
+    pifs_size_t   free_entry_num;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Patch test: small overwrites\r\n");
+
+    memset(patch_test_buf, 0, sizeof(patch_test_buf));
+    ret = pifs_test_patch_create("patch.tst");
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("patch.tst", "r+");
+        ret = file ? PIFS_SUCCESS : PIFS_ERROR_GENERAL;
+    }
+    for (i = 0; i < PATCH_TEST_PAGE_NUM * 2 && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_test_patch_overwrite(file, i, patch_test_buf);
+    }
+    if (ret == PIFS_SUCCESS && !pifs.delta_patched_page_num)
+    {
+        PIFS_TEST_ERROR_MSG("Small overwrites are not stored as patches!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_patch_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+
+    printf("Patch test: small overwrites until patches are folded\r\n");
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("patch.tst", "r+");
+        ret = file ? PIFS_SUCCESS : PIFS_ERROR_GENERAL;
+    }
+    counter = pifs.header.counter;
+    /* Merge folds the patches, when no more delta entry is available */
+    for (; i < PATCH_TEST_WRITE_NUM_MAX && ret == PIFS_SUCCESS && pifs.header.counter == counter; i++)
+    {
+        ret = pifs_test_patch_overwrite(file, i, patch_test_buf);
+        if (pifs.delta_patch_page_num == PIFS_DELTA_PATCH_PAGE_NUM)
+        {
+            is_patch_page_full = TRUE;
+        }
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS && (!is_patch_page_full || pifs.header.counter == counter))
+    {
+        PIFS_TEST_ERROR_MSG("Patch pages or delta entries did not run out!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_patch_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_patch_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+
+    printf("Patch test: patches of removed file\r\n");
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Patches of patch.tst written by the last overwrite are folded
+         * first, so only the patches of patchrm.tst remain */
+        PIFS_GET_MUTEX();
+        ret = pifs_fold_delta_patch(&pifs.header);
+        PIFS_PUT_MUTEX();
+    }
+    if (ret == PIFS_SUCCESS && pifs.delta_patched_page_num)
+    {
+        PIFS_TEST_ERROR_MSG("Patches were not folded!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_patch_create("patchrm.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("patchrm.tst", "r+");
+        ret = file ? PIFS_SUCCESS : PIFS_ERROR_GENERAL;
+    }
+    for (i = 0; i < PATCH_TEST_PAGE_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_test_patch_overwrite(file, i, NULL);
+    }
+    if (file && pifs_fclose(file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("patchrm.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        free_entry_num = pifs.delta_map_free_entry_num;
+        PIFS_GET_MUTEX();
+        ret = pifs_fold_delta_patch(&pifs.header);
+        PIFS_PUT_MUTEX();
+    }
+    if (ret == PIFS_SUCCESS
+            && (pifs.delta_patched_page_num || pifs.delta_map_free_entry_num != free_entry_num))
+    {
+        PIFS_TEST_ERROR_MSG("Patches of removed file were folded!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_patch_check();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_patch_remove(void)
+{
+    return pifs_test_remove("patch.tst");
+}
+
+pifs_status_t pifs_test_patch_r(void)
+{
+    printf("-------------------------------------------------\r\n");
+    printf("Patch test: reading file\r\n");
+
+    return pifs_test_patch_check();
+}
+#endif
+
+#if PIFS_ENABLE_DEFERRED_MAP_ENTRY
+static size_t deferred_buf_num; /**< Number of buffers in file of maximum page count test */
+
+/**
+ * @brief pifs_test_deferred_append Append buffers to an opened file with
+ * the same content as pifs_create_file() would write. Pending map entry is
+ * watched after every write: it shall grow if the new pages follow it and
+ * its page count allows, otherwise it shall be written.
+ *
+ * @param[in] a_file                Opened file.
+ * @param[in] a_filename            Name of file.
+ * @param[in] a_sequence_start      First sequence number of content.
+ * @param[in] a_write_count         Number of buffers to write.
+ * @param[out] a_commit_cntr        Number of pending map entries written.
+ * @param[out] a_page_count_max     Maximum page count of pending map entry.
+ * @return PIFS_SUCCESS if buffers were written.
+ */
+static pifs_status_t pifs_test_deferred_append(P_FILE * a_file, const char * a_filename,
+                                               uint32_t a_sequence_start, size_t a_write_count,
+                                               size_t * a_commit_cntr,
+                                               pifs_page_count_t * a_page_count_max)
+{
+    pifs_status_t     ret = PIFS_SUCCESS;
+    pifs_file_t     * file = (pifs_file_t*) a_file;
+    pifs_address_t    address;
+    pifs_page_count_t page_count;
+    uint32_t          counter;
+    bool_t            is_extendable;
+    size_t            i;
+
+    for (i = 0; i < a_write_count && ret == PIFS_SUCCESS; i++)
+    {
+        address = file->pending_map_address;
+        page_count = file->pending_map_page_count;
+        counter = pifs.header.counter;
+        generate_buffer(a_sequence_start + i, a_filename);
+        if (pifs_fwrite(test_buf_w, 1, sizeof(test_buf_w), a_file) != sizeof(test_buf_w))
+        {
+            PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+            ret = PIFS_ERROR_GENERAL;
+        }
+        else if (page_count && counter == pifs.header.counter)
+        {
+            /* Merge writes pending map entries, therefore it is not checked */
+            is_extendable = (page_count + DEFERRED_TEST_PAGE_PER_BUF < PIFS_MAP_PAGE_COUNT_INVALID);
+            if (file->pending_map_page_count > page_count)
+            {
+                if (!is_extendable
+                        || file->pending_map_page_count != page_count + DEFERRED_TEST_PAGE_PER_BUF
+                        || file->pending_map_address.block_address != address.block_address
+                        || file->pending_map_address.page_address != address.page_address)
+                {
+                    PIFS_TEST_ERROR_MSG("Pending map entry was extended wrongly!\r\n");
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+            else
+            {
+                (*a_commit_cntr)++;
+                if (is_extendable
+                        && file->pending_map_address.block_address == address.block_address
+                        && file->pending_map_address.page_address == address.page_address + page_count)
+                {
+                    PIFS_TEST_ERROR_MSG("Pending map entry was written, but it could be extended!\r\n");
+                    ret = PIFS_ERROR_GENERAL;
+                }
+            }
+        }
+        if (*a_page_count_max < file->pending_map_page_count)
+        {
+            *a_page_count_max = file->pending_map_page_count;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_deferred_close Set user data like pifs_create_file() and
+ * close file.
+ *
+ * @param[in] a_file    Opened file.
+ * @return PIFS_SUCCESS if file was closed.
+ */
+static pifs_status_t pifs_test_deferred_close(P_FILE * a_file)
+{
+    pifs_status_t    ret = PIFS_SUCCESS;
+#if PIFS_ENABLE_USER_DATA
+    pifs_user_data_t user_data;
+
+    fill_buffer(&user_data, sizeof(user_data), FILL_TYPE_SEQUENCE_BYTE, 0);
+    ret = pifs_fsetuserdata(a_file, &user_data);
+    if (ret != PIFS_SUCCESS)
+    {
+        PIFS_TEST_ERROR_MSG("Cannot set user data!\r\n");
+    }
+#endif
+    if (pifs_fclose(a_file))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_deferred_check Check content and size of a file of
+ * deferred map entry test.
+ *
+ * @param[in] a_filename    Name of file.
+ * @param[in] a_read_count  Number of buffers in the file.
+ * @return PIFS_SUCCESS if content and size match.
+ */
+static pifs_status_t pifs_test_deferred_check(const char * a_filename, size_t a_read_count)
+{
+    pifs_status_t ret;
+    long int      file_size;
+
+    ret = pifs_check_file(a_filename, 0, a_read_count);
+    if (ret == PIFS_SUCCESS)
+    {
+        file_size = pifs_filesize(a_filename);
+        if (file_size != (long int) (a_read_count * TEST_BUF_SIZE))
+        {
+            PIFS_TEST_ERROR_MSG("Size of file %s is %li, expected: %lu!\r\n", a_filename,
+                                file_size, (unsigned long) (a_read_count * TEST_BUF_SIZE));
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_deferred_check_all Check every file of deferred map
+ * entry test.
+ *
+ * @return PIFS_SUCCESS if all files match.
+ */
+static pifs_status_t pifs_test_deferred_check_all(void)
+{
+    pifs_status_t ret;
+
+    ret = pifs_test_deferred_check("defer1.tst", deferred_buf_num);
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer2.tst", DEFERRED_TEST_SHORT_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer3.tst", DEFERRED_TEST_SHORT_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer4.tst", 3 * DEFERRED_TEST_SHORT_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer5.tst", 2 * DEFERRED_TEST_SHORT_BUF_NUM);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_deferred_is_pending Check if file has pending map entry.
+ *
+ * @param[in] a_file        Opened file.
+ * @param[in] a_is_expected TRUE: pending map entry is expected.
+ * @return PIFS_SUCCESS if pending map entry is as expected.
+ */
+static pifs_status_t pifs_test_deferred_is_pending(P_FILE * a_file, bool_t a_is_expected)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    bool_t        is_pending = (((pifs_file_t*) a_file)->pending_map_page_count != 0);
+
+    if (is_pending != a_is_expected)
+    {
+        PIFS_TEST_ERROR_MSG("Map entry is %spending!\r\n", is_pending ? "" : "not ");
+        ret = PIFS_ERROR_GENERAL;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_deferred_w Append files while their last map entry is
+ * kept in RAM and check every event which writes the pending entry:
+ * maximum page count of map entry, non-contiguous allocation, seeking,
+ * rewinding and closing the file during merge. Pages of a pending entry
+ * lost by reset shall not stay allocated.
+ */
+pifs_status_t pifs_test_deferred_w(void)
+{
+    pifs_status_t     ret = PIFS_SUCCESS;
+    P_FILE          * file = NULL;
+    P_FILE          * file2 = NULL;
+    size_t            commit_cntr = 0;
+    size_t            commit_cntr2 = 0;
+    pifs_page_count_t page_count_max = 0;
+    pifs_address_t    address;
+    bool_t            is_free;
+    size_t            i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Deferred map entry test: maximum page count\r\n");
+    file = pifs_fopen("defer1.tst", "w");
+    if (file)
+    {
+        /* Pending map entry grows until the free pages following it run */
+        /* out or it reaches the maximum page count */
+        for (i = 0; i < DEFERRED_TEST_BUF_NUM_MAX && ret == PIFS_SUCCESS && !commit_cntr; i++)
+        {
+            ret = pifs_test_deferred_append(file, "defer1.tst", i, 1, &commit_cntr, &page_count_max);
+        }
+        deferred_buf_num = i;
+        if (pifs_test_deferred_close(file) != PIFS_SUCCESS)
+        {
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else
+    {
+        PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    printf("Longest pending map entry: %i pages\r\n", page_count_max);
+    if (ret == PIFS_SUCCESS && (page_count_max > DEFERRED_TEST_PAGE_COUNT_MAX || !commit_cntr))
+    {
+        PIFS_TEST_ERROR_MSG("Pending map entry was not written at maximum page count!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer1.tst", deferred_buf_num);
+    }
+
+    printf("Deferred map entry test: non-contiguous allocation\r\n");
+    commit_cntr = 0;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("defer2.tst", "w");
+        file2 = pifs_fopen("defer3.tst", "w");
+        if (!file || !file2)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    /* Files are appended alternately, so the pages of a file do not follow */
+    /* its pending map entry */
+    for (i = 0; i < DEFERRED_TEST_SHORT_BUF_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_test_deferred_append(file, "defer2.tst", i, 1, &commit_cntr, &page_count_max);
+        if (ret == PIFS_SUCCESS)
+        {
+            ret = pifs_test_deferred_append(file2, "defer3.tst", i, 1, &commit_cntr2, &page_count_max);
+        }
+    }
+    if (file && pifs_test_deferred_close(file) != PIFS_SUCCESS)
+    {
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (file2 && pifs_test_deferred_close(file2) != PIFS_SUCCESS)
+    {
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS && (!commit_cntr || !commit_cntr2))
+    {
+        PIFS_TEST_ERROR_MSG("Pending map entry was not written at non-contiguous pages!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer2.tst", DEFERRED_TEST_SHORT_BUF_NUM);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer3.tst", DEFERRED_TEST_SHORT_BUF_NUM);
+    }
+
+    printf("Deferred map entry test: seek and rewind\r\n");
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("defer4.tst", "w");
+        ret = file ? PIFS_SUCCESS : PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_append(file, "defer4.tst", 0, DEFERRED_TEST_SHORT_BUF_NUM,
+                                        &commit_cntr, &page_count_max);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_is_pending(file, TRUE);
+    }
+    if (ret == PIFS_SUCCESS && pifs_fseek(file, 0, PIFS_SEEK_SET))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot seek!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_is_pending(file, FALSE);
+    }
+    if (ret == PIFS_SUCCESS && pifs_fseek(file, 0, PIFS_SEEK_END))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot seek to end of file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_append(file, "defer4.tst", DEFERRED_TEST_SHORT_BUF_NUM,
+                                        DEFERRED_TEST_SHORT_BUF_NUM, &commit_cntr, &page_count_max);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_is_pending(file, TRUE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        pifs_rewind(file);
+        ret = pifs_test_deferred_is_pending(file, FALSE);
+    }
+    if (ret == PIFS_SUCCESS && pifs_fseek(file, 0, PIFS_SEEK_END))
+    {
+        PIFS_TEST_ERROR_MSG("Cannot seek to end of file!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_append(file, "defer4.tst", 2 * DEFERRED_TEST_SHORT_BUF_NUM,
+                                        DEFERRED_TEST_SHORT_BUF_NUM, &commit_cntr, &page_count_max);
+    }
+    if (file && pifs_test_deferred_close(file) != PIFS_SUCCESS)
+    {
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer4.tst", 3 * DEFERRED_TEST_SHORT_BUF_NUM);
+    }
+
+    printf("Deferred map entry test: merge\r\n");
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("defer5.tst", "w");
+        ret = file ? PIFS_SUCCESS : PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_append(file, "defer5.tst", 0, DEFERRED_TEST_SHORT_BUF_NUM,
+                                        &commit_cntr, &page_count_max);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_is_pending(file, TRUE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Merge closes and reopens the file */
+        PIFS_GET_MUTEX();
+        ret = pifs_merge();
+        PIFS_PUT_MUTEX();
+        if (ret != PIFS_SUCCESS)
+        {
+            PIFS_TEST_ERROR_MSG("Cannot merge: %i\r\n", ret);
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_is_pending(file, FALSE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_append(file, "defer5.tst", DEFERRED_TEST_SHORT_BUF_NUM,
+                                        DEFERRED_TEST_SHORT_BUF_NUM, &commit_cntr, &page_count_max);
+    }
+    if (file && pifs_test_deferred_close(file) != PIFS_SUCCESS)
+    {
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check("defer5.tst", 2 * DEFERRED_TEST_SHORT_BUF_NUM);
+    }
+
+    printf("Deferred map entry test: reset\r\n");
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        file = pifs_fopen("defer6.tst", "w");
+        ret = file ? PIFS_SUCCESS : PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_append(file, "defer6.tst", 0, 1, &commit_cntr, &page_count_max);
+    }
+    if (file && pifs_test_deferred_close(file) != PIFS_SUCCESS)
+    {
+        ret = PIFS_ERROR_GENERAL;
+    }
+    file = NULL;
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Map page and entry of file exist, only appended pages are pending */
+        file = pifs_fopen("defer6.tst", "a");
+        ret = file ? PIFS_SUCCESS : PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_append(file, "defer6.tst", 1, DEFERRED_TEST_SHORT_BUF_NUM,
+                                        &commit_cntr, &page_count_max);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_is_pending(file, TRUE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        address = ((pifs_file_t*) file)->pending_map_address;
+        PIFS_GET_MUTEX();
+        is_free = pifs_is_page_free(address.block_address, address.page_address);
+        PIFS_PUT_MUTEX();
+        if (is_free)
+        {
+            PIFS_TEST_ERROR_MSG("Pages of pending map entry are not reserved!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        /* File is not closed, pending map entry is lost like at reset */
+        ((pifs_file_t*) file)->is_opened = FALSE;
+        ((pifs_file_t*) file)->is_used = FALSE;
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        PIFS_GET_MUTEX();
+        is_free = pifs_is_page_free(address.block_address, address.page_address);
+        PIFS_PUT_MUTEX();
+        if (!is_free)
+        {
+            PIFS_TEST_ERROR_MSG("Pages of lost map entry are not free!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        /* Only the data written before the reset is in the file */
+        ret = pifs_test_deferred_check("defer6.tst", 1);
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remount();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_check_all();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_deferred_remove(void)
+{
+    pifs_status_t ret;
+
+    ret = pifs_test_remove("defer1.tst");
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("defer2.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("defer3.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("defer4.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("defer5.tst");
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_remove("defer6.tst");
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_deferred_r(void)
+{
+    printf("-------------------------------------------------\r\n");
+    printf("Deferred map entry test: reading files\r\n");
+
+    return pifs_test_deferred_check_all();
+}
+#endif
+
+#if PIFS_ENABLE_MAP_TAIL_CACHE
+/**
+ * @brief pifs_test_map_tail_check Check if position of last map entry of file
+ * is known and it is the last entry of the map.
+ *
+ * @param[in] a_file Opened file.
+ * @return PIFS_SUCCESS if position of last map entry is valid.
+ */
+static pifs_status_t pifs_test_map_tail_check(P_FILE * a_file)
+{
+    pifs_status_t     ret = PIFS_SUCCESS;
+    pifs_file_t     * file = (pifs_file_t*) a_file;
+    pifs_map_header_t map_header;
+    pifs_map_entry_t  map_entry;
+
+    if (!file->tail_map_entry_idx)
+    {
+        PIFS_TEST_ERROR_MSG("Position of last map entry is not known!\r\n");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    PIFS_GET_MUTEX();
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_read(file->tail_map_address.block_address, file->tail_map_address.page_address,
+                        PIFS_MAP_HEADER_SIZE_BYTE + (file->tail_map_entry_idx - 1) * PIFS_MAP_ENTRY_SIZE_BYTE,
+                        &map_entry, PIFS_MAP_ENTRY_SIZE_BYTE);
+        if (ret == PIFS_SUCCESS && pifs_is_buffer_erased(&map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
+        {
+            PIFS_TEST_ERROR_MSG("Last map entry is erased!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS && file->tail_map_entry_idx < PIFS_MAP_ENTRY_PER_PAGE)
+    {
+        ret = pifs_read(file->tail_map_address.block_address, file->tail_map_address.page_address,
+                        PIFS_MAP_HEADER_SIZE_BYTE + file->tail_map_entry_idx * PIFS_MAP_ENTRY_SIZE_BYTE,
+                        &map_entry, PIFS_MAP_ENTRY_SIZE_BYTE);
+        if (ret == PIFS_SUCCESS && !pifs_is_buffer_erased(&map_entry, PIFS_MAP_ENTRY_SIZE_BYTE))
+        {
+            PIFS_TEST_ERROR_MSG("Map entry after the last one is not erased!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    else if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_read(file->tail_map_address.block_address, file->tail_map_address.page_address,
+                        0, &map_header, PIFS_MAP_HEADER_SIZE_BYTE);
+        if (ret == PIFS_SUCCESS && !pifs_is_buffer_erased(&map_header.next_map_address, PIFS_ADDRESS_SIZE_BYTE))
+        {
+            PIFS_TEST_ERROR_MSG("Map continues after the last entry!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    PIFS_PUT_MUTEX();
+
+    return ret;
+}
+
+pifs_status_t pifs_test_map_tail_r(void)
+{
+    pifs_status_t ret;
+    long int      file_size;
+
+    ret = pifs_check_file("maptail.tst", 0, MAP_TAIL_TEST_BUF_NUM);
+    if (ret == PIFS_SUCCESS)
+    {
+        file_size = pifs_filesize("maptail.tst");
+        if (file_size != (long int) (MAP_TAIL_TEST_BUF_NUM * TEST_BUF_SIZE))
+        {
+            PIFS_TEST_ERROR_MSG("Size of file is %li, expected: %lu!\r\n",
+                                file_size, (unsigned long) (MAP_TAIL_TEST_BUF_NUM * TEST_BUF_SIZE));
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_map_tail_w Reopen and append a file many times. Position
+ * of last map entry shall be known after seeking to the end of file, so
+ * appending does not walk the map again.
+ */
+pifs_status_t pifs_test_map_tail_w(void)
+{
+    pifs_status_t ret;
+    P_FILE      * file;
+    size_t        i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Map tail test\r\n");
+    ret = pifs_create_file("maptail.tst", 0, 1);
+    for (i = 1; i < MAP_TAIL_TEST_BUF_NUM && ret == PIFS_SUCCESS; i++)
+    {
+        file = pifs_fopen("maptail.tst", "a");
+        if (file)
+        {
+            generate_buffer(i, "maptail.tst");
+            if (pifs_fwrite(test_buf_w, 1, sizeof(test_buf_w), file) != sizeof(test_buf_w))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot write file: %i!\r\n", pifs_errno);
+                ret = PIFS_ERROR_GENERAL;
+            }
+            if (ret == PIFS_SUCCESS)
+            {
+                ret = pifs_test_map_tail_check(file);
+            }
+            if (pifs_fclose(file))
+            {
+                PIFS_TEST_ERROR_MSG("Cannot close file!\r\n");
+                ret = PIFS_ERROR_GENERAL;
+            }
+        }
+        else
+        {
+            PIFS_TEST_ERROR_MSG("Cannot open file!\r\n");
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_map_tail_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_map_tail_remove(void)
+{
+    return pifs_test_remove("maptail.tst");
+}
+#endif
+
+#if PIFS_ENABLE_MOUNT_HINT
+/**
+ * @brief pifs_test_mount_hint_init Mount file system and check whether the
+ * header was found by mount hint. New hint is only written at mount if the
+ * blocks were scanned.
+ *
+ * @param[in] a_is_hint_expected TRUE: latest hint shall be used.
+ *                               FALSE: blocks shall be scanned.
+ * @return PIFS_SUCCESS if file system was mounted as expected and the test
+ * file is intact.
+ */
+static pifs_status_t pifs_test_mount_hint_init(bool_t a_is_hint_expected)
+{
+    pifs_status_t ret;
+    uint32_t      sequence = pifs.mount_hint_sequence;
+
+    ret = pifs_init();
+    if (ret != PIFS_SUCCESS)
+    {
+        PIFS_TEST_ERROR_MSG("Cannot mount file system: %i\r\n", ret);
+    }
+    else if ((pifs.mount_hint_sequence == sequence) != a_is_hint_expected)
+    {
+        PIFS_TEST_ERROR_MSG("Mount hint was %s!\r\n", a_is_hint_expected ? "not used" : "used");
+        ret = PIFS_ERROR_GENERAL;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_check_file("mhint.tst", 71, 2);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_check_fs();
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_mount_hint_forge Write a mount hint of an other header.
+ * File system shall not be mounted.
+ *
+ * @param[in] a_header_address  Address of header in the hint.
+ * @param[in] a_counter         Counter of header in the hint.
+ * @return PIFS_SUCCESS if hint was written.
+ */
+static pifs_status_t pifs_test_mount_hint_forge(pifs_address_t a_header_address, uint32_t a_counter)
+{
+    pifs_status_t  ret;
+    pifs_address_t header_address = pifs.header_address;
+    uint32_t       counter = pifs.header.counter;
+
+    ret = pifs_flash_init();
+    if (ret == PIFS_SUCCESS)
+    {
+        pifs.header_address = a_header_address;
+        pifs.header.counter = a_counter;
+        ret = pifs_mount_hint_write(FALSE);
+        pifs.header_address = header_address;
+        pifs.header.counter = counter;
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_flash_delete();
+    }
+    if (ret != PIFS_SUCCESS)
+    {
+        PIFS_TEST_ERROR_MSG("Cannot write mount hint: %i\r\n", ret);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief pifs_test_mount_hint_tear Program only the beginning of the next
+ * mount hint, like when power is lost during programming.
+ * File system shall not be mounted.
+ *
+ * @return PIFS_SUCCESS if torn hint was written.
+ */
+static pifs_status_t pifs_test_mount_hint_tear(void)
+{
+    pifs_status_t        ret;
+    pifs_mount_hint_t    hint;
+    pifs_size_t          idx;
+    pifs_block_address_t ba;
+    pifs_page_address_t  pa;
+    pifs_page_offset_t   po;
+
+    ret = pifs_flash_init();
+    if (ret == PIFS_SUCCESS && pifs.mount_hint_idx % PIFS_MOUNT_HINT_PER_BLOCK == 0)
+    {
+        /* Torn hint shall not be the first one of a block, */
+        /* because that block would be erased first */
+        ret = pifs_mount_hint_write(FALSE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        idx = pifs.mount_hint_idx;
+        ba = PIFS_MOUNT_HINT_BLOCK_ADDRESS + idx / PIFS_MOUNT_HINT_PER_BLOCK;
+        pa = (idx % PIFS_MOUNT_HINT_PER_BLOCK) / PIFS_MOUNT_HINT_PER_PAGE;
+        po = (idx % PIFS_MOUNT_HINT_PER_PAGE) * PIFS_MOUNT_HINT_SIZE_BYTE;
+        hint.magic = PIFS_MAGIC;
+        hint.sequence = pifs.mount_hint_sequence + 1;
+        ret = pifs_flash_write(ba, pa, po, &hint, offsetof(pifs_mount_hint_t, counter));
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_flash_delete();
+    }
+    if (ret != PIFS_SUCCESS)
+    {
+        PIFS_TEST_ERROR_MSG("Cannot write torn mount hint: %i\r\n", ret);
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_mount_hint_w(void)
+{
+    pifs_status_t  ret;
+    pifs_address_t header_address;
+    uint32_t       counter;
+    pifs_size_t    i;
+
+    printf("-------------------------------------------------\r\n");
+    printf("Mount hint test\r\n");
+
+    ret = pifs_create_file("mhint.tst", 71, 2);
+
+    printf("Remount\r\n");
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_delete();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_init(TRUE);
+    }
+
+    printf("Remount after every mount hint block was used\r\n");
+    for (i = 0; i < PIFS_MOUNT_HINT_PER_BLOCK + 1 && ret == PIFS_SUCCESS; i++)
+    {
+        ret = pifs_mount_hint_write(FALSE);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_delete();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_init(TRUE);
+    }
+
+    printf("Remount with stale header counter in mount hint\r\n");
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_delete();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_forge(pifs.header_address, pifs.header.counter - 1);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_init(FALSE);
+    }
+
+    printf("Remount with mount hint of superseded header\r\n");
+    if (ret == PIFS_SUCCESS)
+    {
+        header_address = pifs.header_address;
+        counter = pifs.header.counter;
+        PIFS_GET_MUTEX();
+        ret = pifs_merge();
+        PIFS_PUT_MUTEX();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_delete();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_forge(header_address, counter);
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_init(FALSE);
+    }
+
+    printf("Remount with torn mount hint\r\n");
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_delete();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_tear();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_init(FALSE);
+    }
+
+    printf("Remount after fallback\r\n");
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_delete();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_init(TRUE);
+    }
+
+    return ret;
+}
+
+pifs_status_t pifs_test_mount_hint_remove(void)
+{
+    return pifs_test_remove("mhint.tst");
+}
+
+pifs_status_t pifs_test_mount_hint_r(void)
+{
+    printf("-------------------------------------------------\r\n");
+    printf("Mount hint test: reading file\r\n");
+
+    return pifs_check_file("mhint.tst", 71, 2);
+}
+#endif
+
+#if PIFS_ENABLE_DIRECTORIES
+pifs_status_t pifs_test_dir_w(void)
+{
+    pifs_status_t ret = PIFS_SUCCESS;
+    pifs_char_t   cwd[PIFS_PATH_LEN_MAX];
+
+    printf("-------------------------------------------------\r\n");
+    printf("Directory test: creating directories and writing files\r\n");
+
+    printf("Entering root directory...\r\n");
+    ret = pifs_chdir(PIFS_ROOT_STR);
+
+    if (ret == PIFS_SUCCESS)
+    {
+        if (strncmp(pifs_getcwd(cwd, sizeof(cwd)), PIFS_ROOT_STR, sizeof(cwd)) != 0)
+        {
+            PIFS_ERROR_MSG("Invalid directory: %s\r\n", cwd);
+            ret = PIFS_ERROR_GENERAL;
+        }
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_mkdir("/a");
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_mkdir("b");
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_mkdir("c");
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_mkdir("a/d");
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_create_file("/a/1", 1, 1);
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_create_file("/b/2", 2, 1);
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_create_file("/c/3", 3, 1);
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_chdir("a/d");
+    }
+
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_create_file("./4", 4, 1);
     }
 
     if (ret == PIFS_SUCCESS)
@@ -1727,6 +5531,139 @@ pifs_status_t pifs_test(void)
     }
 #endif
 
+#if ENABLE_FALLOCATE_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fallocate_w();
+    }
+#endif
+
+#if ENABLE_CACHE_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_cache_w();
+    }
+#endif
+
+#if ENABLE_FSBM_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_w();
+    }
+#endif
+
+#if ENABLE_DELTA_INDEX_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_index();
+    }
+#endif
+
+#if ENABLE_EXTENT_CACHE_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_extent_cache();
+    }
+#endif
+
+#if ENABLE_MOUNT_HINT_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_w();
+    }
+#endif
+
+#if ENABLE_FSBM_BATCH_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_batch_w();
+    }
+#endif
+
+#if ENABLE_DIRECT_READ_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_direct_read();
+    }
+#endif
+
+#if ENABLE_READ_AHEAD_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_read_ahead();
+    }
+#endif
+
+#if ENABLE_BURST_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_burst();
+    }
+#endif
+
+#if ENABLE_ERASED_BITMAP_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_erased_bitmap();
+    }
+#endif
+
+#if ENABLE_BLOCK_TYPE_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_block_type();
+    }
+#endif
+
+#if ENABLE_ALLOC_CURSOR_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_alloc_cursor();
+    }
+#endif
+
+#if ENABLE_EXTENT_ALLOC_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_extent_alloc();
+    }
+#endif
+
+#if ENABLE_DELTA_MAP_EXT_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_map_ext_w();
+    }
+#endif
+
+#if ENABLE_DELTA_FILTER_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_filter();
+    }
+#endif
+
+#if ENABLE_PATCH_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_patch_w();
+    }
+#endif
+
+#if ENABLE_DEFERRED_MAP_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_w();
+    }
+#endif
+
+#if ENABLE_MAP_TAIL_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_map_tail_w();
+    }
+#endif
+
 #if ENABLE_DIRECTORY_TEST
     if (ret == PIFS_SUCCESS)
     {
@@ -1774,6 +5711,13 @@ pifs_status_t pifs_test(void)
     }
 #endif
 
+#if ENABLE_SKIP_READ_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_skip_read();
+    }
+#endif
+
 #if ENABLE_READ_FRAGMENT_TEST
     if (ret == PIFS_SUCCESS)
     {
@@ -1818,6 +5762,17 @@ pifs_status_t pifs_test(void)
     }
 #endif
 
+#if ENABLE_FALLOCATE_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fallocate_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fallocate_remove();
+    }
+#endif
+
 #if ENABLE_DIRECTORY_TEST
     if (ret == PIFS_SUCCESS)
     {
@@ -1825,6 +5780,90 @@ pifs_status_t pifs_test(void)
     }
 #endif
 
+#if ENABLE_CACHE_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_cache_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_cache_remove();
+    }
+#endif
+
+#if ENABLE_FSBM_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_fsbm_remove();
+    }
+#endif
+
+#if ENABLE_MOUNT_HINT_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_mount_hint_remove();
+    }
+#endif
+
+#if ENABLE_DELTA_MAP_EXT_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_map_ext_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_delta_map_ext_remove();
+    }
+#endif
+
+#if ENABLE_PATCH_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_patch_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_patch_remove();
+    }
+#endif
+
+#if ENABLE_DEFERRED_MAP_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_deferred_remove();
+    }
+#endif
+
+#if ENABLE_MAP_TAIL_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_map_tail_r();
+    }
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_map_tail_remove();
+    }
+#endif
+
+#if ENABLE_ENTRY_INDEX_TEST
+    if (ret == PIFS_SUCCESS)
+    {
+        ret = pifs_test_entry_index();
+    }
+#endif
+
 #if ENABLE_LIST_DIRECTORY_TEST
     if (ret == PIFS_SUCCESS)
     {
@@ -46,6 +46,8 @@ pifs_status_t pifs_test_wseek_w(void);
 pifs_status_t pifs_test_wseek_r(void);
 pifs_status_t pifs_test_delta_w(const char * a_filename);
 pifs_status_t pifs_test_delta_r(const char * a_filename);
+pifs_status_t pifs_test_fallocate_w(void);
+pifs_status_t pifs_test_fallocate_r(void);
 pifs_status_t pifs_test_list_dir(void);
 #if PIFS_ENABLE_DIRECTORIES
 pifs_status_t pifs_test_dir_w(void);